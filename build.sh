@@ -14,7 +14,7 @@ fi
 
 DEBUG_FLAGS="-Wall -O0 -g -DDEBUG"
 RELEASE_FLAGS="-Os"
-if [[ $1 = "release" ]]; then
+if [[ $1 = "release" || $1 = "microbench" ]]; then
 	CFLAGS="$CFLAGS -std=c++11 $RELEASE_FLAGS"
 else
 	CFLAGS="$CFLAGS -std=c++11 $DEBUG_FLAGS"
@@ -77,9 +77,34 @@ CFLAGS="$CFLAGS `pkg-config --cflags sdl2` $INCLUDE_DIRS"
 LDFLAGS="$LDFLAGS $LIB_SDL2 $LIB_OPENGL $LIB_IMGUI $LIB_NFD $LIB_STB_IMAGE"
 
 mkdir -p build
+if [[ $1 = "microbench" ]]; then
+	# cpu microbenchmarks of parsing, io and image decoding with synthetic inputs
+	c++ $CFLAGS src/microbench_ub.cpp $LDFLAGS -o build/${TARGET}_microbench
+	EXIT_STATUS=$?
+	if [[ $EXIT_STATUS = 0 ]]; then
+		pushd build > /dev/null
+		./${TARGET}_microbench "${@:2}"
+		EXIT_STATUS=$?
+		popd > /dev/null
+	fi
+	exit $EXIT_STATUS
+fi
 c++ $CFLAGS src/main_sdl2_ub.cpp $LDFLAGS -o build/$TARGET
 EXIT_STATUS=$?
 if [[ $EXIT_STATUS = 0 && $1 = "run" ]]; then
 	./build/$TARGET
+elif [[ $EXIT_STATUS = 0 && $1 = "test" ]]; then
+	# source to source cases of the glsl optimizer
+	c++ $CFLAGS src/glsl_optimizer_test_ub.cpp $LDFLAGS -o build/${TARGET}_glsl_optimizer_test && ./build/${TARGET}_glsl_optimizer_test
+	EXIT_STATUS=$?
+	if [[ $EXIT_STATUS != 0 ]]; then
+		exit $EXIT_STATUS
+	fi
+	# golden image regression suite of the examples on the renderer the goldens were recorded with,
+	# gpu times have no checked in baselines so few frames at a small size are measured
+	LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe ./build/$TARGET --regress examples/shaders/*.frag --headless --strict \
+		--res 384x216 --frames 20 --warmup 5 --out build/regress.json
+	EXIT_STATUS=$?
 fi
+exit $EXIT_STATUS
 
@@ -0,0 +1,59 @@
+// split-sum environment BRDF (Karis 2013), baked into slot 0 whenever
+// this file or u_sample_count changes
+#pragma bake(size=128x128, slot=0, format=rgba16f)
+
+uniform vec2 u_resolution;
+uniform int u_sample_count;
+
+const float PI = 3.14159265;
+
+vec2 hammersley(int i, int n) {
+	// radical inverse without bit ops (GLSL 1.10)
+	float bits = 0.0;
+	float f = 0.5;
+	float k = float(i);
+	for (int b = 0; b < 16; b++) {
+		if (k < 1.0) break;
+		bits += f * mod(k, 2.0);
+		k = floor(k * 0.5);
+		f *= 0.5;
+	}
+	return vec2(float(i) / float(n), bits);
+}
+
+vec3 importanceSampleGGX(vec2 xi, float roughness) {
+	float a = roughness * roughness;
+	float phi = 2.0 * PI * xi.x;
+	float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (a*a - 1.0) * xi.y));
+	float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+	return vec3(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta); // around n = +z
+}
+
+float geometrySmith(float n_dot_v, float n_dot_l, float roughness) {
+	float k = roughness * roughness * 0.5;
+	return n_dot_v / (n_dot_v * (1.0 - k) + k) * n_dot_l / (n_dot_l * (1.0 - k) + k);
+}
+
+void main() {
+	vec2 uv = gl_FragCoord.xy / u_resolution;
+	float n_dot_v = max(uv.x, 1e-3);
+	float roughness = uv.y;
+	vec3 v = vec3(sqrt(1.0 - n_dot_v * n_dot_v), 0.0, n_dot_v);
+
+	int n = u_sample_count > 0 ? u_sample_count : 256;
+	vec2 ab = vec2(0.0);
+	for (int i = 0; i < 4096; i++) {
+		if (i >= n) break;
+		vec3 h = importanceSampleGGX(hammersley(i, n), roughness);
+		vec3 l = 2.0 * dot(v, h) * h - v;
+		float n_dot_l = max(l.z, 0.0);
+		if (n_dot_l > 0.0) {
+			float n_dot_h = max(h.z, 0.0);
+			float v_dot_h = max(dot(v, h), 0.0);
+			float g_vis = geometrySmith(n_dot_v, n_dot_l, roughness) * v_dot_h / (n_dot_h * n_dot_v);
+			float fc = pow(1.0 - v_dot_h, 5.0);
+			ab += vec2((1.0 - fc) * g_vis, fc * g_vis);
+		}
+	}
+	gl_FragColor = vec4(ab / float(n), 0.0, 1.0);
+}
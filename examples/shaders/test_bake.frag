@@ -0,0 +1,10 @@
+// shows the lookup table rendered by test_bake.bake.frag into slot 0
+uniform vec2 u_resolution;
+uniform int u_sample_count; // also an input of the bake pass, editing it rebakes
+uniform sampler2D u_texture;
+
+void main() {
+	vec2 uv = gl_FragCoord.xy / u_resolution.xy;
+	vec2 ab = texture2D(u_texture, uv).rg;
+	gl_FragColor = vec4(ab, u_sample_count < 0 ? 1.0 : 0.0, 1.0);
+}
@@ -1,8 +1,35 @@
 void TextureSlot::clear() {
-	if (texture) glDeleteTextures(1, &texture);
+	if (reload) {
+		reload->release();
+		reload = nullptr;
+	}
+	volume_stream.end();
+	if (sdf_bake) {
+		sdf_bake->release();
+		sdf_bake = nullptr;
+	}
+	if (noise_bake) {
+		noise_bake->release();
+		noise_bake = nullptr;
+	}
+	if (video) {
+		video->close();
+		delete video;
+		video = nullptr;
+	}
+	if (texture) {
+		gpu_memory.untrack(GMK_TEXTURE, texture);
+		glDeleteTextures(1, &texture);
+	}
 	if (image_filepath) free(image_filepath);
 	texture = 0;
 	image_filepath = nullptr;
+	image_file_mtime = 0;
+	image_depth = 1;
+	source = TSS_FILE;
+	is_data = false;
+	residency = TR_RESIDENT;
+	dropped_level_count = 0;
 }
 
 void App::parseUniforms() {
@@ -103,6 +130,7 @@ void App::readUniformData() {
 }
 
 void App::writeUniformData() {
+	PROFILE_ZONE("uniform data save");
 	if (!shader_filepath) return;
 	size_t uniform_filepath_len = strlen(shader_filepath)+strlen(uniformdata_ext);
 	char *uniform_filepath = new char[uniform_filepath_len+1];
@@ -142,14 +170,54 @@ static const char *error_frag_src =
 	"}";
 
 void App::reloadShader() {
+	PROFILE_ZONE("shader reload");
 	loadShader(shader_filepath, /*reload*/true);
 }
 
 void App::recompileShader() {
-	compileShader(src_edit_buffer, /*recompile*/true);
+	validateAndCompileShader(src_edit_buffer, /*recompile*/true);
+}
+
+// right away on the main thread, it's a cheap token pass that mustn't wait
+// behind bakes on the job queue
+void App::validateAndCompileShader(const char *shader_src, bool recompile) {
+	if (!recompile) is_first_compile_pending = true;
+	if (validation_error_log) {
+		delete [] validation_error_log;
+		validation_error_log = nullptr;
+	}
+	char *error_log = nullptr;
+	int error_count;
+	{PROFILE_ZONE("shader validation");
+		error_count = validateGlsl(shader_src, &error_log);
+	}
+	if (error_count) {
+		validation_error_log = error_log;
+		return;
+	}
+	delete [] error_log;
+	compileShader(shader_src, /*recompile*/!is_first_compile_pending);
+	is_first_compile_pending = false;
+}
+
+void App::updateShaderValidation() {
+	// errors show up in the editor while typing
+	if (editor_validation && editor_validation->isDone()) {
+		if (editor_validation_result) editor_validation_result->release();
+		editor_validation_result = editor_validation;
+		editor_validation = nullptr;
+	}
+	if (show_src_edit_window && !editor_validation) {
+		u64 hash = hashBytes(src_edit_buffer, strlen(src_edit_buffer));
+		if (!editor_validation_result || editor_validation_result->src_hash != hash) {
+			editor_validation = new GlslValidation;
+			editor_validation->start(src_edit_buffer);
+		}
+	}
 }
 
 void App::compileShader(const char *shader_src, bool recompile) {
+	PROFILE_ZONE("shader compile");
 	// clean up error log
 	if (compile_error_log) {
 		delete [] compile_error_log;
@@ -158,6 +226,25 @@ void App::compileShader(const char *shader_src, bool recompile) {
 
 	bool is_compiled, is_linked;
 
+	// timings of the other variant don't apply to an edited source
+	u64 src_hash = hashBytes(shader_src, strlen(shader_src));
+	if (src_hash != shader_src_hash) {
+		shader_src_hash = src_hash;
+		shader_gpu_ms[0] = shader_gpu_ms[1] = 0.0f;
+	}
+	shader_timer.reset();
+	if (isRecording()) recordShaderSource(shader_src);
+
+	// the optimized source keeps the line numbers, but the original is
+	// compiled if it fails so errors aren't caused by the optimizer
+	is_shader_optimized = false;
+	if (optimize_shader) {
+		char *optimized_src = optimizeGlsl(shader_src, &optimizer_stats);
+		is_shader_optimized = shader.compileAndAttach(GL_FRAGMENT_SHADER, optimized_src) && shader.link();
+		delete [] optimized_src;
+	}
+	if (is_shader_optimized) goto shader_compiled;
+
 	// compile newly loaded shader
 	is_compiled = shader.compileAndAttach(GL_FRAGMENT_SHADER, shader_src);
 	if (!is_compiled) {
@@ -171,6 +258,10 @@ void App::compileShader(const char *shader_src, bool recompile) {
 		goto shader_compilation_failed;
 	}
 
+shader_compiled:
+	if (optimize_shader && !is_shader_optimized) LOGW("Optimized shader failed to compile, using the original source.");
+	if (heatmap.enabled) heatmap.compile(shader_src);
+
 	if (recompile) {
 		// try to migrate uniform data
 		ShaderUniform *old_uniforms = uniforms; uniforms = nullptr;
@@ -190,10 +281,16 @@ void App::compileShader(const char *shader_src, bool recompile) {
 		readUniformData();
 	}
 
+	cost_estimate.setSource(shader_src);
+	cost_estimate.update(uniforms, uniform_count);
+	metrics_server.add(MI_COMPILE_COUNT);
+
 	return; // success
 
 shader_compilation_failed:
 	assert(compile_error_log); // logically eq. to shader did not compile
+	metrics_server.add(MI_COMPILE_COUNT);
+	metrics_server.add(MI_COMPILE_ERROR_COUNT);
 
 	// use error shader
 	shader.compileAndAttach(GL_FRAGMENT_SHADER, error_frag_src);
@@ -203,6 +300,7 @@ shader_compilation_failed:
 }
 
 void App::loadShader(const char *frag_shader_filepath, bool reload) {
+	PROFILE_ZONE("shader load");
 	char *shader_src = readStringFromFile(frag_shader_filepath);
 	if (!shader_src) return; // couldn't read from file TODO: feedback
 
@@ -213,6 +311,7 @@ void App::loadShader(const char *frag_shader_filepath, bool reload) {
 		strcpy(shader_filepath, frag_shader_filepath);
 
 		addMostRecentlyUsedFilepath(shader_filepath);
+		loadBakePass();
 	}
 
 	// copy src into editor buffer
@@ -220,7 +319,7 @@ void App::loadShader(const char *frag_shader_filepath, bool reload) {
 	// zero terminate just in case so we don't overflow in writeStringToFile
 	src_edit_buffer[sizeof(src_edit_buffer)-1] = '\0';
 
-	compileShader(shader_src, /*recompile*/reload);
+	validateAndCompileShader(shader_src, /*recompile*/reload);
 
 	delete [] shader_src;
 }
@@ -318,7 +417,15 @@ void App::readPreferences() {
 
 	IniVar preferences_vars[] = {
 		{"shader_file_autoreload", INI_VAR_BOOL, &shader_file_autoreload},
-		{"single_triangle_mode", INI_VAR_BOOL, &single_triangle_mode}
+		{"texture_file_autoreload", INI_VAR_BOOL, &texture_file_autoreload},
+		{"sdf_bake_resolution", INI_VAR_INT, &sdf_bake_resolution},
+		{"single_triangle_mode", INI_VAR_BOOL, &single_triangle_mode},
+		{"texture_budget_mib", INI_VAR_INT, &texture_budget_mib},
+		{"texture_cache_mib", INI_VAR_INT, &texture_cache.max_mib},
+		{"optimize_shader", INI_VAR_BOOL, &optimize_shader},
+		{"metrics_port", INI_VAR_INT, &metrics_port},
+		{"fast_start", INI_VAR_BOOL, &fast_start},
+		{"gl_debug_context", INI_VAR_BOOL, &gl_debug_context}
 	};
 	parseIniString(preferences_str, preferences_vars, ARRAY_COUNT(preferences_vars));
 
@@ -334,25 +441,81 @@ void App::writePreferences() {
 	}
 
 	fprintf(file, "shader_file_autoreload=%d\n", shader_file_autoreload);
+	fprintf(file, "texture_file_autoreload=%d\n", texture_file_autoreload);
+	fprintf(file, "sdf_bake_resolution=%d\n", sdf_bake_resolution);
 	fprintf(file, "single_triangle_mode=%d\n", single_triangle_mode);
+	fprintf(file, "texture_budget_mib=%d\n", texture_budget_mib);
+	fprintf(file, "texture_cache_mib=%d\n", texture_cache.max_mib);
+	fprintf(file, "optimize_shader=%d\n", optimize_shader);
+	fprintf(file, "metrics_port=%d\n", metrics_port);
+	fprintf(file, "fast_start=%d\n", fast_start);
+	fprintf(file, "gl_debug_context=%d\n", gl_debug_context);
 
 	fclose(file);
 }
 
+// texture slots are stored as "2d:filepath", "cube:filepath" or "3d:filepath"
+static const char *texture_slot_ini_names[] = {
+	"texture_slot0", "texture_slot1", "texture_slot2", "texture_slot3",
+	"texture_slot4", "texture_slot5", "texture_slot6", "texture_slot7"
+};
+
+static const char *getTextureSlotIniPrefix(GLenum target) {
+	switch (target) {
+		case GL_TEXTURE_2D: return "2d:";
+		case GL_TEXTURE_CUBE_MAP: return "cube:";
+		case GL_TEXTURE_3D: return "3d:";
+		default: return nullptr;
+	}
+}
+
+static const char *getTextureSlotIniPrefix(TextureSlot *texture_slot) {
+	switch (texture_slot->source) {
+		case TSS_FILE: return getTextureSlotIniPrefix(texture_slot->target);
+		case TSS_VIDEO: return "video:";
+		default: return nullptr; // bakes and audio aren't restored from a file
+	}
+}
+
+// "prefix:filepath" as written by writeSession, the texture is loaded later
+static void setTextureSlotFromIniString(TextureSlot *texture_slot, const char *texture_slot_str) {
+	const char *filepath = strchr(texture_slot_str, ':');
+	if (!filepath || !filepath[1]) return;
+	texture_slot->clear();
+	texture_slot->target = GL_TEXTURE_2D;
+	if (!strncmp(texture_slot_str, "cube:", 5)) texture_slot->target = GL_TEXTURE_CUBE_MAP;
+	if (!strncmp(texture_slot_str, "3d:", 3)) texture_slot->target = GL_TEXTURE_3D;
+	if (!strncmp(texture_slot_str, "video:", 6)) texture_slot->source = TSS_VIDEO;
+	texture_slot->image_filepath = (char*)malloc(strlen(filepath+1)+1);
+	strcpy(texture_slot->image_filepath, filepath+1);
+}
+
 void App::readSession() {
 	if (!session_filepath) return;
 	char *session_str = readStringFromFile(session_filepath);
 	if (!session_str) return;
 
 	char *recently_used_str = nullptr; // "filepath0","filepath1","filepath2"
-	IniVar session_vars[] = {
+	char *texture_slot_strs[ARRAY_COUNT(texture_slots)] = {};
+	IniVar session_vars[4+ARRAY_COUNT(texture_slots)] = {
 		{"recently_used", INI_VAR_STRING, &recently_used_str},
 		{"video_width", INI_VAR_INT, &video.width},
 		{ "video_height", INI_VAR_INT, &video.height },
 		{ "video_fullscreen", INI_VAR_INT, &video.fullscreen },
 	};
+	static_assert(ARRAY_COUNT(texture_slot_ini_names) == ARRAY_COUNT(texture_slots), "missing ini names");
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		session_vars[4+tsi] = {texture_slot_ini_names[tsi], INI_VAR_STRING, &texture_slot_strs[tsi]};
+	}
 	parseIniString(session_str, session_vars, ARRAY_COUNT(session_vars));
 
+	// textures are loaded in init() once there is a gl context
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		if (!texture_slot_strs[tsi]) continue;
+		setTextureSlotFromIniString(texture_slots + tsi, texture_slot_strs[tsi]);
+		delete [] texture_slot_strs[tsi];
+	}
+
 	if (recently_used_str) {
 		// free old stuff
 		clearRecentlyUsedFilepaths();
@@ -401,6 +564,13 @@ void App::writeSession() {
 	fprintf(file, "video_width=%d\n", video.width);
 	fprintf(file, "video_height=%d\n", video.height);
 	fprintf(file, "video_fullscreen=%d\n", video.fullscreen);
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		const char *prefix = getTextureSlotIniPrefix(texture_slot);
+		if (texture_slot->image_filepath && prefix) {
+			fprintf(file, "%s=%s%s\n", texture_slot_ini_names[tsi], prefix, texture_slot->image_filepath);
+		}
+	}
 
 	fclose(file);
 }
@@ -422,9 +592,11 @@ void App::newShader() {
 	}
 	strcpy(src_edit_buffer, shader_src_template);
 	recompileShader();
+	loadBakePass();
 }
 
 void App::openShaderDialog() {
+	PROFILE_ZONE("file dialog");
 	char *out_filepath = nullptr;
 	nfdresult_t result = NFD_OpenDialog("frag,glsl,fsh,txt", nullptr, &out_filepath);
 	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
@@ -440,6 +612,7 @@ void App::openShaderDialog() {
 }
 
 void App::saveShaderDialog() {
+	PROFILE_ZONE("file dialog");
 	char *out_filepath = nullptr;
 	nfdresult_t result = NFD_SaveDialog("frag,glsl,fsh,txt", nullptr, &out_filepath);
 	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
@@ -447,6 +620,7 @@ void App::saveShaderDialog() {
 	if (result == NFD_OKAY) {
 		if (shader_filepath) free(shader_filepath);
 		shader_filepath = out_filepath;
+		loadBakePass();
 
 		writeStringToFile(shader_filepath, src_edit_buffer);
 		struct stat attr;
@@ -456,66 +630,438 @@ void App::saveShaderDialog() {
 	}
 }
 
+void App::exportTraceDialog() {
+	PROFILE_ZONE("file dialog");
+	char *out_filepath = nullptr;
+	nfdresult_t result = NFD_SaveDialog("json", nullptr, &out_filepath);
+	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
+	if (result == NFD_OKAY) {
+		profiler.exportChromeTrace(out_filepath);
+		free(out_filepath);
+	}
+}
+
+void App::dumpHitchesDialog() {
+	PROFILE_ZONE("file dialog");
+	char *out_filepath = nullptr;
+	nfdresult_t result = NFD_SaveDialog("txt", nullptr, &out_filepath);
+	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
+	if (result == NFD_OKAY) {
+		hitch_detector.dump(out_filepath);
+		free(out_filepath);
+	}
+}
+
 void App::saveShader() {
 	if (!shader_filepath) return;
 	writeStringToFile(shader_filepath, src_edit_buffer);
 }
 
+void App::toggleHeatmap() {
+	heatmap.enabled = !heatmap.enabled;
+	if (heatmap.enabled) heatmap.compile(src_edit_buffer);
+	else heatmap.release();
+}
+
 void App::toggleWindow(int window_index) {
 	switch (window_index) {
 		case 0: show_uniforms_window = !show_uniforms_window; break;
 		case 1: show_textures_window = !show_textures_window; break;
 		case 2: show_camera_window = !show_camera_window; break;
 		case 3: show_src_edit_window = !show_src_edit_window; break;
+		case 4: show_memory_window = !show_memory_window; break;
+		case 5: show_cost_window = !show_cost_window; break;
+		case 6: show_hitch_window = !show_hitch_window; break;
+		case 7: show_gl_debug_window = !show_gl_debug_window; break;
 		default: assert(!"invalid window_index");
 	}
 }
 
-void App::openImageDialog(TextureSlot *texture_slot, bool load_cube_cross) {
+bool App::loadTextureSlot(TextureSlot *texture_slot, const char *image_filepath, GLenum target) {
+	PROFILE_ZONE("texture load");
+	int out_width, out_height, out_depth = 1;
+	GLuint loaded_texture = 0;
+	VolumeStream volume_stream;
+	MeshSdfBake *sdf_bake = nullptr;
+	DataTextureInfo data_info;
+	bool is_data = false;
+	if (target == GL_TEXTURE_3D && isMeshFile(image_filepath)) {
+		sdf_bake = new MeshSdfBake;
+		if (!sdf_bake->start(image_filepath, texture_cache.dirpath, sdf_bake_resolution)) {
+			sdf_bake->release();
+			return false;
+		}
+		if (SDL_AtomicGet(&sdf_bake->state) == MSBS_BAKED) { // cached
+			volume_stream.begin(sdf_bake->volume_filepath, &loaded_texture);
+			sdf_bake->release();
+			sdf_bake = nullptr;
+			if (!loaded_texture) return false;
+		}
+		out_width = out_height = out_depth = sdf_bake_resolution;
+	} else if (target == GL_TEXTURE_3D) { // texels arrive over the next frames
+		if (volume_stream.begin(image_filepath, &loaded_texture)) {
+			out_width = volume_stream.info.width;
+			out_height = volume_stream.info.height;
+			out_depth = volume_stream.info.depth;
+			if (isNoiseFile(image_filepath)) { // tiles
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+			}
+		}
+	} else if (target == GL_TEXTURE_2D && isDataFile(image_filepath)) {
+		loaded_texture = loadDataTexture(image_filepath, &data_info);
+		out_width = data_info.width;
+		out_height = data_info.height;
+		is_data = true;
+	} else if (target == GL_TEXTURE_2D && isVolumeFile(image_filepath)) { // single slice
+		loaded_texture = loadVolumeTexture2D(image_filepath, &out_width, &out_height);
+	} else if (isCompressedTextureFile(image_filepath)) { // target comes from the file
+		loaded_texture = loadTextureCompressed(image_filepath, &target, &out_width, &out_height);
+	} else {
+		loaded_texture = texture_cache.loadTexture(image_filepath, target, &out_width, &out_height);
+	}
+	if (!loaded_texture && !sdf_bake) return false;
+
+	// copy first in case image_filepath is the slot's own path
+	char *filepath = (char*)malloc(strlen(image_filepath)+1);
+	strcpy(filepath, image_filepath);
+	texture_slot->clear();
+
+	texture_slot->target = target;
+	if (target == GL_TEXTURE_2D && is_data) setWrapTexture2D(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	else if (target == GL_TEXTURE_2D) setWrapTexture2D(GL_REPEAT, GL_REPEAT);
+	texture_slot->is_data = is_data;
+	texture_slot->data_info = data_info;
+	texture_slot->texture = loaded_texture;
+	texture_slot->image_width = out_width;
+	texture_slot->image_height = out_height;
+	texture_slot->image_depth = out_depth;
+	texture_slot->image_filepath = filepath;
+	texture_slot->volume_stream = volume_stream; // slot takes over the stream
+	texture_slot->sdf_bake = sdf_bake;
+	if (loaded_texture) gpu_memory.trackTexture(loaded_texture, target);
+	struct stat attr;
+	if (!stat(filepath, &attr)) texture_slot->image_file_mtime = (int)attr.st_mtime;
+	return true;
+}
+
+void App::updateTextureSlots() {
+	PROFILE_ZONE("texture slots");
+	// stream volume slices, bounded per frame to keep frame times and memory in check
+	const size_t volume_upload_budget = 32 << 20; // 32 MiB
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		if (texture_slot->sdf_bake) {
+			int state = SDL_AtomicGet(&texture_slot->sdf_bake->state);
+			if (state == MSBS_BAKED) {
+				texture_slot->volume_stream.begin(texture_slot->sdf_bake->volume_filepath, &texture_slot->texture);
+				gpu_memory.trackTexture(texture_slot->texture, texture_slot->target);
+			} else if (state == MSBS_FAILED) {
+				LOGW("Could not bake SDF of '%s'.", texture_slot->image_filepath);
+			}
+			if (state != MSBS_BAKING) {
+				texture_slot->sdf_bake->release();
+				texture_slot->sdf_bake = nullptr;
+			}
+		}
+		if (texture_slot->noise_bake) {
+			int state = SDL_AtomicGet(&texture_slot->noise_bake->state);
+			if (state == NBS_FAILED) {
+				LOGW("Could not generate noise '%s'.", texture_slot->image_filepath);
+				texture_slot->noise_bake->release();
+				texture_slot->noise_bake = nullptr;
+			} else if (state == NBS_BAKED) {
+				texture_slot->noise_bake->release();
+				texture_slot->noise_bake = nullptr;
+				loadTextureSlot(texture_slot, texture_slot->image_filepath, texture_slot->target);
+			}
+		}
+		texture_slot->volume_stream.update(volume_upload_budget);
+		if (texture_slot->video) {
+			// benchmarks and replays show the frame of u_time, not whichever one is decoded by then
+			if (is_benchmarking || isReplaying()) texture_slot->video->wait_for_frames = true;
+			texture_slot->video->update(texture_slot->texture, u_time);
+		}
+	}
+}
+
+void App::applyDataUniforms(Shader *target_shader) {
+	char name[32];
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		if (!texture_slot->is_data) continue;
+		DataTextureInfo *info = &texture_slot->data_info;
+		snprintf(name, sizeof(name), "u_data%d_size", tsi);
+		glUniform4f(target_shader->getUniformLocation(name), (float)info->width, (float)info->height,
+			(float)info->record_count, (float)info->column_count);
+		snprintf(name, sizeof(name), "u_data%d_min", tsi);
+		glUniform4fv(target_shader->getUniformLocation(name), 1, info->min);
+		snprintf(name, sizeof(name), "u_data%d_max", tsi);
+		glUniform4fv(target_shader->getUniformLocation(name), 1, info->max);
+	}
+}
+
+bool App::shrinkTextureSlot(TextureSlot *texture_slot) {
+	// cheaper to bring back than an eviction: stays sampleable at a lower resolution
+	int long_side = texture_slot->image_width > texture_slot->image_height
+		? texture_slot->image_width : texture_slot->image_height;
+	if ((texture_slot->target == GL_TEXTURE_2D || texture_slot->target == GL_TEXTURE_CUBE_MAP)
+		&& !texture_slot->is_data && (long_side >> (texture_slot->dropped_level_count+1)) >= 64) {
+		GLuint texture = texture_slot->texture;
+		if (dropTopMipLevel(&texture, texture_slot->target)) {
+			gpu_memory.untrack(GMK_TEXTURE, texture_slot->texture);
+			gpu_memory.trackTexture(texture, texture_slot->target);
+			texture_slot->texture = texture;
+			texture_slot->residency = TR_DOWNSCALED;
+			texture_slot->dropped_level_count++;
+			return true;
+		}
+	}
+
+	gpu_memory.untrack(GMK_TEXTURE, texture_slot->texture);
+	glDeleteTextures(1, &texture_slot->texture);
+	texture_slot->texture = 0;
+	texture_slot->residency = TR_EVICTED;
+	texture_slot->dropped_level_count = 0;
+	return true;
+}
+
+void App::updateTextureResidency() {
+	// without a compiled shader no slot is sampled and all would look unused
+	if (compile_error_log) return;
+	update_count++;
+
+	// slots referenced by the sampler uniforms of the current shader
+	for (int i = 0; i < uniform_count; i++) {
+		ShaderUniform *uniform = uniforms + i;
+		if (uniform->type != GL_SAMPLER_2D && uniform->type != GL_SAMPLER_3D
+			&& uniform->type != GL_SAMPLER_CUBE) continue;
+		for (int e = 0; e < uniform->size; e++) {
+			int unit = ((int*)uniform->data)[e];
+			if (unit >= 0 && unit < (int)ARRAY_COUNT(texture_slots)) {
+				texture_slots[unit].last_sampled_update = update_count;
+			}
+		}
+	}
+
+	// reload shrunk slots on demand, cached images come back without a decode
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		if (texture_slot->residency == TR_RESIDENT || texture_slot->last_sampled_update != update_count) continue;
+		if (!loadTextureSlot(texture_slot, texture_slot->image_filepath, texture_slot->target)) {
+			LOGW("Could not reload evicted texture '%s'.", texture_slot->image_filepath);
+			texture_slot->residency = TR_RESIDENT; // don't try again every frame
+		}
+	}
+
+	if (!texture_budget_mib) return;
+	size_t budget = (size_t)texture_budget_mib << 20;
+	while (gpu_memory.getTotalBytes() > budget) {
+		// least recently sampled slot that can be restored from its file
+		TextureSlot *lru_slot = nullptr;
+		for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+			TextureSlot *texture_slot = texture_slots + tsi;
+			if (!texture_slot->texture || !texture_slot->image_filepath) continue;
+			if (texture_slot->source != TSS_FILE || texture_slot->last_sampled_update == update_count) continue;
+			if (texture_slot->sdf_bake || texture_slot->noise_bake || texture_slot->volume_stream.isStreaming()) continue;
+			if (texture_slot->reload) continue;
+			if (!lru_slot || texture_slot->last_sampled_update < lru_slot->last_sampled_update) lru_slot = texture_slot;
+		}
+		if (!lru_slot) break; // everything left is in use
+		shrinkTextureSlot(lru_slot);
+		// a dropped level is read back synchronously, one per frame, the next frame continues
+		if (lru_slot->residency == TR_DOWNSCALED) break;
+	}
+}
+
+bool App::loadVideoSlot(TextureSlot *texture_slot, const char *video_filepath) {
+	VideoStream *video = new VideoStream;
+	GLuint texture;
+	if (!video->open(video_filepath, &texture)) {
+		delete video;
+		return false;
+	}
+	char *filepath = (char*)malloc(strlen(video_filepath)+1); // may be the slot's own path
+	strcpy(filepath, video_filepath);
+	texture_slot->clear();
+	texture_slot->target = GL_TEXTURE_2D;
+	texture_slot->texture = texture;
+	texture_slot->source = TSS_VIDEO;
+	texture_slot->video = video;
+	texture_slot->image_width = video->width;
+	texture_slot->image_height = video->height;
+	texture_slot->image_filepath = filepath;
+	gpu_memory.trackTexture(texture, GL_TEXTURE_2D);
+	return true;
+}
+
+void App::openVideoDialog(TextureSlot *texture_slot) {
+	PROFILE_ZONE("file dialog");
 	char *out_filepath = nullptr;
-	nfdresult_t result = NFD_OpenDialog("tga,png,bmp,jpg,hdr", nullptr, &out_filepath);
+	nfdresult_t result = NFD_OpenDialog("y4m,png,jpg,tga,bmp", nullptr, &out_filepath);
 	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
 
 	if (result == NFD_OKAY) {
-		if (load_cube_cross) {
-			int out_size;
-			GLuint loaded_texture_cube = loadTextureCubeCross(out_filepath,
-				/*build_mipmaps*/true, &out_size);
-			if (loaded_texture_cube) {
-				texture_slot->clear();
+		loadVideoSlot(texture_slot, out_filepath);
+		free(out_filepath);
+	}
+}
 
-				texture_slot->target = GL_TEXTURE_CUBE_MAP;
-				texture_slot->texture = loaded_texture_cube;
-				texture_slot->image_width = out_size;
-				texture_slot->image_height = out_size;
-				texture_slot->image_filepath = out_filepath;
-			}
-		} else {
-			int out_width, out_height;
-			GLuint loaded_texture = loadTexture2D(out_filepath,
-				/*build_mipmaps*/true, &out_width, &out_height);
-			if (loaded_texture) { // loading successful
-				texture_slot->clear();
+void App::generateNoiseSlot(TextureSlot *texture_slot, const NoiseParams &params) {
+	NoiseBake *noise_bake = new NoiseBake;
+	noise_bake->start(params, texture_cache.dirpath);
+	GLenum target = noise_bake->params.dimensions == 3 ? GL_TEXTURE_3D : GL_TEXTURE_2D;
+	if (SDL_AtomicGet(&noise_bake->state) == NBS_BAKED) { // cached
+		loadTextureSlot(texture_slot, noise_bake->volume_filepath, target);
+		noise_bake->release();
+		return;
+	}
 
-				texture_slot->target = GL_TEXTURE_2D;
-				setWrapTexture2D(GL_REPEAT, GL_REPEAT);
-				texture_slot->texture = loaded_texture;
-				texture_slot->image_width = out_width;
-				texture_slot->image_height = out_height;
-				texture_slot->image_filepath = out_filepath;
+	// the slot stays empty until the job has written the file
+	texture_slot->clear();
+	texture_slot->target = target;
+	texture_slot->image_filepath = (char*)malloc(strlen(noise_bake->volume_filepath)+1);
+	strcpy(texture_slot->image_filepath, noise_bake->volume_filepath);
+	texture_slot->image_width = texture_slot->image_height = noise_bake->params.size;
+	texture_slot->image_depth = target == GL_TEXTURE_3D ? noise_bake->params.size : 1;
+	texture_slot->noise_bake = noise_bake;
+}
+
+void App::loadBakePass() {
+	// results of the previous project's bake pass are stale
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		if (texture_slots[tsi].source == TSS_BAKE) texture_slots[tsi].clear();
+	}
+	if (shader_filepath) bake_pass.load(shader_filepath);
+	else bake_pass.unload();
+}
+
+void App::updateBakePass() {
+	if (shader_file_autoreload && (frame_count % 60) == 0) bake_pass.checkFile();
+
+	TextureSlot *texture_slot = texture_slots + bake_pass.slot;
+	GLuint texture = texture_slot->source == TSS_BAKE ? texture_slot->texture : 0;
+	if (!bake_pass.update(&texture, uniforms, uniform_count, single_triangle_vbo)) return;
+
+	if (texture_slot->texture != texture) { // the slot takes over the texture
+		texture_slot->clear();
+		texture_slot->target = GL_TEXTURE_2D;
+		texture_slot->texture = texture;
+		texture_slot->source = TSS_BAKE;
+		texture_slot->image_filepath = (char*)malloc(strlen(bake_pass.filepath)+1);
+		strcpy(texture_slot->image_filepath, bake_pass.filepath);
+	}
+	texture_slot->image_width = bake_pass.width;
+	texture_slot->image_height = bake_pass.height;
+	gpu_memory.trackTexture(texture, GL_TEXTURE_2D); // size or format may have changed
+}
+
+void App::updateAudioSlot(float delta_time) {
+	TextureSlot *texture_slot = texture_slots + audio_slot;
+	GLuint texture = texture_slot->source == TSS_AUDIO ? texture_slot->texture : 0;
+	if (!audio_spectrum.update(&texture, delta_time)) return;
+
+	if (texture_slot->texture != texture) { // the slot takes over the texture
+		const char *name = audio_spectrum.filepath ? audio_spectrum.filepath : "audio capture";
+		texture_slot->clear();
+		texture_slot->target = GL_TEXTURE_2D;
+		texture_slot->texture = texture;
+		texture_slot->source = TSS_AUDIO;
+		texture_slot->image_width = audio_texture_width;
+		texture_slot->image_height = 2;
+		texture_slot->image_filepath = (char*)malloc(strlen(name)+1);
+		strcpy(texture_slot->image_filepath, name);
+		gpu_memory.trackTexture(texture, GL_TEXTURE_2D);
+	}
+}
+
+void App::openAudioDialog() {
+	PROFILE_ZONE("file dialog");
+	char *out_filepath = nullptr;
+	nfdresult_t result = NFD_OpenDialog("wav", nullptr, &out_filepath);
+	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
+
+	if (result == NFD_OKAY) {
+		audio_spectrum.openFile(out_filepath);
+		free(out_filepath);
+	}
+}
+
+void App::autoreloadTextures(bool check_files) {
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		if (texture_slot->reload) {
+			switch (SDL_AtomicGet(&texture_slot->reload->state)) {
+				case TRS_DECODED:
+					texture_slot->reload->upload(texture_slot->texture,
+						&texture_slot->image_width, &texture_slot->image_height);
+					texture_slot->reload->release();
+					texture_slot->reload = nullptr;
+					gpu_memory.trackTexture(texture_slot->texture, texture_slot->target);
+					break;
+				case TRS_FAILED:
+					LOGW("Could not reload '%s'.", texture_slot->image_filepath);
+					texture_slot->reload->release();
+					texture_slot->reload = nullptr;
+					break;
+				default: break; // still decoding
 			}
+			continue;
+		}
+
+		if (!check_files || !texture_slot->image_filepath || texture_slot->noise_bake) continue;
+		if (texture_slot->source != TSS_FILE) continue; // not loaded from image_filepath
+		if (texture_slot->residency != TR_RESIDENT) continue; // reloaded from the file once sampled
+		struct stat attr;
+		if (stat(texture_slot->image_filepath, &attr)) continue; // file doesn't exist (anymore)
+		if (attr.st_mtime <= texture_slot->image_file_mtime) continue; // not modified
+		texture_slot->image_file_mtime = (int)attr.st_mtime;
+		if (texture_slot->target == GL_TEXTURE_2D && !isCompressedTextureFile(texture_slot->image_filepath)
+			&& !isVolumeFile(texture_slot->image_filepath) && !isDataFile(texture_slot->image_filepath)) {
+			texture_slot->reload = new TextureReload;
+			texture_slot->reload->start(texture_slot->image_filepath);
+		} else { // cube crosses, compressed files and volumes are loaded on the main thread
+			loadTextureSlot(texture_slot, texture_slot->image_filepath, texture_slot->target);
 		}
 	}
 }
 
+void App::openImageDialog(TextureSlot *texture_slot, GLenum target) {
+	PROFILE_ZONE("file dialog");
+	const char *filter_list = target == GL_TEXTURE_3D ? "raw,vol,obj,mdl" : "tga,png,bmp,jpg,hdr,dds,ktx,csv,f32";
+	char *out_filepath = nullptr;
+	nfdresult_t result = NFD_OpenDialog(filter_list, nullptr, &out_filepath);
+	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
+
+	if (result == NFD_OKAY) {
+		loadTextureSlot(texture_slot, out_filepath, target);
+		free(out_filepath);
+	}
+}
+
 void App::resetCamera() {
 	camera_location = v3(0.0f);
 	camera_euler_angles = v3(0.0f, 0.0f, 0.0f);
 }
 
+void App::prefetchTextureSlots() {
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		const char *filepath = texture_slot->image_filepath;
+		if (!filepath || texture_slot->texture || texture_slot->source != TSS_FILE) continue;
+		// only what loadTextureSlot hands to the texture cache
+		if (texture_slot->target == GL_TEXTURE_3D || isDataFile(filepath)
+			|| isVolumeFile(filepath) || isCompressedTextureFile(filepath)) continue;
+		texture_cache.prefetch(filepath, texture_slot->target);
+	}
+}
+
 void App::init() {
 	quit = false;
 
+	gl_debug.init(gl_debug_context); // before anything else touches gl
+
 	resetCamera();
 
 	static vec2 single_triangle_positions[4] = {
@@ -537,6 +1083,8 @@ void App::init() {
 	glBindBuffer(GL_ARRAY_BUFFER, two_triangles_vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(two_triangles_positions), two_triangles_positions, GL_STATIC_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	gpu_memory.track(GMK_BUFFER, single_triangle_vbo, sizeof(single_triangle_positions));
+	gpu_memory.track(GMK_BUFFER, two_triangles_vbo, sizeof(two_triangles_positions));
 
 	const char *vert_src =
 		"attribute vec4 va_position;"
@@ -548,6 +1096,23 @@ void App::init() {
 	shader.bindVertexAttrib("va_position", VAT_POSITION);
 	shader.link();
 
+	if (metrics_port) metrics_server.start(metrics_port);
+
+	// restore texture slots from the session or the replay
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		if (texture_slot->image_filepath && !texture_slot->texture) {
+			bool loaded = texture_slot->source == TSS_VIDEO
+				? loadVideoSlot(texture_slot, texture_slot->image_filepath)
+				: loadTextureSlot(texture_slot, texture_slot->image_filepath, texture_slot->target);
+			if (!loaded) {
+				LOGW("Could not restore texture '%s'.", texture_slot->image_filepath);
+				texture_slot->clear();
+			}
+		}
+	}
+	texture_cache.finishPrefetches();
+
 	// set imgui style
 	ImGuiStyle& style = ImGui::GetStyle();
 	style.WindowRounding = 3.0f;
@@ -630,6 +1195,10 @@ void App::gui() {
 				shader_file_autoreload = !shader_file_autoreload;
 				writePreferences();
 			}
+			if (ImGui::MenuItem("Autoreload Textures", nullptr, texture_file_autoreload)) {
+				texture_file_autoreload = !texture_file_autoreload;
+				writePreferences();
+			}
 			if (ImGui::MenuItem("Save", io.OSXBehaviors ? "Cmd+S" : "Ctrl+S", false, !!shader_filepath)) {
 				saveShader();
 			}
@@ -662,12 +1231,31 @@ void App::gui() {
 			if (ImGui::MenuItem("Reset Camera")) {
 				resetCamera();
 			}
+			ImGui::Separator();
+			if (ImGui::MenuItem("Cost Heatmap", nullptr, heatmap.enabled, !!src_edit_buffer[0])) {
+				toggleHeatmap();
+			}
 			ImGui::EndMenu();
 		}
 if (ImGui::BeginMenu("Tools")) {
 	if (ImGui::MenuItem("Recompile Shader", io.OSXBehaviors ? "Cmd+B" : "Ctrl+B", false, !!src_edit_buffer[0])) {
 		recompileShader();
 	}
+	ImGui::Separator();
+	if (isRecording()) {
+		char label[64];
+		snprintf(label, sizeof(label), "Stop Recording (%d frames)", recorded_frame_count);
+		if (ImGui::MenuItem(label)) stopRecording();
+	} else if (ImGui::MenuItem("Record Replay...", nullptr, false, !isReplaying())) {
+		recordReplayDialog();
+	}
+	ImGui::Separator();
+	if (ImGui::MenuItem("Profile Zones", nullptr, profiler.isEnabled())) {
+		profiler.setEnabled(!profiler.isEnabled());
+	}
+	if (ImGui::MenuItem("Export Trace...")) {
+		exportTraceDialog();
+	}
 	ImGui::EndMenu();
 }
 if (ImGui::BeginMenu("Window")) {
@@ -685,6 +1273,18 @@ if (ImGui::BeginMenu("Window")) {
 	if (ImGui::MenuItem("Source editor", io.OSXBehaviors ? "Cmd+4" : "Ctrl+4", show_src_edit_window)) {
 		show_src_edit_window = !show_src_edit_window;
 	}
+	if (ImGui::MenuItem("GPU Memory", io.OSXBehaviors ? "Cmd+5" : "Ctrl+5", show_memory_window)) {
+		show_memory_window = !show_memory_window;
+	}
+	if (ImGui::MenuItem("Shader Cost", io.OSXBehaviors ? "Cmd+6" : "Ctrl+6", show_cost_window)) {
+		show_cost_window = !show_cost_window;
+	}
+	if (ImGui::MenuItem("Hitches", io.OSXBehaviors ? "Cmd+7" : "Ctrl+7", show_hitch_window)) {
+		show_hitch_window = !show_hitch_window;
+	}
+	if (ImGui::MenuItem("GL Debug", io.OSXBehaviors ? "Cmd+8" : "Ctrl+8", show_gl_debug_window)) {
+		show_gl_debug_window = !show_gl_debug_window;
+	}
 	ImGui::EndMenu();
 }
 ImGui::EndMainMenuBar();
@@ -720,6 +1320,7 @@ ImGui::EndMainMenuBar();
 					if (!strcmp(u_resolution_name, uniforms[i].name)) continue;
 					if (!strcmp(u_view_to_world_name, uniforms[i].name)) continue;
 					if (!strcmp(u_world_to_view_name, uniforms[i].name)) continue;
+					if (!strncmp("u_data", uniforms[i].name, 6) && uniforms[i].name[6] >= '0' && uniforms[i].name[6] <= '9') continue; // set from data textures
 					uniforms[i].gui();
 				}
 			}
@@ -729,6 +1330,95 @@ ImGui::EndMainMenuBar();
 
 	if (show_textures_window) {
 		if (ImGui::Begin("Textures", &show_textures_window)) {
+			if (ImGui::CollapsingHeader("Mesh SDF")) {
+				if (ImGui::InputInt("Resolution", &sdf_bake_resolution, 16, 64)) {
+					if (sdf_bake_resolution < 8) sdf_bake_resolution = 8;
+					if (sdf_bake_resolution > 512) sdf_bake_resolution = 512;
+					writePreferences();
+				}
+				if (ImGui::IsItemHovered()) {
+					ImGui::SetTooltip("Grid size for meshes (obj, mdl) loaded into 3D slots.\n"
+						"The mesh is fit into [-1, 1]^3, sample with texture3D(tex, 0.5*p + 0.5).r");
+				}
+			}
+			if (ImGui::CollapsingHeader("Noise")) {
+				ImGui::Combo("Type", &noise_params.type, noise_type_names, NT_COUNT);
+				if (noise_params.type != NT_BLUE) {
+					ImGui::RadioButton("2D", &noise_params.dimensions, 2); ImGui::SameLine();
+					ImGui::RadioButton("3D", &noise_params.dimensions, 3);
+				}
+				ImGui::InputInt("Size", &noise_params.size, 16, 64);
+				if (ImGui::IsItemHovered() && noise_params.type == NT_BLUE) {
+					ImGui::SetTooltip("Void-and-cluster is O(n^2), sizes above 128 take a while.");
+				}
+				if (noise_params.type != NT_BLUE) {
+					ImGui::InputInt("Period", &noise_params.period);
+					if (ImGui::IsItemHovered()) ImGui::SetTooltip("Lattice cells across the tile");
+					if (noise_params.type != NT_WORLEY) ImGui::SliderInt("Octaves", &noise_params.octaves, 1, 8);
+				}
+				int seed = (int)noise_params.seed;
+				if (ImGui::InputInt("Seed", &seed)) noise_params.seed = (u32)seed;
+				ImGui::SliderInt("Slot", &noise_target_slot, 0, ARRAY_COUNT(texture_slots)-1);
+				if (ImGui::Button("Generate")) {
+					generateNoiseSlot(texture_slots + noise_target_slot, noise_params);
+				}
+			}
+			if (ImGui::CollapsingHeader("Audio")) {
+				if (ImGui::Button("Open WAV...")) openAudioDialog();
+				ImGui::SameLine();
+				if (ImGui::Button("Capture")) audio_spectrum.openCapture();
+				ImGui::SameLine();
+				if (ImGui::Button("Stop")) {
+					audio_spectrum.close();
+					if (texture_slots[audio_slot].source == TSS_AUDIO) texture_slots[audio_slot].clear();
+				}
+				if (ImGui::SliderInt("Slot##audio", &audio_slot, 0, ARRAY_COUNT(texture_slots)-1)) {
+					for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+						if (texture_slots[tsi].source == TSS_AUDIO) texture_slots[tsi].clear();
+					}
+				}
+				if (ImGui::IsItemHovered()) {
+					ImGui::SetTooltip("512x2: spectrum at y = 0.25, waveform at y = 0.75");
+				}
+				if (audio_spectrum.isOpen()) {
+					ImGui::Text("%s", audio_spectrum.filepath ? audio_spectrum.filepath : "capture device");
+					ImGui::Text("audio to photon: %.1f ms", audio_spectrum.latency_ms);
+					ImGui::Text("dropped frames: %d", SDL_AtomicGet(&audio_spectrum.dropped_frame_count));
+				}
+			}
+			bool has_video = false;
+			for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) has_video |= !!texture_slots[tsi].video;
+			if (has_video && ImGui::CollapsingHeader("Video")) {
+				for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+					VideoStream *video = texture_slots[tsi].video;
+					if (!video) continue;
+					ImGui::PushID(tsi);
+					ImGui::Text("%d: frame %d/%d", tsi, video->shown_sequence % video->frame_count, video->frame_count);
+					ImGui::SameLine();
+					ImGui::Text("dropped %d late %d", video->dropped_frame_count, video->late_frame_count);
+					ImGui::DragFloat("fps", &video->fps, 0.1f, 1.0f, 240.0f);
+					ImGui::Checkbox("Wait for frames", &video->wait_for_frames);
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("Block until the frame for u_time is decoded,\nfor offline rendering");
+					}
+					ImGui::PopID();
+				}
+			}
+			if (bake_pass.isLoaded() && ImGui::CollapsingHeader("Bake Pass")) {
+				ImGui::TextWrapped("%s", bake_pass.filepath);
+				ImGui::Text("%dx%d %s -> slot %d", bake_pass.width, bake_pass.height,
+					bake_pass.full_float ? "rgba32f" : "rgba16f", bake_pass.slot);
+				if (bake_pass.compile_error_log) {
+					ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", bake_pass.compile_error_log);
+				} else {
+					ImGui::Text("baked %d times, last took %.2f ms", bake_pass.bake_count, bake_pass.bake_ms);
+					if (bake_pass.gpu_timer.isSupported() && bake_pass.gpu_timer.last_milliseconds > 0.0f) {
+						ImGui::SameLine();
+						ImGui::Text("(GPU %.2f ms)", bake_pass.gpu_timer.last_milliseconds);
+					}
+				}
+				if (ImGui::Button("Rebake")) bake_pass.invalidate();
+			}
 			ImGui::Columns(2);
 			for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
 				TextureSlot *texture_slot = texture_slots + tsi;
@@ -743,7 +1433,12 @@ ImGui::EndMainMenuBar();
 				if (ImGui::SmallButton("x")) texture_slot->clear();
 				ImGui::PopStyleColor(3);
 				if (ImGui::Button(" 2D ")) openImageDialog(texture_slot);
-				if (ImGui::Button("Cube")) openImageDialog(texture_slot, /*load_cube_cross*/true);
+				ImGui::SameLine();
+				if (ImGui::Button(" 3D ")) openImageDialog(texture_slot, GL_TEXTURE_3D);
+				if (ImGui::Button("Cube")) openImageDialog(texture_slot, GL_TEXTURE_CUBE_MAP);
+				ImGui::SameLine();
+				if (ImGui::Button("Vid")) openVideoDialog(texture_slot);
+				if (ImGui::IsItemHovered()) ImGui::SetTooltip("y4m video or an image of a numbered sequence");
 				ImGui::PopID();
 				ImGui::EndGroup();
 
@@ -751,8 +1446,23 @@ ImGui::EndMainMenuBar();
 				//ImTextureID im_tex_id = (ImTextureID)(intptr_t)texture_slot->texture;
 				ImGui::Image((void*)texture_slot, ImVec2(64, 64));
 				if (ImGui::IsItemHovered() && texture_slot->image_filepath) {
-					ImGui::SetTooltip("%s\n%dx%d", texture_slot->image_filepath,
-						texture_slot->image_width, texture_slot->image_height);
+					if (texture_slot->target == GL_TEXTURE_3D) {
+						ImGui::SetTooltip("%s\n%dx%dx%d", texture_slot->image_filepath,
+							texture_slot->image_width, texture_slot->image_height, texture_slot->image_depth);
+					} else {
+						ImGui::SetTooltip("%s\n%dx%d", texture_slot->image_filepath,
+							texture_slot->image_width, texture_slot->image_height);
+					}
+				}
+				if (texture_slot->sdf_bake) {
+					ImGui::SameLine();
+					ImGui::ProgressBar(texture_slot->sdf_bake->getProgress(), ImVec2(64, 0), "baking");
+				} else if (texture_slot->noise_bake) {
+					ImGui::SameLine();
+					ImGui::ProgressBar(texture_slot->noise_bake->getProgress(), ImVec2(64, 0), "noise");
+				} else if (texture_slot->volume_stream.isStreaming()) {
+					ImGui::SameLine();
+					ImGui::ProgressBar(texture_slot->volume_stream.getProgress(), ImVec2(64, 0));
 				}
 
 				if ((tsi & 1) && tsi + 1 != ARRAY_COUNT(texture_slots)) {
@@ -781,6 +1491,10 @@ ImGui::EndMainMenuBar();
 
 	if (show_src_edit_window) {
 		if (ImGui::Begin("Source editor", &show_src_edit_window)) {
+			GlslValidation *result = editor_validation_result;
+			if (result && result->error_count) {
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", result->error_log);
+			}
 			// TODO: add horizontal scrollbar
 			ImGui::InputTextMultiline("##Text buffer", src_edit_buffer, sizeof(src_edit_buffer)-1,
 				/*fullwidth, fullheight*/ImVec2(-1.0f, -1.0f), ImGuiInputTextFlags_AllowTabInput);
@@ -788,6 +1502,242 @@ ImGui::EndMainMenuBar();
 		ImGui::End();
 	}
 
+	if (show_memory_window) {
+		if (ImGui::Begin("GPU Memory", &show_memory_window)) {
+			const float mib = 1.0f/(1 << 20);
+			for (int kind = 0; kind < GMK_COUNT; kind++) {
+				ImGui::Text("%-12s %3d %9.2f MiB", gpu_memory_kind_names[kind],
+					gpu_memory.counts[kind], mib*gpu_memory.bytes[kind]);
+			}
+			size_t total_bytes = gpu_memory.getTotalBytes();
+			ImGui::Text("%-16s %9.2f MiB", "Total", mib*total_bytes);
+			ImGui::Text("%-16s %9.2f MiB", "Peak", mib*gpu_memory.peak_bytes);
+			int free_kib = queryGpuFreeMemoryKiB();
+			if (free_kib >= 0) ImGui::Text("%-16s %9.2f MiB", "Driver free", free_kib/1024.0f);
+			ImGui::Separator();
+
+			if (ImGui::InputInt("Budget (MiB)", &texture_budget_mib, 16, 128)) {
+				if (texture_budget_mib < 0) texture_budget_mib = 0;
+				writePreferences();
+			}
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("0 disables the budget. Over budget, texture slots no sampler\n"
+					"uses are downscaled, least recently sampled first, then evicted.\n"
+					"They are reloaded from the file or texture cache once sampled again.");
+			}
+			if (texture_budget_mib) {
+				char overlay[64];
+				snprintf(overlay, sizeof(overlay), "%.1f / %d MiB", mib*total_bytes, texture_budget_mib);
+				ImGui::ProgressBar(mib*total_bytes/texture_budget_mib, ImVec2(-1.0f, 0.0f), overlay);
+			}
+			ImGui::Separator();
+
+			for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+				TextureSlot *texture_slot = texture_slots + tsi;
+				if (!texture_slot->image_filepath) continue;
+				size_t slot_bytes = texture_slot->texture ? gpu_memory.getBytes(GMK_TEXTURE, texture_slot->texture) : 0;
+				ImGui::Text("%d: %9.2f MiB", tsi, mib*slot_bytes);
+				ImGui::SameLine();
+				if (texture_slot->residency == TR_EVICTED) ImGui::TextDisabled("evicted");
+				else if (texture_slot->residency == TR_DOWNSCALED) ImGui::Text("1/%d res", 1 << texture_slot->dropped_level_count);
+				else if (texture_slot->last_sampled_update == update_count) ImGui::Text("sampled");
+				else ImGui::TextDisabled("unused");
+				if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", texture_slot->image_filepath);
+			}
+		}
+		ImGui::End();
+	}
+
+	if (show_cost_window) {
+		if (ImGui::Begin("Shader Cost", &show_cost_window)) {
+			cost_estimate.update(uniforms, uniform_count); // loop bounds can be uniforms
+			if (!cost_estimate.has_main) {
+				ImGui::TextDisabled("no main() found");
+			} else {
+				ShaderCost *cost = &cost_estimate.per_pixel;
+				ImGui::Text("%-16s %10.0f", "ALU ops", cost->alu);
+				ImGui::Text("%-16s %10.0f", "Transcendental", cost->transcendental);
+				ImGui::Text("%-16s %10.0f", "Texture fetches", cost->fetches);
+				ImGui::Text("%-16s %10d", "Max loop depth", cost_estimate.max_loop_depth);
+				if (ImGui::InputInt("Unknown loops iterate", &cost_estimate.unknown_trip_count)) {
+					if (cost_estimate.unknown_trip_count < 0) cost_estimate.unknown_trip_count = 0;
+				}
+				if (ImGui::IsItemHovered()) {
+					ImGui::SetTooltip("Trip count assumed for the %d loops without constant bounds.\n"
+						"Bounds are literals, consts, #defines and int or float uniforms.",
+						cost_estimate.unknown_loop_count);
+				}
+			}
+			ImGui::Separator();
+
+			for (int li = 0; li < cost_estimate.loop_count; li++) {
+				ShaderCostLoop *loop = cost_estimate.loops + li;
+				ImGui::Text("line %4d %*s%s()", loop->line, 2*(loop->depth-1), "",
+					cost_estimate.functions[loop->function_index].name);
+				ImGui::SameLine();
+				if (loop->trip_count < 0.0f) ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.3f, 1.0f), "? iterations");
+				else ImGui::Text("%.0f iterations", loop->trip_count);
+				if (loop->has_break) {ImGui::SameLine(); ImGui::TextDisabled("at most, breaks");}
+				if (loop->uses_uniform) {ImGui::SameLine(); ImGui::TextDisabled("uniform bound");}
+			}
+			if (cost_estimate.loop_count) ImGui::Separator();
+
+			for (int fi = 0; fi < cost_estimate.function_count; fi++) {
+				ShaderCostFunction *function = cost_estimate.functions + fi;
+				ImGui::Text("%-20s %8.0f alu %6.0f trans %6.0f tex", function->name,
+					function->cost.alu, function->cost.transcendental, function->cost.fetches);
+			}
+			ImGui::Separator();
+
+			if (ImGui::Checkbox("Optimize before compiling", &optimize_shader)) {
+				writePreferences();
+				recompileShader();
+			}
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Inlines one line functions, folds constants, reuses repeated calls\n"
+					"and removes unused functions before the driver sees the source.");
+			}
+			if (is_shader_optimized) {
+				ImGui::Text("%d calls inlined, %d constants folded, %d calls reused, %d functions removed",
+					optimizer_stats.inlined_call_count, optimizer_stats.folded_count,
+					optimizer_stats.reused_call_count, optimizer_stats.removed_function_count);
+			} else if (optimize_shader) {
+				ImGui::TextDisabled("optimized source failed to compile, the original is used");
+			}
+			if (shader_timer.isSupported()) {
+				for (int optimized = 0; optimized < 2; optimized++) {
+					const char *label = optimized ? "GPU time optimized" : "GPU time original";
+					if (shader_gpu_ms[optimized] > 0.0f) ImGui::Text("%-20s %8.3f ms", label, shader_gpu_ms[optimized]);
+					else ImGui::TextDisabled("%-20s %8s    (toggle to measure)", label, "-");
+				}
+			} else {
+				ImGui::TextDisabled("no timer queries, GPU time isn't available");
+			}
+		}
+		ImGui::End();
+	}
+
+	if (show_hitch_window) {
+		if (ImGui::Begin("Hitches", &show_hitch_window)) {
+			ImGui::SliderFloat("Threshold", &hitch_detector.threshold, 1.25f, 8.0f, "%.2fx average");
+			ImGui::SliderFloat("Minimum", &hitch_detector.min_frame_ms, 0.0f, 100.0f, "%.1f ms");
+			ImGui::Text("Average frame %.2f ms, %d hitches", hitch_detector.average_ms, hitch_detector.hitch_count);
+			if (!profiler.isEnabled()) ImGui::TextDisabled("profile zones are off, causes aren't recorded");
+			if (ImGui::Button("Clear")) hitch_detector.clear();
+			ImGui::SameLine();
+			if (ImGui::Button("Dump...")) dumpHitchesDialog();
+			ImGui::Separator();
+
+			for (int age = 0; age < HitchDetector::hitch_ring_size; age++) {
+				Hitch *hitch = hitch_detector.getHitch(age);
+				if (!hitch) break;
+				char time_str[16];
+				strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&hitch->time));
+				bool is_open = ImGui::TreeNode((void*)(intptr_t)hitch->frame_index, "%s frame %llu  %.1f ms (%.1fx)",
+					time_str, (unsigned long long)hitch->frame_index, hitch->frame_ms,
+					hitch->average_ms > 0.0f ? hitch->frame_ms / hitch->average_ms : 0.0f);
+				if (!is_open) {
+					if (hitch->cause_count) {ImGui::SameLine(); ImGui::TextDisabled("%s", hitch->causes[0].name);}
+					continue;
+				}
+				for (int ci = 0; ci < hitch->cause_count; ci++) {
+					HitchCause *cause = hitch->causes + ci;
+					if (cause->count > 1) ImGui::Text("%-20s %8.2f ms (%dx)", cause->name, cause->ms, cause->count);
+					else ImGui::Text("%-20s %8.2f ms", cause->name, cause->ms);
+				}
+				if (!hitch->cause_count) ImGui::TextDisabled("no zones finished in this frame");
+				ImGui::TreePop();
+			}
+		}
+		ImGui::End();
+	}
+
+	if (show_gl_debug_window) {
+		if (ImGui::Begin("GL Debug", &show_gl_debug_window)) {
+			if (!gl_debug.isSupported()) {
+				ImGui::TextDisabled("no KHR_debug in this context");
+			} else {
+				ImGui::Text("%d messages%s", gl_debug.getTotalCount(),
+					gl_debug.isSynchronous() ? "" : ", asynchronous: frames may be late, set gl_debug_context=1 for exact ones");
+				for (int ci = 0; ci < GDC_COUNT; ci++) {
+					char label[64];
+					snprintf(label, sizeof(label), "%s (%d)", gl_debug_category_names[ci], gl_debug.getCategoryCount((GlDebugCategory)ci));
+					if (ci % 4) ImGui::SameLine();
+					ImGui::Checkbox(label, &gl_debug.is_category_shown[ci]);
+				}
+				ImGui::Combo("Minimum severity", &gl_debug.min_severity, gl_debug_severity_names, GDS_COUNT);
+				if (ImGui::Button("Clear")) gl_debug.clear();
+				ImGui::Separator();
+
+				int message_count = gl_debug.takeSnapshot(); // newest first
+				ImGui::Columns(4, "gl debug messages");
+				ImGui::Text("Count"); ImGui::NextColumn();
+				ImGui::Text("Frames"); ImGui::NextColumn();
+				ImGui::Text("Category"); ImGui::NextColumn();
+				ImGui::Text("Message"); ImGui::NextColumn();
+				ImGui::Separator();
+				for (int mi = 0; mi < message_count; mi++) {
+					GlDebugMessage *message = gl_debug.snapshot + mi;
+					if (!gl_debug.is_category_shown[message->category] || message->severity < gl_debug.min_severity) continue;
+					ImGui::Text("%d", message->count); ImGui::NextColumn();
+					if (message->first_frame == message->last_frame) ImGui::Text("%llu", (unsigned long long)message->first_frame);
+					else ImGui::Text("%llu-%llu", (unsigned long long)message->first_frame, (unsigned long long)message->last_frame);
+					ImGui::NextColumn();
+					ImVec4 color = message->severity == GDS_HIGH ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f)
+						: message->severity == GDS_MEDIUM ? ImVec4(1.0f, 0.7f, 0.3f, 1.0f) : ImGui::GetStyle().Colors[ImGuiCol_Text];
+					ImGui::TextColored(color, "%s", gl_debug_category_names[message->category]); ImGui::NextColumn();
+					ImGui::TextWrapped("%s", message->text); ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+			}
+		}
+		ImGui::End();
+	}
+
+	if (heatmap.enabled) {
+		bool show_heatmap = true;
+		if (ImGui::Begin("Cost Heatmap", &show_heatmap, ImGuiWindowFlags_AlwaysAutoResize)) {
+			if (heatmap.compile_error_log) {
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", heatmap.compile_error_log);
+			} else {
+				ImGui::Text("%d loops and %d texture fetches instrumented", heatmap.loop_count, heatmap.fetch_count);
+				ImGui::Combo("Count", &heatmap.counter, heatmap_counter_names, HC_COUNT);
+				ImGui::Checkbox("Auto range", &heatmap.auto_range);
+				if (!heatmap.auto_range) {
+					ImGui::SameLine();
+					ImGui::PushItemWidth(100.0f);
+					ImGui::DragFloat("Max", &heatmap.range_max, 1.0f, 1.0f, 1e6f, "%.0f");
+					ImGui::PopItemWidth();
+				}
+
+				// legend
+				HeatmapStats *stats = heatmap.stats + heatmap.counter;
+				float range_max = heatmap.auto_range ? stats->max : heatmap.range_max;
+				if (range_max < 1.0f) range_max = 1.0f;
+				const int segment_count = 16;
+				const float legend_width = 256.0f, legend_height = 16.0f;
+				ImDrawList *draw_list = ImGui::GetWindowDrawList();
+				ImVec2 legend_pos = ImGui::GetCursorScreenPos();
+				for (int s = 0; s < segment_count; s++) {
+					vec3 left = getHeatmapRampColor((float)s / segment_count);
+					vec3 right = getHeatmapRampColor((float)(s+1) / segment_count);
+					ImU32 left_color = ImGui::GetColorU32(ImVec4(left.x, left.y, left.z, 1.0f));
+					ImU32 right_color = ImGui::GetColorU32(ImVec4(right.x, right.y, right.z, 1.0f));
+					float x0 = legend_pos.x + legend_width*s/segment_count;
+					float x1 = legend_pos.x + legend_width*(s+1)/segment_count;
+					draw_list->AddRectFilledMultiColor(ImVec2(x0, legend_pos.y), ImVec2(x1, legend_pos.y + legend_height),
+						left_color, right_color, right_color, left_color);
+				}
+				ImGui::Dummy(ImVec2(legend_width, legend_height));
+				ImGui::Text("0 .. %.0f", range_max);
+				ImGui::Text("min %.0f  mean %.1f  max %.0f", stats->min, stats->mean, stats->max);
+				ImGui::TextDisabled("over %d pixels, discarded pixels are darker", heatmap.counted_pixel_count);
+			}
+		}
+		ImGui::End();
+		if (!show_heatmap) toggleHeatmap();
+	}
+
 	// overlay messages
 	int overlay_flags = ImGuiWindowFlags_NoTitleBar
 		| ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize
@@ -804,10 +1754,10 @@ ImGui::EndMainMenuBar();
 		ImGui::SameLine();
 		if (ImGui::Button("New")) newShader();
 		ImGui::End();
-	} else if (compile_error_log) {
+	} else if (validation_error_log || compile_error_log) {
 		ImGui::SetNextWindowPosCenter();
 		ImGui::Begin("Overlay", nullptr, ImVec2(0, 0), 0.3f, overlay_flags);
-		ImGui::TextUnformatted(compile_error_log);
+		ImGui::TextUnformatted(validation_error_log ? validation_error_log : compile_error_log);
 		ImGui::End();
 	}
 }
@@ -823,9 +1773,22 @@ struct BindArrayBuffer {
 };
 
 void App::update(float delta_time) {
+	PROFILE_ZONE("update");
+	// camera, input and frame count come from the log in replays
+	if (isRecording()) recordFrame(delta_time);
+	else if (isReplaying()) delta_time = replayFrame();
+
 	if (anim_play) frame_count++;
+	u_time = (float)frame_count / 60.0f;
+
+	if (!hide_gui) {PROFILE_ZONE("gui");
+		gui();
+	}
 
-	if (!hide_gui) gui();
+	updateShaderValidation();
+	// uniform edits of the gui and compiles of this frame
+	if (isRecording()) recordUniformChanges();
+	else if (isReplaying() && !applyReplayEvents()) finishReplay(/*failed*/true);
 
 	// autoreload frag shader (every 60 frames)
 	if (shader_filepath && shader_file_autoreload && (frame_count % 60) == 0) {
@@ -838,6 +1801,9 @@ void App::update(float delta_time) {
 		}
 	}
 
+	// autoreload textures, decoded on worker threads and uploaded once ready
+	if (texture_file_autoreload) autoreloadTextures((frame_count % 60) == 0);
+
 	// update camera (-z: forward, y: up)
 	camera_euler_angles += 2.0f*delta_time
 		* v3(-movement_command.rotate.x, -movement_command.rotate.y, 0.0f);
@@ -850,44 +1816,90 @@ void App::update(float delta_time) {
 	mat4 view_to_world = translationMatrix(camera_location) * m4(rot);
 	mat4 world_to_view = m4(transpose(rot)) * translationMatrix(-camera_location);
 
-	// bind textures
+	updateTextureSlots();
+	if (bake_pass.isLoaded()) updateBakePass();
+	if (audio_spectrum.isOpen()) updateAudioSlot(delta_time);
+	updateTextureResidency();
+	texture_cache.update();
+
+	// window back buffers: double buffered rgba8 and a 16 bit depth buffer
+	size_t drawable_pixel_count = (size_t)(video.pixel_scale*video.width)*(size_t)(video.pixel_scale*video.height);
+	gpu_memory.track(GMK_FRAMEBUFFER, 0, drawable_pixel_count*(2*4 + 2));
+	metrics_server.set(MI_TEXTURE_MEMORY_KIB, (int)(gpu_memory.bytes[GMK_TEXTURE] >> 10));
+	metrics_server.set(MI_GPU_MEMORY_KIB, (int)(gpu_memory.getTotalBytes() >> 10));
+
+	drawShader(view_to_world, world_to_view);
+	if (isReplaying()) endReplayFrame();
+}
+
+void App::bindTextureSlots() {
 	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
 		glActiveTexture(GL_TEXTURE0+tsi);
 		glBindTexture(texture_slots[tsi].target, texture_slots[tsi].texture);
 	}
+}
+
+void App::drawShader(const mat4 &view_to_world, const mat4 &world_to_view) {
+	bindTextureSlots();
 
 	// draw fullscreen triangle(s)
 	glClearColor(0.2f, 0.21f, 0.22f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
-	{ BindShader bind_shader(shader);
-		if (!compile_error_log) {
+	Shader *counting_shader = nullptr;
+	if (heatmap.enabled && !compile_error_log) {
+		counting_shader = heatmap.beginCounting((int)(video.pixel_scale*video.width),
+			(int)(video.pixel_scale*video.height), uniforms, uniform_count);
+	}
+	if (counting_shader) { // instrumented shader writes counts, shown through the ramp
+		applyBuiltinUniforms(counting_shader, view_to_world, world_to_view);
+		drawFullscreenTriangles();
+		heatmap.endCounting();
+		heatmap.draw(single_triangle_vbo);
+	} else { BindShader bind_shader(shader);
+		if (!compile_error_log) {PROFILE_ZONE("uniform apply");
 			for (int i = 0; i < uniform_count; i++) {
 				uniforms[i].apply();
 			}
 		}
+		applyBuiltinUniforms(&shader, view_to_world, world_to_view);
+		bool is_timed = !compile_error_log && !is_benchmarking;
+		if (is_timed) shader_timer.begin();
+		ProfileScope draw_zone("draw");
+		drawFullscreenTriangles();
+		draw_zone.end();
+		if (is_timed) {
+			shader_timer.end();
+			if (shader_timer.milliseconds > 0.0f) {
+				shader_gpu_ms[is_shader_optimized] = shader_timer.milliseconds;
+				metrics_server.set(MI_SHADER_GPU_US, (int)(1000.0f*shader_timer.milliseconds));
+			}
+		}
+	}
+}
 
-		// apply builtin uniforms
-		u_time = (float)frame_count / 60.0f;
-		glUniform1f(shader.getUniformLocation(u_time_name), u_time);
-		vec2 u_resolution = v2(video.pixel_scale*video.width, video.pixel_scale*video.height);
-		glUniform2fv(shader.getUniformLocation(u_resolution_name), 1, u_resolution.e);
-		glUniformMatrix4fv(shader.getUniformLocation(u_view_to_world_name), 1, GL_FALSE, view_to_world.e);
-		glUniformMatrix4fv(shader.getUniformLocation(u_world_to_view_name), 1, GL_FALSE, world_to_view.e);
+void App::applyBuiltinUniforms(Shader *target_shader, const mat4 &view_to_world, const mat4 &world_to_view) {
+	glUniform1f(target_shader->getUniformLocation(u_time_name), u_time);
+	vec2 u_resolution = v2(video.pixel_scale*video.width, video.pixel_scale*video.height);
+	glUniform2fv(target_shader->getUniformLocation(u_resolution_name), 1, u_resolution.e);
+	glUniformMatrix4fv(target_shader->getUniformLocation(u_view_to_world_name), 1, GL_FALSE, view_to_world.e);
+	glUniformMatrix4fv(target_shader->getUniformLocation(u_world_to_view_name), 1, GL_FALSE, world_to_view.e);
+	applyDataUniforms(target_shader);
+}
 
-		if (single_triangle_mode) {
-			{ BindArrayBuffer bind_array_buffer(single_triangle_vbo);
-				glEnableVertexAttribArray(VAT_POSITION);
-				glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-				glDrawArrays(GL_TRIANGLES, 0, 3);
-				glDisableVertexAttribArray(VAT_POSITION);
-			}
-		} else {
-			{ BindArrayBuffer bind_array_buffer(two_triangles_vbo);
-				glEnableVertexAttribArray(VAT_POSITION);
-				glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-				glDisableVertexAttribArray(VAT_POSITION);
-			}
+void App::drawFullscreenTriangles() {
+	if (single_triangle_mode) {
+		{ BindArrayBuffer bind_array_buffer(single_triangle_vbo);
+			glEnableVertexAttribArray(VAT_POSITION);
+			glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glDisableVertexAttribArray(VAT_POSITION);
+		}
+	} else {
+		{ BindArrayBuffer bind_array_buffer(two_triangles_vbo);
+			glEnableVertexAttribArray(VAT_POSITION);
+			glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			glDisableVertexAttribArray(VAT_POSITION);
 		}
 	}
 }
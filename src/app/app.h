@@ -3,16 +3,44 @@ struct MovementCommand {
 	vec2 rotate;
 };
 
+enum TextureSlotSource {
+	TSS_FILE, // image_filepath
+	TSS_BAKE, // rendered by the bake pass
+	TSS_AUDIO, // spectrum and waveform of the audio input
+	TSS_VIDEO // video file or image sequence
+};
+
+enum TextureResidency {
+	TR_RESIDENT,
+	TR_DOWNSCALED, // top mip levels dropped to stay within the memory budget
+	TR_EVICTED // texture deleted, reloaded once the shader samples the slot again
+};
+
 struct TextureSlot {
 	GLenum target = GL_TEXTURE_2D; // texture target: 1D 2D 3D or cube map
 	GLuint texture = 0;
 	int image_width, image_height;
+	int image_depth = 1; // 3D only
 	char *image_filepath = nullptr;
+	int image_file_mtime = 0;
+	TextureReload *reload = nullptr; // hot reload when the image changes on disk
+	VolumeStream volume_stream; // 3D textures are uploaded over several frames
+	MeshSdfBake *sdf_bake = nullptr; // 3D texture from a mesh, streamed once baked
+	NoiseBake *noise_bake = nullptr; // generated noise, loaded once written
+	TextureSlotSource source = TSS_FILE;
+	VideoStream *video = nullptr; // TSS_VIDEO
+	bool is_data = false; // csv or raw floats, data_info is valid
+	DataTextureInfo data_info;
+	TextureResidency residency = TR_RESIDENT;
+	int dropped_level_count = 0; // TR_DOWNSCALED
+	u64 last_sampled_update = 0; // App::update_count when a sampler uniform last referenced the slot
 
 	void clear();
 };
 
 struct App {
+	friend struct Microbench; // microbench_ub.cpp times the private parsing and io
+
 	bool quit = false;
 	bool hide_gui = false;
 	VideoMode video;
@@ -26,6 +54,9 @@ struct App {
 
 	char *preferences_filepath;
 	char *session_filepath;
+	TextureCache texture_cache;
+	bool fast_start = false; // kiosk restarts, see main()
+	bool gl_debug_context = false; // synchronous driver debug output
 	void readPreferences();
 	void writePreferences();
 	void readSession();
@@ -35,20 +66,40 @@ struct App {
 	void openShaderDialog();
 	void saveShaderDialog();
 	void saveShader();
+	void exportTraceDialog(); // chrome trace of the profile zones
+	void dumpHitchesDialog();
 
 	void resetCamera();
 	void toggleAnimation() {anim_play = !anim_play;}
 	void toggleWindow(int window_index);
+	void toggleHeatmap();
 
+	void prefetchTextureSlots(); // before init(), reads the restored texture files on the workers
 	void init();
 	void update(float delta_time);
 
-	void beforeQuit() {writeSession();} // will be called before application exits
+	int runBenchmark(const BenchOptions &options); // returns the exit code
+
+	// replays and recordings of the per frame input, in replay.cpp
+	bool openReplay(const ReplayOptions &options); // before init(), reads the header
+	bool isReplaying() {return replay_log.file && !replay_log.is_writing;}
+	bool isReplayFailed() {return is_replay_failed;}
+	bool startRecording(const char *filepath);
+	void stopRecording();
+	bool isRecording() {return replay_log.file && replay_log.is_writing;}
+
+	void beforeQuit() { // will be called before application exits
+		if (!replay_options.replay_filepath) writeSession(); // replays don't change the session
+		stopRecording();
+		metrics_server.stop();
+		audio_spectrum.close();
+	}
 
 private:
 	char *shader_filepath = nullptr;
 	int shader_file_mtime = 0;
 	bool shader_file_autoreload = true;
+	bool texture_file_autoreload = true;
 
 	char *recently_used_filepaths[10] = {}; // cyclic, from most recent to less recent
 	int most_recently_used_index = 0; // top of stack
@@ -70,6 +121,13 @@ private:
 
 	void loadShader(const char *frag_file_path, bool reload=false);
 	void compileShader(const char *shader_src, bool recompile=false);
+	// sources are validated first, ones with errors never reach the driver
+	void validateAndCompileShader(const char *shader_src, bool recompile);
+	void updateShaderValidation(); // validates the editor buffer on the job queue as it changes
+	bool is_first_compile_pending = false; // the source of a newly loaded file hasn't been compiled yet
+	char *validation_error_log = nullptr; // the running program is kept while this is set
+	GlslValidation *editor_validation = nullptr; // in flight
+	GlslValidation *editor_validation_result = nullptr;
 	void parseUniforms();
 	void readUniformData();
 	void writeUniformData();
@@ -80,17 +138,92 @@ private:
 	u64 frame_count = 0;
 
 	TextureSlot texture_slots[8];
+	bool loadTextureSlot(TextureSlot *texture_slot, const char *image_filepath, GLenum target);
+	void autoreloadTextures(bool check_files);
+	void updateTextureSlots(); // finishes bakes and streams volumes
+	void applyDataUniforms(Shader *target_shader);
+	void applyBuiltinUniforms(Shader *target_shader, const mat4 &view_to_world, const mat4 &world_to_view);
+	int texture_budget_mib = 0; // 0: no budget
+	int metrics_port = 0; // prometheus endpoint on localhost, 0: off
+	u64 update_count = 0;
+	void updateTextureResidency(); // reloads sampled slots, shrinks unsampled ones over budget
+	bool shrinkTextureSlot(TextureSlot *texture_slot);
+	int sdf_bake_resolution = 64;
+	NoiseParams noise_params;
+	int noise_target_slot = 0;
+	void generateNoiseSlot(TextureSlot *texture_slot, const NoiseParams &params);
+
+	BakePass bake_pass;
+	void loadBakePass();
+	void updateBakePass();
+
+	AudioSpectrum audio_spectrum;
+	int audio_slot = 6;
+	void updateAudioSlot(float delta_time);
+	void openAudioDialog();
 
 	GLuint single_triangle_vbo;
 	GLuint two_triangles_vbo;
 	bool single_triangle_mode = true;
-	
-	void openImageDialog(TextureSlot *texture_slot, bool load_cube_cross=false);
+	void drawFullscreenTriangles();
+	void bindTextureSlots();
+	void drawShader(const mat4 &view_to_world, const mat4 &world_to_view); // with the bound textures and uniforms
+
+	ShaderHeatmap heatmap;
+	ShaderCostEstimate cost_estimate;
+
+	bool optimize_shader = false;
+	bool is_shader_optimized = false; // the bound program was compiled from optimized source
+	GlslOptimizerStats optimizer_stats = {};
+	GpuTimer shader_timer;
+	float shader_gpu_ms[2] = {}; // without and with optimization, of the current source
+	u64 shader_src_hash = 0;
+	bool is_benchmarking = false; // frames are timed by the benchmark, the shader timer stays out of its queries
+	// benchmark modes, in bench.cpp
+	char *loadBenchShader(const char *filepath); // returns the new[]'d error or nullptr
+	void prepareBenchFrame(int frame); // u_time, texture slots and the bake pass
+	void drawBenchProgram(BenchProgram *program, const mat4 &view_to_world, const mat4 &world_to_view);
+	bool measureBenchFrames(const BenchOptions &options, BenchTarget *target, float *gpu_ms, float *cpu_ms, float *frame_ms); // false without gpu times
+	int benchShaders(const BenchOptions &options, BenchTarget *target, FILE *file);
+	int compareShaders(const BenchOptions &options, BenchTarget *target, FILE *file);
+	int regressShaders(const BenchOptions &options, BenchTarget *target, FILE *file);
+
+	ReplayLog replay_log; // recording or replaying
+	ReplayOptions replay_options;
+	char *replay_src = nullptr; // of the header, compiled at the first frame of a pass
+	int replay_pass = 0;
+	bool is_replay_failed = false;
+	u64 replay_frame_ticks = 0; // when the current frame began
+	float replay_last_update_ms = 0.0f;
+	float *replay_frame_ms = nullptr, *replay_update_ms = nullptr;
+	int replay_sample_count = 0, replay_sample_capacity = 0;
+	u8 *recorded_uniform_data = nullptr; // values at the last frame, only changes are recorded
+	size_t recorded_uniform_data_size = 0;
+	int recorded_uniform_count = -1;
+	int recorded_frame_count = 0;
+	void writeReplayHeader();
+	bool readReplayHeader(bool is_repeat);
+	void recordReplayDialog();
+	void recordFrame(float delta_time);
+	void recordShaderSource(const char *shader_src);
+	void recordUniformChanges();
+	bool applyReplayEvents(); // up to the next frame, false on errors
+	float replayFrame(); // returns the fixed timestep
+	void endReplayFrame();
+	void finishReplay(bool failed);
+
+	void openImageDialog(TextureSlot *texture_slot, GLenum target=GL_TEXTURE_2D);
+	void openVideoDialog(TextureSlot *texture_slot);
+	bool loadVideoSlot(TextureSlot *texture_slot, const char *video_filepath);
 
 	bool show_uniforms_window = false;
 	bool show_textures_window = false;
 	bool show_camera_window = false;
 	bool show_src_edit_window = false;
+	bool show_memory_window = false;
+	bool show_cost_window = false;
+	bool show_hitch_window = false;
+	bool show_gl_debug_window = false;
 
 	void gui();
 };
@@ -0,0 +1,918 @@
+int parseBenchArgs(int argc, char *argv[], BenchOptions *options) {
+	const char *invalid_arg = nullptr; // only an error in a benchmark mode, os x may pass -psn_...
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool has_value = i+1 < argc;
+		if (!strcmp(arg, "--bench") || !strcmp(arg, "--compare") || !strcmp(arg, "--regress")) {
+			options->mode = !strcmp(arg, "--bench") ? BM_BENCH : !strcmp(arg, "--compare") ? BM_COMPARE : BM_REGRESS;
+			options->shader_filepaths = argv + i + 1;
+			options->shader_count = 0;
+			while (i+1 < argc && strncmp(argv[i+1], "--", 2)) {
+				options->shader_count++;
+				i++;
+			}
+		} else if (!strcmp(arg, "--res") && has_value) {
+			if (sscanf(argv[++i], "%dx%d", &options->width, &options->height) != 2
+				|| options->width <= 0 || options->height <= 0) {
+				if (!invalid_arg) invalid_arg = argv[i];
+			}
+		} else if (!strcmp(arg, "--frames") && has_value) {
+			options->frame_count = atoi(argv[++i]);
+			if (options->frame_count <= 0 && !invalid_arg) invalid_arg = argv[i];
+		} else if (!strcmp(arg, "--warmup") && has_value) {
+			options->warmup_count = atoi(argv[++i]);
+			if (options->warmup_count < 0 && !invalid_arg) invalid_arg = argv[i];
+		} else if (!strcmp(arg, "--out") && has_value) {
+			options->out_filepath = argv[++i];
+		} else if (!strcmp(arg, "--diff-out") && has_value) {
+			options->diff_filepath = argv[++i];
+		} else if (!strcmp(arg, "--diff-dir") && has_value) {
+			options->diff_dirpath = argv[++i];
+		} else if (!strcmp(arg, "--tolerance") && has_value) {
+			options->perceptual_threshold = (float)atof(argv[++i]);
+		} else if (!strcmp(arg, "--max-diff") && has_value) {
+			options->max_differing_fraction = (float)atof(argv[++i]);
+		} else if (!strcmp(arg, "--time-threshold") && has_value) {
+			options->time_threshold = (float)atof(argv[++i]);
+		} else if (!strcmp(arg, "--update")) {
+			options->update = true;
+		} else if (!strcmp(arg, "--strict")) {
+			options->strict = true;
+		} else if (!strcmp(arg, "--headless")) {
+			options->headless = true;
+		} else if (!strcmp(arg, "--optimize")) {
+			options->optimize = true;
+		} else if (!strcmp(arg, "--fast-start")) { // handled in main
+		} else if (!invalid_arg) {
+			invalid_arg = arg;
+		}
+	}
+	if (options->mode == BM_NONE) return 0;
+	if (invalid_arg) {
+		LOGE("Invalid benchmark argument: %s", invalid_arg);
+		return -1;
+	}
+	if (options->mode != BM_COMPARE && !options->shader_count) {
+		LOGE("No shader files given after --bench or --regress");
+		return -1;
+	}
+	if (options->mode == BM_COMPARE && options->shader_count != 2) {
+		LOGE("--compare takes two shader files");
+		return -1;
+	}
+	return 1;
+}
+
+static int compareFloats(const void *a, const void *b) {
+	float fa = *(const float*)a, fb = *(const float*)b;
+	return fa < fb ? -1 : fa > fb ? 1 : 0;
+}
+
+void computeBenchStats(const float *samples, int count, BenchStats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	if (count <= 0) return;
+	float *sorted = new float[count];
+	memcpy(sorted, samples, count*sizeof(float));
+	qsort(sorted, count, sizeof(float), compareFloats);
+
+	double sum = 0.0;
+	for (int i = 0; i < count; i++) sum += sorted[i];
+	stats->mean = (float)(sum / count);
+	stats->median = count % 2 ? sorted[count/2] : 0.5f*(sorted[count/2-1] + sorted[count/2]);
+	// nearest rank
+	stats->p95 = sorted[(int)ceil(0.95*count)-1];
+	stats->p99 = sorted[(int)ceil(0.99*count)-1];
+	stats->min = sorted[0];
+	stats->max = sorted[count-1];
+	delete [] sorted;
+}
+
+// two sided 95% quantile of the t distribution
+static double tQuantile95(int degrees_of_freedom) {
+	static const double table[30] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	if (degrees_of_freedom <= 30) return table[degrees_of_freedom > 0 ? degrees_of_freedom-1 : 0];
+	if (degrees_of_freedom <= 60) return 2.000;
+	if (degrees_of_freedom <= 120) return 1.980;
+	return 1.960;
+}
+
+void computeBenchSpeedup(const float *a, const float *b, int count, BenchSpeedup *speedup) {
+	// log ratios of the pairs, drawn right after each other so drift cancels
+	double sum = 0.0, squared_sum = 0.0;
+	int n = 0;
+	for (int i = 0; i < count; i++) {
+		if (a[i] <= 0.0f || b[i] <= 0.0f) continue; // lost query
+		double d = log((double)a[i] / (double)b[i]);
+		sum += d;
+		squared_sum += d*d;
+		n++;
+	}
+	speedup->pair_count = n;
+	if (n < 2) {
+		speedup->speedup = speedup->low = speedup->high = n ? (float)exp(sum) : 0.0f;
+		return;
+	}
+	double mean = sum / n;
+	double variance = (squared_sum - n*mean*mean) / (n-1);
+	double margin = tQuantile95(n-1) * sqrt(variance > 0.0 ? variance : 0.0) / sqrt((double)n);
+	speedup->speedup = (float)exp(mean);
+	speedup->low = (float)exp(mean - margin);
+	speedup->high = (float)exp(mean + margin);
+}
+
+static const char *bench_vert_src =
+	"attribute vec4 va_position;"
+	"void main() {gl_Position = va_position;}";
+
+char *BenchProgram::compile(const char *src, bool optimize) {
+	release();
+	shader.compileAndAttach(GL_VERTEX_SHADER, bench_vert_src);
+	shader.bindVertexAttrib("va_position", VAT_POSITION);
+	// falls back to the original source like App::compileShader
+	is_optimized = false;
+	if (optimize) {
+		GlslOptimizerStats stats;
+		char *optimized_src = optimizeGlsl(src, &stats);
+		is_optimized = shader.compileAndAttach(GL_FRAGMENT_SHADER, optimized_src) && shader.link();
+		delete [] optimized_src;
+	}
+	if (!is_optimized) {
+		if (!shader.compileAndAttach(GL_FRAGMENT_SHADER, src)) return shader.getShaderCompileErrorLog(GL_FRAGMENT_SHADER);
+		if (!shader.link()) return shader.getLinkErrorLog();
+	}
+
+	GLint active_count = 0;
+	glGetProgramiv(shader.getProgram(), GL_ACTIVE_UNIFORMS, &active_count);
+	inputs = new ShaderUniform[active_count > 0 ? active_count : 1];
+	for (int i = 0; i < active_count; i++) {
+		ShaderUniform *input = inputs + input_count++;
+		GLsizei name_len;
+		glGetActiveUniform(shader.getProgram(), i, (GLsizei)sizeof(input->name),
+			&name_len, &input->size, &input->type, input->name);
+		input->location = shader.getUniformLocation(input->name);
+		input->data = nullptr;
+		input->flags = 0;
+	}
+	return nullptr;
+}
+
+void BenchProgram::connect(ShaderUniform *uniforms, int uniform_count) {
+	for (int i = 0; i < input_count; i++) {
+		ShaderUniform *input = inputs + i;
+		input->data = nullptr;
+		for (int j = 0; j < uniform_count; j++) {
+			ShaderUniform *uniform = uniforms + j;
+			if (uniform->type != input->type || uniform->size < input->size) continue;
+			if (strcmp(uniform->name, input->name)) continue;
+			input->data = uniform->data;
+			break;
+		}
+	}
+}
+
+void BenchProgram::release() {
+	if (inputs) {
+		delete [] inputs;
+		inputs = nullptr;
+	}
+	input_count = 0;
+}
+
+// offscreen frame of the exact benchmark size, independent of window and display
+struct BenchTarget {
+	int width = 0, height = 0;
+	GLuint texture = 0, framebuffer = 0;
+
+	bool create(int target_width, int target_height);
+	void bind(); // and sets the viewport
+	void readPixels(u8 *out_rgba); // width*height*4
+	void present(GLuint triangle_vbo); // shows the frame in the window and swaps
+	void release();
+
+private:
+	Shader present_shader;
+};
+
+static const char *bench_present_vert_src =
+	"attribute vec4 va_position;"
+	"varying vec2 v_texcoord;"
+	"void main() {"
+	"	v_texcoord = 0.5*va_position.xy + 0.5;"
+	"	gl_Position = va_position;"
+	"}";
+static const char *bench_present_frag_src =
+	"uniform sampler2D u_frame;"
+	"varying vec2 v_texcoord;"
+	"void main() {gl_FragColor = texture2D(u_frame, v_texcoord);}";
+
+bool BenchTarget::create(int target_width, int target_height) {
+	width = target_width;
+	height = target_height;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		LOGE("Benchmark framebuffer incomplete (0x%X)", status);
+		release();
+		return false;
+	}
+
+	present_shader.compileAndAttach(GL_VERTEX_SHADER, bench_present_vert_src);
+	present_shader.compileAndAttach(GL_FRAGMENT_SHADER, bench_present_frag_src);
+	present_shader.bindVertexAttrib("va_position", VAT_POSITION);
+	present_shader.link();
+	return true;
+}
+
+void BenchTarget::bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+void BenchTarget::readPixels(u8 *out_rgba) {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, out_rgba);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void BenchTarget::present(GLuint triangle_vbo) {
+	int drawable_width, drawable_height;
+	SDL_GL_GetDrawableSize(sdl_window, &drawable_width, &drawable_height);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, drawable_width, drawable_height);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	{ BindShader bind_shader(present_shader);
+		glUniform1i(present_shader.getUniformLocation("u_frame"), 0);
+		glBindBuffer(GL_ARRAY_BUFFER, triangle_vbo); // fullscreen triangle
+		glEnableVertexAttribArray(VAT_POSITION);
+		glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glDisableVertexAttribArray(VAT_POSITION);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	SDL_GL_SwapWindow(sdl_window);
+}
+
+void BenchTarget::release() {
+	if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
+	if (texture) glDeleteTextures(1, &texture);
+	framebuffer = texture = 0;
+}
+
+static void writeJsonString(FILE *file, const char *str) {
+	fputc('"', file);
+	for (const char *c = str; *c; c++) {
+		if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+		else if (*c == '\n') fputs("\\n", file);
+		else if (*c == '\t') fputs("\\t", file);
+		else if ((unsigned char)*c < 0x20) fprintf(file, "\\u%04x", *c);
+		else fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+static void writeBenchStats(FILE *file, const char *indent, const char *name, const float *samples, int count) {
+	BenchStats stats;
+	computeBenchStats(samples, count, &stats);
+	fprintf(file, "%s\"%s\": {\"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"min\": %.4f, \"max\": %.4f}",
+		indent, name, stats.mean, stats.median, stats.p95, stats.p99, stats.min, stats.max);
+}
+
+static void writeBenchHeader(FILE *file, const BenchOptions &options) {
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"vendor\": "); writeJsonString(file, (const char*)glGetString(GL_VENDOR)); fprintf(file, ",\n");
+	fprintf(file, "\t\"renderer\": "); writeJsonString(file, (const char*)glGetString(GL_RENDERER)); fprintf(file, ",\n");
+	fprintf(file, "\t\"version\": "); writeJsonString(file, (const char*)glGetString(GL_VERSION)); fprintf(file, ",\n");
+	fprintf(file, "\t\"width\": %d,\n\t\"height\": %d,\n", options.width, options.height);
+	fprintf(file, "\t\"frames\": %d,\n\t\"warmup\": %d,\n", options.frame_count, options.warmup_count);
+	fprintf(file, "\t\"headless\": %s,\n", options.headless ? "true" : "false");
+	fprintf(file, "\t\"optimize\": %s,\n", options.optimize ? "true" : "false");
+}
+
+int App::runBenchmark(const BenchOptions &options) {
+	is_benchmarking = true;
+	shader_file_autoreload = false;
+	texture_file_autoreload = false;
+	optimize_shader = options.optimize;
+	heatmap.enabled = false;
+	// u_resolution is the framebuffer size
+	video.width = options.width;
+	video.height = options.height;
+	video.pixel_scale = 1.0f;
+
+	FILE *file = stdout;
+	if (options.out_filepath) {
+		file = fopen(options.out_filepath, "w");
+		if (!file) {
+			LOGE("Could not open %s for writing", options.out_filepath);
+			return 1;
+		}
+	}
+	BenchTarget target;
+	int exit_code = 1;
+	if (target.create(options.width, options.height)) {
+		writeBenchHeader(file, options);
+		if (options.mode == BM_COMPARE) exit_code = compareShaders(options, &target, file);
+		else if (options.mode == BM_REGRESS) exit_code = regressShaders(options, &target, file);
+		else exit_code = benchShaders(options, &target, file);
+		fprintf(file, "}\n");
+		target.release();
+	}
+	if (file != stdout) fclose(file);
+	is_benchmarking = false;
+	return exit_code;
+}
+
+char *App::loadBenchShader(const char *filepath) {
+	// loaded synchronously, the validation still keeps the driver from broken sources
+	char *shader_src = readStringFromFile(filepath);
+	if (!shader_src) {
+		const char *message = "could not read the file";
+		char *error = new char[strlen(message)+1];
+		strcpy(error, message);
+		return error;
+	}
+	char *validation_log;
+	if (validateGlsl(shader_src, &validation_log)) {
+		delete [] shader_src;
+		return validation_log;
+	}
+	if (shader_filepath) delete [] shader_filepath;
+	shader_filepath = new char[strlen(filepath)+1];
+	strcpy(shader_filepath, filepath);
+	loadBakePass();
+	compileShader(shader_src, /*recompile*/false);
+	delete [] shader_src;
+	if (!compile_error_log) return nullptr;
+	char *error = new char[strlen(compile_error_log)+1];
+	strcpy(error, compile_error_log);
+	return error;
+}
+
+void App::prepareBenchFrame(int frame) {
+	frame_count = frame;
+	u_time = (float)frame / 60.0f;
+	updateTextureSlots();
+	if (bake_pass.isLoaded()) updateBakePass();
+}
+
+void App::drawBenchProgram(BenchProgram *program, const mat4 &view_to_world, const mat4 &world_to_view) {
+	// same work as the else branch of drawShader
+	bindTextureSlots();
+	glClearColor(0.2f, 0.21f, 0.22f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	{ BindShader bind_shader(program->shader);
+		for (int i = 0; i < program->input_count; i++) {
+			if (program->inputs[i].data) program->inputs[i].apply();
+		}
+		applyBuiltinUniforms(&program->shader, view_to_world, world_to_view);
+		drawFullscreenTriangles();
+	}
+}
+
+static bool isBakeShader(const char *filepath) {
+	size_t filepath_len = strlen(filepath);
+	return filepath_len > 10 && !strcmp(filepath + filepath_len - 10, ".bake.frag");
+}
+
+bool App::measureBenchFrames(const BenchOptions &options, BenchTarget *target, float *gpu_ms, float *cpu_ms, float *frame_ms) {
+	bool has_timer_queries = shader_timer.isSupported();
+	int total_frame_count = options.warmup_count + options.frame_count;
+	GLuint *queries = nullptr;
+	if (has_timer_queries) {
+		queries = new GLuint[options.frame_count];
+		glGenQueries(options.frame_count, queries);
+	}
+	u64 *frame_ticks = new u64[options.frame_count+1]; // begin of each measured frame and the end of the last
+	double ticks_to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+	resetCamera();
+	mat4 view_to_world = translationMatrix(camera_location);
+	mat4 world_to_view = translationMatrix(-camera_location);
+
+	for (int frame = 0; frame < total_frame_count; frame++) {
+		int measured = frame - options.warmup_count; // negative while warming up
+		SDL_PumpEvents(); // keeps the window responsive
+		u64 begin_ticks = SDL_GetPerformanceCounter();
+		if (measured >= 0) frame_ticks[measured] = begin_ticks;
+
+		prepareBenchFrame(frame);
+		target->bind();
+		if (measured >= 0 && queries) glBeginQuery(GL_TIME_ELAPSED, queries[measured]);
+		drawShader(view_to_world, world_to_view);
+		if (measured >= 0 && queries) glEndQuery(GL_TIME_ELAPSED);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (measured >= 0) cpu_ms[measured] = (float)((SDL_GetPerformanceCounter() - begin_ticks)*ticks_to_ms);
+
+		if (options.headless) glFlush();
+		else target->present(single_triangle_vbo);
+	}
+	glFinish();
+	frame_ticks[options.frame_count] = SDL_GetPerformanceCounter();
+
+	for (int i = 0; i < options.frame_count; i++) {
+		frame_ms[i] = (float)((frame_ticks[i+1] - frame_ticks[i])*ticks_to_ms);
+		if (queries) {
+			GLuint nanoseconds = 0;
+			glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &nanoseconds);
+			gpu_ms[i] = nanoseconds*1e-6f;
+		}
+	}
+	if (queries) {
+		glDeleteQueries(options.frame_count, queries);
+		delete [] queries;
+	}
+	delete [] frame_ticks;
+	return has_timer_queries;
+}
+
+int App::benchShaders(const BenchOptions &options, BenchTarget *target, FILE *file) {
+	float *gpu_ms = new float[options.frame_count];
+	float *cpu_ms = new float[options.frame_count];
+	float *frame_ms = new float[options.frame_count];
+
+	fprintf(file, "\t\"results\": [");
+	int exit_code = 0;
+	int result_count = 0;
+	for (int si = 0; si < options.shader_count; si++) {
+		const char *filepath = options.shader_filepaths[si];
+		if (isBakeShader(filepath)) continue; // rendered by the shader next to it
+
+		fprintf(file, result_count++ ? ",\n" : "\n");
+		fprintf(file, "\t\t{\n\t\t\t\"shader\": ");
+		writeJsonString(file, filepath);
+		fprintf(file, ",\n");
+
+		char *error = loadBenchShader(filepath);
+		if (error) {
+			LOGE("Benchmark of %s failed: %s", filepath, error);
+			fprintf(file, "\t\t\t\"error\": ");
+			writeJsonString(file, error);
+			fprintf(file, "\n\t\t}");
+			delete [] error;
+			exit_code = 1;
+			continue;
+		}
+		LOGI("Benchmarking %s (%d frames)", filepath, options.warmup_count + options.frame_count);
+		bool has_gpu_ms = measureBenchFrames(options, target, gpu_ms, cpu_ms, frame_ms);
+
+		fprintf(file, "\t\t\t\"optimized\": %s,\n", is_shader_optimized ? "true" : "false");
+		if (has_gpu_ms) {
+			writeBenchStats(file, "\t\t\t", "gpu_ms", gpu_ms, options.frame_count);
+		} else {
+			fprintf(file, "\t\t\t\"gpu_ms\": null");
+		}
+		fprintf(file, ",\n");
+		writeBenchStats(file, "\t\t\t", "cpu_ms", cpu_ms, options.frame_count);
+		fprintf(file, ",\n");
+		writeBenchStats(file, "\t\t\t", "frame_ms", frame_ms, options.frame_count);
+		fprintf(file, "\n\t\t}");
+	}
+	fprintf(file, "\n\t]\n");
+
+	delete [] gpu_ms;
+	delete [] cpu_ms;
+	delete [] frame_ms;
+	return exit_code;
+}
+
+int App::compareShaders(const BenchOptions &options, BenchTarget *target, FILE *file) {
+	const char *filepaths[2] = {options.shader_filepaths[0], options.shader_filepaths[1]};
+	fprintf(file, "\t\"a\": "); writeJsonString(file, filepaths[0]); fprintf(file, ",\n");
+	fprintf(file, "\t\"b\": "); writeJsonString(file, filepaths[1]); fprintf(file, ",\n");
+
+	// a is the app's shader with the uniforms of its .uniformdata, b gets the same values
+	BenchProgram program_b;
+	char *error = loadBenchShader(filepaths[0]);
+	int failed = 0;
+	if (!error) {
+		failed = 1;
+		char *src = readStringFromFile(filepaths[1]);
+		char *validation_log;
+		if (!src) {
+			const char *message = "could not read the file";
+			error = new char[strlen(message)+1];
+			strcpy(error, message);
+		} else if (validateGlsl(src, &validation_log)) {
+			error = validation_log;
+		} else {
+			error = program_b.compile(src, options.optimize);
+		}
+		if (src) delete [] src;
+	}
+	if (error) {
+		LOGE("Comparison failed, %s: %s", filepaths[failed], error);
+		fprintf(file, "\t\"error\": ");
+		writeJsonString(file, error);
+		fprintf(file, ",\n\t\"failed\": ");
+		writeJsonString(file, filepaths[failed]);
+		fprintf(file, "\n");
+		delete [] error;
+		program_b.release();
+		return 1;
+	}
+	program_b.connect(uniforms, uniform_count);
+	int unconnected_count = 0; // builtins are set at draw time
+	for (int i = 0; i < program_b.input_count; i++) {
+		const char *name = program_b.inputs[i].name;
+		if (program_b.inputs[i].data || !strcmp(name, u_time_name) || !strcmp(name, u_resolution_name)
+			|| !strcmp(name, u_view_to_world_name) || !strcmp(name, u_world_to_view_name)
+			|| !strncmp(name, "u_data", 6)) continue;
+		unconnected_count++;
+	}
+	if (unconnected_count) LOGW("%d uniforms of %s aren't in %s and stay 0", unconnected_count, filepaths[1], filepaths[0]);
+	LOGI("Comparing %s and %s (%d frames)", filepaths[0], filepaths[1], options.warmup_count + options.frame_count);
+
+	// timer queries if possible, otherwise each draw is fenced by glFinish
+	bool has_timer_queries = shader_timer.isSupported();
+	GLuint *queries = nullptr; // a and b of each measured frame
+	if (has_timer_queries) {
+		queries = new GLuint[2*options.frame_count];
+		glGenQueries(2*options.frame_count, queries);
+	}
+	float *ms[2] = {new float[options.frame_count], new float[options.frame_count]};
+	double ticks_to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+	// images are compared at a few frames, outside of the timed draws
+	size_t image_size = (size_t)4*options.width*options.height;
+	u8 *images[2] = {new u8[image_size], new u8[image_size]};
+	u8 *diff_image = options.diff_filepath ? new u8[image_size] : nullptr;
+	u8 *worst_diff_image = options.diff_filepath ? new u8[image_size] : nullptr;
+	int diff_interval = options.frame_count >= 8 ? options.frame_count / 8 : 1;
+	int compared_frame_count = 0;
+	int worst_frame = -1;
+	ImageDiffStats worst = {};
+	float min_psnr = INFINITY;
+
+	resetCamera();
+	mat4 view_to_world = translationMatrix(camera_location);
+	mat4 world_to_view = translationMatrix(-camera_location);
+
+	int total_frame_count = options.warmup_count + options.frame_count;
+	for (int frame = 0; frame < total_frame_count; frame++) {
+		int measured = frame - options.warmup_count; // negative while warming up
+		SDL_PumpEvents(); // keeps the window responsive
+		prepareBenchFrame(frame);
+
+		// alternating order, so neither profits from caches warmed up by the other
+		for (int k = 0; k < 2; k++) {
+			int variant = k ^ (frame & 1);
+			target->bind();
+			u64 begin_ticks = 0;
+			if (measured >= 0) {
+				if (queries) {
+					glBeginQuery(GL_TIME_ELAPSED, queries[2*measured + variant]);
+				} else {
+					glFinish();
+					begin_ticks = SDL_GetPerformanceCounter();
+				}
+			}
+			if (variant == 0) drawShader(view_to_world, world_to_view);
+			else drawBenchProgram(&program_b, view_to_world, world_to_view);
+			if (measured >= 0) {
+				if (queries) {
+					glEndQuery(GL_TIME_ELAPSED);
+				} else {
+					glFinish();
+					ms[variant][measured] = (float)((SDL_GetPerformanceCounter() - begin_ticks)*ticks_to_ms);
+				}
+			}
+		}
+
+		if (measured >= 0 && measured % diff_interval == 0) {
+			target->bind();
+			drawShader(view_to_world, world_to_view);
+			target->readPixels(images[0]);
+			target->bind();
+			drawBenchProgram(&program_b, view_to_world, world_to_view);
+			target->readPixels(images[1]);
+			ImageDiffStats diff;
+			diffImages(images[0], images[1], options.width, options.height, &diff, diff_image);
+			if (worst_frame < 0 || diff.differing_pixel_count > worst.differing_pixel_count
+				|| (diff.differing_pixel_count == worst.differing_pixel_count && diff.max_difference > worst.max_difference)) {
+				worst = diff;
+				worst_frame = frame;
+				if (diff_image) memcpy(worst_diff_image, diff_image, image_size);
+			}
+			if (diff.psnr < min_psnr) min_psnr = diff.psnr;
+			compared_frame_count++;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (options.headless) glFlush();
+		else target->present(single_triangle_vbo);
+	}
+	glFinish();
+
+	if (queries) {
+		for (int i = 0; i < options.frame_count; i++) {
+			for (int variant = 0; variant < 2; variant++) {
+				GLuint nanoseconds = 0;
+				glGetQueryObjectuiv(queries[2*i + variant], GL_QUERY_RESULT, &nanoseconds);
+				ms[variant][i] = nanoseconds*1e-6f;
+			}
+		}
+		glDeleteQueries(2*options.frame_count, queries);
+		delete [] queries;
+	}
+
+	BenchSpeedup speedup;
+	computeBenchSpeedup(ms[0], ms[1], options.frame_count, &speedup);
+	bool is_significant = speedup.pair_count >= 2 && (speedup.low > 1.0f || speedup.high < 1.0f);
+	LOGI("Speedup of %s: %.3fx (95%% CI %.3f-%.3f), %d of %d pixels differ",
+		filepaths[1], speedup.speedup, speedup.low, speedup.high, worst.differing_pixel_count, worst.pixel_count);
+
+	fprintf(file, "\t\"timing\": \"%s\",\n", has_timer_queries ? "timer_query" : "finish");
+	fprintf(file, "\t\"a_optimized\": %s,\n", is_shader_optimized ? "true" : "false");
+	fprintf(file, "\t\"b_optimized\": %s,\n", program_b.is_optimized ? "true" : "false");
+	writeBenchStats(file, "\t", "a_ms", ms[0], options.frame_count);
+	fprintf(file, ",\n");
+	writeBenchStats(file, "\t", "b_ms", ms[1], options.frame_count);
+	fprintf(file, ",\n");
+	fprintf(file, "\t\"speedup\": {\"value\": %.4f, \"ci95_low\": %.4f, \"ci95_high\": %.4f, \"pairs\": %d, \"significant\": %s},\n",
+		speedup.speedup, speedup.low, speedup.high, speedup.pair_count, is_significant ? "true" : "false");
+	fprintf(file, "\t\"image_diff\": {\"compared_frames\": %d, \"worst_frame\": %d, \"differing_pixels\": %d, \"perceptual_pixels\": %d, "
+		"\"differing_fraction\": %.6f, \"max_difference\": %d, \"mean_difference\": %.4f, ",
+		compared_frame_count, worst_frame, worst.differing_pixel_count, worst.perceptual_pixel_count,
+		worst.pixel_count ? (double)worst.differing_pixel_count / worst.pixel_count : 0.0,
+		worst.max_difference, worst.mean_difference);
+	if (isinf(min_psnr)) fprintf(file, "\"min_psnr\": null},\n"); // identical
+	else fprintf(file, "\"min_psnr\": %.2f},\n", min_psnr);
+	fprintf(file, "\t\"identical\": %s\n", worst.differing_pixel_count ? "false" : "true");
+
+	if (worst_diff_image && !writeTga(options.diff_filepath, worst_diff_image, options.width, options.height)) {
+		LOGW("Diff image wasn't written");
+	}
+	delete [] ms[0];
+	delete [] ms[1];
+	delete [] images[0];
+	delete [] images[1];
+	if (diff_image) delete [] diff_image;
+	if (worst_diff_image) delete [] worst_diff_image;
+	program_b.release();
+	return 0;
+}
+
+// golden images are rendered at these sizes and frames, independent of --res
+static const int regress_sizes[][2] = {{96, 54}, {384, 216}};
+static const int regress_frames[] = {0, 60, 150}; // u_time 0, 1 and 2.5 s
+
+static void flipRows(u8 *rgba, int width, int height) {
+	size_t row_size = (size_t)4*width;
+	u8 *row = new u8[row_size];
+	for (int y = 0; y < height/2; y++) {
+		u8 *top = rgba + y*row_size, *bottom = rgba + (height-1-y)*row_size;
+		memcpy(row, top, row_size);
+		memcpy(top, bottom, row_size);
+		memcpy(bottom, row, row_size);
+	}
+	delete [] row;
+}
+
+// "llvmpipe (LLVM 15.0.6, 256 bits)" -> "llvmpipe", usable as a directory name
+static void getRendererKey(const char *renderer, char *key, size_t key_size) {
+	size_t len = 0;
+	for (const char *c = renderer; *c && len+1 < key_size; c++) {
+		if (c[0] == ' ' && c[1] == '(') break;
+		bool is_safe = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '.' || *c == '-';
+		key[len++] = is_safe ? *c : '_';
+	}
+	key[len] = '\0';
+}
+
+int App::regressShaders(const BenchOptions &options, BenchTarget *target, FILE *file) {
+	const char *renderer = (const char*)glGetString(GL_RENDERER);
+	char resolution[32];
+	snprintf(resolution, sizeof(resolution), "%dx%d", options.width, options.height);
+
+	// golden/<renderer>/ next to the first shader, images differ between renderers
+	const char *first_filepath = options.shader_filepaths[0];
+	char renderer_key[128];
+	getRendererKey(renderer, renderer_key, sizeof(renderer_key));
+	char golden_dirpath[1024];
+	int golden_parent_len = snprintf(golden_dirpath, sizeof(golden_dirpath), "%.*sgolden",
+		(int)(getFilename(first_filepath) - first_filepath), first_filepath);
+	if (options.update) makeDirectory(golden_dirpath);
+	snprintf(golden_dirpath + golden_parent_len, sizeof(golden_dirpath) - golden_parent_len, "/%s", renderer_key);
+	if (options.update) makeDirectory(golden_dirpath);
+	bool has_diff_dir = false;
+
+	// baselines are only comparable on the same renderer at the same size
+	char baselines_filepath[1024];
+	snprintf(baselines_filepath, sizeof(baselines_filepath), "%s/baselines.ini", golden_dirpath);
+	char *baseline_renderer = nullptr;
+	char *baseline_resolution = nullptr;
+	float *baselines = new float[options.shader_count]; // 0: none
+	float *medians = new float[options.shader_count]; // 0: not measured
+	IniVar *baseline_vars = new IniVar[options.shader_count+2];
+	baseline_vars[0] = {"renderer", INI_VAR_STRING, &baseline_renderer};
+	baseline_vars[1] = {"resolution", INI_VAR_STRING, &baseline_resolution};
+	for (int si = 0; si < options.shader_count; si++) {
+		baselines[si] = medians[si] = 0.0f;
+		baseline_vars[2+si] = {getFilename(options.shader_filepaths[si]), INI_VAR_FLOAT, baselines + si};
+	}
+	char *baselines_str = readStringFromFile(baselines_filepath);
+	if (baselines_str) {
+		parseIniString(baselines_str, baseline_vars, options.shader_count+2);
+		delete [] baselines_str;
+	}
+	bool has_baselines = !options.update && baseline_renderer && baseline_resolution
+		&& !strcmp(baseline_renderer, renderer) && !strcmp(baseline_resolution, resolution);
+	if (!options.update && !has_baselines) {
+		LOGW("No GPU time baselines of %s at %s in %s, times aren't compared", renderer, resolution, baselines_filepath);
+	}
+
+	BenchTarget size_targets[ARRAY_COUNT(regress_sizes)];
+	for (int ri = 0; ri < (int)ARRAY_COUNT(regress_sizes); ri++) {
+		size_targets[ri].create(regress_sizes[ri][0], regress_sizes[ri][1]);
+	}
+	size_t max_image_size = (size_t)4*regress_sizes[ARRAY_COUNT(regress_sizes)-1][0]*regress_sizes[ARRAY_COUNT(regress_sizes)-1][1];
+	u8 *actual = new u8[max_image_size];
+	u8 *diff_image = new u8[max_image_size];
+	float *gpu_ms = new float[options.frame_count];
+	float *cpu_ms = new float[options.frame_count];
+	float *frame_ms = new float[options.frame_count];
+
+	resetCamera();
+	mat4 view_to_world = translationMatrix(camera_location);
+	mat4 world_to_view = translationMatrix(-camera_location);
+
+	fprintf(file, "\t\"update\": %s,\n", options.update ? "true" : "false");
+	fprintf(file, "\t\"results\": [");
+	int check_count = 0;
+	int failure_count = 0;
+	int skipped_count = 0; // images without a golden
+	int result_count = 0;
+	for (int si = 0; si < options.shader_count; si++) {
+		const char *filepath = options.shader_filepaths[si];
+		if (isBakeShader(filepath)) continue; // rendered by the shader next to it
+		const char *name = getFilename(filepath);
+
+		fprintf(file, result_count++ ? ",\n" : "\n");
+		fprintf(file, "\t\t{\n\t\t\t\"shader\": ");
+		writeJsonString(file, filepath);
+		fprintf(file, ",\n");
+
+		char *error = loadBenchShader(filepath);
+		if (error) {
+			LOGE("FAIL %s: %s", filepath, error);
+			fprintf(file, "\t\t\t\"error\": ");
+			writeJsonString(file, error);
+			fprintf(file, "\n\t\t}");
+			delete [] error;
+			check_count++;
+			failure_count++;
+			continue;
+		}
+
+		fprintf(file, "\t\t\t\"images\": [");
+		int image_count = 0;
+		for (int ri = 0; ri < (int)ARRAY_COUNT(regress_sizes); ri++) {
+			BenchTarget *size_target = size_targets + ri;
+			if (!size_target->framebuffer) continue;
+			int width = size_target->width, height = size_target->height;
+			video.width = width; // u_resolution
+			video.height = height;
+			for (int fi = 0; fi < (int)ARRAY_COUNT(regress_frames); fi++) {
+				int frame = regress_frames[fi];
+				prepareBenchFrame(frame);
+				size_target->bind();
+				drawShader(view_to_world, world_to_view);
+				size_target->readPixels(actual);
+
+				char golden_filepath[1024];
+				snprintf(golden_filepath, sizeof(golden_filepath), "%s/%s.%dx%d.f%d.tga", golden_dirpath, name, width, height, frame);
+				fprintf(file, "%s\t\t\t\t{\"size\": \"%dx%d\", \"frame\": %d, ", image_count++ ? ",\n" : "\n", width, height, frame);
+				if (options.update) {
+					bool is_written = writeTga(golden_filepath, actual, width, height);
+					fprintf(file, "\"status\": \"%s\"}", is_written ? "updated" : "write_failed");
+					check_count++;
+					if (!is_written) failure_count++;
+					continue;
+				}
+
+				int golden_width, golden_height, channel_count;
+				u8 *golden = stbi_load(golden_filepath, &golden_width, &golden_height, &channel_count, 4);
+				if (!golden && !options.strict) { // only some renderers have goldens
+					LOGW("SKIP %s %dx%d frame %d: no golden image %s, record it with --update", name, width, height, frame, golden_filepath);
+					fprintf(file, "\"status\": \"skipped\"}");
+					skipped_count++;
+					continue;
+				}
+				check_count++;
+				if (!golden || golden_width != width || golden_height != height) {
+					LOGE("FAIL %s %dx%d frame %d: %s golden image %s, record it with --update",
+						name, width, height, frame, golden ? "wrong size of the" : "no", golden_filepath);
+					fprintf(file, "\"status\": \"%s\"}", golden ? "wrong_size" : "missing");
+					if (golden) stbi_image_free(golden);
+					failure_count++;
+					continue;
+				}
+				flipRows(golden, width, height); // glReadPixels order
+				ImageDiffStats diff;
+				diffImages(golden, actual, width, height, &diff, diff_image, options.perceptual_threshold);
+				stbi_image_free(golden);
+				bool is_failed = diff.perceptual_pixel_count > (int)(options.max_differing_fraction*diff.pixel_count);
+				fprintf(file, "\"status\": \"%s\", \"perceptual_pixels\": %d, \"differing_pixels\": %d, \"max_difference\": %d",
+					is_failed ? "fail" : "pass", diff.perceptual_pixel_count, diff.differing_pixel_count, diff.max_difference);
+				if (is_failed) {
+					if (!has_diff_dir) {
+						makeDirectory(options.diff_dirpath);
+						has_diff_dir = true;
+					}
+					char diff_filepath[1024];
+					snprintf(diff_filepath, sizeof(diff_filepath), "%s/%s.%dx%d.f%d", options.diff_dirpath, name, width, height, frame);
+					size_t stem_len = strlen(diff_filepath);
+					snprintf(diff_filepath + stem_len, sizeof(diff_filepath) - stem_len, ".actual.tga");
+					writeTga(diff_filepath, actual, width, height);
+					snprintf(diff_filepath + stem_len, sizeof(diff_filepath) - stem_len, ".diff.tga");
+					writeTga(diff_filepath, diff_image, width, height);
+					fprintf(file, ", \"diff\": ");
+					writeJsonString(file, diff_filepath);
+					LOGE("FAIL %s %dx%d frame %d: %d pixels differ (max %d), see %s",
+						name, width, height, frame, diff.perceptual_pixel_count, diff.max_difference, diff_filepath);
+					failure_count++;
+				}
+				fprintf(file, "}");
+			}
+		}
+		fprintf(file, "\n\t\t\t],\n");
+		video.width = options.width;
+		video.height = options.height;
+
+		// GPU time at --res
+		if (measureBenchFrames(options, target, gpu_ms, cpu_ms, frame_ms)) {
+			BenchStats stats;
+			computeBenchStats(gpu_ms, options.frame_count, &stats);
+			medians[si] = stats.median;
+			fprintf(file, "\t\t\t\"gpu_median_ms\": %.4f,\n", stats.median);
+		} else {
+			fprintf(file, "\t\t\t\"gpu_median_ms\": null,\n");
+		}
+		if (options.update || !has_baselines || baselines[si] <= 0.0f || medians[si] <= 0.0f) {
+			fprintf(file, "\t\t\t\"timing\": \"%s\"\n\t\t}", options.update && medians[si] > 0.0f ? "updated" : "skipped");
+			continue;
+		}
+		float delta = medians[si]/baselines[si] - 1.0f;
+		bool is_slower = delta > options.time_threshold;
+		fprintf(file, "\t\t\t\"baseline_ms\": %.4f,\n\t\t\t\"delta\": %.4f,\n\t\t\t\"timing\": \"%s\"\n\t\t}",
+			baselines[si], delta, is_slower ? "fail" : "pass");
+		check_count++;
+		if (is_slower) {
+			LOGE("FAIL %s: GPU time %.3f ms, baseline %.3f ms (%+.1f%%)", name, medians[si], baselines[si], 100.0f*delta);
+			failure_count++;
+		}
+	}
+	fprintf(file, "\n\t],\n");
+	fprintf(file, "\t\"checks\": %d,\n\t\"failures\": %d,\n\t\"skipped\": %d\n", check_count, failure_count, skipped_count);
+
+	if (options.update) {
+		FILE *baselines_file = fopen(baselines_filepath, "w");
+		if (baselines_file) {
+			fprintf(baselines_file, "renderer=%s\n", renderer);
+			fprintf(baselines_file, "resolution=%s\n", resolution);
+			for (int si = 0; si < options.shader_count; si++) {
+				if (medians[si] > 0.0f) fprintf(baselines_file, "%s=%.4f\n", getFilename(options.shader_filepaths[si]), medians[si]);
+			}
+			fclose(baselines_file);
+		} else {
+			LOGE("Could not write %s", baselines_filepath);
+			failure_count++;
+		}
+	}
+	if (failure_count) LOGE("%d of %d regression checks failed", failure_count, check_count);
+	else if (!check_count) LOGE("No regression checks ran, there are no goldens in %s", golden_dirpath);
+	else LOGI("All %d regression checks passed", check_count);
+	if (skipped_count) LOGW("%d images skipped without a golden image, --strict fails them", skipped_count);
+
+	for (int ri = 0; ri < (int)ARRAY_COUNT(regress_sizes); ri++) size_targets[ri].release();
+	delete [] actual;
+	delete [] diff_image;
+	delete [] gpu_ms;
+	delete [] cpu_ms;
+	delete [] frame_ms;
+	delete [] baselines;
+	delete [] medians;
+	delete [] baseline_vars;
+	if (baseline_renderer) delete [] baseline_renderer;
+	if (baseline_resolution) delete [] baseline_resolution;
+	return failure_count || !check_count ? 1 : 0; // nothing checked is no pass
+}
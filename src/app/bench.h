@@ -0,0 +1,80 @@
+// Command line benchmarks of fragment shaders:
+//   twotris --bench a.frag [b.frag ...] [options]
+//   twotris --compare a.frag b.frag [--diff-out diff.tga] [options]
+//   twotris --regress a.frag [b.frag ...] [--update] [--strict] [options]
+// options: --res 1920x1080 --frames 500 --warmup 50 --headless --optimize
+//          --out results.json
+// Shaders are rendered into a framebuffer of the given size without vsync,
+// u_time advances by 1/60 s per frame from 0, the camera is at its reset
+// position and uniforms come from the shader's .uniformdata. Preferences and
+// the session aren't read, so results only depend on the files and the GPU.
+// --bench writes per frame GPU time (timer queries), CPU time and frame time
+// as JSON with mean, median, p95 and p99 and the GL vendor, renderer and version.
+// --compare draws both shaders every frame in alternating order, b with the
+// uniform values of a, and reports the speedup of b with a 95% confidence
+// interval and how much their images differ.
+// --regress renders each shader at fixed sizes and times and compares the
+// images to golden images in golden/<renderer>/ next to the first shader
+// with a perceptual tolerance, and the median GPU time at --res to the
+// baselines recorded there. Failures are written to --diff-dir as the actual
+// and the diff image. --update records new golden images and baselines
+// instead. Images without a golden are skipped, --strict fails them, and a
+// run that checked nothing fails.
+enum BenchMode {
+	BM_NONE,
+	BM_BENCH,
+	BM_COMPARE,
+	BM_REGRESS
+};
+
+struct BenchOptions {
+	BenchMode mode = BM_NONE;
+	char **shader_filepaths = nullptr; // points into argv
+	int shader_count = 0;
+	int width = 1920, height = 1080;
+	int frame_count = 500;
+	int warmup_count = 50; // not measured
+	bool headless = false; // hidden window, otherwise frames are shown and swapped
+	bool optimize = false; // GLSL optimizer pass before compiling
+	const char *out_filepath = nullptr; // stdout if not given
+	const char *diff_filepath = nullptr; // --compare: image of the frame that differs most
+	// --regress
+	bool update = false;
+	bool strict = false; // images without a golden fail instead of being skipped
+	float perceptual_threshold = 0.1f; // per pixel, 0..1
+	float max_differing_fraction = 0.001f; // of perceptually differing pixels
+	float time_threshold = 0.15f; // slowdown relative to the baseline
+	const char *diff_dirpath = "regress_diff";
+};
+
+// 0: no benchmark mode given, 1: benchmark, -1: invalid arguments (logged)
+int parseBenchArgs(int argc, char *argv[], BenchOptions *options);
+
+struct BenchStats { // milliseconds
+	float mean, median, p95, p99, min, max;
+};
+
+void computeBenchStats(const float *samples, int count, BenchStats *stats);
+
+// ratio of paired times a/b as the geometric mean, > 1 if b is faster
+struct BenchSpeedup {
+	float speedup;
+	float low, high; // 95% confidence interval
+	int pair_count;
+};
+
+void computeBenchSpeedup(const float *a, const float *b, int count, BenchSpeedup *speedup);
+
+struct BenchTarget; // offscreen frame, in bench.cpp
+
+// second shader of a comparison, its uniforms point into the data of the first
+struct BenchProgram {
+	Shader shader;
+	ShaderUniform *inputs = nullptr;
+	int input_count = 0;
+	bool is_optimized = false;
+
+	char *compile(const char *src, bool optimize); // returns the new[]'d error log or nullptr
+	void connect(ShaderUniform *uniforms, int uniform_count); // by name, type and size
+	void release();
+};
@@ -0,0 +1,422 @@
+int parseReplayArgs(int argc, char *argv[], ReplayOptions *options) {
+	const char *invalid_arg = nullptr; // only an error with --record or --replay, os x may pass -psn_...
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool has_value = i+1 < argc;
+		if (!strcmp(arg, "--record") && has_value) {
+			options->record_filepath = argv[++i];
+		} else if (!strcmp(arg, "--replay") && has_value) {
+			options->replay_filepath = argv[++i];
+		} else if (!strcmp(arg, "--repeat") && has_value) {
+			options->repeat_count = atoi(argv[++i]);
+			if (options->repeat_count <= 0 && !invalid_arg) invalid_arg = argv[i];
+		} else if (!strcmp(arg, "--out") && has_value) {
+			options->out_filepath = argv[++i];
+		} else if (!strcmp(arg, "--fast-start")) { // handled in main
+		} else if (!invalid_arg) {
+			invalid_arg = arg;
+		}
+	}
+	if (!options->record_filepath && !options->replay_filepath) return 0;
+	if (invalid_arg) {
+		LOGE("Invalid replay argument: %s", invalid_arg);
+		return -1;
+	}
+	if (options->record_filepath && options->replay_filepath) {
+		LOGE("--record and --replay can't be combined");
+		return -1;
+	}
+	return 1;
+}
+
+bool ReplayLog::openWrite(const char *filepath) {
+	close();
+	file = fopen(filepath, "wb");
+	if (!file) {
+		LOGE("Could not open %s for writing", filepath);
+		return false;
+	}
+	is_writing = true;
+	has_error = false;
+	return true;
+}
+
+bool ReplayLog::openRead(const char *filepath) {
+	close();
+	file = fopen(filepath, "rb");
+	if (!file) {
+		LOGE("Could not open %s", filepath);
+		return false;
+	}
+	is_writing = false;
+	has_error = false;
+	return true;
+}
+
+void ReplayLog::close() {
+	if (file) fclose(file);
+	file = nullptr;
+}
+
+void ReplayLog::write(const void *data, size_t size) {
+	if (size && fwrite(data, size, 1, file) != 1) has_error = true;
+}
+
+void ReplayLog::writeString(const char *str) {
+	u32 len = str ? (u32)strlen(str) : 0;
+	write(&len, sizeof(len));
+	write(str, len);
+}
+
+bool ReplayLog::read(void *data, size_t size) {
+	if (size && fread(data, size, 1, file) != 1) has_error = true;
+	return !has_error;
+}
+
+char *ReplayLog::readString() {
+	u32 len;
+	if (!read(&len, sizeof(len))) return nullptr;
+	if (len > (64u << 20)) { // larger than any source or path
+		has_error = true;
+		return nullptr;
+	}
+	char *str = new char[len+1];
+	if (!read(str, len)) {
+		delete [] str;
+		return nullptr;
+	}
+	str[len] = '\0';
+	return str;
+}
+
+int ReplayLog::peek() {
+	int c = fgetc(file);
+	if (c != EOF) ungetc(c, file);
+	return c;
+}
+
+static const char *replay_fourcc = "RPLY";
+static const u32 replay_version = 1;
+static const float replay_timestep = 1.0f / 60.0f;
+
+void App::writeReplayHeader() {
+	replay_log.write(replay_fourcc, 4);
+	replay_log.write(&replay_version, sizeof(u32));
+	replay_log.write(&video.width, sizeof(int));
+	replay_log.write(&video.height, sizeof(int));
+	u8 optimize = optimize_shader ? 1 : 0;
+	replay_log.write(&optimize, sizeof(u8));
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		TextureSlot *texture_slot = texture_slots + tsi;
+		const char *prefix = getTextureSlotIniPrefix(texture_slot);
+		if (texture_slot->image_filepath && prefix) {
+			char *texture_slot_str = new char[strlen(prefix)+strlen(texture_slot->image_filepath)+1];
+			strcpy(texture_slot_str, prefix);
+			strcat(texture_slot_str, texture_slot->image_filepath);
+			replay_log.writeString(texture_slot_str);
+			delete [] texture_slot_str;
+		} else {
+			replay_log.writeString(nullptr);
+		}
+	}
+	replay_log.writeString(u_time_name);
+	replay_log.writeString(u_resolution_name);
+	replay_log.writeString(u_view_to_world_name);
+	replay_log.writeString(u_world_to_view_name);
+	replay_log.writeString(shader_filepath);
+	replay_log.writeString(src_edit_buffer);
+}
+
+bool App::readReplayHeader(bool is_repeat) {
+	u32 fourcc = 0, version = 0;
+	replay_log.read(&fourcc, sizeof(u32));
+	replay_log.read(&version, sizeof(u32));
+	if (fourcc != *((u32*)replay_fourcc) || version != replay_version) {
+		LOGE("Not a valid replay file: %s", replay_options.replay_filepath);
+		return false;
+	}
+	int width = 0, height = 0;
+	u8 optimize = 0;
+	replay_log.read(&width, sizeof(int));
+	replay_log.read(&height, sizeof(int));
+	replay_log.read(&optimize, sizeof(u8));
+	if (!is_repeat) { // the window keeps the size it has by now
+		video.width = width;
+		video.height = height;
+	}
+	optimize_shader = !!optimize;
+
+	// slots are loaded in init(), repeats keep them
+	for (int tsi = 0; tsi < (int)ARRAY_COUNT(texture_slots); tsi++) {
+		char *texture_slot_str = replay_log.readString();
+		if (!texture_slot_str) return false;
+		if (!is_repeat && texture_slot_str[0]) setTextureSlotFromIniString(texture_slots + tsi, texture_slot_str);
+		delete [] texture_slot_str;
+	}
+
+	char *builtin_names[4] = {u_time_name, u_resolution_name, u_view_to_world_name, u_world_to_view_name};
+	for (int i = 0; i < (int)ARRAY_COUNT(builtin_names); i++) {
+		char *name = replay_log.readString();
+		if (!name) return false;
+		strncpy(builtin_names[i], name, sizeof(u_time_name)-1);
+		delete [] name;
+	}
+
+	char *filepath = replay_log.readString();
+	if (!filepath) return false;
+	if (shader_filepath) delete [] shader_filepath;
+	shader_filepath = filepath[0] ? filepath : nullptr; // for the bake pass next to it
+	if (!shader_filepath) delete [] filepath;
+	if (replay_src) delete [] replay_src;
+	replay_src = replay_log.readString();
+	return !!replay_src;
+}
+
+bool App::openReplay(const ReplayOptions &options) {
+	replay_options = options;
+	if (!replay_log.openRead(options.replay_filepath)) return false;
+	if (!readReplayHeader(/*is_repeat*/false)) {
+		if (replay_log.has_error) LOGE("Replay header of %s is incomplete", options.replay_filepath);
+		replay_log.close();
+		return false;
+	}
+	// nothing but the log changes what is drawn
+	shader_file_autoreload = false;
+	texture_file_autoreload = false;
+	replay_pass = 0;
+	replay_frame_ticks = 0;
+	replay_sample_count = 0;
+	LOGI("Replaying %s", options.replay_filepath);
+	return true;
+}
+
+bool App::startRecording(const char *filepath) {
+	if (isReplaying() || !replay_log.openWrite(filepath)) return false;
+	writeReplayHeader();
+	recorded_uniform_count = -1; // the first frame records all values
+	recorded_frame_count = 0;
+	LOGI("Recording to %s", filepath);
+	return true;
+}
+
+void App::stopRecording() {
+	if (!isRecording()) return;
+	if (replay_log.has_error) LOGE("Could not write the whole replay, stopped after %d frames", recorded_frame_count);
+	else LOGI("Recorded %d frames", recorded_frame_count);
+	replay_log.close();
+	if (recorded_uniform_data) delete [] recorded_uniform_data;
+	recorded_uniform_data = nullptr;
+}
+
+void App::recordReplayDialog() {
+	PROFILE_ZONE("file dialog");
+	char *out_filepath = nullptr;
+	nfdresult_t result = NFD_SaveDialog("replay", nullptr, &out_filepath);
+	SDL_RaiseWindow(sdl_window); // workaround: focus window again after dialog closes
+	if (result == NFD_OKAY) {
+		startRecording(out_filepath);
+		free(out_filepath);
+	}
+}
+
+void App::recordFrame(float delta_time) {
+	if (replay_log.has_error) {
+		stopRecording();
+		return;
+	}
+	u8 type = RE_FRAME;
+	u8 flags = (anim_play ? RFF_ANIM_PLAY : 0) | (hide_gui ? RFF_HIDE_GUI : 0);
+	replay_log.write(&type, sizeof(u8));
+	replay_log.write(&delta_time, sizeof(float));
+	replay_log.write(&movement_command.move, sizeof(vec3));
+	replay_log.write(&movement_command.rotate, sizeof(vec2));
+	replay_log.write(&camera_location, sizeof(vec3));
+	replay_log.write(&camera_euler_angles, sizeof(vec3));
+	replay_log.write(&frame_count, sizeof(u64));
+	replay_log.write(&flags, sizeof(u8));
+	recorded_frame_count++;
+}
+
+void App::recordShaderSource(const char *shader_src) {
+	u8 type = RE_SHADER;
+	replay_log.write(&type, sizeof(u8));
+	replay_log.writeString(shader_src);
+}
+
+void App::recordUniformChanges() {
+	// a recompile changes the layout, the values moved over are written again
+	bool is_new_layout = recorded_uniform_count != uniform_count
+		|| (uniform_count && recorded_uniform_data_size != uniform_data_size);
+	if (is_new_layout) {
+		if (recorded_uniform_data) delete [] recorded_uniform_data;
+		recorded_uniform_data = uniform_count ? new u8[uniform_data_size] : nullptr;
+		recorded_uniform_data_size = uniform_count ? uniform_data_size : 0;
+		recorded_uniform_count = uniform_count;
+	}
+	for (int ui = 0; ui < uniform_count; ui++) {
+		ShaderUniform *uniform = uniforms + ui;
+		size_t offset = uniform->data - uniform_data;
+		u32 size = (u32)uniform->getSize();
+		if (!is_new_layout && !memcmp(recorded_uniform_data + offset, uniform->data, size)) continue;
+		u8 type = RE_UNIFORM;
+		u32 uniform_type = (u32)uniform->type;
+		replay_log.write(&type, sizeof(u8));
+		replay_log.writeString(uniform->name);
+		replay_log.write(&uniform_type, sizeof(u32));
+		replay_log.write(&size, sizeof(u32));
+		replay_log.write(uniform->data, size);
+	}
+	if (uniform_count) memcpy(recorded_uniform_data, uniform_data, uniform_data_size);
+}
+
+bool App::applyReplayEvents() {
+	for (int type = replay_log.peek(); type != EOF && type != RE_FRAME; type = replay_log.peek()) {
+		fgetc(replay_log.file);
+		if (type == RE_SHADER) {
+			char *src = replay_log.readString();
+			if (!src) return false;
+			strncpy(src_edit_buffer, src, sizeof(src_edit_buffer)-1);
+			compileShader(src, /*recompile*/true);
+			delete [] src;
+		} else if (type == RE_UNIFORM) {
+			char *name = replay_log.readString();
+			if (!name) return false;
+			u32 uniform_type = 0, size = 0;
+			replay_log.read(&uniform_type, sizeof(u32));
+			replay_log.read(&size, sizeof(u32));
+			if (replay_log.has_error || size > (1u << 20)) {
+				delete [] name;
+				return false;
+			}
+			u8 *data = new u8[size];
+			bool is_read = replay_log.read(data, size);
+			for (int ui = 0; is_read && ui < uniform_count; ui++) {
+				ShaderUniform *uniform = uniforms + ui;
+				if (!strcmp(uniform->name, name) && uniform->type == uniform_type && uniform->getSize() == size) {
+					memcpy(uniform->data, data, size);
+					break;
+				}
+			}
+			delete [] data;
+			delete [] name;
+			if (!is_read) return false;
+		} else {
+			LOGE("Unknown replay event %d", type);
+			return false;
+		}
+	}
+	return true;
+}
+
+float App::replayFrame() {
+	if (replay_src) { // first frame of a pass, compiled like a newly loaded file
+		strncpy(src_edit_buffer, replay_src, sizeof(src_edit_buffer)-1);
+		compileShader(replay_src, /*recompile*/false);
+		delete [] replay_src;
+		replay_src = nullptr;
+		replay_frame_ticks = 0; // the compile isn't part of a frame
+	}
+	u64 ticks = SDL_GetPerformanceCounter();
+	if (!applyReplayEvents()) {
+		finishReplay(/*failed*/true);
+		return replay_timestep;
+	}
+	if (replay_log.peek() == EOF) {
+		if (++replay_pass < replay_options.repeat_count) {
+			fseek(replay_log.file, 0, SEEK_SET);
+			if (!readReplayHeader(/*is_repeat*/true)) finishReplay(/*failed*/true);
+			else LOGI("Replay pass %d of %d", replay_pass+1, replay_options.repeat_count);
+		} else {
+			finishReplay(/*failed*/false);
+		}
+		return replay_timestep; // this frame is drawn as it was left
+	}
+
+	u8 type, flags = 0;
+	replay_log.read(&type, sizeof(u8));
+	float delta_time; // as recorded, only kept for the record
+	replay_log.read(&delta_time, sizeof(float));
+	replay_log.read(&movement_command.move, sizeof(vec3));
+	replay_log.read(&movement_command.rotate, sizeof(vec2));
+	replay_log.read(&camera_location, sizeof(vec3));
+	replay_log.read(&camera_euler_angles, sizeof(vec3));
+	replay_log.read(&frame_count, sizeof(u64));
+	replay_log.read(&flags, sizeof(u8));
+	if (replay_log.has_error) {
+		finishReplay(/*failed*/true);
+		return replay_timestep;
+	}
+	anim_play = !!(flags & RFF_ANIM_PLAY);
+	hide_gui = !!(flags & RFF_HIDE_GUI);
+
+	if (replay_frame_ticks) { // since the last frame began, with the swap
+		if (replay_sample_count == replay_sample_capacity) {
+			replay_sample_capacity = replay_sample_capacity ? 2*replay_sample_capacity : 1024;
+			float *frame_ms = new float[replay_sample_capacity];
+			float *update_ms = new float[replay_sample_capacity];
+			if (replay_sample_count) {
+				memcpy(frame_ms, replay_frame_ms, replay_sample_count*sizeof(float));
+				memcpy(update_ms, replay_update_ms, replay_sample_count*sizeof(float));
+				delete [] replay_frame_ms;
+				delete [] replay_update_ms;
+			}
+			replay_frame_ms = frame_ms;
+			replay_update_ms = update_ms;
+		}
+		double ticks_to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+		replay_frame_ms[replay_sample_count] = (float)((double)(ticks - replay_frame_ticks) * ticks_to_ms);
+		replay_update_ms[replay_sample_count] = replay_last_update_ms;
+		replay_sample_count++;
+	}
+	replay_frame_ticks = ticks;
+	return replay_timestep;
+}
+
+void App::endReplayFrame() {
+	double ticks_to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+	replay_last_update_ms = (float)((double)(SDL_GetPerformanceCounter() - replay_frame_ticks) * ticks_to_ms);
+}
+
+void App::finishReplay(bool failed) {
+	replay_log.close();
+	if (replay_src) delete [] replay_src;
+	replay_src = nullptr;
+	is_replay_failed = failed;
+	quit = true;
+	if (failed) {
+		LOGE("Replay of %s stopped, the file is incomplete or invalid", replay_options.replay_filepath);
+	} else if (replay_sample_count) {
+		BenchStats frame_stats;
+		computeBenchStats(replay_frame_ms, replay_sample_count, &frame_stats);
+		LOGI("Replayed %d frames, frame time median %.3f ms, p99 %.3f ms",
+			replay_sample_count, frame_stats.median, frame_stats.p99);
+	}
+
+	if (replay_options.out_filepath) {
+		FILE *file = fopen(replay_options.out_filepath, "w");
+		if (!file) {
+			LOGE("Could not open %s for writing", replay_options.out_filepath);
+			is_replay_failed = true;
+		} else {
+			fprintf(file, "{\n");
+			fprintf(file, "\t\"replay\": "); writeJsonString(file, replay_options.replay_filepath); fprintf(file, ",\n");
+			fprintf(file, "\t\"vendor\": "); writeJsonString(file, (const char*)glGetString(GL_VENDOR)); fprintf(file, ",\n");
+			fprintf(file, "\t\"renderer\": "); writeJsonString(file, (const char*)glGetString(GL_RENDERER)); fprintf(file, ",\n");
+			fprintf(file, "\t\"version\": "); writeJsonString(file, (const char*)glGetString(GL_VERSION)); fprintf(file, ",\n");
+			fprintf(file, "\t\"complete\": %s,\n", failed ? "false" : "true");
+			fprintf(file, "\t\"repeats\": %d,\n", replay_options.repeat_count);
+			fprintf(file, "\t\"frames\": %d,\n", replay_sample_count);
+			writeBenchStats(file, "\t", "frame_ms", replay_frame_ms, replay_sample_count);
+			fprintf(file, ",\n");
+			writeBenchStats(file, "\t", "update_ms", replay_update_ms, replay_sample_count);
+			fprintf(file, "\n}\n");
+			fclose(file);
+		}
+	}
+	if (replay_sample_capacity) {
+		delete [] replay_frame_ms;
+		delete [] replay_update_ms;
+	}
+	replay_frame_ms = replay_update_ms = nullptr;
+	replay_sample_count = replay_sample_capacity = 0;
+}
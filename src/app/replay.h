@@ -0,0 +1,48 @@
+// Recording of the per frame input of App::update into a binary log and its
+// replay, so a camera flight or uniform drag can be profiled repeatedly:
+//   twotris --record flight.replay
+//   twotris --replay flight.replay [--repeat 3] [--out replay.json]
+// Recording can also be started and stopped in the Tools menu.
+// The header holds the window size, texture slots, built-in uniform names and
+// the editor source. Each frame then has a frame record with the movement
+// command, the camera, the frame count and the measured frame time, followed by
+// the sources compiled and the uniforms that changed during the frame.
+// Replays step App::update at a fixed 1/60 s with the recorded camera and
+// input, without vsync, and report frame and update times with --out.
+enum ReplayEventType {
+	RE_FRAME = 1,
+	RE_SHADER, // source compiled during the frame
+	RE_UNIFORM // by name, type and size
+};
+
+enum ReplayFrameFlags {
+	RFF_ANIM_PLAY = 1 << 0,
+	RFF_HIDE_GUI = 1 << 1
+};
+
+struct ReplayOptions {
+	const char *record_filepath = nullptr;
+	const char *replay_filepath = nullptr;
+	int repeat_count = 1;
+	const char *out_filepath = nullptr; // replay times as JSON
+};
+
+// 0: neither given, 1: record or replay, -1: invalid arguments (logged)
+int parseReplayArgs(int argc, char *argv[], ReplayOptions *options);
+
+// little endian like the .uniformdata files
+struct ReplayLog {
+	FILE *file = nullptr;
+	bool is_writing = false;
+	bool has_error = false; // short read or write, the log is closed at the next frame
+
+	bool openWrite(const char *filepath);
+	bool openRead(const char *filepath);
+	void close();
+
+	void write(const void *data, size_t size);
+	void writeString(const char *str);
+	bool read(void *data, size_t size);
+	char *readString(); // new[]'d, nullptr on error
+	int peek(); // next event type or EOF
+};
@@ -0,0 +1,289 @@
+void AudioFFT::init() {
+	int bits = 0;
+	while ((1 << bits) < audio_fft_size) bits++;
+	for (int i = 0; i < audio_fft_size; i++) {
+		int r = 0;
+		for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits-1-b);
+		bit_reverse[i] = (u16)r;
+		window[i] = 0.5f - 0.5f*cosf(2.0f*(float)M_PI*i/(audio_fft_size-1));
+	}
+	// stage with butterfly span h uses w^k = exp(-i*pi*k/h) for k in [0, h)
+	for (int h = 1; h < audio_fft_size; h *= 2) {
+		for (int k = 0; k < h; k++) {
+			twiddle_re[h-1+k] = cosf((float)M_PI*k/h);
+			twiddle_im[h-1+k] = -sinf((float)M_PI*k/h);
+		}
+	}
+}
+
+void AudioFFT::transform() {
+	for (int h = 1; h < audio_fft_size; h *= 2) {
+		const float *wr = twiddle_re + h-1;
+		const float *wi = twiddle_im + h-1;
+		for (int start = 0; start < audio_fft_size; start += 2*h) {
+			float *ar = re + start, *ai = im + start;
+			float *br = ar + h, *bi = ai + h;
+			int k = 0;
+#ifdef USE_SSE2
+			// four butterflies at once from the third stage on
+			for (; k + 4 <= h; k += 4) {
+				__m128 vwr = _mm_loadu_ps(wr+k), vwi = _mm_loadu_ps(wi+k);
+				__m128 vbr = _mm_loadu_ps(br+k), vbi = _mm_loadu_ps(bi+k);
+				__m128 var = _mm_loadu_ps(ar+k), vai = _mm_loadu_ps(ai+k);
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(vbr, vwr), _mm_mul_ps(vbi, vwi));
+				__m128 ti = _mm_add_ps(_mm_mul_ps(vbr, vwi), _mm_mul_ps(vbi, vwr));
+				_mm_storeu_ps(br+k, _mm_sub_ps(var, tr));
+				_mm_storeu_ps(bi+k, _mm_sub_ps(vai, ti));
+				_mm_storeu_ps(ar+k, _mm_add_ps(var, tr));
+				_mm_storeu_ps(ai+k, _mm_add_ps(vai, ti));
+			}
+#endif
+			for (; k < h; k++) {
+				float tr = br[k]*wr[k] - bi[k]*wi[k];
+				float ti = br[k]*wi[k] + bi[k]*wr[k];
+				br[k] = ar[k] - tr;
+				bi[k] = ai[k] - ti;
+				ar[k] += tr;
+				ai[k] += ti;
+			}
+		}
+	}
+}
+
+bool AudioSpectrum::openDevice(int is_capture_device) {
+	// a fast start leaves the audio subsystem to the first device
+	if (!SDL_WasInit(SDL_INIT_AUDIO) && SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+		LOGE("Could not initialize audio: %s", SDL_GetError());
+		return false;
+	}
+	SDL_AudioSpec desired;
+	SDL_zero(desired);
+	desired.freq = 48000;
+	desired.format = AUDIO_F32SYS;
+	desired.channels = is_capture_device ? 1 : 2;
+	desired.samples = 512; // ~10 ms, keeps latency low
+	desired.callback = audioCallback;
+	desired.userdata = this;
+	// no allowed changes: SDL converts to and from what the hardware wants
+	device = SDL_OpenAudioDevice(nullptr, is_capture_device, &desired, &spec, 0);
+	if (!device) {
+		LOGE("Could not open audio %s device: %s", is_capture_device ? "capture" : "playback", SDL_GetError());
+		return false;
+	}
+	is_capture = is_capture_device != 0;
+
+	fft = new AudioFFT;
+	fft->init();
+	memset(history, 0, sizeof(history));
+	memset(smoothed, 0, sizeof(smoothed));
+	history_position = 0;
+	hop_fill = 0;
+	SDL_AtomicSet(&write_index, 0);
+	SDL_AtomicSet(&read_index, 0);
+	SDL_AtomicSet(&dropped_frame_count, 0);
+	latency_ms = 0.0f;
+	return true;
+}
+
+bool AudioSpectrum::openFile(const char *wav_filepath) {
+	close();
+
+	SDL_AudioSpec wav_spec;
+	Uint8 *wav_buffer;
+	Uint32 wav_length;
+	if (!SDL_LoadWAV(wav_filepath, &wav_spec, &wav_buffer, &wav_length)) {
+		LOGE("Could not load '%s': %s", wav_filepath, SDL_GetError());
+		return false;
+	}
+	if (!openDevice(0)) {
+		SDL_FreeWAV(wav_buffer);
+		return false;
+	}
+
+	// convert once up front so the callback only copies
+	SDL_AudioCVT cvt;
+	if (SDL_BuildAudioCVT(&cvt, wav_spec.format, wav_spec.channels, wav_spec.freq,
+		AUDIO_F32SYS, spec.channels, spec.freq) < 0) {
+		LOGE("Can't convert '%s': %s", wav_filepath, SDL_GetError());
+		SDL_FreeWAV(wav_buffer);
+		close();
+		return false;
+	}
+	cvt.len = (int)wav_length;
+	cvt.buf = (Uint8*)SDL_malloc((size_t)cvt.len*cvt.len_mult);
+	memcpy(cvt.buf, wav_buffer, wav_length);
+	SDL_FreeWAV(wav_buffer);
+	SDL_ConvertAudio(&cvt);
+	wav_frame_count = (size_t)cvt.len_cvt / (sizeof(float)*spec.channels);
+	wav_samples = (float*)cvt.buf;
+	wav_position = 0;
+	if (!wav_frame_count) {
+		LOGE("'%s' has no samples", wav_filepath);
+		close();
+		return false;
+	}
+
+	filepath = new char[strlen(wav_filepath)+1];
+	strcpy(filepath, wav_filepath);
+	SDL_PauseAudioDevice(device, 0);
+	return true;
+}
+
+bool AudioSpectrum::openCapture() {
+	close();
+	if (!openDevice(1)) return false;
+	SDL_PauseAudioDevice(device, 0);
+	return true;
+}
+
+void AudioSpectrum::close() {
+	if (device) {
+		SDL_CloseAudioDevice(device); // waits for the callback to return
+		device = 0;
+	}
+	if (wav_samples) {
+		SDL_free(wav_samples);
+		wav_samples = nullptr;
+	}
+	wav_frame_count = 0;
+	if (fft) {
+		delete fft;
+		fft = nullptr;
+	}
+	if (filepath) {
+		delete [] filepath;
+		filepath = nullptr;
+	}
+	allocated_texture = 0;
+}
+
+void SDLCALL AudioSpectrum::audioCallback(void *userdata, Uint8 *stream, int len) {
+	AudioSpectrum *audio = (AudioSpectrum*)userdata;
+	float *samples = (float*)stream;
+	int frame_count = len / (int)(sizeof(float)*audio->spec.channels);
+	u64 now = SDL_GetPerformanceCounter();
+	u64 newest_sample_ticks = now;
+
+	if (!audio->is_capture) {
+		// loop the file into the output
+		int channels = audio->spec.channels;
+		for (int frame = 0; frame < frame_count;) {
+			size_t chunk = audio->wav_frame_count - audio->wav_position;
+			if (chunk > (size_t)(frame_count - frame)) chunk = (size_t)(frame_count - frame);
+			memcpy(samples + frame*channels, audio->wav_samples + audio->wav_position*channels,
+				chunk*channels*sizeof(float));
+			frame += (int)chunk;
+			audio->wav_position += chunk;
+			if (audio->wav_position == audio->wav_frame_count) audio->wav_position = 0;
+		}
+		// this buffer plays after the one the device is playing right now
+		double buffered_seconds = (double)(frame_count + audio->spec.samples) / audio->spec.freq;
+		newest_sample_ticks = now + (u64)(buffered_seconds * SDL_GetPerformanceFrequency());
+	}
+	audio->analyze(samples, frame_count, newest_sample_ticks);
+}
+
+void AudioSpectrum::analyze(const float *samples, int frame_count, u64 newest_sample_ticks) {
+	const int hop_size = audio_fft_size / 4;
+	int channels = spec.channels;
+	u64 ticks_per_frame = SDL_GetPerformanceFrequency() / (u64)spec.freq;
+	for (int frame = 0; frame < frame_count; frame++) {
+		float mono = 0.0f;
+		for (int c = 0; c < channels; c++) mono += samples[frame*channels + c];
+		history[history_position] = mono / channels;
+		history_position = (history_position + 1) & (audio_fft_size-1);
+		if (++hop_fill == hop_size) {
+			hop_fill = 0;
+			pushFrame(newest_sample_ticks - (u64)(frame_count-1 - frame)*ticks_per_frame);
+		}
+	}
+}
+
+void AudioSpectrum::pushFrame(u64 ticks) {
+	int write = SDL_AtomicGet(&write_index);
+	int read = SDL_AtomicGet(&read_index);
+	if ((u32)(write - read) >= (u32)frame_ring_size) { // consumer is behind, don't block the audio thread
+		SDL_AtomicAdd(&dropped_frame_count, 1);
+		return;
+	}
+	AudioSpectrumFrame *frame = frames + (write & (frame_ring_size-1));
+
+	// oldest sample first, windowed, in bit reversed order for the fft
+	for (int i = 0; i < audio_fft_size; i++) {
+		int j = fft->bit_reverse[i];
+		fft->re[j] = history[(history_position + i) & (audio_fft_size-1)] * fft->window[i];
+		fft->im[j] = 0.0f;
+	}
+	fft->transform();
+
+	// like the WebAudio AnalyserNode: smoothed magnitude, -100..-30 dB mapped to 0..1
+	const float smoothing = 0.8f;
+	const float scale = 1.0f / audio_fft_size;
+	int bin = 0;
+#ifdef USE_SSE2
+	__m128 vscale = _mm_set1_ps(scale);
+	__m128 vsmoothing = _mm_set1_ps(smoothing), vone_minus_smoothing = _mm_set1_ps(1.0f - smoothing);
+	for (; bin + 4 <= audio_texture_width; bin += 4) {
+		__m128 re = _mm_loadu_ps(fft->re + bin), im = _mm_loadu_ps(fft->im + bin);
+		__m128 magnitude = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))), vscale);
+		__m128 s = _mm_add_ps(_mm_mul_ps(vsmoothing, _mm_loadu_ps(smoothed + bin)),
+			_mm_mul_ps(vone_minus_smoothing, magnitude));
+		_mm_storeu_ps(smoothed + bin, s);
+	}
+#endif
+	for (; bin < audio_texture_width; bin++) {
+		float re = fft->re[bin], im = fft->im[bin];
+		float magnitude = sqrtf(re*re + im*im) * scale;
+		smoothed[bin] = smoothing*smoothed[bin] + (1.0f - smoothing)*magnitude;
+	}
+	for (bin = 0; bin < audio_texture_width; bin++) {
+		float db = 20.0f*log10f(smoothed[bin] + 1e-12f);
+		float v = (db + 100.0f) / 70.0f;
+		frame->spectrum[bin] = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+	}
+
+	// newest samples
+	int first = history_position - audio_texture_width;
+	for (int i = 0; i < audio_texture_width; i++) {
+		float v = 0.5f + 0.5f*history[(first + i) & (audio_fft_size-1)];
+		frame->waveform[i] = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+	}
+	frame->ticks = ticks;
+
+	SDL_AtomicSet(&write_index, write + 1); // publishes the frame
+}
+
+bool AudioSpectrum::update(GLuint *io_texture, float frame_time) {
+	if (!device) return false;
+	int write = SDL_AtomicGet(&write_index);
+	int read = SDL_AtomicGet(&read_index);
+	if (write == read) return false; // nothing new
+
+	// only the newest frame matters, older ones are skipped
+	AudioSpectrumFrame *frame = frames + ((write-1) & (frame_ring_size-1));
+	// a new name may be the one of a texture the slot deleted, so it always gets storage
+	bool is_new_texture = !*io_texture;
+	if (is_new_texture) glGenTextures(1, io_texture);
+	glBindTexture(GL_TEXTURE_2D, *io_texture);
+	if (is_new_texture || *io_texture != allocated_texture) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, audio_texture_width, 2, 0, GL_RED, GL_FLOAT, nullptr);
+		allocated_texture = *io_texture;
+	}
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, audio_texture_width, 1, GL_RED, GL_FLOAT, frame->spectrum);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 1, audio_texture_width, 1, GL_RED, GL_FLOAT, frame->waveform);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// the frame shows up on screen after this frame is swapped, about one frame from now
+	double now = (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+	double sample_time = (double)frame->ticks / (double)SDL_GetPerformanceFrequency();
+	float latency = (float)(1000.0*(now - sample_time) + 1000.0f*frame_time);
+	latency_ms = latency_ms == 0.0f ? latency : 0.9f*latency_ms + 0.1f*latency;
+
+	SDL_AtomicSet(&read_index, write); // hands all slots up to write back to the producer
+	return true;
+}
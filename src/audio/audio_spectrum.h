@@ -0,0 +1,71 @@
+// Audio input for shaders, laid out like Shadertoy's audio textures:
+// a 512x2 texture with the spectrum in row 0 and the waveform in row 1,
+// both in [0, 1]. Sample it with texture2D(tex, vec2(x, 0.25)) for the
+// spectrum and texture2D(tex, vec2(x, 0.75)) for the waveform.
+//
+// The source is a looping WAV file (played back) or the capture device.
+// The FFT runs in the SDL audio callback and finished frames are handed
+// to the render thread through a single producer single consumer ring.
+static const int audio_fft_size = 2048; // the lowest 512 bins end up in the texture
+static const int audio_texture_width = 512;
+
+struct AudioSpectrumFrame {
+	float spectrum[audio_texture_width];
+	float waveform[audio_texture_width];
+	u64 ticks; // performance counter when the newest sample is heard (or was recorded)
+};
+
+struct AudioFFT {
+	float re[audio_fft_size], im[audio_fft_size];
+	float window[audio_fft_size]; // hann
+	float twiddle_re[audio_fft_size], twiddle_im[audio_fft_size]; // per stage, stage h at [h-1, 2h-1)
+	u16 bit_reverse[audio_fft_size];
+
+	void init();
+	void transform(); // in place, input in bit reversed order
+};
+
+struct AudioSpectrum {
+	char *filepath = nullptr; // nullptr when capturing
+	float latency_ms = 0.0f; // audio to photon, smoothed
+	SDL_atomic_t dropped_frame_count = {0}; // ring was full, render thread fell behind
+
+	bool openFile(const char *wav_filepath);
+	bool openCapture();
+	void close();
+	bool isOpen() {return device != 0;}
+
+	// render thread: uploads the newest frame into *io_texture (created if 0).
+	// frame_time is used to estimate when the frame reaches the screen
+	bool update(GLuint *io_texture, float frame_time);
+
+private:
+	SDL_AudioDeviceID device = 0;
+	SDL_AudioSpec spec;
+	bool is_capture = false;
+
+	// looping file playback, converted to the device format
+	float *wav_samples = nullptr;
+	size_t wav_frame_count = 0;
+	size_t wav_position = 0;
+
+	// audio thread only
+	AudioFFT *fft = nullptr;
+	float history[audio_fft_size]; // mono, ring
+	int history_position = 0;
+	int hop_fill = 0;
+	float smoothed[audio_texture_width];
+
+	// single producer (audio thread), single consumer (render thread)
+	enum {frame_ring_size = 16}; // power of two
+	AudioSpectrumFrame frames[frame_ring_size];
+	SDL_atomic_t write_index = {0}; // only the producer writes it
+	SDL_atomic_t read_index = {0}; // only the consumer writes it
+
+	GLuint allocated_texture = 0;
+
+	bool openDevice(int is_capture_device);
+	void analyze(const float *samples, int frame_count, u64 newest_sample_ticks);
+	void pushFrame(u64 ticks);
+	static void SDLCALL audioCallback(void *userdata, Uint8 *stream, int len);
+};
@@ -0,0 +1,122 @@
+/*
+Unity build of the GLSL optimizer tests, no window or GL context:
+  build/twotris_glsl_optimizer_test
+Every case is optimized and compared to the expected source, failures print
+both and the exit code is 1.
+ */
+
+#define NO_APP_MAIN
+#include "main_sdl2_ub.cpp"
+
+struct GlslOptimizerTestCase {
+	const char *src;
+	const char *expected;
+};
+
+static const GlslOptimizerTestCase glsl_optimizer_test_cases[] = {
+	// folding
+	{"void main() {float x = 2.0 * 3.0 + 1.0;}",
+	 "void main() {float x = 7.0;}"},
+	{"void main() {float x = 1.0 - 2.0 * 3.0;}",
+	 "void main() {float x = -5.0;}"},
+	{"void main() {int i = 7 / 2;}",
+	 "void main() {int i = 3;}"},
+	{"void main() {bool b = 1.0 < 2.0;}",
+	 "void main() {bool b = true;}"},
+	// a unary sign binds tighter than the operator after the literal
+	{"void main() {float x = -2.0 + 3.0;}",
+	 "void main() {float x = -2.0 + 3.0;}"},
+	{"void main() {vec4 c = vec4(-0.5 + 1.0, -2.0 * 3.0 + 1.0, 0.0, 1.0);}",
+	 "void main() {vec4 c = vec4(-0.5 + 1.0, -6.0 + 1.0, 0.0, 1.0);}"},
+	{"void main() {bool b = -1.0 < 0.5;}",
+	 "void main() {bool b = -1.0 < 0.5;}"},
+	{"void main() {float x = -2.0 * 3.0;}",
+	 "void main() {float x = -6.0;}"},
+	{"void main() {float x = 4.0 - -2.0 * 3.0;}",
+	 "void main() {float x = 4.0 - -6.0;}"},
+	// operands of tighter binding neighbors stay
+	{"uniform float u; void main() {float x = u * 2.0 + 3.0;}",
+	 "uniform float u; void main() {float x = u * 2.0 + 3.0;}"},
+	{"uniform float u; void main() {float x = 2.0 + 3.0 * u;}",
+	 "uniform float u; void main() {float x = 2.0 + 3.0 * u;}"},
+
+	// inlining, the removed callee leaves its whitespace
+	{"float sq(float x) {return x * x;} void main() {gl_FragColor = vec4(sq(2.0));}",
+	 " void main() {gl_FragColor = vec4(4.0);}"},
+	{"uniform float u; float sq(float x) {return x * x;} void main() {gl_FragColor = vec4(sq(u));}",
+	 "uniform float u;  void main() {gl_FragColor = vec4(float(float(u) * float(u)));}"},
+	{"float f(float x); void main() {gl_FragColor = vec4(f(2.0));} float f(float x) {return x * 3.0;}",
+	 " void main() {gl_FragColor = vec4(6.0);} "},
+	// through a callee inlined first, b is in front of a but after main
+	{"float a(float x); void main() {gl_FragColor = vec4(a(1.0));} float b(float x) {return x + 1.0;} float a(float x) {return b(x);}",
+	 " void main() {gl_FragColor = vec4(2.0);}  "},
+	// an argument used twice would be evaluated twice
+	{"uniform float u; float sq(float x) {return x * x;} void main() {gl_FragColor = vec4(sq(u + 1.0));}",
+	 "uniform float u; float sq(float x) {return x * x;} void main() {gl_FragColor = vec4(sq(u + 1.0));}"},
+	// out parameters
+	{"float f(out float y) {return y = 1.0;} void main() {float a; gl_FragColor = vec4(f(a));}",
+	 "float f(out float y) {return y = 1.0;} void main() {float a; gl_FragColor = vec4(f(a));}"},
+	{"uniform float u; float f(inout float y) {return y * u;} void main() {float a = 1.0; gl_FragColor = vec4(f(a));}",
+	 "uniform float u; float f(inout float y) {return y * u;} void main() {float a = 1.0; gl_FragColor = vec4(f(a));}"},
+	// side effects, inlined g would be read after bump() wrote it
+	{"float g; float bump() {g += 1.0; return g;} float f(float x) {return bump() + x;} void main() {gl_FragColor = vec4(f(g));}",
+	 "float g; float bump() {g += 1.0; return g;} float f(float x) {return bump() + x;} void main() {gl_FragColor = vec4(f(g));}"},
+	// the callee body calls b, which the caller comes before
+	{"float a(float x); void main() {gl_FragColor = vec4(a(1.0));} float b(float x) {float y = x + 1.0; return y;} float a(float x) {return b(x);}",
+	 "float a(float x); void main() {gl_FragColor = vec4(a(1.0));} float b(float x) {float y = x + 1.0; return y;} float a(float x) {return b(x);}"},
+	{"float f(float x); void main() {gl_FragColor = vec4(f(1.0));} uniform float u; float f(float x) {return x * u;}",
+	 "float f(float x); void main() {gl_FragColor = vec4(f(1.0));} uniform float u; float f(float x) {return x * u;}"},
+
+	// reuse of calls
+	{"uniform float u; float l(float x) {float y = x * u; return y;} void main() {float x = l(2.0) + l(2.0);}",
+	 "uniform float u; float l(float x) {float y = x * u; return y;} void main() {float _opt_call0 = l(2.0); float x = _opt_call0 + _opt_call0;}"},
+	{"float g; float bump() {g += 1.0; return g;} void main() {float x = bump() + bump();}",
+	 "float g; float bump() {g += 1.0; return g;} void main() {float x = bump() + bump();}"},
+	{"float f(float x, out float y) {y = x; return x;} void main() {float a; float x = f(1.0, a) + f(1.0, a);}",
+	 "float f(float x, out float y) {y = x; return x;} void main() {float a; float x = f(1.0, a) + f(1.0, a);}"},
+	// only one of them is evaluated
+	{"uniform float u; float l(float x) {float y = x * u; return y;} void main() {float x = u > 0.0 ? l(2.0) : l(2.0);}",
+	 "uniform float u; float l(float x) {float y = x * u; return y;} void main() {float x = u > 0.0 ? l(2.0) : l(2.0);}"},
+
+	// constant branches
+	{"void main() {if (true) {gl_FragColor = vec4(1.0);} else {gl_FragColor = vec4(0.0);}}",
+	 "void main() {{gl_FragColor = vec4(1.0);}}"},
+	{"void main() {if (false) {gl_FragColor = vec4(1.0);} else {gl_FragColor = vec4(0.0);}}",
+	 "void main() { {gl_FragColor = vec4(0.0);}}"},
+	{"void main() {if (1.0 < 2.0) {gl_FragColor = vec4(1.0);}}",
+	 "void main() {{gl_FragColor = vec4(1.0);}}"},
+	{"void main() {gl_FragColor = vec4(0.0); while (false) {gl_FragColor = vec4(1.0);}}",
+	 "void main() {gl_FragColor = vec4(0.0); }"},
+	{"uniform bool b; void main() {if (b) {gl_FragColor = vec4(1.0);}}",
+	 "uniform bool b; void main() {if (b) {gl_FragColor = vec4(1.0);}}"},
+
+	// dead functions
+	{"float unused(float x) {float y = x; return y;} void main() {gl_FragColor = vec4(1.0);}",
+	 " void main() {gl_FragColor = vec4(1.0);}"},
+	{"float helper(float x) {float y = x; return y;} float unused(float x) {float y = helper(x); return y;} void main() {gl_FragColor = vec4(1.0);}",
+	 "  void main() {gl_FragColor = vec4(1.0);}"},
+	{"float f(float x); void main() {gl_FragColor = vec4(1.0);} float f(float x) {float y = x; return y;}",
+	 " void main() {gl_FragColor = vec4(1.0);} "},
+	// reached only through the prototype in front of main
+	{"float f(float x); void main() {gl_FragColor = vec4(f(2.0));} float f(float x) {float y = x * 3.0; return y;}",
+	 "float f(float x); void main() {gl_FragColor = vec4(f(2.0));} float f(float x) {float y = x * 3.0; return y;}"},
+	{"#define F(x) helper(x)\nfloat helper(float x) {float y = x; return y;} void main() {gl_FragColor = vec4(F(1.0));}",
+	 "#define F(x) helper(x)\nfloat helper(float x) {float y = x; return y;} void main() {gl_FragColor = vec4(F(1.0));}"},
+};
+
+int main(int argc, char *argv[]) {
+	int failure_count = 0;
+	int case_count = (int)ARRAY_COUNT(glsl_optimizer_test_cases);
+	for (int i = 0; i < case_count; i++) {
+		const GlslOptimizerTestCase *test = glsl_optimizer_test_cases + i;
+		GlslOptimizerStats stats;
+		char *optimized = optimizeGlsl(test->src, &stats);
+		if (!optimized || strcmp(optimized, test->expected)) {
+			printf("FAIL %s\n  expected %s\n  got      %s\n", test->src, test->expected, optimized ? optimized : "(null)");
+			failure_count++;
+		}
+		delete [] optimized;
+	}
+	printf("%d of %d glsl optimizer cases passed\n", case_count - failure_count, case_count);
+	return failure_count ? 1 : 0;
+}
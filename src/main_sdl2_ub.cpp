@@ -11,6 +11,28 @@ Unity build file using SDL2
 #include <stdlib.h> // for atoi
 
 #include <sys/stat.h> // fstat
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h> // file mapping
+	#include <direct.h> // _mkdir
+	#include <sys/utime.h> // _utime
+	#include <winsock2.h> // metrics endpoint
+#else
+	#include <fcntl.h> // open
+	#include <unistd.h> // close, sysconf
+	#include <dirent.h> // opendir
+	#include <utime.h> // utime
+	#include <sys/mman.h> // mmap
+	#include <sys/socket.h> // metrics endpoint
+	#include <sys/select.h>
+	#include <netinet/in.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define USE_SSE2
+	#include <emmintrin.h> // SSE2 intrinsics
+#endif
 
 #include <SDL.h>
 #ifndef __APPLE__
@@ -56,7 +78,37 @@ void windowToggleFullscreen();
 //#include "video/font_bitmap.h"
 #include "video/video_mode.h"
 
+#include "system/hash.h"
+#include "system/filepath.h"
+#include "system/mapped_file.h"
+#include "system/job_queue.h"
+#include "system/profiler.h"
+#include "system/metrics_server.h"
+#include "system/hitch_detector.h"
+#include "system/startup_timer.h"
+
+#include "video/gpu_memory.h"
+#include "video/gl_debug.h"
+#include "video/texture_cache.h"
+#include "video/texture_compressed.h"
+#include "video/texture_reload.h"
+#include "video/texture_volume.h"
+#include "video/mesh_sdf.h"
+#include "video/noise_texture.h"
+#include "video/video_stream.h"
+#include "video/data_texture.h"
 #include "video/shader_uniform.h"
+#include "video/gpu_timer.h"
+#include "video/bake_pass.h"
+#include "video/glsl_lexer.h"
+#include "video/shader_heatmap.h"
+#include "video/shader_cost.h"
+#include "video/glsl_optimizer.h"
+#include "video/glsl_validator.h"
+#include "video/image_diff.h"
+#include "audio/audio_spectrum.h"
+#include "app/bench.h"
+#include "app/replay.h"
 #include "app/app.h"
 
 
@@ -75,17 +127,53 @@ void windowToggleFullscreen();
 //#include "video/font_bitmap.cpp"
 //#include "video/renderer.cpp"
 
+#include "system/hash.cpp"
+#include "system/filepath.cpp"
+#include "system/mapped_file.cpp"
+#include "system/job_queue.cpp"
+#include "system/profiler.cpp"
+#include "system/metrics_server.cpp"
+#include "system/hitch_detector.cpp"
+#include "system/startup_timer.cpp"
+
+#include "video/gpu_memory.cpp"
+#include "video/gl_debug.cpp"
+#include "video/texture_cache.cpp"
+#include "video/texture_compressed.cpp"
+#include "video/texture_reload.cpp"
+#include "video/texture_volume.cpp"
+#include "video/mesh_sdf.cpp"
+#include "video/noise_texture.cpp"
+#include "video/video_stream.cpp"
+#include "video/data_texture.cpp"
 #include "video/shader_uniform.cpp"
+#include "video/bake_pass.cpp"
+#include "video/glsl_lexer.cpp"
+#include "video/shader_heatmap.cpp"
+#include "video/shader_cost.cpp"
+#include "video/glsl_optimizer.cpp"
+#include "video/gpu_timer.cpp"
+#include "video/glsl_validator.cpp"
+#include "video/image_diff.cpp"
+#include "audio/audio_spectrum.cpp"
 #include "app/app.cpp"
+#include "app/bench.cpp"
+#include "app/replay.cpp"
+
 
 
+#ifndef NO_APP_MAIN // other entry points (microbench_ub.cpp) include everything above
 
 /* inits sdl and creates an opengl window */
-static void initSDL(VideoMode *video) {
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER) < 0) {
+static void initSDL(VideoMode *video, bool vsync=true, bool hidden=false, bool fast_start=false, bool debug_context=false) {
+	// a fast start only inits video, audio comes with the first device and the rest after the first frame
+	Uint32 subsystems = SDL_INIT_VIDEO;
+	if (!fast_start) subsystems |= SDL_INIT_AUDIO | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER;
+	if (SDL_Init(subsystems) < 0) {
 		LOGE("Failed to init SDL2: %s", SDL_GetError());
 		exit(1);
 	}
+	startup_timer.endPhase("sdl init");
 
 #ifdef _WIN32
 	float ddpi;
@@ -111,9 +199,10 @@ static void initSDL(VideoMode *video) {
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
 						SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
 #endif
+	if (debug_context) SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG); // slower, but exact debug output
 
 	int window_flags =
-		  SDL_WINDOW_SHOWN
+		  (hidden ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN)
 		| SDL_WINDOW_RESIZABLE
 		| SDL_WINDOW_OPENGL
 		| SDL_WINDOW_ALLOW_HIGHDPI;
@@ -127,12 +216,14 @@ static void initSDL(VideoMode *video) {
 		LOGE("Failed to create an OpenGL window: %s", SDL_GetError());
 		exit(1);
 	}
+	startup_timer.endPhase("window");
 
 	sdl_gl_context = SDL_GL_CreateContext(sdl_window);
 	if (!sdl_gl_context) {
 		LOGE("Failed to create an OpenGL context: %s", SDL_GetError());
 		exit(1);
 	}
+	startup_timer.endPhase("gl context");
 
 	int drawable_width, drawable_height;
 	SDL_GL_GetDrawableSize(sdl_window, &drawable_width, &drawable_height);
@@ -143,13 +234,16 @@ static void initSDL(VideoMode *video) {
 		video->pixel_scale = 1.0f;
 	}
 
-	if (SDL_GL_SetSwapInterval(1) == -1) { // sync with monitor refresh rate
+	if (!vsync) {
+		SDL_GL_SetSwapInterval(0);
+	} else if (SDL_GL_SetSwapInterval(1) == -1) { // sync with monitor refresh rate
 		LOGW("Could not enable VSync.");
 	}
 
 	#ifndef __APPLE__
 	glewInit();
 	#endif
+	startup_timer.endPhase("gl setup");
 }
 
 void quitSDL() {
@@ -158,6 +252,8 @@ void quitSDL() {
 	SDL_Quit();
 }
 
+#endif // NO_APP_MAIN
+
 
 
 App *app = nullptr;
@@ -182,17 +278,25 @@ void windowToggleFullscreen() {
 #endif
 }
 
+#ifndef NO_APP_MAIN
+
 u64 mouse_timer = 0;
 
 void mainLoop() {
+	hitch_detector.beginFrame(); // measures the frame before, with its zones
+	metrics_server.beginFrame();
+	gl_debug.beginFrame();
+	PROFILE_ZONE("frame");
 	ImGuiIO& io = ImGui::GetIO();
 	SDL_Event sdl_event;
+	ProfileScope poll_zone("poll events");
 	while (SDL_PollEvent(&sdl_event)) {
 		ImGui_ImplSdlGL2_ProcessEvent(&sdl_event);
 		switch (sdl_event.type) {
 			case SDL_WINDOWEVENT:
 				switch (sdl_event.window.event) {
 		        	case SDL_WINDOWEVENT_SIZE_CHANGED: {
+						PROFILE_ZONE("window resize");
 #ifdef _WIN32
 						app->video.width = sdl_event.window.data1 / app->video.pixel_scale;
 						app->video.height = sdl_event.window.data2 / app->video.pixel_scale;
@@ -226,7 +330,7 @@ void mainLoop() {
 				bool shift_key_down = io.KeyShift;
 				if (ctrl_key_down) {
 					switch (sdl_event.key.keysym.sym) {
-						case SDLK_1: case SDLK_2: case SDLK_3: case SDLK_4:
+						case SDLK_1: case SDLK_2: case SDLK_3: case SDLK_4: case SDLK_5: case SDLK_6: case SDLK_7: case SDLK_8:
 							app->toggleWindow(sdl_event.key.keysym.sym-SDLK_1);
 							break;
 						case SDLK_b: // build / compile
@@ -262,6 +366,8 @@ void mainLoop() {
 		}
 	}
 
+	poll_zone.end();
+
 	// TODO: make use of mouse_timer
 	// doesn't seam to work on OS X?
 	SDL_ShowCursor(app->hide_gui ? SDL_DISABLE : SDL_ENABLE);
@@ -294,13 +400,44 @@ void mainLoop() {
 
 	app->update((float)frametime.smoothed_frame_time);
 
-	ImGui::Render();
+	{PROFILE_ZONE("imgui render");
+		ImGui::Render();
+	}
 
-	SDL_GL_SwapWindow(sdl_window);
+	{PROFILE_ZONE("swap");
+		SDL_GL_SwapWindow(sdl_window);
+	}
 	frametime.update();
 }
 
+// rasterizes the imgui font on a worker while the window is created,
+// the first frame then only uploads it
+static void buildFontAtlasJob(void *data) {
+	{PROFILE_ZONE("font atlas");
+		unsigned char *pixels;
+		int width, height;
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	}
+	SDL_AtomicSet((SDL_atomic_t*)data, 1);
+}
+
 int main(int argc, char *argv[]) {
+	profiler.init();
+	profiler.setThreadName("main");
+	startup_timer.begin();
+
+	BenchOptions bench_options;
+	int bench_args = parseBenchArgs(argc, argv, &bench_options);
+	if (bench_args < 0) return 1;
+	bool is_benchmark = bench_args > 0;
+	ReplayOptions replay_options;
+	if (parseReplayArgs(argc, argv, &replay_options) < 0) return 1;
+	bool is_replay = !!replay_options.replay_filepath;
+	bool fast_start_arg = false;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--fast-start")) fast_start_arg = true;
+	}
+
 	app = new App();
 	app->video.width = 1024;
 	app->video.height = 640;
@@ -323,19 +460,51 @@ int main(int argc, char *argv[]) {
 	strcpy(imgui_ini_filepath, pref_path);
 	strcat(imgui_ini_filepath, "imgui.ini");
 	io.IniFilename = imgui_ini_filepath;
+	app->texture_cache.init(pref_path);
 
 	SDL_free(pref_path);
-	app->readPreferences();
-	app->readSession();
+	if (!is_benchmark) { // benchmarks don't depend on the last session
+		app->readPreferences();
+		if (!is_replay) app->readSession(); // replays bring their window size and texture slots
+	}
+	if (is_replay && !app->openReplay(replay_options)) return 1;
+	startup_timer.endPhase("preferences");
+
+	job_queue.init();
+	startup_timer.endPhase("job queue");
+
+	// overlap the restored textures and the font atlas with window and context creation
+	bool fast_start = (app->fast_start || fast_start_arg) && !is_benchmark;
+	startup_timer.is_fast_start = fast_start;
+	SDL_atomic_t is_font_atlas_built = {1};
+	if (fast_start) {
+		app->prefetchTextureSlots();
+		SDL_AtomicSet(&is_font_atlas_built, 0);
+		job_queue.push(buildFontAtlasJob, &is_font_atlas_built);
+	}
 
-	initSDL(&app->video);
+	initSDL(&app->video, /*vsync*/!is_benchmark && !is_replay, /*hidden*/bench_options.headless, fast_start,
+		/*debug_context*/app->gl_debug_context);
 
+	while (!SDL_AtomicGet(&is_font_atlas_built)) SDL_Delay(1); // imgui owns the atlas from here on
 	ImGui_ImplSdlGL2_Init(sdl_window);
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	startup_timer.endPhase("imgui init");
 
 	app->init();
+	startup_timer.endPhase("app init");
+
+	if (is_benchmark) {
+		int exit_code = app->runBenchmark(bench_options);
+		job_queue.shutdown();
+		ImGui_ImplSdlGL2_Shutdown();
+		quitSDL();
+		return exit_code;
+	}
+
+	if (replay_options.record_filepath) app->startRecording(replay_options.record_filepath);
 
 	// init this last for sake of last_ticks
 	frametime.init();
@@ -343,17 +512,25 @@ int main(int argc, char *argv[]) {
 	do {
 		Uint32 beginTicks = SDL_GetTicks();
 		mainLoop();
+		if (!startup_timer.isFinished()) { // the first frame is on screen
+			startup_timer.finish();
+			metrics_server.set(MI_STARTUP_MS, (int)(startup_timer.getTotalMs() + 0.5f));
+			if (fast_start) SDL_InitSubSystem(SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER);
+		}
 		// hack for when vsync isn't working
 		Uint32 elapsedTicks = SDL_GetTicks() - beginTicks;
-		if (elapsedTicks < 16) {
+		if (elapsedTicks < 16 && !app->isReplaying()) { // replays run as fast as they can
 			SDL_Delay(16 - elapsedTicks);
 		}
 	} while(!app->quit);
 
 	app->beforeQuit();
+	job_queue.shutdown();
 
 	ImGui_ImplSdlGL2_Shutdown();
 	quitSDL();
 
-	return 0;
+	return app->isReplayFailed() ? 1 : 0;
 }
+
+#endif // NO_APP_MAIN
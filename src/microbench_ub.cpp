@@ -0,0 +1,369 @@
+/*
+Unity build of CPU microbenchmarks, the app code without window or GL context:
+  build/twotris_microbench [--filter name] [--min-time ms] [--hdr-mib 100]
+Each case is run until it took --min-time, setup and cleanup aren't timed.
+Allocations are those through new and new[] on the main thread, stb_image
+allocates with malloc and the bakes on the worker threads.
+ */
+
+#include <new> // std::bad_alloc
+
+#define NO_APP_MAIN
+#include "main_sdl2_ub.cpp"
+
+static u64 allocation_count = 0;
+static u64 allocation_bytes = 0;
+static SDL_threadID main_thread_id = 0; // counted on the main thread only, the workers would race
+
+void *operator new(size_t size) {
+	if (SDL_ThreadID() == main_thread_id) {
+		allocation_count++;
+		allocation_bytes += size;
+	}
+	void *p = malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+void *operator new[](size_t size) {
+	if (SDL_ThreadID() == main_thread_id) {
+		allocation_count++;
+		allocation_bytes += size;
+	}
+	void *p = malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+void operator delete(void *p) noexcept {free(p);}
+void operator delete[](void *p) noexcept {free(p);}
+
+typedef void (*MicrobenchProc)(void *data);
+
+struct MicrobenchCase {
+	const char *name;
+	MicrobenchProc setup; // before every run, optional
+	MicrobenchProc run;
+	MicrobenchProc cleanup; // after every run, optional
+};
+
+// fake GL program for parseUniforms, GLEW calls go through function pointers
+#ifndef __APPLE__
+static int fake_uniform_count = 0;
+
+static void GLAPIENTRY fakeGetProgramiv(GLuint program, GLenum pname, GLint *params) {
+	*params = pname == GL_ACTIVE_UNIFORMS ? fake_uniform_count : 0;
+}
+
+static void GLAPIENTRY fakeGetActiveUniform(GLuint program, GLuint index, GLsizei buf_size,
+	GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+	static const GLenum types[] = {GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4, GL_FLOAT_MAT4, GL_INT};
+	*type = types[index % ARRAY_COUNT(types)];
+	*size = index % 7 == 0 ? 4 : 1; // some arrays
+	*length = snprintf(name, buf_size, index % 5 == 0 ? "u_color%u" : "u_param%u", index);
+}
+
+static GLint GLAPIENTRY fakeGetUniformLocation(GLuint program, const GLchar *name) {
+	return (GLint)hashBytes(name, strlen(name)) & 0x7FFFFFFF;
+}
+#endif
+
+// synthetic uniforms laid out like App::parseUniforms does it
+static void makeUniforms(int count, ShaderUniform **out_uniforms, u8 **out_data, size_t *out_data_size) {
+	static const GLenum types[] = {GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4, GL_FLOAT_MAT4, GL_INT};
+	ShaderUniform *uniforms = new ShaderUniform[count];
+	size_t data_size = 0;
+	for (int i = 0; i < count; i++) {
+		ShaderUniform *uniform = uniforms + i;
+		memset(uniform, 0, sizeof(*uniform));
+		snprintf(uniform->name, sizeof(uniform->name), i % 5 == 0 ? "u_color%d" : "u_param%d", i);
+		uniform->type = types[i % ARRAY_COUNT(types)];
+		uniform->size = i % 7 == 0 ? 4 : 1;
+		uniform->location = i;
+		data_size += uniform->getSize();
+	}
+	u8 *data = new u8[data_size];
+	for (size_t i = 0; i < data_size; i++) data[i] = (u8)i;
+	size_t offset = 0;
+	for (int i = 0; i < count; i++) {
+		uniforms[i].data = data + offset;
+		offset += uniforms[i].getSize();
+	}
+	*out_uniforms = uniforms;
+	*out_data = data;
+	*out_data_size = data_size;
+}
+
+enum {MICROBENCH_UNIFORM_COUNT = 10000, MICROBENCH_INI_LINE_COUNT = 100000};
+static const char *microbench_shader_filepath = "microbench_tmp.frag"; // only its .uniformdata is written
+static const char *microbench_hdr_filepath = "microbench_tmp.hdr";
+static const char *microbench_tga_filepath = "microbench_tmp.tga";
+static const char *microbench_mesh_filepath = "microbench_tmp.obj";
+
+struct Microbench {
+	App *app;
+	ShaderUniform *old_uniforms = nullptr;
+	u8 *old_uniform_data = nullptr;
+	char *ini_src = nullptr;
+	size_t ini_size = 0;
+	char *ini_str = nullptr; // parsed in place, so a fresh copy per run
+	int hdr_mib = 100;
+
+	void setUniforms(int count) {
+		if (app->uniforms) delete [] app->uniforms;
+		if (app->uniform_data) delete [] app->uniform_data;
+		makeUniforms(count, &app->uniforms, &app->uniform_data, &app->uniform_data_size);
+		app->uniform_count = count;
+	}
+
+	// parseUniforms
+	static void parseUniforms(void *data) {((Microbench*)data)->app->parseUniforms();}
+
+	// transferUniformData, the O(n^2) name matching of a recompile
+	static void setupTransfer(void *data) {
+		Microbench *mb = (Microbench*)data;
+		size_t data_size;
+		makeUniforms(MICROBENCH_UNIFORM_COUNT, &mb->old_uniforms, &mb->old_uniform_data, &data_size);
+		mb->setUniforms(MICROBENCH_UNIFORM_COUNT);
+	}
+	static void transferUniformData(void *data) {
+		Microbench *mb = (Microbench*)data;
+		mb->app->transferUniformData(mb->old_uniforms, MICROBENCH_UNIFORM_COUNT);
+	}
+	static void cleanupTransfer(void *data) {
+		Microbench *mb = (Microbench*)data;
+		delete [] mb->old_uniforms;
+		delete [] mb->old_uniform_data;
+		mb->old_uniforms = nullptr;
+		mb->old_uniform_data = nullptr;
+	}
+
+	// writeUniformData and readUniformData of a .uniformdata file
+	static void writeUniformData(void *data) {((Microbench*)data)->app->writeUniformData();}
+	static void readUniformData(void *data) {((Microbench*)data)->app->readUniformData();}
+
+	// parseIniString of a long file, the preferences keys among others
+	static void setupIni(void *data) {
+		Microbench *mb = (Microbench*)data;
+		mb->ini_str = new char[mb->ini_size+1];
+		memcpy(mb->ini_str, mb->ini_src, mb->ini_size+1);
+	}
+	static void parseIni(void *data) {
+		Microbench *mb = (Microbench*)data;
+		int int_value = 0;
+		float float_value = 0.0f;
+		char *str_value = nullptr;
+		IniVar vars[] = {
+			{"shader_file_autoreload", INI_VAR_BOOL, &int_value},
+			{"texture_file_autoreload", INI_VAR_BOOL, &int_value},
+			{"sdf_bake_resolution", INI_VAR_INT, &int_value},
+			{"texture_budget_mib", INI_VAR_INT, &int_value},
+			{"camera_location_x", INI_VAR_FLOAT, &float_value},
+			{"texture_slot7", INI_VAR_STRING, &str_value}
+		};
+		parseIniString(mb->ini_str, vars, ARRAY_COUNT(vars));
+		if (str_value) delete [] str_value;
+	}
+	static void cleanupIni(void *data) {
+		Microbench *mb = (Microbench*)data;
+		delete [] mb->ini_str;
+		mb->ini_str = nullptr;
+	}
+
+	// image decodes like the texture reload jobs do them
+	static void decodeHdr(void *data) {
+		int width, height, channel_count;
+		float *pixels = stbi_loadf(microbench_hdr_filepath, &width, &height, &channel_count, 3);
+		if (!pixels) LOGE("Could not decode %s", microbench_hdr_filepath);
+		else stbi_image_free(pixels);
+	}
+	static void decodeTga(void *data) {
+		int width, height, channel_count;
+		u8 *pixels = stbi_load(microbench_tga_filepath, &width, &height, &channel_count, 4);
+		if (!pixels) LOGE("Could not decode %s", microbench_tga_filepath);
+		else stbi_image_free(pixels);
+	}
+
+	// bakes as the texture slots start them, their parallelFor runs inside the
+	// bake job. Each is timed with one worker and with all of them, the ratio
+	// shows how far the bake spreads across the workers
+	static void useWorkers(int thread_count) {
+		if (thread_count <= 0) thread_count = SDL_GetCPUCount()-1 > 1 ? SDL_GetCPUCount()-1 : 1;
+		if (job_queue.getThreadCount() == thread_count) return;
+		job_queue.shutdown();
+		job_queue.init(thread_count);
+	}
+	static void useOneWorker(void *data) {useWorkers(1);}
+	static void useAllWorkers(void *data) {useWorkers(0);}
+	static void bakeSdf(void *data) {
+		MeshSdfBake *bake = new MeshSdfBake;
+		if (bake->start(microbench_mesh_filepath, "", 64)) {
+			while (SDL_AtomicGet(&bake->state) == MSBS_BAKING) SDL_Delay(1);
+			remove(bake->volume_filepath); // baked again next run
+		}
+		bake->release();
+	}
+	static void bakeBlueNoise(void *data) {
+		NoiseParams params;
+		params.type = NT_BLUE;
+		params.size = 128;
+		NoiseBake *bake = new NoiseBake;
+		bake->start(params, "");
+		while (SDL_AtomicGet(&bake->state) == NBS_BAKING) SDL_Delay(1);
+		remove(bake->volume_filepath);
+		bake->release();
+	}
+
+	bool writeInputs() {
+		app->shader_filepath = new char[strlen(microbench_shader_filepath)+1];
+		strcpy(app->shader_filepath, microbench_shader_filepath);
+
+		// 100k lines, keys of the preferences and session are spread through it
+		ini_src = new char[MICROBENCH_INI_LINE_COUNT*48];
+		char *c = ini_src;
+		for (int i = 0; i < MICROBENCH_INI_LINE_COUNT; i++) {
+			if (i % 1000 == 0) c += sprintf(c, "texture_slot7=2d:/some/long/path/to/a/texture_%d.png\n", i);
+			else c += sprintf(c, "key_%d=%d\n", i, i*7);
+		}
+		ini_size = c - ini_src;
+
+		// flat (not run length encoded) rgbe scanlines
+		int hdr_width = 4096;
+		int hdr_height = (int)(((size_t)hdr_mib << 20) / (4*hdr_width));
+		FILE *file = fopen(microbench_hdr_filepath, "wb");
+		if (!file) {
+			LOGE("Could not write %s", microbench_hdr_filepath);
+			return false;
+		}
+		fprintf(file, "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", hdr_height, hdr_width);
+		u8 *row = new u8[4*hdr_width];
+		for (int y = 0; y < hdr_height; y++) {
+			for (int x = 0; x < hdr_width; x++) {
+				row[4*x+0] = (u8)(128 + (x & 127)); // never 2, 2 which starts an rle scanline
+				row[4*x+1] = (u8)y;
+				row[4*x+2] = (u8)(x ^ y);
+				row[4*x+3] = (u8)(120 + (x+y) % 16);
+			}
+			fwrite(row, 4, hdr_width, file);
+		}
+		delete [] row;
+		fclose(file);
+
+		int tga_size = 4096;
+		u8 *pixels = new u8[(size_t)4*tga_size*tga_size];
+		for (size_t i = 0; i < (size_t)4*tga_size*tga_size; i++) pixels[i] = (u8)(i*31 >> 8);
+		bool is_written = writeTga(microbench_tga_filepath, pixels, tga_size, tga_size);
+		delete [] pixels;
+		if (!is_written) return false;
+
+		// uv sphere of 8k triangles
+		file = fopen(microbench_mesh_filepath, "w");
+		if (!file) {
+			LOGE("Could not write %s", microbench_mesh_filepath);
+			return false;
+		}
+		int ring_count = 64, segment_count = 64;
+		for (int ri = 0; ri <= ring_count; ri++) {
+			float theta = (float)M_PI*ri/ring_count;
+			for (int si = 0; si < segment_count; si++) {
+				float phi = 2.0f*(float)M_PI*si/segment_count;
+				fprintf(file, "v %f %f %f\n", sinf(theta)*cosf(phi), cosf(theta), sinf(theta)*sinf(phi));
+			}
+		}
+		for (int ri = 0; ri < ring_count; ri++) {
+			for (int si = 0; si < segment_count; si++) {
+				int a = ri*segment_count + si + 1, b = ri*segment_count + (si+1) % segment_count + 1;
+				fprintf(file, "f %d %d %d\nf %d %d %d\n", a, b, a + segment_count, b, b + segment_count, a + segment_count);
+			}
+		}
+		fclose(file);
+		return true;
+	}
+
+	void removeInputs() {
+		delete [] ini_src;
+		ini_src = nullptr;
+		remove(microbench_hdr_filepath);
+		remove(microbench_tga_filepath);
+		remove(microbench_mesh_filepath);
+		char uniformdata_filepath[256];
+		snprintf(uniformdata_filepath, sizeof(uniformdata_filepath), "%s.uniformdata", microbench_shader_filepath);
+		remove(uniformdata_filepath);
+	}
+};
+
+static void runMicrobench(const MicrobenchCase *mc, void *data, double min_ms) {
+	double ticks_to_ns = 1e9 / (double)SDL_GetPerformanceFrequency();
+	double total_ns = 0.0;
+	u64 run_count = 0, total_allocation_count = 0, total_allocation_bytes = 0;
+	while (run_count < 3 || total_ns < 1e6*min_ms) { // at least 3 runs
+		if (mc->setup) mc->setup(data);
+		u64 count_before = allocation_count, bytes_before = allocation_bytes;
+		u64 begin_ticks = SDL_GetPerformanceCounter();
+		mc->run(data);
+		total_ns += (double)(SDL_GetPerformanceCounter() - begin_ticks) * ticks_to_ns;
+		total_allocation_count += allocation_count - count_before;
+		total_allocation_bytes += allocation_bytes - bytes_before;
+		if (mc->cleanup) mc->cleanup(data);
+		run_count++;
+	}
+	printf("%-32s %8llu %16.0f %12.1f %14.0f\n", mc->name, (unsigned long long)run_count, total_ns / run_count,
+		(double)total_allocation_count / run_count, (double)total_allocation_bytes / run_count);
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+	main_thread_id = SDL_ThreadID();
+	const char *filter = nullptr;
+	double min_ms = 500.0;
+	Microbench mb;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--filter") && i+1 < argc) filter = argv[++i];
+		else if (!strcmp(argv[i], "--min-time") && i+1 < argc) min_ms = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--hdr-mib") && i+1 < argc) mb.hdr_mib = atoi(argv[++i]);
+		else {
+			LOGE("Unknown argument %s, expected --filter name, --min-time ms or --hdr-mib size", argv[i]);
+			return 1;
+		}
+	}
+
+	app = new App();
+	mb.app = app;
+	if (!mb.writeInputs()) return 1;
+
+	const MicrobenchCase cases[] = {
+#ifndef __APPLE__
+		{"parse_uniforms_10k", nullptr, Microbench::parseUniforms, nullptr},
+#endif
+		{"transfer_uniform_data_10k", Microbench::setupTransfer, Microbench::transferUniformData, Microbench::cleanupTransfer},
+		{"write_uniform_data_10k", nullptr, Microbench::writeUniformData, nullptr},
+		{"read_uniform_data_10k", nullptr, Microbench::readUniformData, nullptr},
+		{"parse_ini_100k_lines", Microbench::setupIni, Microbench::parseIni, Microbench::cleanupIni},
+		{"decode_hdr", nullptr, Microbench::decodeHdr, nullptr},
+		{"decode_tga_4096", nullptr, Microbench::decodeTga, nullptr},
+		{"bake_sdf_64_1_worker", Microbench::useOneWorker, Microbench::bakeSdf, nullptr},
+		{"bake_sdf_64_all_workers", Microbench::useAllWorkers, Microbench::bakeSdf, nullptr},
+		{"bake_blue_noise_128_1_worker", Microbench::useOneWorker, Microbench::bakeBlueNoise, nullptr},
+		{"bake_blue_noise_128_all_workers", Microbench::useAllWorkers, Microbench::bakeBlueNoise, nullptr}
+	};
+
+#ifndef __APPLE__
+	fake_uniform_count = MICROBENCH_UNIFORM_COUNT;
+	__glewGetProgramiv = fakeGetProgramiv;
+	__glewGetActiveUniform = fakeGetActiveUniform;
+	__glewGetUniformLocation = fakeGetUniformLocation;
+#endif
+	mb.setUniforms(MICROBENCH_UNIFORM_COUNT);
+
+	printf("%-32s %8s %16s %12s %14s\n", "case", "runs", "ns/op", "allocs/op", "bytes/op");
+	for (int i = 0; i < (int)ARRAY_COUNT(cases); i++) {
+		if (filter && !strstr(cases[i].name, filter)) continue;
+		if (cases[i].run == Microbench::parseUniforms || cases[i].run == Microbench::transferUniformData) {
+			mb.setUniforms(MICROBENCH_UNIFORM_COUNT); // read and write need them in place
+		}
+		runMicrobench(cases + i, &mb, min_ms);
+	}
+	// cube cross extraction is part of loadTextureCubeCross, which uploads through GL
+
+	job_queue.shutdown();
+	mb.removeInputs();
+	return 0;
+}
@@ -0,0 +1,89 @@
+bool hasFileExtension(const char *filepath, const char *ext) {
+	const char *dot = strrchr(filepath, '.');
+	if (!dot) return false;
+	return !SDL_strcasecmp(dot+1, ext);
+}
+
+void makeDirectory(const char *dirpath) {
+#ifdef _WIN32
+	_mkdir(dirpath);
+#else
+	mkdir(dirpath, 0755);
+#endif
+}
+
+const char *getFilename(const char *filepath) {
+	const char *filename = filepath;
+	for (const char *c = filepath; *c; c++) {
+		if (*c == '/' || *c == '\\') filename = c+1;
+	}
+	return filename;
+}
+
+static DirectoryFile *addDirectoryFile(DirectoryFile **files, int *file_count, int *file_capacity, const char *filename) {
+	if (*file_count == *file_capacity) {
+		*file_capacity = *file_capacity ? 2*(*file_capacity) : 32;
+		DirectoryFile *new_files = new DirectoryFile[*file_capacity];
+		if (*files) {
+			memcpy(new_files, *files, *file_count*sizeof(DirectoryFile));
+			delete [] *files;
+		}
+		*files = new_files;
+	}
+	DirectoryFile *file = *files + (*file_count)++;
+	file->filename = new char[strlen(filename)+1];
+	strcpy(file->filename, filename);
+	return file;
+}
+
+int listDirectoryFiles(const char *dirpath, DirectoryFile **out_files) {
+	DirectoryFile *files = nullptr;
+	int file_count = 0, file_capacity = 0;
+	size_t dirpath_len = strlen(dirpath);
+	const char *separator = dirpath_len && (dirpath[dirpath_len-1] == '/' || dirpath[dirpath_len-1] == '\\') ? "" : "/";
+#ifdef _WIN32
+	char pattern[1024];
+	snprintf(pattern, sizeof(pattern), "%s%s*", dirpath, separator);
+	WIN32_FIND_DATAA find_data;
+	HANDLE find = FindFirstFileA(pattern, &find_data);
+	if (find != INVALID_HANDLE_VALUE) {
+		do {
+			if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+			DirectoryFile *file = addDirectoryFile(&files, &file_count, &file_capacity, find_data.cFileName);
+			file->size = ((u64)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+			file->mtime = ((u64)find_data.ftLastWriteTime.dwHighDateTime << 32) | find_data.ftLastWriteTime.dwLowDateTime;
+		} while (FindNextFileA(find, &find_data));
+		FindClose(find);
+	}
+#else
+	DIR *dir = opendir(dirpath);
+	if (dir) {
+		struct dirent *dir_entry;
+		while ((dir_entry = readdir(dir))) {
+			char filepath[1024];
+			snprintf(filepath, sizeof(filepath), "%s%s%s", dirpath, separator, dir_entry->d_name);
+			struct stat attr;
+			if (stat(filepath, &attr) || !S_ISREG(attr.st_mode)) continue;
+			DirectoryFile *file = addDirectoryFile(&files, &file_count, &file_capacity, dir_entry->d_name);
+			file->size = (u64)attr.st_size;
+			file->mtime = (u64)attr.st_mtime;
+		}
+		closedir(dir);
+	}
+#endif
+	*out_files = files;
+	return file_count;
+}
+
+void freeDirectoryFiles(DirectoryFile *files, int file_count) {
+	for (int i = 0; i < file_count; i++) delete [] files[i].filename;
+	delete [] files;
+}
+
+void touchFile(const char *filepath) {
+#ifdef _WIN32
+	_utime(filepath, nullptr);
+#else
+	utime(filepath, nullptr);
+#endif
+}
@@ -0,0 +1,14 @@
+// case insensitive check of the extension, ext without the dot ("dds")
+bool hasFileExtension(const char *filepath, const char *ext);
+void makeDirectory(const char *dirpath); // fails harmlessly if it already exists
+const char *getFilename(const char *filepath); // the part after the last path separator
+
+struct DirectoryFile {
+	char *filename; // without the directory
+	u64 size;
+	u64 mtime; // only comparable to each other, the unit depends on the platform
+};
+// regular files of a directory, not recursive, free them with freeDirectoryFiles
+int listDirectoryFiles(const char *dirpath, DirectoryFile **out_files);
+void freeDirectoryFiles(DirectoryFile *files, int file_count);
+void touchFile(const char *filepath); // modification time to now
@@ -0,0 +1,30 @@
+static inline u64 hashMix(u64 h) { // murmur3 finalizer
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// consumes 32 bytes per iteration in four independent lanes so large files hash at memory speed
+u64 hashBytes(const void *data, size_t size, u64 seed) {
+	const u64 prime = 0x9E3779B97F4A7C15ull;
+	const u8 *bytes = (const u8*)data;
+	u64 lanes[4] = {seed, seed + prime, seed ^ prime, seed - prime};
+
+	size_t block_count = size / 32;
+	for (size_t bi = 0; bi < block_count; bi++) {
+		for (int li = 0; li < 4; li++) {
+			u64 word;
+			memcpy(&word, bytes + 32*bi + 8*li, sizeof(word));
+			lanes[li] = (lanes[li] ^ word) * prime;
+			lanes[li] ^= lanes[li] >> 29;
+		}
+	}
+
+	u64 h = (u64)size * prime;
+	for (int li = 0; li < 4; li++) h = hashMix(h ^ lanes[li]);
+	for (size_t i = 32*block_count; i < size; i++) h = (h ^ bytes[i]) * 0x100000001B3ull; // fnv-1a tail
+	return hashMix(h);
+}
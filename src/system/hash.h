@@ -0,0 +1,2 @@
+// 64 bit non-cryptographic hash, used to key on-disk caches
+u64 hashBytes(const void *data, size_t size, u64 seed = 0);
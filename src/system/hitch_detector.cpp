@@ -0,0 +1,101 @@
+HitchDetector hitch_detector;
+
+static const int hitch_warmup_frame_count = 30; // loading the first shader and textures isn't a hitch
+
+void HitchDetector::beginFrame() {
+	u64 ticks = SDL_GetPerformanceCounter();
+	if (frame_begin_ticks) {
+		float frame_ms = (float)((double)(ticks - frame_begin_ticks) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+		bool is_hitch = frame_index >= (u64)hitch_warmup_frame_count
+			&& frame_ms > min_frame_ms && frame_ms > threshold*average_ms;
+		if (is_hitch) {
+			Hitch *hitch = hitches + (hitch_count % hitch_ring_size);
+			hitch->frame_index = frame_index;
+			hitch->time = time(nullptr);
+			hitch->frame_ms = frame_ms;
+			hitch->average_ms = average_ms;
+			attributeCauses(hitch);
+			hitch_count++;
+			metrics_server.add(MI_HITCH_COUNT);
+			LOGW("Hitch at frame %llu: %.1f ms, average %.1f ms%s%s", (unsigned long long)frame_index, frame_ms, average_ms,
+				hitch->cause_count ? ", longest zone " : "", hitch->cause_count ? hitch->causes[0].name : "");
+		} else { // the plain mean until there are enough frames for the moving one
+			float alpha = frame_index < 20 ? 1.0f / (frame_index + 1) : 0.05f;
+			average_ms += alpha*(frame_ms - average_ms);
+		}
+		frame_index++;
+	}
+	frame_begin_ticks = ticks;
+}
+
+void HitchDetector::attributeCauses(Hitch *hitch) {
+	if (!zones) zones = new ProfileZone[ProfileThread::zone_ring_size];
+	int zone_count = profiler.getRecentZones(frame_begin_ticks, zones, ProfileThread::zone_ring_size);
+
+	// sum up by name, zone names are literals but may be duplicated across files
+	HitchCause causes[32];
+	int cause_count = 0;
+	for (int zi = 0; zi < zone_count; zi++) {
+		ProfileZone *zone = zones + zi;
+		if (!strcmp(zone->name, "frame")) continue; // all of it
+		float ms = (float)((double)(zone->end_ticks - zone->begin_ticks) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+		int ci = 0;
+		while (ci < cause_count && strcmp(causes[ci].name, zone->name)) ci++;
+		if (ci == cause_count) {
+			if (cause_count == (int)ARRAY_COUNT(causes)) continue;
+			causes[cause_count++] = {zone->name, 0.0f, 0};
+		}
+		causes[ci].ms += ms;
+		causes[ci].count++;
+	}
+
+	// keep the longest
+	hitch->cause_count = 0;
+	for (int i = 0; i < Hitch::max_cause_count && i < cause_count; i++) {
+		int longest = i;
+		for (int ci = i+1; ci < cause_count; ci++) {
+			if (causes[ci].ms > causes[longest].ms) longest = ci;
+		}
+		HitchCause cause = causes[longest];
+		causes[longest] = causes[i];
+		causes[i] = cause;
+		hitch->causes[hitch->cause_count++] = cause;
+	}
+}
+
+void HitchDetector::clear() {
+	hitch_count = 0;
+}
+
+Hitch *HitchDetector::getHitch(int age) {
+	if (age < 0 || age >= hitch_count || age >= hitch_ring_size) return nullptr;
+	return hitches + ((hitch_count - 1 - age) % hitch_ring_size);
+}
+
+bool HitchDetector::dump(const char *filepath) {
+	FILE *file = fopen(filepath, "w");
+	if (!file) {
+		LOGE("Could not open %s for writing", filepath);
+		return false;
+	}
+	fprintf(file, "%d hitches longer than %.1fx the average frame time and %.1f ms, the last %d follow\n",
+		hitch_count, threshold, min_frame_ms, hitch_count < hitch_ring_size ? hitch_count : (int)hitch_ring_size);
+	for (int age = hitch_ring_size-1; age >= 0; age--) { // oldest first
+		Hitch *hitch = getHitch(age);
+		if (!hitch) continue;
+		char time_str[32];
+		strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", localtime(&hitch->time));
+		fprintf(file, "\n%s frame %llu: %.2f ms, average %.2f ms\n", time_str,
+			(unsigned long long)hitch->frame_index, hitch->frame_ms, hitch->average_ms);
+		for (int ci = 0; ci < hitch->cause_count; ci++) {
+			HitchCause *cause = hitch->causes + ci;
+			fprintf(file, "\t%-20s %8.2f ms", cause->name, cause->ms);
+			if (cause->count > 1) fprintf(file, " (%dx)", cause->count);
+			fprintf(file, "\n");
+		}
+	}
+	bool is_written = !ferror(file);
+	fclose(file);
+	if (!is_written) LOGE("Could not write %s", filepath);
+	return is_written;
+}
@@ -0,0 +1,45 @@
+// Flags frames that take much longer than the moving average of the frames
+// before and attributes them to the profile zones the main thread finished in
+// that frame, e.g. a shader compile, a texture upload or a file dialog.
+// The last hitches are kept in a ring, shown in the Hitches window and can be
+// dumped to a text file.
+struct HitchCause {
+	const char *name; // of the profile zone
+	float ms; // summed up if the zone ran more than once
+	int count;
+};
+
+struct Hitch {
+	u64 frame_index;
+	time_t time;
+	float frame_ms;
+	float average_ms; // of the frames before
+	enum {max_cause_count = 8};
+	HitchCause causes[max_cause_count]; // longest first, zones nest so they can overlap
+	int cause_count;
+};
+
+struct HitchDetector {
+	float threshold = 2.0f; // relative to the average
+	float min_frame_ms = 20.0f; // shorter frames are never hitches, e.g. without vsync
+	float average_ms = 0.0f; // exponential moving average, hitches excluded
+	u64 frame_index = 0;
+	int hitch_count = 0; // since the start or clear()
+
+	enum {hitch_ring_size = 64};
+	Hitch hitches[hitch_ring_size];
+
+	// call on the main thread at the same point of every frame
+	void beginFrame();
+	void clear();
+	Hitch *getHitch(int age); // 0: the latest, nullptr if there are fewer
+	bool dump(const char *filepath);
+
+private:
+	u64 frame_begin_ticks = 0;
+	ProfileZone *zones = nullptr; // of the last frame
+
+	void attributeCauses(Hitch *hitch);
+};
+
+extern HitchDetector hitch_detector;
@@ -0,0 +1,154 @@
+JobQueue job_queue;
+
+void JobQueue::init(int requested_thread_count) {
+	if (thread_count) return; // already running
+
+	if (requested_thread_count <= 0) requested_thread_count = SDL_GetCPUCount()-1;
+	if (requested_thread_count < 1) requested_thread_count = 1;
+	if (requested_thread_count > (int)ARRAY_COUNT(threads)) requested_thread_count = (int)ARRAY_COUNT(threads);
+
+	mutex = SDL_CreateMutex();
+	job_pushed = SDL_CreateCond();
+	job_popped = SDL_CreateCond();
+	quit = false;
+	for (int ti = 0; ti < requested_thread_count; ti++) {
+		char thread_name[32];
+		snprintf(thread_name, sizeof(thread_name), "worker%d", ti);
+		threads[thread_count] = SDL_CreateThread(workerThread, thread_name, this);
+		if (threads[thread_count]) thread_count++;
+		else LOGW("Could not create worker thread: %s", SDL_GetError());
+	}
+}
+
+void JobQueue::shutdown() {
+	if (!thread_count) return;
+
+	SDL_LockMutex(mutex);
+	quit = true;
+	SDL_CondBroadcast(job_pushed);
+	SDL_UnlockMutex(mutex);
+	for (int ti = 0; ti < thread_count; ti++) {
+		SDL_WaitThread(threads[ti], nullptr);
+	}
+	thread_count = 0;
+
+	SDL_DestroyCond(job_popped);
+	SDL_DestroyCond(job_pushed);
+	SDL_DestroyMutex(mutex);
+}
+
+void JobQueue::push(JobProc proc, void *data) {
+	if (!thread_count) { // no workers (yet), do it right away
+		proc(data);
+		return;
+	}
+
+	SDL_LockMutex(mutex);
+	while (job_count == (int)ARRAY_COUNT(jobs)) {
+		SDL_CondWait(job_popped, mutex);
+	}
+	Job *job = jobs + (job_read_index + job_count) % ARRAY_COUNT(jobs);
+	job->proc = proc;
+	job->data = data;
+	job_count++;
+	SDL_CondSignal(job_pushed);
+	SDL_UnlockMutex(mutex);
+}
+
+bool JobQueue::tryPush(JobProc proc, void *data) {
+	if (!thread_count) return false;
+	SDL_LockMutex(mutex);
+	bool is_pushed = job_count < (int)ARRAY_COUNT(jobs);
+	if (is_pushed) {
+		Job *job = jobs + (job_read_index + job_count) % ARRAY_COUNT(jobs);
+		job->proc = proc;
+		job->data = data;
+		job_count++;
+		SDL_CondSignal(job_pushed);
+	}
+	SDL_UnlockMutex(mutex);
+	return is_pushed;
+}
+
+int JobQueue::workerThread(void *data) {
+	JobQueue *queue = (JobQueue*)data;
+	profiler.setThreadName("worker");
+	for (;;) {
+		SDL_LockMutex(queue->mutex);
+		while (queue->job_count == 0 && !queue->quit) {
+			SDL_CondWait(queue->job_pushed, queue->mutex);
+		}
+		if (queue->job_count == 0) { // quit and drained
+			SDL_UnlockMutex(queue->mutex);
+			return 0;
+		}
+		Job job = queue->jobs[queue->job_read_index];
+		queue->job_read_index = (queue->job_read_index + 1) % ARRAY_COUNT(queue->jobs);
+		queue->job_count--;
+		SDL_CondSignal(queue->job_popped);
+		SDL_UnlockMutex(queue->mutex);
+
+		job.proc(job.data);
+	}
+}
+
+// shared by the calling thread and the helper jobs of one parallelFor call
+// lives on the heap because helper jobs may only get to run after parallelFor returned
+struct ParallelForTask {
+	ParallelForProc proc;
+	void *data;
+	int count;
+	SDL_atomic_t next_index;
+	SDL_atomic_t done_count;
+	SDL_atomic_t ref_count;
+	SDL_sem *all_done;
+
+	void run() {
+		for (;;) {
+			int index = SDL_AtomicAdd(&next_index, 1);
+			if (index >= count) break;
+			proc(data, index);
+			if (SDL_AtomicAdd(&done_count, 1) == count-1) SDL_SemPost(all_done);
+		}
+	}
+
+	void release() {
+		if (SDL_AtomicAdd(&ref_count, -1) == 1) {
+			SDL_DestroySemaphore(all_done);
+			delete this;
+		}
+	}
+
+	static void helperJob(void *data) {
+		ParallelForTask *task = (ParallelForTask*)data;
+		task->run();
+		task->release();
+	}
+};
+
+void JobQueue::parallelFor(int count, ParallelForProc proc, void *data) {
+	if (count <= 0) return;
+	int helper_count = thread_count < count-1 ? thread_count : count-1;
+	if (helper_count == 0) {
+		for (int i = 0; i < count; i++) proc(data, i);
+		return;
+	}
+
+	ParallelForTask *task = new ParallelForTask;
+	task->proc = proc;
+	task->data = data;
+	task->count = count;
+	SDL_AtomicSet(&task->next_index, 0);
+	SDL_AtomicSet(&task->done_count, 0);
+	SDL_AtomicSet(&task->ref_count, helper_count+1);
+	task->all_done = SDL_CreateSemaphore(0);
+
+	// helpers never block the caller, it claims indices itself and only waits for
+	// the ones a running helper claimed, helpers still in the queue find none left
+	int pushed_count = 0;
+	while (pushed_count < helper_count && tryPush(ParallelForTask::helperJob, task)) pushed_count++;
+	for (int hi = pushed_count; hi < helper_count; hi++) task->release(); // queue full, never started
+	task->run();
+	SDL_SemWait(task->all_done);
+	task->release();
+}
@@ -0,0 +1,41 @@
+// Pool of worker threads for background work (decoding, baking, ...).
+// Jobs must not touch OpenGL, results are handed back to the main thread
+// through state the job owner polls every frame.
+typedef void (*JobProc)(void *data);
+typedef void (*ParallelForProc)(void *data, int index);
+
+struct JobQueue {
+	void init(int thread_count = 0); // 0: one thread per core minus the main thread
+	void shutdown(); // finishes queued jobs first
+
+	void push(JobProc proc, void *data); // blocks while the queue is full
+	bool tryPush(JobProc proc, void *data); // false if the queue is full or there are no workers
+
+	// runs proc(data, index) for every index in [0, count) on the workers and
+	// the calling thread and returns when all of them are done. Safe to call
+	// from a job: helper jobs are only pushed if there is room, and the caller
+	// doesn't wait for helpers that are still queued behind other long jobs
+	void parallelFor(int count, ParallelForProc proc, void *data);
+
+	int getThreadCount() {return thread_count;}
+
+private:
+	struct Job {
+		JobProc proc;
+		void *data;
+	};
+	Job jobs[256]; // ring buffer
+	int job_read_index = 0;
+	int job_count = 0;
+	bool quit = false;
+
+	SDL_mutex *mutex = nullptr;
+	SDL_cond *job_pushed = nullptr;
+	SDL_cond *job_popped = nullptr;
+	SDL_Thread *threads[64];
+	int thread_count = 0;
+
+	static int workerThread(void *data);
+};
+
+extern JobQueue job_queue;
@@ -0,0 +1,74 @@
+u64 MappedFile::getFileSize(const char *filepath) {
+#ifdef _WIN32
+	struct __stat64 attr;
+	if (_stat64(filepath, &attr)) return 0;
+#else
+	struct stat attr;
+	if (stat(filepath, &attr)) return 0;
+#endif
+	return (u64)attr.st_size;
+}
+
+bool MappedFile::open(const char *filepath) {
+	u64 file_size = getFileSize(filepath);
+	if (file_size == 0 || file_size > (u64)SIZE_MAX) return false;
+	return openRange(filepath, 0, (size_t)file_size);
+}
+
+bool MappedFile::openRange(const char *filepath, u64 offset, size_t range_size) {
+	close();
+	if (range_size == 0) return false;
+	if (offset + range_size > getFileSize(filepath)) return false; // touching pages past EOF would fault
+
+#ifdef _WIN32
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	u64 granularity = system_info.dwAllocationGranularity;
+#else
+	u64 granularity = (u64)sysconf(_SC_PAGESIZE);
+#endif
+	// mappings have to start at a multiple of the allocation granularity
+	u64 view_offset = offset - offset % granularity;
+	size_t view_padding = (size_t)(offset - view_offset);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file); // the mapping keeps its own reference
+	if (!mapping) return false;
+	view = MapViewOfFile(mapping, FILE_MAP_READ,
+		(DWORD)(view_offset >> 32), (DWORD)(view_offset & 0xFFFFFFFF), view_padding + range_size);
+	CloseHandle(mapping); // the view keeps its own reference
+	if (!view) return false;
+#else
+	int fd = ::open(filepath, O_RDONLY);
+	if (fd == -1) return false;
+	view = mmap(nullptr, view_padding + range_size, PROT_READ, MAP_PRIVATE, fd, (off_t)view_offset);
+	::close(fd); // the mapping keeps its own reference
+	if (view == MAP_FAILED) {
+		view = nullptr;
+		return false;
+	}
+	madvise(view, view_padding + range_size, MADV_SEQUENTIAL);
+#endif
+
+	view_size = view_padding + range_size;
+	data = (u8*)view + view_padding;
+	size = range_size;
+	return true;
+}
+
+void MappedFile::close() {
+	if (!view) return;
+#ifdef _WIN32
+	UnmapViewOfFile(view);
+#else
+	munmap(view, view_size);
+#endif
+	view = nullptr;
+	view_size = 0;
+	data = nullptr;
+	size = 0;
+}
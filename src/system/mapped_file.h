@@ -0,0 +1,15 @@
+// read-only memory mapping of a file (or a window into it)
+struct MappedFile {
+	u8 *data = nullptr; // first requested byte
+	size_t size = 0; // number of requested bytes
+
+	bool open(const char *filepath); // maps the whole file
+	bool openRange(const char *filepath, u64 offset, size_t range_size);
+	void close();
+
+	static u64 getFileSize(const char *filepath); // 0 if file doesn't exist
+
+private:
+	void *view = nullptr; // start of mapping (aligned to allocation granularity)
+	size_t view_size = 0;
+};
@@ -0,0 +1,220 @@
+#ifdef _MSC_VER
+	#pragma comment(lib, "ws2_32.lib")
+#endif
+
+MetricsServer metrics_server;
+
+#ifdef _WIN32
+	#define closeMetricsSocket closesocket
+	static const SOCKET invalid_metrics_socket = INVALID_SOCKET;
+	typedef SOCKET MetricsSocket;
+#else
+	#define closeMetricsSocket close
+	static const int invalid_metrics_socket = -1;
+	typedef int MetricsSocket;
+#endif
+
+#ifdef MSG_NOSIGNAL
+	static const int metrics_send_flags = MSG_NOSIGNAL; // a client that hung up doesn't raise SIGPIPE
+#else
+	static const int metrics_send_flags = 0;
+#endif
+
+bool MetricsServer::start(int port) {
+	if (thread) return true;
+	if (port <= 0 || port > 65535) {
+		LOGE("Invalid metrics port %d", port);
+		return false;
+	}
+#ifdef _WIN32
+	WSADATA wsa_data;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data)) {
+		LOGE("Could not initialize Winsock for the metrics endpoint");
+		return false;
+	}
+#endif
+	listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_socket == invalid_metrics_socket) {
+		LOGE("Could not create the metrics socket");
+		stop();
+		return false;
+	}
+	int reuse = 1; // restarts don't wait for old connections to time out
+	setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons((u16)port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // not reachable from other machines
+	if (bind(listen_socket, (sockaddr*)&address, sizeof(address)) || listen(listen_socket, 8)) {
+		LOGE("Could not listen on 127.0.0.1:%d for metrics", port);
+		stop();
+		return false;
+	}
+
+	start_ticks = SDL_GetTicks();
+	SDL_AtomicSet(&quit, 0);
+	thread = SDL_CreateThread(serverThread, "metrics", this);
+	if (!thread) {
+		LOGE("Could not start the metrics thread: %s", SDL_GetError());
+		stop();
+		return false;
+	}
+	LOGI("Serving metrics at http://127.0.0.1:%d/metrics", port);
+	return true;
+}
+
+void MetricsServer::stop() {
+	if (thread) {
+		SDL_AtomicSet(&quit, 1);
+		SDL_WaitThread(thread, nullptr); // polls quit at least four times a second
+		thread = nullptr;
+	}
+	if (listen_socket != invalid_metrics_socket) {
+		closeMetricsSocket(listen_socket);
+		listen_socket = invalid_metrics_socket;
+#ifdef _WIN32
+		WSACleanup();
+#endif
+	}
+}
+
+static int compareFrameTimes(const void *a, const void *b) {
+	float fa = *(const float*)a, fb = *(const float*)b;
+	return fa < fb ? -1 : fa > fb ? 1 : 0;
+}
+
+void MetricsServer::beginFrame() {
+	u64 ticks = SDL_GetPerformanceCounter();
+	if (!frame_begin_ticks) {
+		frame_begin_ticks = ticks;
+		return;
+	}
+	float ms = (float)((double)(ticks - frame_begin_ticks) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+	frame_begin_ticks = ticks;
+	int frame_count = SDL_AtomicAdd(&values[MI_FRAME_COUNT], 1) + 1;
+	frame_ms[(frame_count - 1) % metrics_frame_window] = ms;
+	if (frame_sample_count < metrics_frame_window) frame_sample_count++;
+
+	if (frame_count % 60 == 0) { // the display may have changed
+		SDL_DisplayMode mode;
+		SDL_Window *window = SDL_GL_GetCurrentWindow();
+		int refresh_rate = window && !SDL_GetWindowDisplayMode(window, &mode) ? mode.refresh_rate : 0;
+		refresh_interval_ms = 1000.0f / (refresh_rate > 0 ? refresh_rate : 60);
+
+		float sorted[metrics_frame_window];
+		memcpy(sorted, frame_ms, frame_sample_count*sizeof(float));
+		qsort(sorted, frame_sample_count, sizeof(float), compareFrameTimes);
+		int last = frame_sample_count - 1;
+		set(MI_FRAME_P50_US, (int)(1000.0f*sorted[(int)(0.50f*last + 0.5f)]));
+		set(MI_FRAME_P95_US, (int)(1000.0f*sorted[(int)(0.95f*last + 0.5f)]));
+		set(MI_FRAME_P99_US, (int)(1000.0f*sorted[(int)(0.99f*last + 0.5f)]));
+	}
+	if (ms > 1.5f*refresh_interval_ms) add(MI_DROPPED_FRAME_COUNT);
+}
+
+void MetricsServer::writeMetrics(char *buffer, size_t buffer_size) {
+	int v[MI_COUNT];
+	for (int i = 0; i < MI_COUNT; i++) v[i] = SDL_AtomicGet(&values[i]);
+	double uptime = (double)(SDL_GetTicks() - start_ticks) / 1000.0;
+	double kib = 1024.0;
+	snprintf(buffer, buffer_size,
+		"# HELP twotris_uptime_seconds Seconds since the metrics endpoint started.\n"
+		"# TYPE twotris_uptime_seconds gauge\n"
+		"twotris_uptime_seconds %.3f\n"
+		"# HELP twotris_frame_time_seconds Frame time quantiles of the last %d frames.\n"
+		"# TYPE twotris_frame_time_seconds gauge\n"
+		"twotris_frame_time_seconds{quantile=\"0.5\"} %.6f\n"
+		"twotris_frame_time_seconds{quantile=\"0.95\"} %.6f\n"
+		"twotris_frame_time_seconds{quantile=\"0.99\"} %.6f\n"
+		"# HELP twotris_frames_total Frames drawn.\n"
+		"# TYPE twotris_frames_total counter\n"
+		"twotris_frames_total %d\n"
+		"# HELP twotris_dropped_frames_total Frames longer than 1.5 refresh intervals.\n"
+		"# TYPE twotris_dropped_frames_total counter\n"
+		"twotris_dropped_frames_total %d\n"
+		"# HELP twotris_hitches_total Frames flagged by the hitch detector.\n"
+		"# TYPE twotris_hitches_total counter\n"
+		"twotris_hitches_total %d\n"
+		"# HELP twotris_shader_gpu_time_seconds GPU time of the last timed draw of the shader.\n"
+		"# TYPE twotris_shader_gpu_time_seconds gauge\n"
+		"twotris_shader_gpu_time_seconds %.6f\n"
+		"# HELP twotris_shader_compiles_total Fragment shader compiles by result.\n"
+		"# TYPE twotris_shader_compiles_total counter\n"
+		"twotris_shader_compiles_total{result=\"ok\"} %d\n"
+		"twotris_shader_compiles_total{result=\"error\"} %d\n"
+		"# HELP twotris_texture_memory_bytes Texture memory tracked by the app.\n"
+		"# TYPE twotris_texture_memory_bytes gauge\n"
+		"twotris_texture_memory_bytes %.0f\n"
+		"# HELP twotris_gpu_memory_bytes GPU memory tracked by the app, textures, buffers and framebuffers.\n"
+		"# TYPE twotris_gpu_memory_bytes gauge\n"
+		"twotris_gpu_memory_bytes %.0f\n"
+		"# HELP twotris_startup_seconds Time from the start of the process to the first frame on screen.\n"
+		"# TYPE twotris_startup_seconds gauge\n"
+		"twotris_startup_seconds %.3f\n",
+		uptime, (int)metrics_frame_window,
+		v[MI_FRAME_P50_US]*1e-6, v[MI_FRAME_P95_US]*1e-6, v[MI_FRAME_P99_US]*1e-6,
+		v[MI_FRAME_COUNT], v[MI_DROPPED_FRAME_COUNT], v[MI_HITCH_COUNT],
+		v[MI_SHADER_GPU_US]*1e-6,
+		v[MI_COMPILE_COUNT] - v[MI_COMPILE_ERROR_COUNT], v[MI_COMPILE_ERROR_COUNT],
+		v[MI_TEXTURE_MEMORY_KIB]*kib, v[MI_GPU_MEMORY_KIB]*kib,
+		v[MI_STARTUP_MS]*1e-3);
+}
+
+static bool sendAll(MetricsSocket client, const char *data, size_t size) {
+	while (size) {
+		int sent = (int)send(client, data, (int)size, metrics_send_flags);
+		if (sent <= 0) return false;
+		data += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+int MetricsServer::serverThread(void *data) {
+	MetricsServer *server = (MetricsServer*)data;
+	const size_t body_size = 8 << 10;
+	char *body = new char[body_size];
+	while (!SDL_AtomicGet(&server->quit)) {
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(server->listen_socket, &read_set);
+		timeval timeout = {0, 250000};
+		if (select((int)server->listen_socket+1, &read_set, nullptr, nullptr, &timeout) <= 0) continue;
+		MetricsSocket client = accept(server->listen_socket, nullptr, nullptr);
+		if (client == invalid_metrics_socket) continue;
+
+		// a client that doesn't send or read only holds up other clients for a second
+#ifdef _WIN32
+		DWORD socket_timeout = 1000;
+#else
+		timeval socket_timeout = {1, 0};
+#endif
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&socket_timeout, sizeof(socket_timeout));
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char*)&socket_timeout, sizeof(socket_timeout));
+#ifdef SO_NOSIGPIPE
+		int no_sigpipe = 1;
+		setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+		char request[1024]; // only the request line matters
+		int request_len = (int)recv(client, request, sizeof(request)-1, 0);
+		if (request_len > 0) {
+			request[request_len] = '\0';
+			bool is_metrics = !strncmp(request, "GET /metrics ", 13) || !strncmp(request, "GET / ", 6);
+			if (is_metrics) server->writeMetrics(body, body_size);
+			else snprintf(body, body_size, "only GET /metrics is served\n");
+			char header[256];
+			snprintf(header, sizeof(header),
+				"HTTP/1.0 %s\r\n"
+				"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+				"Content-Length: %d\r\n"
+				"Connection: close\r\n\r\n",
+				is_metrics ? "200 OK" : "404 Not Found", (int)strlen(body));
+			if (sendAll(client, header, strlen(header))) sendAll(client, body, strlen(body));
+		}
+		closeMetricsSocket(client);
+	}
+	delete [] body;
+	return 0;
+}
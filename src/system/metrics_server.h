@@ -0,0 +1,54 @@
+// Prometheus text format endpoint on 127.0.0.1 for monitoring unattended
+// installations, e.g. http://127.0.0.1:9464/metrics. The main thread only
+// stores values into atomics, a background thread accepts the connections and
+// formats them, so a slow or stuck client never blocks the render loop.
+enum MetricId {
+	MI_FRAME_P50_US, // frame time quantiles of the last metrics_frame_window frames
+	MI_FRAME_P95_US,
+	MI_FRAME_P99_US,
+	MI_FRAME_COUNT,
+	MI_DROPPED_FRAME_COUNT, // longer than 1.5 refresh intervals
+	MI_HITCH_COUNT,
+	MI_SHADER_GPU_US, // of the bound program, timer queries
+	MI_COMPILE_COUNT,
+	MI_COMPILE_ERROR_COUNT,
+	MI_TEXTURE_MEMORY_KIB,
+	MI_GPU_MEMORY_KIB, // all tracked allocations
+	MI_STARTUP_MS, // from main to the first frame on screen
+	MI_COUNT
+};
+
+struct MetricsServer {
+	SDL_atomic_t values[MI_COUNT] = {};
+
+	void set(MetricId id, int value) {SDL_AtomicSet(&values[id], value);}
+	void add(MetricId id, int delta = 1) {SDL_AtomicAdd(&values[id], delta);}
+
+	bool start(int port); // 0 < port < 65536, logs errors
+	void stop();
+	bool isRunning() {return !!thread;}
+
+	// call on the main thread at the same point of every frame
+	void beginFrame();
+
+private:
+	enum {metrics_frame_window = 600};
+	float frame_ms[metrics_frame_window];
+	int frame_sample_count = 0; // up to metrics_frame_window, then the ring is full
+	u64 frame_begin_ticks = 0;
+	float refresh_interval_ms = 1000.0f / 60.0f; // of the window's display
+	u32 start_ticks = 0; // uptime
+
+#ifdef _WIN32
+	SOCKET listen_socket = INVALID_SOCKET;
+#else
+	int listen_socket = -1;
+#endif
+	SDL_Thread *thread = nullptr;
+	SDL_atomic_t quit = {0};
+
+	static int serverThread(void *data);
+	void writeMetrics(char *buffer, size_t buffer_size);
+};
+
+extern MetricsServer metrics_server;
@@ -0,0 +1,104 @@
+Profiler profiler;
+
+void Profiler::init() {
+	if (!thread_tls) thread_tls = SDL_TLSCreate();
+	base_ticks = SDL_GetPerformanceCounter();
+}
+
+ProfileThread *Profiler::getThread() {
+	if (!thread_tls) return nullptr; // not initialized
+	ProfileThread *thread = (ProfileThread*)SDL_TLSGet(thread_tls);
+	if (thread) return thread;
+
+	int index = SDL_AtomicAdd(&thread_count, 1);
+	if (index >= max_thread_count) {
+		SDL_AtomicAdd(&thread_count, -1);
+		return nullptr;
+	}
+	thread = new ProfileThread;
+	thread->thread_id = SDL_ThreadID();
+	snprintf(thread->name, sizeof(thread->name), "thread %d", index);
+	SDL_TLSSet(thread_tls, thread, nullptr); // lives as long as the app
+	SDL_AtomicSetPtr(&threads[index], thread);
+	return thread;
+}
+
+void Profiler::setThreadName(const char *name) {
+	ProfileThread *thread = getThread();
+	if (!thread) return;
+	strncpy(thread->name, name, sizeof(thread->name)-1);
+	thread->name[sizeof(thread->name)-1] = '\0';
+}
+
+void Profiler::addZone(const char *name, u64 begin_ticks, u64 end_ticks) {
+	ProfileThread *thread = getThread();
+	if (!thread) return;
+	ProfileZone *zone = thread->zones + (thread->written_count & (ProfileThread::zone_ring_size-1));
+	zone->name = name;
+	zone->begin_ticks = begin_ticks;
+	zone->end_ticks = end_ticks;
+	thread->written_count++;
+	SDL_AtomicSet(&thread->published_count, (int)thread->written_count); // publishes the zone
+}
+
+int Profiler::getRecentZones(u64 since_ticks, ProfileZone *out_zones, int max_count) {
+	ProfileThread *thread = getThread();
+	if (!thread) return 0;
+	int count = 0;
+	u32 available_count = thread->written_count < (u32)ProfileThread::zone_ring_size
+		? thread->written_count : (u32)ProfileThread::zone_ring_size;
+	for (u32 i = 1; i <= available_count && count < max_count; i++) { // zones are added as they end
+		ProfileZone *zone = thread->zones + ((thread->written_count - i) & (ProfileThread::zone_ring_size-1));
+		if (zone->end_ticks < since_ticks) break;
+		out_zones[count++] = *zone;
+	}
+	return count;
+}
+
+bool Profiler::exportChromeTrace(const char *filepath) {
+	FILE *file = fopen(filepath, "w");
+	if (!file) {
+		LOGE("Could not open %s for writing", filepath);
+		return false;
+	}
+	double ticks_to_us = 1e6 / (double)SDL_GetPerformanceFrequency();
+	ProfileZone *zones = new ProfileZone[ProfileThread::zone_ring_size];
+	int zone_count = 0;
+	bool is_first_event = true;
+	fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	int count = SDL_AtomicGet(&thread_count);
+	for (int ti = 0; ti < count && ti < max_thread_count; ti++) {
+		ProfileThread *thread = (ProfileThread*)SDL_AtomicGetPtr(&threads[ti]);
+		if (!thread) continue; // still registering
+
+		// copy the ring, then drop what the writer may have overwritten while copying
+		u32 end = (u32)SDL_AtomicGet(&thread->published_count);
+		u32 copy_count = end < (u32)ProfileThread::zone_ring_size ? end : (u32)ProfileThread::zone_ring_size;
+		for (u32 i = 0; i < copy_count; i++) {
+			zones[i] = thread->zones[(end - copy_count + i) & (ProfileThread::zone_ring_size-1)];
+		}
+		u32 end_after = (u32)SDL_AtomicGet(&thread->published_count);
+		// the writer is at end_after now, the zone it writes replaces end_after - zone_ring_size
+		int first = (int)(end_after - end) + 1 - (ProfileThread::zone_ring_size - (int)copy_count);
+		if (first < 0) first = 0;
+
+		fprintf(file, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+			is_first_event ? "" : ",", ti, thread->name);
+		is_first_event = false;
+		for (int i = first; i < (int)copy_count; i++) {
+			ProfileZone *zone = zones + i;
+			if (zone->begin_ticks < base_ticks) continue;
+			fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+				zone->name, ti, (double)(zone->begin_ticks - base_ticks) * ticks_to_us,
+				(double)(zone->end_ticks - zone->begin_ticks) * ticks_to_us);
+			zone_count++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	delete [] zones;
+	bool is_written = !ferror(file);
+	fclose(file);
+	if (is_written) LOGI("Wrote %d zones to %s", zone_count, filepath);
+	else LOGE("Could not write %s", filepath);
+	return is_written;
+}
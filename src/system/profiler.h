@@ -0,0 +1,60 @@
+// Scoped CPU timing zones of the main and worker threads, e.g. the phases of
+// a frame, exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev):
+//   {PROFILE_ZONE("draw"); ...}
+// Names must be string literals. Every thread writes its zones into its own
+// ring without locks, the oldest get overwritten, so an export shows the last
+// few seconds. Exports read the rings while they are written and drop the
+// zones that were overwritten in the meantime.
+struct ProfileZone {
+	const char *name;
+	u64 begin_ticks, end_ticks; // SDL_GetPerformanceCounter
+};
+
+struct ProfileThread {
+	enum {zone_ring_size = 1 << 14}; // power of two
+	ProfileZone zones[zone_ring_size];
+	u32 written_count = 0; // owning thread only
+	SDL_atomic_t published_count = {0}; // zones the exporter may read, wraps
+	SDL_threadID thread_id;
+	char name[32];
+};
+
+struct Profiler {
+	void init(); // on the main thread before other threads add zones
+	void setEnabled(bool enabled) {SDL_AtomicSet(&is_enabled, enabled ? 1 : 0);}
+	bool isEnabled() {return !!SDL_AtomicGet(&is_enabled);}
+	void setThreadName(const char *name); // track name of the calling thread
+
+	void addZone(const char *name, u64 begin_ticks, u64 end_ticks);
+	// zones of the calling thread that ended at or after since_ticks, newest first
+	int getRecentZones(u64 since_ticks, ProfileZone *out_zones, int max_count);
+	bool exportChromeTrace(const char *filepath);
+
+private:
+	enum {max_thread_count = 64};
+	SDL_TLSID thread_tls = 0; // ProfileThread of the calling thread
+	void *threads[max_thread_count] = {}; // ProfileThread, set with SDL_AtomicSetPtr
+	SDL_atomic_t thread_count = {0};
+	SDL_atomic_t is_enabled = {1};
+	u64 base_ticks = 0; // trace timestamps start here
+
+	ProfileThread *getThread(); // registers the calling thread on its first zone
+};
+
+extern Profiler profiler;
+
+struct ProfileScope {
+	const char *name;
+	u64 begin_ticks;
+
+	ProfileScope(const char *name) : name(name), begin_ticks(profiler.isEnabled() ? SDL_GetPerformanceCounter() : 0) {}
+	~ProfileScope() {end();}
+	void end() { // before the scope ends
+		if (begin_ticks) profiler.addZone(name, begin_ticks, SDL_GetPerformanceCounter());
+		begin_ticks = 0;
+	}
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
@@ -0,0 +1,38 @@
+StartupTimer startup_timer;
+
+static float startupTicksToMs(u64 ticks) {
+	return (float)((double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+void StartupTimer::begin() {
+	begin_ticks = phase_begin_ticks = SDL_GetPerformanceCounter();
+	phase_count = 0;
+	is_finished = false;
+}
+
+void StartupTimer::endPhase(const char *name) {
+	if (is_finished) return;
+	u64 ticks = SDL_GetPerformanceCounter();
+	if (phase_count < max_phase_count) {
+		phases[phase_count++] = {name, phase_begin_ticks, ticks};
+		profiler.addZone(name, phase_begin_ticks, ticks); // dropped if the profiler isn't initialized yet
+	}
+	phase_begin_ticks = ticks;
+}
+
+void StartupTimer::finish() {
+	if (is_finished) return;
+	endPhase("first frame");
+	is_finished = true;
+
+	LOGI("Startup%s took %.1f ms to the first frame:", is_fast_start ? " (fast start)" : "", getTotalMs());
+	for (int i = 0; i < phase_count; i++) {
+		StartupPhase *phase = phases + i;
+		LOGI("  %-20s %8.2f ms", phase->name, startupTicksToMs(phase->end_ticks - phase->begin_ticks));
+	}
+}
+
+float StartupTimer::getTotalMs() {
+	if (!phase_count) return 0.0f;
+	return startupTicksToMs(phases[phase_count-1].end_ticks - begin_ticks);
+}
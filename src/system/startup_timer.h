@@ -0,0 +1,28 @@
+// Wall clock time of the startup phases, from the start of main to the first
+// frame on screen. Phases are back to back on the main thread, each one ends
+// where the next begins. They are added to the profile zones and logged as a
+// table once the first frame is swapped.
+struct StartupPhase {
+	const char *name; // string literal
+	u64 begin_ticks, end_ticks; // SDL_GetPerformanceCounter
+};
+
+struct StartupTimer {
+	enum {max_phase_count = 32};
+	StartupPhase phases[max_phase_count];
+	int phase_count = 0;
+	bool is_fast_start = false; // only reported
+
+	void begin(); // first thing in main
+	void endPhase(const char *name); // the phase from the end of the one before
+	void finish(); // after the first swap, logs the phases
+	bool isFinished() {return is_finished;}
+	float getTotalMs(); // of the finished phases
+
+private:
+	u64 begin_ticks = 0;
+	u64 phase_begin_ticks = 0;
+	bool is_finished = false;
+};
+
+extern StartupTimer startup_timer;
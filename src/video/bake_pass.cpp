@@ -0,0 +1,227 @@
+static const char *bake_vert_src =
+	"attribute vec4 va_position;"
+	"void main() {gl_Position = va_position;}";
+
+static char *getBakeFilepath(const char *shader_filepath) {
+	// foo.frag -> foo.bake.frag
+	const char *ext = strrchr(shader_filepath, '.');
+	const char *sep = strrchr(shader_filepath, '/');
+	const char *sep_win = strrchr(shader_filepath, '\\');
+	if (sep_win > sep) sep = sep_win;
+	if (!ext || (sep && ext < sep)) ext = shader_filepath + strlen(shader_filepath); // no extension
+	size_t stem_len = ext - shader_filepath;
+	char *filepath = new char[strlen(shader_filepath) + 6 + 1];
+	memcpy(filepath, shader_filepath, stem_len);
+	strcpy(filepath + stem_len, ".bake");
+	strcat(filepath, ext);
+	return filepath;
+}
+
+void BakePass::load(const char *shader_filepath) {
+	unload();
+	char *bake_filepath = getBakeFilepath(shader_filepath);
+	struct stat attr;
+	if (stat(bake_filepath, &attr)) { // this project has no bake shader
+		delete [] bake_filepath;
+		return;
+	}
+	filepath = bake_filepath;
+	file_mtime = 0;
+	checkFile();
+}
+
+void BakePass::unload() {
+	if (filepath) {
+		delete [] filepath;
+		filepath = nullptr;
+	}
+	if (compile_error_log) {
+		delete [] compile_error_log;
+		compile_error_log = nullptr;
+	}
+	clearInputs();
+	texture = 0;
+	allocated_texture = 0;
+	needs_bake = false;
+}
+
+void BakePass::clearInputs() {
+	if (inputs) {
+		delete [] inputs;
+		inputs = nullptr;
+	}
+	input_count = 0;
+	resolution_location = -1;
+}
+
+void BakePass::checkFile() {
+	if (!filepath) return;
+	struct stat attr;
+	if (stat(filepath, &attr)) return; // gone, keep the last bake
+	if (attr.st_mtime <= file_mtime) return;
+	file_mtime = (int)attr.st_mtime;
+
+	char *src = readStringFromFile(filepath);
+	if (!src) return;
+	parsePragma(src);
+	compile(src);
+	delete [] src;
+}
+
+void BakePass::parsePragma(const char *src) {
+	width = height = 256;
+	slot = 7;
+	full_float = false;
+	const char *pragma = strstr(src, "#pragma bake");
+	if (!pragma) return;
+	const char *end = strchr(pragma, '\n');
+	if (!end) end = pragma + strlen(pragma);
+	char line[256];
+	size_t line_len = end - pragma < (ptrdiff_t)sizeof(line) ? end - pragma : sizeof(line)-1;
+	memcpy(line, pragma, line_len);
+	line[line_len] = '\0';
+
+	const char *size = strstr(line, "size=");
+	if (size && sscanf(size, "size=%dx%d", &width, &height) != 2) {
+		LOGW("Bake pragma: size should look like size=256x256");
+	}
+	if (width < 1) width = 1;
+	if (height < 1) height = 1;
+	GLint max_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+	if (max_size > 0 && (width > max_size || height > max_size)) {
+		LOGW("Bake pragma: size %dx%d is larger than the %d the driver supports, clamped", width, height, max_size);
+		if (width > max_size) width = max_size;
+		if (height > max_size) height = max_size;
+	}
+	const char *slot_str = strstr(line, "slot=");
+	if (slot_str) slot = atoi(slot_str + 5);
+	if (slot < 0 || slot > 7) slot = 7;
+	full_float = strstr(line, "rgba32f") != nullptr;
+}
+
+void BakePass::compile(const char *src) {
+	if (compile_error_log) {
+		delete [] compile_error_log;
+		compile_error_log = nullptr;
+	}
+	clearInputs();
+
+	if (!has_vertex_shader) {
+		shader.compileAndAttach(GL_VERTEX_SHADER, bake_vert_src);
+		shader.bindVertexAttrib("va_position", VAT_POSITION);
+		has_vertex_shader = true;
+	}
+	if (!shader.compileAndAttach(GL_FRAGMENT_SHADER, src)) {
+		compile_error_log = shader.getShaderCompileErrorLog(GL_FRAGMENT_SHADER);
+		LOGW("Bake shader '%s' did not compile:\n%s", filepath, compile_error_log);
+		return;
+	}
+	if (!shader.link()) {
+		compile_error_log = shader.getLinkErrorLog();
+		LOGW("Bake shader '%s' did not link:\n%s", filepath, compile_error_log);
+		return;
+	}
+
+	// remember which uniforms there are, values are looked up by name at bake time
+	GLint active_count = 0;
+	glGetProgramiv(shader.getProgram(), GL_ACTIVE_UNIFORMS, &active_count);
+	inputs = new ShaderUniform[active_count > 0 ? active_count : 1];
+	for (int i = 0; i < active_count; i++) {
+		ShaderUniform *input = inputs + input_count;
+		GLsizei name_len;
+		glGetActiveUniform(shader.getProgram(), i, (GLsizei)sizeof(input->name),
+			&name_len, &input->size, &input->type, input->name);
+		input->location = shader.getUniformLocation(input->name);
+		input->data = nullptr;
+		input->flags = 0;
+		if (!strcmp(input->name, "u_resolution")) {
+			resolution_location = input->location;
+			continue;
+		}
+		input_count++;
+	}
+	needs_bake = true;
+}
+
+bool BakePass::update(GLuint *io_texture, ShaderUniform *uniforms, int uniform_count, GLuint triangle_vbo) {
+	gpu_timer.collect(); // bakes are rare, begin() alone would leave the last one pending
+	if (!filepath || compile_error_log || !inputs) return false;
+
+	// hash everything the result depends on, the source is covered by needs_bake
+	u32 settings[3] = {(u32)width, (u32)height, (u32)full_float};
+	u64 hash = hashBytes(settings, sizeof(settings));
+	for (int i = 0; i < input_count; i++) {
+		ShaderUniform *input = inputs + i;
+		input->data = nullptr;
+		for (int j = 0; j < uniform_count; j++) {
+			ShaderUniform *uniform = uniforms + j;
+			if (uniform->type != input->type || strcmp(uniform->name, input->name)) continue;
+			if (uniform->size < input->size) continue; // array too short
+			input->data = uniform->data;
+			hash = hashBytes(input->data, input->getSize(), hash);
+			break;
+		}
+	}
+	if (!needs_bake && hash == inputs_hash && *io_texture == texture) return false;
+
+	u64 begin_ticks = SDL_GetPerformanceCounter();
+	// a new name may be the one of a texture the slot deleted, so it always gets storage
+	bool is_new_texture = !*io_texture;
+	if (is_new_texture) glGenTextures(1, io_texture);
+	glBindTexture(GL_TEXTURE_2D, *io_texture);
+	if (is_new_texture || *io_texture != allocated_texture || width != allocated_width
+		|| height != allocated_height || full_float != allocated_full_float) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, full_float ? GL_RGBA32F : GL_RGBA16F,
+			width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+		allocated_texture = *io_texture;
+		allocated_width = width;
+		allocated_height = height;
+		allocated_full_float = full_float;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (!framebuffer) {
+		glGenFramebuffers(1, &framebuffer);
+		gpu_memory.track(GMK_FRAMEBUFFER, framebuffer, 0); // renders into the slot texture, no storage of its own
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *io_texture, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status == GL_FRAMEBUFFER_COMPLETE) {
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glViewport(0, 0, width, height);
+		gpu_timer.begin();
+		shader.use();
+		for (int i = 0; i < input_count; i++) {
+			if (inputs[i].data) inputs[i].apply();
+		}
+		if (resolution_location != -1) glUniform2f(resolution_location, (float)width, (float)height);
+		glBindBuffer(GL_ARRAY_BUFFER, triangle_vbo); // fullscreen triangle
+		glEnableVertexAttribArray(VAT_POSITION);
+		glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glDisableVertexAttribArray(VAT_POSITION);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glUseProgram(0);
+		gpu_timer.end();
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	} else { // leaves the texture undefined, trying again every frame won't help
+		LOGE("Bake framebuffer incomplete (0x%X), float render targets not supported?", status);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	bake_ms = (float)(1000.0 * (double)(SDL_GetPerformanceCounter() - begin_ticks)
+		/ (double)SDL_GetPerformanceFrequency());
+	bake_count++;
+	needs_bake = false;
+	inputs_hash = hash;
+	texture = *io_texture;
+	return true;
+}
@@ -0,0 +1,47 @@
+// Optional bake shader of a project: next to foo.frag there may be a
+// foo.bake.frag. It is rendered into a float texture that the main shader
+// samples (a split-sum BRDF lookup table, a tabulated phase function, ...)
+// and rendered again only when its source or one of its inputs changed.
+// Settings are given in the bake shader, all optional:
+//   #pragma bake(size=256x256, slot=7, format=rgba16f)
+// Its uniforms take the values of main shader uniforms of the same name,
+// except u_resolution which is the bake size.
+struct BakePass {
+	char *filepath = nullptr;
+	int width = 256, height = 256;
+	int slot = 7; // texture slot that receives the result
+	bool full_float = false; // rgba32f instead of rgba16f
+	char *compile_error_log = nullptr;
+	GLuint texture = 0; // last baked into, owned by the texture slot
+	int bake_count = 0;
+	float bake_ms = 0.0f; // cpu time of the last bake, without waiting for the gpu
+	GpuTimer gpu_timer; // gpu time of the bakes, a few frames late
+
+	void load(const char *shader_filepath); // picks up the bake shader if there is one
+	void unload();
+	bool isLoaded() {return filepath != nullptr;}
+	void checkFile(); // recompiles if the file changed
+	void invalidate() {needs_bake = true;}
+
+	// renders into *io_texture (created if 0) if anything changed since the last
+	// bake. input values are looked up in uniforms. returns true if it baked
+	bool update(GLuint *io_texture, ShaderUniform *uniforms, int uniform_count, GLuint triangle_vbo);
+
+private:
+	Shader shader;
+	bool has_vertex_shader = false;
+	int file_mtime = 0;
+	GLuint framebuffer = 0;
+	bool needs_bake = false;
+	u64 inputs_hash = 0;
+	ShaderUniform *inputs = nullptr; // data points into the main shader's uniform data
+	int input_count = 0;
+	GLint resolution_location = -1;
+	GLuint allocated_texture = 0; // storage of this texture has the current size and format
+	int allocated_width = 0, allocated_height = 0;
+	bool allocated_full_float = false;
+
+	void compile(const char *src);
+	void parsePragma(const char *src);
+	void clearInputs();
+};
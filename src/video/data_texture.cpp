@@ -0,0 +1,316 @@
+static const int data_texture_row_length = 1024; // records per texture row when wrapping
+
+bool isDataFile(const char *filepath) {
+	return hasFileExtension(filepath, "csv") || hasFileExtension(filepath, "f32");
+}
+
+static inline bool isCsvSeparator(char c) {
+	return c == ',' || c == ';' || c == '\t';
+}
+
+// strtof needs a terminated string, the mapping isn't. nullptr if there is no number
+static const char *parseCsvFloat(const char *c, const char *end, float *out) {
+	while (c < end && (*c == ' ' || *c == '"')) c++;
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+')) negative = *c++ == '-';
+	double mantissa = 0.0;
+	int digit_count = 0, exponent = 0;
+	for (; c < end && *c >= '0' && *c <= '9'; c++, digit_count++) mantissa = 10.0*mantissa + (*c - '0');
+	if (c < end && *c == '.') {
+		for (c++; c < end && *c >= '0' && *c <= '9'; c++, digit_count++) {
+			mantissa = 10.0*mantissa + (*c - '0');
+			exponent--;
+		}
+	}
+	if (!digit_count) return nullptr;
+	if (c < end && (*c == 'e' || *c == 'E')) {
+		const char *e = c+1;
+		bool negative_exponent = false;
+		if (e < end && (*e == '-' || *e == '+')) negative_exponent = *e++ == '-';
+		if (e < end && *e >= '0' && *e <= '9') {
+			int e_value = 0;
+			for (; e < end && *e >= '0' && *e <= '9'; e++) e_value = 10*e_value + (*e - '0');
+			exponent += negative_exponent ? -e_value : e_value;
+			c = e;
+		}
+	}
+	if (exponent) mantissa *= pow(10.0, exponent);
+	*out = (float)(negative ? -mantissa : mantissa);
+	while (c < end && (*c == ' ' || *c == '"')) c++;
+	return c;
+}
+
+struct CsvChunk {
+	const char *begin, *end; // whole lines
+	int record_count;
+	int first_record;
+	float min[4], max[4];
+};
+
+struct CsvParse {
+	CsvChunk *chunks;
+	int column_count;
+	float *values;
+};
+
+static void countCsvRecords(void *data, int index) {
+	CsvChunk *chunk = ((CsvParse*)data)->chunks + index;
+	int count = 0;
+	bool line_has_content = false;
+	for (const char *c = chunk->begin; c < chunk->end; c++) {
+		if (*c == '\n') {
+			count += line_has_content;
+			line_has_content = false;
+		} else if (*c != '\r' && *c != ' ') {
+			line_has_content = true;
+		}
+	}
+	chunk->record_count = count + line_has_content;
+}
+
+static void parseCsvChunk(void *data, int index) {
+	CsvParse *parse = (CsvParse*)data;
+	CsvChunk *chunk = parse->chunks + index;
+	for (int i = 0; i < 4; i++) {
+		chunk->min[i] = FLT_MAX;
+		chunk->max[i] = -FLT_MAX;
+	}
+	float *record = parse->values + (size_t)chunk->first_record*parse->column_count;
+	const char *c = chunk->begin;
+	int records_left = chunk->record_count;
+	while (c < chunk->end && records_left) {
+		const char *line_end = (const char*)memchr(c, '\n', chunk->end - c);
+		if (!line_end) line_end = chunk->end;
+		bool line_has_content = false;
+		for (const char *l = c; l < line_end; l++) line_has_content |= *l != '\r' && *l != ' ';
+		if (line_has_content) {
+			int column = 0;
+			const char *field = c;
+			while (column < parse->column_count) {
+				float value = NAN; // missing or not a number
+				const char *field_end = parseCsvFloat(field, line_end, &value);
+				if (!field_end) field_end = field;
+				record[column] = value;
+				if (value == value) { // not nan
+					int channel = parse->column_count <= 4 ? column : 0; // one range for wide tables
+					if (value < chunk->min[channel]) chunk->min[channel] = value;
+					if (value > chunk->max[channel]) chunk->max[channel] = value;
+				}
+				column++;
+				while (field_end < line_end && !isCsvSeparator(*field_end)) field_end++; // rest of a bad field
+				if (field_end == line_end) break;
+				field = field_end + 1;
+			}
+			for (; column < parse->column_count; column++) record[column] = NAN; // short line
+			record += parse->column_count;
+			records_left--;
+		}
+		c = line_end + 1;
+	}
+}
+
+static bool loadCsv(const char *filepath, float **out_values, DataTextureInfo *info) {
+	MappedFile file;
+	if (!file.open(filepath)) return false;
+	const char *begin = (const char*)file.data;
+	const char *end = begin + file.size;
+	if (file.size >= 3 && !memcmp(begin, "\xEF\xBB\xBF", 3)) begin += 3; // utf-8 bom
+
+	// the first line tells the column count and whether it's a header
+	while (begin < end && (*begin == '\n' || *begin == '\r')) begin++;
+	const char *first_line_end = (const char*)memchr(begin, '\n', end - begin);
+	if (!first_line_end) first_line_end = end;
+	int column_count = 0;
+	bool is_header = false;
+	for (const char *field = begin;;) {
+		float value;
+		const char *field_end = parseCsvFloat(field, first_line_end, &value);
+		if (!field_end) is_header = true;
+		else field = field_end;
+		while (field < first_line_end && !isCsvSeparator(*field)) {
+			if (*field != '\r' && *field != ' ') is_header = true;
+			field++;
+		}
+		column_count++;
+		if (field >= first_line_end) break;
+		field++;
+	}
+	if (is_header) begin = first_line_end < end ? first_line_end + 1 : end;
+
+	// split into chunks of whole lines for the workers
+	CsvParse parse;
+	int chunk_count = 1;
+	if (file.size > (1 << 20)) chunk_count = 4*(job_queue.getThreadCount() + 1);
+	parse.chunks = new CsvChunk[chunk_count];
+	const char *chunk_begin = begin;
+	for (int i = 0; i < chunk_count; i++) {
+		const char *chunk_end = i == chunk_count-1 ? end : begin + (end - begin)*(i+1)/chunk_count;
+		if (chunk_end < chunk_begin) chunk_end = chunk_begin;
+		const char *newline = (const char*)memchr(chunk_end, '\n', end - chunk_end);
+		chunk_end = newline ? newline + 1 : end;
+		parse.chunks[i].begin = chunk_begin;
+		parse.chunks[i].end = chunk_end;
+		chunk_begin = chunk_end;
+	}
+	job_queue.parallelFor(chunk_count, countCsvRecords, &parse);
+	int record_count = 0;
+	for (int i = 0; i < chunk_count; i++) {
+		parse.chunks[i].first_record = record_count;
+		record_count += parse.chunks[i].record_count;
+	}
+	if (!record_count || !column_count) {
+		LOGE("No records in '%s'", filepath);
+		delete [] parse.chunks;
+		return false;
+	}
+
+	parse.column_count = column_count;
+	parse.values = new float[(size_t)record_count*column_count];
+	job_queue.parallelFor(chunk_count, parseCsvChunk, &parse);
+	file.close();
+
+	info->record_count = record_count;
+	info->column_count = column_count;
+	info->channel_count = column_count <= 4 ? column_count : 1;
+	for (int i = 0; i < 4; i++) {
+		info->min[i] = FLT_MAX;
+		info->max[i] = -FLT_MAX;
+		for (int c = 0; c < chunk_count; c++) {
+			info->min[i] = fminf(info->min[i], parse.chunks[c].min[i]);
+			info->max[i] = fmaxf(info->max[i], parse.chunks[c].max[i]);
+		}
+	}
+	if (column_count > 4) { // one range for the whole table
+		for (int i = 1; i < 4; i++) {
+			info->min[i] = info->min[0];
+			info->max[i] = info->max[0];
+		}
+	}
+	delete [] parse.chunks;
+	*out_values = parse.values;
+	return true;
+}
+
+static bool loadF32(const char *filepath, MappedFile *file, DataTextureInfo *info) {
+	if (!file->open(filepath)) return false;
+	size_t float_count = file->size / sizeof(float);
+
+	const char *basename = strrchr(filepath, '/');
+	const char *basename_win = strrchr(filepath, '\\');
+	if (basename_win > basename) basename = basename_win;
+	basename = basename ? basename+1 : filepath;
+	const char *ext = strrchr(basename, '.');
+	info->channel_count = 1;
+	struct {const char *token; int channel_count;} channel_tokens[] = {
+		{"_rgba.", 4}, {"_rgb.", 3}, {"_rg.", 2}, {"_r.", 1}
+	};
+	for (int i = 0; i < (int)ARRAY_COUNT(channel_tokens); i++) {
+		const char *token = strstr(basename, channel_tokens[i].token);
+		if (token && token + strlen(channel_tokens[i].token) - 1 == ext) {
+			info->channel_count = channel_tokens[i].channel_count;
+			break;
+		}
+	}
+	info->column_count = info->channel_count;
+	info->record_count = (int)(float_count / info->channel_count);
+	info->width = info->height = 0;
+	for (const char *c = basename; *c; c++) {
+		if (c[0] < '0' || c[0] > '9' || (c > basename && c[-1] >= '0' && c[-1] <= '9')) continue;
+		if (sscanf(c, "%dx%d", &info->width, &info->height) == 2) break;
+		info->width = info->height = 0;
+	}
+	if (info->width > 0 && info->height > 0) {
+		if ((size_t)info->width*info->height*info->channel_count > float_count) {
+			LOGE("'%s' is smaller than %dx%d", filepath, info->width, info->height);
+			file->close();
+			return false;
+		}
+		info->record_count = info->width*info->height;
+	}
+	if (!info->record_count) {
+		file->close();
+		return false;
+	}
+
+	const float *values = (const float*)file->data;
+	for (int c = 0; c < 4; c++) {
+		info->min[c] = FLT_MAX;
+		info->max[c] = -FLT_MAX;
+	}
+	size_t value_count = (size_t)info->record_count*info->channel_count;
+	for (size_t i = 0; i < value_count; i++) {
+		float v = values[i];
+		if (v != v) continue;
+		int c = (int)(i % info->channel_count);
+		if (v < info->min[c]) info->min[c] = v;
+		if (v > info->max[c]) info->max[c] = v;
+	}
+	return true;
+}
+
+GLuint loadDataTexture(const char *filepath, DataTextureInfo *out_info) {
+	u64 begin_ticks = SDL_GetPerformanceCounter();
+	DataTextureInfo info;
+	MappedFile f32_file;
+	float *csv_values = nullptr;
+	const float *values;
+	if (hasFileExtension(filepath, "csv")) {
+		if (!loadCsv(filepath, &csv_values, &info)) return 0;
+		values = csv_values;
+		info.width = info.height = 0;
+	} else {
+		if (!loadF32(filepath, &f32_file, &info)) return 0;
+		values = (const float*)f32_file.data;
+	}
+
+	if (info.column_count > 4) { // table
+		info.width = info.column_count;
+		info.height = info.record_count;
+	} else if (!info.width) { // list, wrap into rows
+		info.width = info.record_count < data_texture_row_length ? info.record_count : data_texture_row_length;
+		info.height = (info.record_count + info.width - 1) / info.width;
+	}
+	GLint max_size;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+	if (info.width > max_size || info.height > max_size) {
+		LOGE("Data texture %dx%d exceeds GL_MAX_TEXTURE_SIZE %d: %s", info.width, info.height, max_size, filepath);
+		if (csv_values) delete [] csv_values;
+		f32_file.close();
+		return 0;
+	}
+
+	// the last row of a wrapped list is padded
+	size_t channels = info.column_count > 4 ? 1 : (size_t)info.channel_count;
+	size_t value_count = (size_t)info.width*info.height*channels;
+	float *padded = nullptr;
+	size_t available_count = (size_t)info.record_count*(info.column_count > 4 ? info.column_count : info.channel_count);
+	if (value_count > available_count) {
+		padded = new float[value_count];
+		memcpy(padded, values, available_count*sizeof(float));
+		for (size_t i = available_count; i < value_count; i++) padded[i] = 0.0f;
+		values = padded;
+	}
+
+	static const GLenum internal_formats[4] = {GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F};
+	static const GLenum formats[4] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// data, sample exact values
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, internal_formats[channels-1], info.width, info.height, 0,
+		formats[channels-1], GL_FLOAT, values);
+
+	if (padded) delete [] padded;
+	if (csv_values) delete [] csv_values;
+	f32_file.close();
+
+	double ms = 1000.0 * (double)(SDL_GetPerformanceCounter() - begin_ticks)
+		/ (double)SDL_GetPerformanceFrequency();
+	LOGI("Loaded %d records of %d columns from '%s' in %.0f ms", info.record_count, info.column_count, filepath, ms);
+	*out_info = info;
+	return texture;
+}
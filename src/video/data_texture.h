@@ -0,0 +1,22 @@
+// Numeric data as float textures for visualization shaders.
+//  .csv: records (lines) of numbers. 1 to 4 columns become the channels of
+//        one texel per record, records wrap into rows of up to 1024 texels.
+//        Wider tables are stored as R32F, one row per record.
+//        A header line with column names is skipped.
+//  .f32: raw little endian float32. The name may carry the size and the
+//        channel count, e.g. "heights_512x512.f32" or "flow_256x256_rg.f32",
+//        otherwise it is a list of scalars wrapped like a csv column.
+// The shader gets uniforms for texture slot i, if it declares them:
+//   vec4 u_data<i>_size (width, height, record count, column count)
+//   vec4 u_data<i>_min, u_data<i>_max per channel
+bool isDataFile(const char *filepath); // by extension
+
+struct DataTextureInfo {
+	int width, height;
+	int record_count;
+	int column_count;
+	int channel_count; // texture channels, 1 to 4
+	float min[4], max[4];
+};
+
+GLuint loadDataTexture(const char *filepath, DataTextureInfo *out_info);
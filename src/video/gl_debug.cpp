@@ -0,0 +1,172 @@
+// KHR_debug and ARB_debug_output share these values
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT                   0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS       0x8242
+#define GL_DEBUG_SOURCE_API               0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM     0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER   0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY       0x8249
+#define GL_DEBUG_SOURCE_APPLICATION       0x824A
+#define GL_DEBUG_SOURCE_OTHER             0x824B
+#define GL_DEBUG_TYPE_ERROR               0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR  0x824E
+#define GL_DEBUG_TYPE_PORTABILITY         0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE         0x8250
+#define GL_DEBUG_TYPE_OTHER               0x8251
+#define GL_DEBUG_TYPE_MARKER              0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP          0x8269
+#define GL_DEBUG_TYPE_POP_GROUP           0x826A
+#define GL_DEBUG_SEVERITY_HIGH            0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM          0x9147
+#define GL_DEBUG_SEVERITY_LOW             0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION    0x826B
+#endif
+
+// own typedefs, the callback's user parameter isn't const in older glew headers
+typedef void (GLAPIENTRY *GlDebugProc)(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar *text, const void *user_param);
+typedef void (GLAPIENTRY *GlDebugMessageCallbackProc)(GlDebugProc callback, const void *user_param);
+typedef void (GLAPIENTRY *GlDebugMessageControlProc)(GLenum source, GLenum type, GLenum severity,
+	GLsizei count, const GLuint *ids, GLboolean enabled);
+
+GlDebugOutput gl_debug;
+
+const char *gl_debug_category_names[GDC_COUNT] = {
+	"Error",
+	"Performance",
+	"Deprecated",
+	"Undefined",
+	"Portability",
+	"Marker",
+	"Other"
+};
+
+const char *gl_debug_severity_names[GDS_COUNT] = {
+	"Notification",
+	"Low",
+	"Medium",
+	"High"
+};
+
+static GlDebugCategory getGlDebugCategory(GLenum type) {
+	switch (type) {
+		case GL_DEBUG_TYPE_ERROR: return GDC_ERROR;
+		case GL_DEBUG_TYPE_PERFORMANCE: return GDC_PERFORMANCE;
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return GDC_DEPRECATED;
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return GDC_UNDEFINED;
+		case GL_DEBUG_TYPE_PORTABILITY: return GDC_PORTABILITY;
+		case GL_DEBUG_TYPE_MARKER: case GL_DEBUG_TYPE_PUSH_GROUP: case GL_DEBUG_TYPE_POP_GROUP: return GDC_MARKER;
+		default: return GDC_OTHER;
+	}
+}
+
+static GlDebugSeverity getGlDebugSeverity(GLenum severity) {
+	switch (severity) {
+		case GL_DEBUG_SEVERITY_HIGH: return GDS_HIGH;
+		case GL_DEBUG_SEVERITY_MEDIUM: return GDS_MEDIUM;
+		case GL_DEBUG_SEVERITY_LOW: return GDS_LOW;
+		default: return GDS_NOTIFICATION;
+	}
+}
+
+bool GlDebugOutput::init(bool is_debug_context) {
+	if (is_supported) return true;
+#ifdef EMSCRIPTEN
+	return false;
+#else
+	bool is_khr = !!SDL_GL_ExtensionSupported("GL_KHR_debug");
+	bool is_arb = !is_khr && SDL_GL_ExtensionSupported("GL_ARB_debug_output");
+	if (!is_khr && !is_arb) {
+		LOGI("No KHR_debug, driver debug output isn't available.");
+		return false;
+	}
+	GlDebugMessageCallbackProc debugMessageCallback = (GlDebugMessageCallbackProc)SDL_GL_GetProcAddress(
+		is_khr ? "glDebugMessageCallback" : "glDebugMessageCallbackARB");
+	GlDebugMessageControlProc debugMessageControl = (GlDebugMessageControlProc)SDL_GL_GetProcAddress(
+		is_khr ? "glDebugMessageControl" : "glDebugMessageControlARB");
+	if (!debugMessageCallback || !debugMessageControl) {
+		LOGW("Could not load the debug output functions.");
+		return false;
+	}
+
+	if (!mutex) mutex = SDL_CreateMutex();
+	if (!snapshot) snapshot = new GlDebugMessage[message_ring_size];
+	debugMessageCallback(debugCallback, this);
+	debugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE); // low severity is off by default
+	if (is_khr) glEnable(GL_DEBUG_OUTPUT); // ARB only has output in debug contexts
+	is_synchronous = is_debug_context;
+	if (is_synchronous) glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); // messages arrive in the call that caused them
+	is_supported = true;
+	LOGI("Capturing %s debug output%s.", is_khr ? "KHR" : "ARB", is_debug_context ? " of a debug context" : "");
+	return true;
+#endif
+}
+
+void GlDebugOutput::beginFrame() {
+	SDL_AtomicAdd(&frame_index, 1);
+}
+
+void GlDebugOutput::clear() {
+	if (!mutex) return;
+	SDL_LockMutex(mutex);
+	message_count = 0;
+	for (int i = 0; i < GDC_COUNT; i++) SDL_AtomicSet(&category_counts[i], 0);
+	SDL_AtomicSet(&total_count, 0);
+	SDL_UnlockMutex(mutex);
+}
+
+void GLAPIENTRY GlDebugOutput::debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar *text, const void *user_param) {
+	((GlDebugOutput*)user_param)->addMessage(source, type, id, severity, length, text);
+}
+
+void GlDebugOutput::addMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const char *text) {
+	if (length < 0) length = (GLsizei)strlen(text);
+	u64 text_hash = hashBytes(text, length);
+	GlDebugCategory category = getGlDebugCategory(type);
+	GlDebugSeverity message_severity = getGlDebugSeverity(severity);
+	u64 frame = (u64)SDL_AtomicGet(&frame_index);
+	SDL_AtomicAdd(&category_counts[category], 1);
+	SDL_AtomicAdd(&total_count, 1);
+
+	SDL_LockMutex(mutex);
+	int ring_count = message_count < message_ring_size ? message_count : (int)message_ring_size;
+	for (int i = 0; i < ring_count; i++) {
+		GlDebugMessage *message = messages + i;
+		if (message->text_hash == text_hash && message->id == id && message->source == source && message->category == category) {
+			message->count++;
+			message->last_frame = frame;
+			SDL_UnlockMutex(mutex);
+			return;
+		}
+	}
+	GlDebugMessage *message = messages + (message_count % message_ring_size);
+	message->category = category;
+	message->severity = message_severity;
+	message->source = source;
+	message->id = id;
+	message->text_hash = text_hash;
+	message->count = 1;
+	message->first_frame = message->last_frame = frame;
+	int text_len = length < (GLsizei)sizeof(message->text) ? (int)length : (int)sizeof(message->text)-1;
+	memcpy(message->text, text, text_len);
+	message->text[text_len] = '\0';
+	message_count++;
+	SDL_UnlockMutex(mutex);
+
+	// only the first of a kind is logged, the window has the rest
+	if (message_severity == GDS_HIGH) LOGE("GL %s: %.*s", gl_debug_category_names[category], (int)length, text);
+	else if (message_severity != GDS_NOTIFICATION) LOGW("GL %s: %.*s", gl_debug_category_names[category], (int)length, text);
+}
+
+int GlDebugOutput::takeSnapshot() {
+	if (!mutex) return 0;
+	SDL_LockMutex(mutex);
+	int ring_count = message_count < message_ring_size ? message_count : (int)message_ring_size;
+	for (int i = 0; i < ring_count; i++) {
+		snapshot[i] = messages[(message_count - 1 - i) % message_ring_size];
+	}
+	SDL_UnlockMutex(mutex);
+	return ring_count;
+}
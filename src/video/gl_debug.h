@@ -0,0 +1,81 @@
+// Debug output of the driver through KHR_debug (or ARB_debug_output), e.g.
+// shader recompiles on state changes, slow paths and redundant state reported
+// as performance messages. The callback may run on driver threads, messages
+// are deduplicated by source, category, id and text into a locked ring, so a
+// warning repeated every frame takes one entry with a count and the frames it
+// occurred in. Asynchronous output attributes messages to the frame the
+// callback runs in, a debug context makes it synchronous and exact.
+#ifndef GLAPIENTRY // glew defines it, the system headers on os x don't
+#define GLAPIENTRY
+#endif
+
+enum GlDebugCategory { // by message type
+	GDC_ERROR,
+	GDC_PERFORMANCE,
+	GDC_DEPRECATED,
+	GDC_UNDEFINED,
+	GDC_PORTABILITY,
+	GDC_MARKER, // markers and debug groups
+	GDC_OTHER,
+	GDC_COUNT
+};
+
+extern const char *gl_debug_category_names[GDC_COUNT];
+
+enum GlDebugSeverity {
+	GDS_NOTIFICATION,
+	GDS_LOW,
+	GDS_MEDIUM,
+	GDS_HIGH,
+	GDS_COUNT
+};
+
+extern const char *gl_debug_severity_names[GDS_COUNT];
+
+struct GlDebugMessage {
+	GlDebugCategory category;
+	GlDebugSeverity severity;
+	GLenum source;
+	GLuint id;
+	u64 text_hash;
+	int count;
+	u64 first_frame, last_frame;
+	char text[256]; // truncated
+};
+
+struct GlDebugOutput {
+	// filters of the GL Debug window, captured messages aren't filtered
+	bool is_category_shown[GDC_COUNT] = {true, true, true, true, true, false, true};
+	int min_severity = GDS_LOW; // GlDebugSeverity
+
+	// call with the context current, synchronous output if it's a debug context
+	bool init(bool is_debug_context);
+	bool isSupported() {return is_supported;}
+	bool isSynchronous() {return is_synchronous;}
+
+	void beginFrame(); // on the main thread, messages get the index of the frame
+	void clear();
+
+	// copies the messages into snapshot, newest first, main thread only
+	int takeSnapshot();
+	GlDebugMessage *snapshot = nullptr;
+	int getCategoryCount(GlDebugCategory category) {return SDL_AtomicGet(&category_counts[category]);}
+	int getTotalCount() {return SDL_AtomicGet(&total_count);}
+
+private:
+	enum {message_ring_size = 128};
+	GlDebugMessage messages[message_ring_size];
+	int message_count = 0; // unique since the start or clear(), the oldest get overwritten
+	SDL_mutex *mutex = nullptr;
+	SDL_atomic_t frame_index = {0};
+	SDL_atomic_t category_counts[GDC_COUNT] = {};
+	SDL_atomic_t total_count = {0}; // with duplicates
+	bool is_supported = false;
+	bool is_synchronous = false;
+
+	void addMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const char *text);
+	static void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+		GLsizei length, const GLchar *text, const void *user_param);
+};
+
+extern GlDebugOutput gl_debug;
@@ -0,0 +1,238 @@
+bool GlslToken::is(const char *str) const {
+	return !strncmp(text, str, length) && str[length] == '\0';
+}
+
+static bool isGlslIdentifierStart(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool isGlslDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static bool isGlslHexDigit(char c) {
+	return isGlslDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// longest operators first
+static const char *glsl_operators[] = {
+	"<<=", ">>=",
+	"++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "^^",
+	"+=", "-=", "*=", "/=", "%=", "&=", "|=", "^="
+};
+
+static int getGlslTokenLength(const char *c, bool at_line_start, GlslTokenType *out_type) {
+	const char *begin = c;
+	if (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r' || *c == '\f' || *c == '\v') {
+		while (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r' || *c == '\f' || *c == '\v') c++;
+		*out_type = GTT_WHITESPACE;
+	} else if (c[0] == '/' && c[1] == '/') {
+		while (*c && *c != '\n') c++;
+		*out_type = GTT_COMMENT;
+	} else if (c[0] == '/' && c[1] == '*') {
+		c += 2;
+		while (*c && !(c[0] == '*' && c[1] == '/')) c++;
+		if (*c) c += 2;
+		*out_type = GTT_COMMENT;
+	} else if (*c == '#' && at_line_start) {
+		while (*c && *c != '\n') {
+			if (c[0] == '\\' && c[1] == '\n') c++; // line continuation
+			else if (c[0] == '\\' && c[1] == '\r' && c[2] == '\n') c += 2;
+			c++;
+		}
+		*out_type = GTT_PREPROCESSOR;
+	} else if (isGlslIdentifierStart(*c)) {
+		while (isGlslIdentifierStart(*c) || isGlslDigit(*c)) c++;
+		*out_type = GTT_IDENTIFIER;
+	} else if (isGlslDigit(*c) || (c[0] == '.' && isGlslDigit(c[1]))) {
+		if (c[0] == '0' && (c[1] == 'x' || c[1] == 'X')) {
+			c += 2;
+			while (isGlslHexDigit(*c)) c++;
+		} else {
+			while (isGlslDigit(*c)) c++;
+			if (*c == '.') c++;
+			while (isGlslDigit(*c)) c++;
+			if ((*c == 'e' || *c == 'E')
+				&& (isGlslDigit(c[1]) || ((c[1] == '+' || c[1] == '-') && isGlslDigit(c[2])))) {
+				c += 2;
+				while (isGlslDigit(*c)) c++;
+			}
+		}
+		if ((c[0] == 'l' && c[1] == 'f') || (c[0] == 'L' && c[1] == 'F')) c += 2;
+		else if (*c == 'f' || *c == 'F' || *c == 'u' || *c == 'U') c++;
+		*out_type = GTT_NUMBER;
+	} else if (strchr("+-*/%<>=!&|^~?:;,.()[]{}", *c)) {
+		*out_type = GTT_OPERATOR;
+		for (int i = 0; i < (int)ARRAY_COUNT(glsl_operators); i++) {
+			size_t len = strlen(glsl_operators[i]);
+			if (!strncmp(c, glsl_operators[i], len)) return (int)len;
+		}
+		c++;
+	} else {
+		c++;
+		*out_type = GTT_UNKNOWN;
+	}
+	return (int)(c - begin);
+}
+
+int tokenizeGlsl(const char *src, GlslToken **out_tokens) {
+	*out_tokens = nullptr;
+	int token_count = 0, token_capacity = 0;
+	GlslToken *tokens = nullptr;
+	int line = 1;
+	bool at_line_start = true; // only whitespace since the last newline
+	for (const char *c = src; *c;) {
+		GlslTokenType type;
+		int length = getGlslTokenLength(c, at_line_start, &type);
+		if (token_count == token_capacity) {
+			token_capacity = token_capacity ? 2*token_capacity : 1024;
+			GlslToken *new_tokens = new GlslToken[token_capacity];
+			if (tokens) {
+				memcpy(new_tokens, tokens, token_count*sizeof(GlslToken));
+				delete [] tokens;
+			}
+			tokens = new_tokens;
+		}
+		GlslToken *token = tokens + token_count++;
+		token->type = type;
+		token->text = c;
+		token->length = length;
+		token->line = line;
+		for (int i = 0; i < length; i++) {
+			if (c[i] == '\n') {
+				line++;
+				at_line_start = true;
+			}
+		}
+		if (type != GTT_WHITESPACE) at_line_start = false;
+		c += length;
+	}
+	*out_tokens = tokens;
+	return token_count;
+}
+
+static const char *glsl_texture_fetch_names[] = {
+	"texture1D", "texture2D", "texture3D", "textureCube", "shadow1D", "shadow2D",
+	"texture1DLod", "texture2DLod", "texture3DLod", "textureCubeLod", "shadow1DLod", "shadow2DLod",
+	"texture1DProj", "texture2DProj", "texture3DProj", "shadow1DProj", "shadow2DProj",
+	"texture1DProjLod", "texture2DProjLod", "texture3DProjLod", "shadow1DProjLod", "shadow2DProjLod",
+	"texture2DLodEXT", "texture2DGradARB", "texture2DGradEXT", "textureCubeLodEXT", "textureCubeGradARB",
+	"texture", "textureLod", "textureProj", "textureProjLod", "textureGrad", "textureProjGrad",
+	"textureOffset", "textureLodOffset", "textureGradOffset", "textureProjOffset",
+	"texelFetch", "texelFetchOffset", "textureGather", "textureGatherOffset"
+};
+
+bool isGlslTextureFetch(const GlslToken *token) {
+	if (token->type != GTT_IDENTIFIER) return false;
+	for (int i = 0; i < (int)ARRAY_COUNT(glsl_texture_fetch_names); i++) {
+		if (token->is(glsl_texture_fetch_names[i])) return true;
+	}
+	return false;
+}
+
+bool isGlslBuiltinTypeName(const GlslToken *token) {
+	static const char *names[] = {
+		"float", "int", "uint", "bool", "vec2", "vec3", "vec4", "ivec2", "ivec3", "ivec4",
+		"uvec2", "uvec3", "uvec4", "bvec2", "bvec3", "bvec4", "mat2", "mat3", "mat4",
+		"mat2x2", "mat2x3", "mat2x4", "mat3x2", "mat3x3", "mat3x4", "mat4x2", "mat4x3", "mat4x4"
+	};
+	for (int i = 0; i < (int)ARRAY_COUNT(names); i++) {
+		if (token->is(names[i])) return true;
+	}
+	return false;
+}
+
+int skipGlslSpace(const GlslToken *tokens, int token_count, int index) {
+	while (index < token_count && !tokens[index].isSignificant()) index++;
+	return index;
+}
+
+int skipGlslSpaceBackwards(const GlslToken *tokens, int index) {
+	while (index >= 0 && !tokens[index].isSignificant()) index--;
+	return index;
+}
+
+int findClosingGlslBracket(const GlslToken *tokens, int token_count, int open_index) {
+	int depth = 0;
+	for (int i = open_index; i < token_count; i++) {
+		if (tokens[i].type != GTT_OPERATOR) continue;
+		char c = tokens[i].text[0];
+		if (c == '(' || c == '[' || c == '{') depth++;
+		else if (c == ')' || c == ']' || c == '}') {
+			if (--depth == 0) return i;
+		}
+	}
+	return token_count;
+}
+
+static void appendString(char **io_str, const char *text) {
+	size_t len = *io_str ? strlen(*io_str) : 0;
+	char *str = new char[len+strlen(text)+1];
+	if (*io_str) {
+		memcpy(str, *io_str, len);
+		delete [] *io_str;
+	}
+	strcpy(str+len, text);
+	*io_str = str;
+}
+
+void GlslRewriter::begin(const GlslToken *rewrite_tokens, int rewrite_token_count) {
+	end();
+	tokens = rewrite_tokens;
+	token_count = rewrite_token_count;
+	replacements = new char*[token_count+1]();
+	befores = new char*[token_count+1](); // one past the end for appending
+	afters = new char*[token_count+1]();
+}
+
+void GlslRewriter::end() {
+	for (int i = 0; replacements && i <= token_count; i++) {
+		delete [] replacements[i];
+		delete [] befores[i];
+		delete [] afters[i];
+	}
+	delete [] replacements; replacements = nullptr;
+	delete [] befores; befores = nullptr;
+	delete [] afters; afters = nullptr;
+	tokens = nullptr;
+	token_count = 0;
+}
+
+void GlslRewriter::replace(int token_index, const char *text) {
+	assert(token_index >= 0 && token_index < token_count);
+	delete [] replacements[token_index];
+	replacements[token_index] = nullptr;
+	appendString(&replacements[token_index], text);
+}
+
+void GlslRewriter::insertBefore(int token_index, const char *text) {
+	assert(token_index >= 0 && token_index <= token_count);
+	appendString(&befores[token_index], text);
+}
+
+void GlslRewriter::insertAfter(int token_index, const char *text) {
+	assert(token_index >= 0 && token_index < token_count);
+	appendString(&afters[token_index], text);
+}
+
+char *GlslRewriter::write() {
+	size_t size = 1;
+	for (int i = 0; i <= token_count; i++) {
+		if (befores[i]) size += strlen(befores[i]);
+		if (afters[i]) size += strlen(afters[i]);
+		if (i == token_count) break;
+		size += replacements[i] ? strlen(replacements[i]) : tokens[i].length;
+	}
+	char *src = new char[size];
+	char *out = src;
+	for (int i = 0; i <= token_count; i++) {
+		if (befores[i]) {strcpy(out, befores[i]); out += strlen(befores[i]);}
+		if (i < token_count) {
+			if (replacements[i]) {strcpy(out, replacements[i]); out += strlen(replacements[i]);}
+			else {memcpy(out, tokens[i].text, tokens[i].length); out += tokens[i].length;}
+		}
+		if (afters[i]) {strcpy(out, afters[i]); out += strlen(afters[i]);}
+	}
+	*out = '\0';
+	return src;
+}
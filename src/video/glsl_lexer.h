@@ -0,0 +1,56 @@
+// Tokenizer for GLSL source. The tokens cover the source without gaps, so
+// concatenating them gives back the original text. Tools rewrite a shader by
+// editing single tokens and keep the comments and formatting of the rest.
+enum GlslTokenType {
+	GTT_WHITESPACE,
+	GTT_COMMENT,
+	GTT_PREPROCESSOR, // a whole directive up to the end of the line, continuations included
+	GTT_IDENTIFIER, // keywords and type names too
+	GTT_NUMBER,
+	GTT_OPERATOR, // punctuation, multi character operators like += are one token
+	GTT_UNKNOWN
+};
+
+struct GlslToken {
+	GlslTokenType type;
+	const char *text; // into the source, not terminated
+	int length;
+	int line; // 1 based
+
+	bool is(const char *str) const;
+	bool isSignificant() const {return type != GTT_WHITESPACE && type != GTT_COMMENT;}
+};
+
+// returns the token count, *out_tokens is new[]'d (nullptr for an empty source)
+int tokenizeGlsl(const char *src, GlslToken **out_tokens);
+
+// builtin texture lookup function names, GLSL 1.10 to 1.30 and common extensions
+bool isGlslTextureFetch(const GlslToken *token);
+// scalar, vector and matrix types
+bool isGlslBuiltinTypeName(const GlslToken *token);
+
+// index of the next token at or after index that isn't whitespace or a comment, token_count if none
+int skipGlslSpace(const GlslToken *tokens, int token_count, int index);
+// index of the last such token at or before index, -1 if none
+int skipGlslSpaceBackwards(const GlslToken *tokens, int index);
+// index of the ) ] or } closing the bracket at open_index, token_count if unbalanced
+int findClosingGlslBracket(const GlslToken *tokens, int token_count, int open_index);
+
+// Edits to a token stream. A token can be replaced (removed with "") and get
+// text inserted before and after it, insertions at the same place keep their order.
+struct GlslRewriter {
+	const GlslToken *tokens = nullptr;
+	int token_count = 0;
+
+	void begin(const GlslToken *rewrite_tokens, int rewrite_token_count);
+	void end(); // drops all edits
+	void replace(int token_index, const char *text);
+	void insertBefore(int token_index, const char *text);
+	void insertAfter(int token_index, const char *text);
+	char *write(); // new[]'d source with the edits applied
+
+private:
+	char **replacements = nullptr; // per token, nullptr keeps the token
+	char **befores = nullptr;
+	char **afters = nullptr;
+};
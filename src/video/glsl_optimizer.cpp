@@ -0,0 +1,843 @@
+struct GlslFunctionInfo {
+	int begin; // first token of the return type
+	int name;
+	int params_open, params_close;
+	int body_open, body_close; // -1 for prototypes
+	int end; // closing brace or semicolon of a prototype
+	bool has_out_params;
+	bool writes_globals; // itself or through its callees
+};
+
+struct GlslOptimizer {
+	char *src = nullptr;
+	GlslToken *tokens = nullptr;
+	int token_count = 0;
+	GlslFunctionInfo *functions = nullptr;
+	int function_count = 0;
+	int *global_names = nullptr; // token indices of global variable names
+	int global_name_count = 0;
+	bool has_conditionals = false; // #if and friends, functions can't be matched reliably
+	GlslRewriter rewriter;
+	GlslOptimizerStats stats = {};
+
+	void parse();
+	bool apply(bool changed);
+	void release();
+
+	bool inlineCalls();
+	bool foldConstants();
+	bool removeConstantBranches();
+	bool reuseCalls();
+	bool removeDeadFunctions();
+
+	int next(int index) {return skipGlslSpace(tokens, token_count, index+1);}
+	int prev(int index) {return skipGlslSpaceBackwards(tokens, index-1);}
+	bool isCall(int index);
+	int findFunction(const GlslToken *name, int *out_definition_count = nullptr);
+	bool isGlobalName(const GlslToken *token);
+	bool isDeclaredBefore(const GlslToken *name, int index);
+	bool isPure(const GlslToken *name);
+	void remove(int begin, int end);
+	char *getText(int begin, int end);
+};
+
+static bool isSameToken(const GlslToken *a, const GlslToken *b) {
+	return a->length == b->length && !strncmp(a->text, b->text, a->length);
+}
+
+static bool isAssignmentOperator(const GlslToken *token) {
+	static const char *operators[] = {"=", "+=", "-=", "*=", "/=", "%=", "<<=", ">>=", "&=", "|=", "^=", "++", "--"};
+	if (token->type != GTT_OPERATOR) return false;
+	for (int i = 0; i < (int)ARRAY_COUNT(operators); i++) {
+		if (token->is(operators[i])) return true;
+	}
+	return false;
+}
+
+// C precedence levels, lower binds tighter, 0 if not a binary operator
+static int getBinaryPrecedence(const GlslToken *token) {
+	static const struct {const char *op; int precedence;} operators[] = {
+		{"*", 3}, {"/", 3}, {"%", 3}, {"+", 4}, {"-", 4}, {"<<", 5}, {">>", 5},
+		{"<", 6}, {">", 6}, {"<=", 6}, {">=", 6}, {"==", 7}, {"!=", 7},
+		{"&", 8}, {"^", 9}, {"|", 10}, {"&&", 11}, {"^^", 12}, {"||", 13}
+	};
+	if (token->type != GTT_OPERATOR) return 0;
+	for (int i = 0; i < (int)ARRAY_COUNT(operators); i++) {
+		if (token->is(operators[i].op)) return operators[i].precedence;
+	}
+	return 0;
+}
+
+// builtins with out parameters
+static bool isWritingBuiltin(const GlslToken *token) {
+	return token->is("modf") || token->is("frexp") || token->is("uaddCarry") || token->is("usubBorrow")
+		|| token->is("umulExtended") || token->is("imulExtended");
+}
+
+void GlslOptimizer::release() {
+	rewriter.end();
+	delete [] tokens; tokens = nullptr;
+	delete [] functions; functions = nullptr;
+	delete [] global_names; global_names = nullptr;
+	token_count = function_count = global_name_count = 0;
+}
+
+void GlslOptimizer::parse() {
+	release();
+	token_count = tokenizeGlsl(src, &tokens);
+	functions = new GlslFunctionInfo[token_count/4 + 1];
+	global_names = new int[token_count + 1];
+	has_conditionals = false;
+
+	int statement_begin = -1;
+	for (int i = skipGlslSpace(tokens, token_count, 0); i < token_count; i = next(i)) {
+		const GlslToken *token = tokens + i;
+		if (token->type == GTT_PREPROCESSOR) {
+			const char *c = token->text + 1;
+			while (*c == ' ' || *c == '\t') c++;
+			if (!strncmp(c, "if", 2) || !strncmp(c, "el", 2)) has_conditionals = true;
+			continue;
+		}
+		if (statement_begin < 0) statement_begin = i;
+		if (token->is("{")) { // struct or interface block
+			i = findClosingGlslBracket(tokens, token_count, i);
+			continue;
+		}
+		if (token->is(";")) { // declarations: names followed by = ; , or [ outside of brackets
+			int depth = 0;
+			for (int j = statement_begin; j < i; j = next(j)) {
+				if (tokens[j].is("(") || tokens[j].is("[") || tokens[j].is("{")) depth++;
+				else if (tokens[j].is(")") || tokens[j].is("]") || tokens[j].is("}")) depth--;
+				else if (depth == 0 && tokens[j].type == GTT_IDENTIFIER) {
+					const GlslToken *after = tokens + next(j);
+					if (after->is("=") || after->is(";") || after->is(",") || after->is("[")) global_names[global_name_count++] = j;
+				}
+			}
+			statement_begin = -1;
+			continue;
+		}
+		if (token->type != GTT_IDENTIFIER) continue;
+		int open = next(i);
+		int before = prev(i);
+		if (open >= token_count || !tokens[open].is("(") || before < statement_begin || tokens[before].type != GTT_IDENTIFIER) continue;
+		int close = findClosingGlslBracket(tokens, token_count, open);
+		int body = next(close);
+		if (body >= token_count || !(tokens[body].is("{") || tokens[body].is(";"))) continue;
+
+		GlslFunctionInfo *function = functions + function_count++;
+		function->begin = statement_begin;
+		function->name = i;
+		function->params_open = open;
+		function->params_close = close;
+		function->has_out_params = false;
+		function->writes_globals = false;
+		for (int j = open; j < close; j++) {
+			if (tokens[j].is("out") || tokens[j].is("inout")) function->has_out_params = true;
+		}
+		if (tokens[body].is("{")) {
+			function->body_open = body;
+			function->body_close = findClosingGlslBracket(tokens, token_count, body);
+			function->end = function->body_close;
+		} else {
+			function->body_open = function->body_close = -1;
+			function->end = body;
+		}
+		i = function->end;
+		statement_begin = -1;
+	}
+
+	// globals written by each function, then through the functions it calls
+	for (int fi = 0; fi < function_count; fi++) {
+		GlslFunctionInfo *function = functions + fi;
+		for (int i = function->body_open+1; i < function->body_close && !function->writes_globals; i = next(i)) {
+			if (tokens[i].type != GTT_IDENTIFIER || tokens[prev(i)].is(".")) continue;
+			if (isGlobalName(tokens + i)) {
+				int after = next(i);
+				while (after < function->body_close && (tokens[after].is(".") || tokens[after].is("["))) { // g.x = or g[i] =
+					after = tokens[after].is(".") ? next(next(after)) : next(findClosingGlslBracket(tokens, token_count, after));
+				}
+				if (isAssignmentOperator(tokens + after) || tokens[prev(i)].is("++") || tokens[prev(i)].is("--")) {
+					function->writes_globals = true;
+				}
+			} else if (isCall(i)) {
+				int callee = findFunction(tokens + i);
+				if (!isWritingBuiltin(tokens + i) && (callee < 0 || !functions[callee].has_out_params)) continue;
+				int close = findClosingGlslBracket(tokens, token_count, next(i));
+				for (int j = next(i); j < close; j++) { // a global passed to an out parameter
+					if (tokens[j].type == GTT_IDENTIFIER && isGlobalName(tokens + j)) function->writes_globals = true;
+				}
+			}
+		}
+	}
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (int fi = 0; fi < function_count; fi++) {
+			GlslFunctionInfo *function = functions + fi;
+			for (int i = function->body_open+1; i < function->body_close && !function->writes_globals; i = next(i)) {
+				if (!isCall(i)) continue;
+				int callee = findFunction(tokens + i);
+				if (callee >= 0 && functions[callee].writes_globals) function->writes_globals = changed = true;
+			}
+		}
+	}
+
+	rewriter.begin(tokens, token_count);
+}
+
+bool GlslOptimizer::apply(bool changed) {
+	if (changed) {
+		char *optimized_src = rewriter.write();
+		delete [] src;
+		src = optimized_src;
+	}
+	rewriter.end();
+	return changed;
+}
+
+bool GlslOptimizer::isCall(int index) {
+	if (tokens[index].type != GTT_IDENTIFIER) return false;
+	int open = next(index), before = prev(index);
+	return open < token_count && tokens[open].is("(") && (before < 0 || !tokens[before].is("."));
+}
+
+int GlslOptimizer::findFunction(const GlslToken *name, int *out_definition_count) {
+	int found = -1, definition_count = 0;
+	for (int fi = 0; fi < function_count; fi++) {
+		if (!isSameToken(tokens + functions[fi].name, name)) continue;
+		if (functions[fi].body_open < 0) {
+			if (found < 0) found = fi;
+			continue;
+		}
+		if (!definition_count++) found = fi;
+	}
+	if (out_definition_count) *out_definition_count = definition_count;
+	return found;
+}
+
+bool GlslOptimizer::isGlobalName(const GlslToken *token) {
+	if (token->length > 3 && !strncmp(token->text, "gl_", 3)) return true;
+	for (int i = 0; i < global_name_count; i++) {
+		if (isSameToken(tokens + global_names[i], token)) return true;
+	}
+	return false;
+}
+
+// true for builtins and for user functions and globals with a declaration in front of index
+bool GlslOptimizer::isDeclaredBefore(const GlslToken *name, int index) {
+	bool is_user_name = false;
+	for (int fi = 0; fi < function_count; fi++) {
+		if (!isSameToken(tokens + functions[fi].name, name)) continue;
+		if (functions[fi].begin < index) return true;
+		is_user_name = true;
+	}
+	for (int i = 0; i < global_name_count; i++) {
+		if (!isSameToken(tokens + global_names[i], name)) continue;
+		if (global_names[i] < index) return true;
+		is_user_name = true;
+	}
+	return !is_user_name;
+}
+
+// a user function without side effects and a single definition, so its return type is known
+bool GlslOptimizer::isPure(const GlslToken *name) {
+	int definition_count;
+	int fi = findFunction(name, &definition_count);
+	if (fi < 0 || definition_count != 1) return false;
+	GlslFunctionInfo *function = functions + fi;
+	if (function->writes_globals || function->has_out_params || tokens[prev(function->name)].is("void")) return false;
+	for (int i = function->begin; i < function->name; i++) {
+		if (tokens[i].is("[")) return false; // array return type
+	}
+	return true;
+}
+
+// replaces tokens begin to end (inclusive) with nothing but their newlines,
+// directives stay since macros can be used after them
+void GlslOptimizer::remove(int begin, int end) {
+	for (int i = begin; i <= end; i++) {
+		if (tokens[i].type == GTT_PREPROCESSOR) continue;
+		int newline_count = 0;
+		if (!tokens[i].isSignificant()) {
+			for (int j = 0; j < tokens[i].length; j++) newline_count += tokens[i].text[j] == '\n';
+		}
+		char *newlines = new char[newline_count+1];
+		memset(newlines, '\n', newline_count);
+		newlines[newline_count] = '\0';
+		rewriter.replace(i, newlines);
+		delete [] newlines;
+	}
+}
+
+// new[]'d text of tokens begin to end (inclusive) on a single line
+char *GlslOptimizer::getText(int begin, int end) {
+	size_t size = 1;
+	for (int i = begin; i <= end; i++) size += tokens[i].isSignificant() ? tokens[i].length : 1;
+	char *text = new char[size];
+	char *c = text;
+	for (int i = begin; i <= end; i++) {
+		if (!tokens[i].isSignificant()) {
+			if (c != text && c[-1] != ' ') *c++ = ' ';
+			continue;
+		}
+		memcpy(c, tokens[i].text, tokens[i].length);
+		c += tokens[i].length;
+	}
+	*c = '\0';
+	return text;
+}
+
+static void appendText(char **io_text, size_t *io_capacity, const char *text, int length = -1) {
+	size_t text_length = length < 0 ? strlen(text) : (size_t)length;
+	size_t used = *io_text ? strlen(*io_text) : 0;
+	if (used + text_length + 1 > *io_capacity) {
+		*io_capacity = 2*(used + text_length + 1);
+		char *new_text = new char[*io_capacity];
+		if (*io_text) {
+			memcpy(new_text, *io_text, used);
+			delete [] *io_text;
+		}
+		*io_text = new_text;
+	}
+	memcpy(*io_text + used, text, text_length);
+	(*io_text)[used + text_length] = '\0';
+}
+
+// splits the arguments of a call at top level commas, returns the argument count
+static int splitGlslArguments(GlslOptimizer *optimizer, int open, int close, int *out_begins, int *out_ends, int max_count) {
+	const GlslToken *tokens = optimizer->tokens;
+	int first = optimizer->next(open);
+	if (first == close) return 0;
+	if (tokens[first].is("void") && optimizer->next(first) == close) return 0;
+	int count = 0, depth = 0;
+	out_begins[0] = first;
+	for (int i = first; i < close; i = optimizer->next(i)) {
+		if (tokens[i].is("(") || tokens[i].is("[") || tokens[i].is("{")) depth++;
+		else if (tokens[i].is(")") || tokens[i].is("]") || tokens[i].is("}")) depth--;
+		else if (depth == 0 && tokens[i].is(",")) {
+			out_ends[count++] = optimizer->prev(i);
+			if (count == max_count) return -1;
+			out_begins[count] = optimizer->next(i);
+		}
+	}
+	out_ends[count++] = optimizer->prev(close);
+	return count;
+}
+
+enum {MAX_INLINE_PARAMS = 16, MAX_INLINE_EXPRESSION_TOKENS = 64};
+
+bool GlslOptimizer::inlineCalls() {
+	if (has_conditionals) return false;
+	bool changed = false;
+	int *is_rewritten = new int[token_count+1](); // tokens inside a call that was inlined in this pass
+	for (int fi = 0; fi < function_count; fi++) {
+		GlslFunctionInfo *callee = functions + fi;
+		int definition_count;
+		findFunction(tokens + callee->name, &definition_count);
+		// arguments are evaluated before the body, inlined they'd see the writes of a global writing one
+		if (callee->body_open < 0 || callee->has_out_params || callee->writes_globals || definition_count != 1) continue;
+
+		// body is { return expression; }
+		int return_index = next(callee->body_open);
+		if (!tokens[return_index].is("return")) continue;
+		int expression_begin = next(return_index), semicolon = -1, expression_token_count = 0;
+		bool is_simple = true;
+		for (int i = expression_begin; i < callee->body_close; i = next(i)) {
+			if (tokens[i].is(";")) {semicolon = i; break;}
+			if (isAssignmentOperator(tokens + i) || tokens[i].type == GTT_PREPROCESSOR) is_simple = false;
+			expression_token_count++;
+		}
+		if (!is_simple || semicolon < 0 || next(semicolon) != callee->body_close
+			|| !expression_token_count || expression_token_count > MAX_INLINE_EXPRESSION_TOKENS) continue;
+		int return_type = prev(callee->name);
+		if (tokens[return_type].type != GTT_IDENTIFIER) continue; // array
+
+		// parameters are [qualifiers] type name
+		int param_begins[MAX_INLINE_PARAMS], param_ends[MAX_INLINE_PARAMS], param_use_counts[MAX_INLINE_PARAMS] = {};
+		int param_count = splitGlslArguments(this, callee->params_open, callee->params_close, param_begins, param_ends, MAX_INLINE_PARAMS);
+		bool has_simple_params = param_count >= 0;
+		for (int pi = 0; pi < param_count; pi++) {
+			if (tokens[param_ends[pi]].type != GTT_IDENTIFIER || tokens[prev(param_ends[pi])].type != GTT_IDENTIFIER) has_simple_params = false;
+		}
+		if (!has_simple_params) continue;
+		for (int i = expression_begin; i < semicolon; i = next(i)) {
+			if (tokens[i].type != GTT_IDENTIFIER || tokens[prev(i)].is(".")) continue;
+			for (int pi = 0; pi < param_count; pi++) {
+				if (isSameToken(tokens + i, tokens + param_ends[pi])) param_use_counts[pi]++;
+			}
+		}
+
+		for (int gi = 0; gi < function_count; gi++) {
+			GlslFunctionInfo *caller = functions + gi;
+			if (gi == fi || caller->body_open < 0) continue;
+			for (int i = caller->body_open+1; i < caller->body_close; i = next(i)) {
+				if (is_rewritten[i] || !isCall(i) || !isSameToken(tokens + i, tokens + callee->name)) continue;
+				int open = next(i);
+				int close = findClosingGlslBracket(tokens, token_count, open);
+				int arg_begins[MAX_INLINE_PARAMS], arg_ends[MAX_INLINE_PARAMS];
+				if (splitGlslArguments(this, open, close, arg_begins, arg_ends, MAX_INLINE_PARAMS) != param_count) continue;
+
+				// arguments without side effects, ones not used exactly once must be a single token
+				bool can_inline = true;
+				for (int pi = 0; pi < param_count && can_inline; pi++) {
+					if (param_use_counts[pi] != 1 && arg_begins[pi] != arg_ends[pi]) can_inline = false;
+					for (int j = arg_begins[pi]; j <= arg_ends[pi]; j = next(j)) {
+						if (isAssignmentOperator(tokens + j) || isWritingBuiltin(tokens + j)
+							|| (isCall(j) && findFunction(tokens + j) >= 0 && !isPure(tokens + j))) {
+							can_inline = false;
+						}
+					}
+				}
+				// names the expression refers to must not be declared by the caller, and
+				// must be declared in front of it when the callee comes after the caller
+				for (int j = expression_begin; j < semicolon && can_inline; j = next(j)) {
+					if (tokens[j].type != GTT_IDENTIFIER || tokens[prev(j)].is(".")) continue;
+					bool is_param = false;
+					for (int pi = 0; pi < param_count; pi++) is_param |= isSameToken(tokens + j, tokens + param_ends[pi]);
+					if (is_param) continue;
+					if (!isDeclaredBefore(tokens + j, caller->begin)) can_inline = false;
+					if (isCall(j)) continue;
+					for (int k = caller->params_open; k < caller->body_close && can_inline; k = next(k)) {
+						if (!isSameToken(tokens + k, tokens + j)) continue;
+						const GlslToken *before = tokens + prev(k), *after = tokens + next(k);
+						bool is_declared = before->type == GTT_IDENTIFIER // float name, or float a, name = ...
+							|| (before->is(",") && (after->is("=") || after->is(";") || after->is("[")));
+						if (is_declared) can_inline = false;
+					}
+				}
+				if (!can_inline) continue;
+
+				// Type(expression) with Type(argument) for each parameter, the constructors
+				// keep implicit conversions of arguments and the return value
+				char *text = nullptr;
+				size_t capacity = 0;
+				bool is_builtin_return = isGlslBuiltinTypeName(tokens + return_type);
+				if (is_builtin_return) appendText(&text, &capacity, tokens[return_type].text, tokens[return_type].length);
+				appendText(&text, &capacity, "(");
+				for (int j = expression_begin; j < semicolon; j++) {
+					if (!tokens[j].isSignificant()) {
+						appendText(&text, &capacity, " ");
+						continue;
+					}
+					int param = -1;
+					if (tokens[j].type == GTT_IDENTIFIER && !tokens[prev(j)].is(".")) {
+						for (int pi = 0; pi < param_count; pi++) {
+							if (isSameToken(tokens + j, tokens + param_ends[pi])) param = pi;
+						}
+					}
+					if (param < 0) {
+						appendText(&text, &capacity, tokens[j].text, tokens[j].length);
+						continue;
+					}
+					const GlslToken *param_type = tokens + prev(param_ends[param]);
+					if (isGlslBuiltinTypeName(param_type)) appendText(&text, &capacity, param_type->text, param_type->length);
+					char *arg_text = getText(arg_begins[param], arg_ends[param]);
+					appendText(&text, &capacity, "(");
+					appendText(&text, &capacity, arg_text);
+					appendText(&text, &capacity, ")");
+					delete [] arg_text;
+				}
+				appendText(&text, &capacity, ")");
+				remove(i, close);
+				rewriter.replace(i, text);
+				delete [] text;
+				for (int j = i; j <= close; j++) is_rewritten[j] = 1;
+				stats.inlined_call_count++;
+				changed = true;
+				i = close;
+			}
+		}
+	}
+	delete [] is_rewritten;
+	return apply(changed);
+}
+
+enum GlslLiteralKind {GLK_INT, GLK_FLOAT, GLK_BOOL};
+
+struct GlslLiteral {
+	GlslLiteralKind kind;
+	double value;
+};
+
+// decimal int, float and bool literals, without suffixes that change the type
+static bool parseGlslLiteral(const GlslToken *token, GlslLiteral *out_literal) {
+	if (token->is("true") || token->is("false")) {
+		out_literal->kind = GLK_BOOL;
+		out_literal->value = token->is("true");
+		return true;
+	}
+	if (token->type != GTT_NUMBER) return false;
+	bool is_float = false;
+	for (int i = 0; i < token->length; i++) {
+		char c = token->text[i];
+		if (c == '.' || c == 'e' || c == 'E') is_float = true;
+		else if (!(c >= '0' && c <= '9') && !(i > 0 && (c == '+' || c == '-'))) return false; // hex or suffix
+	}
+	if (!is_float && token->length > 1 && token->text[0] == '0') return false; // octal
+	char number[64];
+	if (token->length >= (int)sizeof(number)) return false;
+	memcpy(number, token->text, token->length);
+	number[token->length] = '\0';
+	out_literal->kind = is_float ? GLK_FLOAT : GLK_INT;
+	out_literal->value = is_float ? (double)(float)atof(number) : atof(number);
+	return true;
+}
+
+static bool formatGlslLiteral(const GlslLiteral &literal, char *out_text, size_t size) {
+	if (literal.kind == GLK_BOOL) {
+		snprintf(out_text, size, "%s", literal.value != 0.0 ? "true" : "false");
+	} else if (literal.kind == GLK_INT) {
+		if (literal.value < -2147483648.0 || literal.value > 2147483647.0) return false;
+		snprintf(out_text, size, "%d", (int)literal.value);
+	} else {
+		float value = (float)literal.value;
+		if (value != value || value - value != 0.0f) return false; // nan or inf
+		snprintf(out_text, size, "%.9g", value);
+		if (!strchr(out_text, '.') && !strchr(out_text, 'e')) strncat(out_text, ".0", size - strlen(out_text) - 1);
+	}
+	return true;
+}
+
+static bool evaluateGlslOperator(const GlslToken *op, const GlslLiteral &a, const GlslLiteral &b, GlslLiteral *out_result) {
+	if (a.kind != b.kind) return false; // mixed types are an error in GLSL 1.10, the driver should report it
+	double x = a.value, y = b.value;
+	bool is_number = a.kind != GLK_BOOL;
+	out_result->kind = a.kind;
+	if (is_number && op->is("+")) out_result->value = x + y;
+	else if (is_number && op->is("-")) out_result->value = x - y;
+	else if (is_number && op->is("*")) out_result->value = x * y;
+	else if (is_number && op->is("/")) {
+		if (y == 0.0) return false;
+		out_result->value = a.kind == GLK_INT ? (double)((long long)x / (long long)y) : x / y;
+	} else if (a.kind == GLK_INT && op->is("%")) {
+		if (y <= 0.0) return false;
+		out_result->value = (double)((long long)x % (long long)y);
+	} else {
+		out_result->kind = GLK_BOOL;
+		if (is_number && op->is("<")) out_result->value = x < y;
+		else if (is_number && op->is(">")) out_result->value = x > y;
+		else if (is_number && op->is("<=")) out_result->value = x <= y;
+		else if (is_number && op->is(">=")) out_result->value = x >= y;
+		else if (op->is("==")) out_result->value = x == y;
+		else if (op->is("!=")) out_result->value = x != y;
+		else if (!is_number && op->is("&&")) out_result->value = x != 0.0 && y != 0.0;
+		else if (!is_number && op->is("||")) out_result->value = x != 0.0 || y != 0.0;
+		else if (!is_number && op->is("^^")) out_result->value = (x != 0.0) != (y != 0.0);
+		else return false;
+	}
+	if (out_result->kind == GLK_FLOAT) out_result->value = (float)out_result->value; // as the GPU would
+	return true;
+}
+
+// tokens an expression can start after
+static bool opensGlslExpression(const GlslToken *token) {
+	static const char *openers[] = {"(", "[", ",", "?", ":", ";", "{", "}", "return"};
+	for (int i = 0; i < (int)ARRAY_COUNT(openers); i++) {
+		if (token->is(openers[i])) return true;
+	}
+	return isAssignmentOperator(token) && !token->is("++") && !token->is("--");
+}
+
+static bool closesGlslExpression(const GlslToken *token) {
+	return token->is(")") || token->is("]") || token->is(",") || token->is(";") || token->is("?") || token->is(":");
+}
+
+bool GlslOptimizer::foldConstants() {
+	bool changed = false;
+	for (int i = skipGlslSpace(tokens, token_count, 0); i < token_count; i = next(i)) {
+		GlslLiteral a, b, result;
+		int before = prev(i);
+		const GlslToken *prev_token = before >= 0 ? tokens + before : nullptr;
+		if (!prev_token || prev_token->type == GTT_PREPROCESSOR) continue;
+		char text[64];
+
+		// ( literal )
+		if (tokens[i].is("(") && prev_token->type == GTT_OPERATOR && !prev_token->is(")") && !prev_token->is("]")) {
+			int literal = next(i), close = next(literal);
+			if (close < token_count && tokens[close].is(")") && parseGlslLiteral(tokens + literal, &a)) {
+				remove(i, literal-1);
+				remove(literal+1, close);
+				stats.folded_count++;
+				changed = true;
+				i = close;
+				continue;
+			}
+		}
+		// float(literal) and int(literal)
+		if ((tokens[i].is("float") || tokens[i].is("int")) && !prev_token->is(".")) {
+			int open = next(i), literal = next(open), close = next(literal);
+			if (close < token_count && tokens[open].is("(") && tokens[close].is(")")
+				&& parseGlslLiteral(tokens + literal, &a) && a.kind != GLK_BOOL) {
+				result.kind = tokens[i].is("float") ? GLK_FLOAT : GLK_INT;
+				result.value = result.kind == GLK_INT ? (double)(long long)a.value : (double)(float)a.value;
+				if (formatGlslLiteral(result, text, sizeof(text))) {
+					remove(i, close);
+					rewriter.replace(i, text);
+					stats.folded_count++;
+					changed = true;
+					i = close;
+					continue;
+				}
+			}
+		}
+		// ! literal
+		if (tokens[i].is("!") && (opensGlslExpression(prev_token) || getBinaryPrecedence(prev_token))) {
+			int literal = next(i);
+			if (literal < token_count && parseGlslLiteral(tokens + literal, &a) && a.kind == GLK_BOOL) {
+				remove(i, literal-1);
+				rewriter.replace(literal, a.value != 0.0 ? "false" : "true");
+				stats.folded_count++;
+				changed = true;
+				i = literal;
+				continue;
+			}
+		}
+		// literal op literal, if the neighbors bind looser than op
+		if (!parseGlslLiteral(tokens + i, &a)) continue;
+		int op = next(i);
+		if (op >= token_count) break;
+		int precedence = getBinaryPrecedence(tokens + op);
+		int literal = next(op);
+		if (!precedence || literal >= token_count || !parseGlslLiteral(tokens + literal, &b)) continue;
+		int after = next(literal);
+		if (after >= token_count) break;
+		if (prev_token->is("-") || prev_token->is("+")) { // unary, what's in front of it matters
+			int context = prev(before);
+			bool is_unary = context < 0 || (tokens[context].type == GTT_OPERATOR && !tokens[context].is(")")
+				&& !tokens[context].is("]")) || tokens[context].is("return");
+			// the sign binds tighter than op, -a op b is only -(a op b) for * and /
+			if (is_unary && !tokens[op].is("*") && !tokens[op].is("/")) continue;
+			if (is_unary && context >= 0) prev_token = tokens + context;
+			else if (is_unary) continue;
+		}
+		bool prev_is_looser = opensGlslExpression(prev_token) || getBinaryPrecedence(prev_token) > precedence;
+		bool next_is_looser = closesGlslExpression(tokens + after) || getBinaryPrecedence(tokens + after) >= precedence;
+		if (!prev_is_looser || !next_is_looser) continue;
+		if (!evaluateGlslOperator(tokens + op, a, b, &result) || !formatGlslLiteral(result, text, sizeof(text))) continue;
+		remove(i, literal);
+		rewriter.replace(i, text);
+		stats.folded_count++;
+		changed = true;
+		i = literal;
+	}
+	return apply(changed);
+}
+
+// if (true) { a } else { b } keeps a, if (false) { a } else b keeps b, while (false) { a } goes away
+bool GlslOptimizer::removeConstantBranches() {
+	bool changed = false;
+	for (int i = skipGlslSpace(tokens, token_count, 0); i < token_count; i = next(i)) {
+		if (!tokens[i].is("if") && !tokens[i].is("while")) continue;
+		int before = prev(i);
+		if (before < 0 || !(tokens[before].is(";") || tokens[before].is("{") || tokens[before].is("}"))) continue;
+		int open = next(i), literal = next(open), close = next(literal), body = next(close);
+		GlslLiteral condition;
+		if (body >= token_count || !tokens[open].is("(") || !tokens[close].is(")") || !tokens[body].is("{")) continue;
+		if (!parseGlslLiteral(tokens + literal, &condition) || condition.kind != GLK_BOOL) continue;
+		int body_close = findClosingGlslBracket(tokens, token_count, body);
+		if (body_close >= token_count) continue;
+		int else_index = next(body_close);
+		bool has_else = tokens[i].is("if") && else_index < token_count && tokens[else_index].is("else");
+
+		if (tokens[i].is("while")) {
+			if (condition.value != 0.0) continue; // endless loop with breaks, keep it
+			remove(i, body_close);
+		} else if (condition.value == 0.0) {
+			remove(i, has_else ? else_index : body_close);
+		} else {
+			int else_body = has_else ? next(else_index) : -1;
+			if (has_else && !tokens[else_body].is("{")) continue; // else if chain, its end isn't known here
+			remove(i, body-1);
+			if (has_else) remove(body_close+1, findClosingGlslBracket(tokens, token_count, else_body));
+		}
+		stats.folded_count++;
+		changed = true;
+		i = body_close;
+	}
+	return apply(changed);
+}
+
+enum {MAX_STATEMENT_CALLS = 64};
+
+// a statement calling the same function with the same arguments more than once
+// gets the result in a variable declared in front of it
+bool GlslOptimizer::reuseCalls() {
+	if (has_conditionals) return false;
+	bool changed = false;
+	for (int fi = 0; fi < function_count; fi++) {
+		GlslFunctionInfo *function = functions + fi;
+		if (function->body_open < 0) continue;
+		int depth = 0;
+		for (int s = next(function->body_open); s < function->body_close; s = next(s)) {
+			if (tokens[s].is("(")) depth++;
+			if (tokens[s].is(")")) depth--;
+			const GlslToken *before = tokens + prev(s);
+			if (depth != 0 || !(before->is(";") || before->is("{") || before->is("}"))) continue;
+			static const char *keywords[] = {"if", "for", "while", "do", "else", "switch", "case", "default", "struct"};
+			bool is_keyword = false;
+			for (int k = 0; k < (int)ARRAY_COUNT(keywords); k++) is_keyword |= tokens[s].is(keywords[k]);
+			if (is_keyword || tokens[s].type == GTT_PREPROCESSOR || !tokens[s].isSignificant()) continue;
+
+			// a simple statement: [declaration or lvalue =] expression ;
+			int end = -1, assignment = -1, statement_depth = 0;
+			bool is_simple = true;
+			for (int i = s; i < function->body_close; i = next(i)) {
+				if (tokens[i].is("{") || tokens[i].is("}") || tokens[i].type == GTT_PREPROCESSOR) {is_simple = false; break;}
+				if (tokens[i].is("(") || tokens[i].is("[")) statement_depth++;
+				else if (tokens[i].is(")") || tokens[i].is("]")) statement_depth--;
+				else if (statement_depth == 0 && tokens[i].is(";")) {end = i; break;}
+				else if (statement_depth == 0 && assignment < 0 && isAssignmentOperator(tokens + i)) assignment = i;
+			}
+			if (!is_simple || end < 0) continue;
+			int rhs = assignment >= 0 ? next(assignment) : tokens[s].is("return") ? next(s) : s;
+			int assigned = assignment >= 0 ? prev(assignment) : -1;
+
+			// the right hand side mustn't have side effects or evaluate parts conditionally
+			int calls[MAX_STATEMENT_CALLS], call_count = 0;
+			statement_depth = 0;
+			for (int i = rhs; i < end && is_simple; i = next(i)) {
+				if (tokens[i].is("(") || tokens[i].is("[")) statement_depth++;
+				else if (tokens[i].is(")") || tokens[i].is("]")) statement_depth--;
+				if (isAssignmentOperator(tokens + i) || tokens[i].is("?") || tokens[i].is("&&") || tokens[i].is("||")
+					|| (statement_depth == 0 && tokens[i].is(",")) || isWritingBuiltin(tokens + i)) {
+					is_simple = false;
+				} else if (isCall(i) && findFunction(tokens + i) >= 0) {
+					if (!isPure(tokens + i)) is_simple = false;
+					else if (call_count < MAX_STATEMENT_CALLS) calls[call_count++] = i;
+				}
+			}
+			if (!is_simple) continue;
+
+			for (int ci = 0; ci < call_count; ci++) {
+				int match_count = 0;
+				int matches[MAX_STATEMENT_CALLS];
+				int close = findClosingGlslBracket(tokens, token_count, next(calls[ci]));
+				bool uses_assigned = false;
+				for (int j = calls[ci]; j < close; j = next(j)) {
+					if (assigned >= 0 && isSameToken(tokens + j, tokens + assigned)) uses_assigned = true;
+				}
+				if (uses_assigned) continue;
+				for (int cj = ci+1; cj < call_count; cj++) {
+					int other_close = findClosingGlslBracket(tokens, token_count, next(calls[cj]));
+					if (calls[cj] < close) continue; // nested
+					int j = calls[ci], k = calls[cj];
+					while (j <= close && k <= other_close && isSameToken(tokens + j, tokens + k)) {
+						j = next(j);
+						k = next(k);
+					}
+					if (j > close && k > other_close) matches[match_count++] = cj;
+				}
+				if (!match_count) continue;
+
+				GlslFunctionInfo *callee = functions + findFunction(tokens + calls[ci]);
+				char name[32];
+				snprintf(name, sizeof(name), "_opt_call%d", stats.reused_call_count);
+				char *type_text = getText(callee->begin, prev(callee->name));
+				char *call_text = getText(calls[ci], close);
+				char *declaration = new char[strlen(type_text) + strlen(name) + strlen(call_text) + 8];
+				sprintf(declaration, "%s %s = %s; ", type_text, name, call_text);
+				rewriter.insertBefore(s, declaration);
+				delete [] declaration;
+				delete [] call_text;
+				delete [] type_text;
+
+				remove(calls[ci], close);
+				rewriter.replace(calls[ci], name);
+				for (int mi = 0; mi < match_count; mi++) {
+					int call = calls[matches[mi]];
+					remove(call, findClosingGlslBracket(tokens, token_count, next(call)));
+					rewriter.replace(call, name);
+				}
+				stats.reused_call_count++;
+				changed = true;
+				break; // one per statement and pass, the others could overlap
+			}
+			s = end;
+		}
+	}
+	return apply(changed);
+}
+
+bool GlslOptimizer::removeDeadFunctions() {
+	if (has_conditionals) return false;
+	bool *is_used = new bool[function_count+1]();
+	// used by main(), global initializers or macros
+	int main_index = -1;
+	for (int fi = 0; fi < function_count; fi++) {
+		if (tokens[functions[fi].name].is("main")) main_index = fi;
+	}
+	if (main_index < 0) {
+		delete [] is_used;
+		return apply(false);
+	}
+	int fi_next = 0; // function bodies are skipped while scanning the top level
+	for (int i = 0; i < token_count; i++) {
+		if (fi_next < function_count && i == functions[fi_next].begin) {
+			i = functions[fi_next++].end;
+			continue;
+		}
+		const GlslToken *token = tokens + i;
+		for (int fi = 0; fi < function_count; fi++) {
+			const GlslToken *name = tokens + functions[fi].name;
+			if (token->type == GTT_IDENTIFIER && isSameToken(token, name)) is_used[fi] = true;
+			if (token->type == GTT_PREPROCESSOR) {
+				for (const char *c = token->text; c + name->length <= token->text + token->length; c++) {
+					if (strncmp(c, name->text, name->length)) continue;
+					bool starts_word = c == token->text || !(isGlslIdentifierStart(c[-1]) || isGlslDigit(c[-1]));
+					bool ends_word = !(isGlslIdentifierStart(c[name->length]) || isGlslDigit(c[name->length]));
+					if (starts_word && ends_word) is_used[fi] = true;
+				}
+			}
+		}
+	}
+	for (int fi = 0; fi < function_count; fi++) {
+		if (isSameToken(tokens + functions[fi].name, tokens + functions[main_index].name)) is_used[fi] = true;
+	}
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (int fi = 0; fi < function_count; fi++) {
+			if (!is_used[fi] || functions[fi].body_open < 0) continue;
+			for (int i = functions[fi].body_open+1; i < functions[fi].body_close; i = next(i)) {
+				if (tokens[i].type != GTT_IDENTIFIER) continue;
+				for (int fj = 0; fj < function_count; fj++) { // overloads and prototypes too
+					if (is_used[fj] || !isSameToken(tokens + i, tokens + functions[fj].name)) continue;
+					is_used[fj] = changed = true;
+				}
+			}
+		}
+	}
+
+	bool changed = false;
+	for (int fi = 0; fi < function_count; fi++) {
+		if (is_used[fi]) continue;
+		remove(functions[fi].begin, functions[fi].end);
+		if (functions[fi].body_open >= 0) stats.removed_function_count++;
+		changed = true;
+	}
+	delete [] is_used;
+	return apply(changed);
+}
+
+char *optimizeGlsl(const char *src, GlslOptimizerStats *out_stats) {
+	GlslOptimizer optimizer;
+	optimizer.src = new char[strlen(src)+1];
+	strcpy(optimizer.src, src);
+
+	enum {MAX_ROUNDS = 16};
+	for (int round = 0; round < MAX_ROUNDS; round++) {
+		bool changed = false;
+		optimizer.parse();
+		changed |= optimizer.inlineCalls();
+		optimizer.parse();
+		changed |= optimizer.foldConstants();
+		optimizer.parse();
+		changed |= optimizer.removeConstantBranches();
+		optimizer.parse();
+		changed |= optimizer.reuseCalls();
+		optimizer.parse();
+		changed |= optimizer.removeDeadFunctions();
+		if (!changed) break;
+	}
+	optimizer.release();
+	if (out_stats) *out_stats = optimizer.stats;
+	return optimizer.src;
+}
@@ -0,0 +1,18 @@
+// Source to source optimizer for fragment shaders, for drivers that optimize
+// poorly (llvmpipe, some mobile GPUs). Works on the tokens like the heatmap
+// instrumentation and repeats these passes until nothing changes:
+// - inlining of functions whose body is a single return expression
+// - folding of constant literal expressions, if (true) and if (false)
+// - reuse of calls to side effect free functions that a statement repeats
+// - removal of functions main() doesn't reach
+// Removed code keeps its newlines, so the line numbers of compile errors
+// still match the original source.
+struct GlslOptimizerStats {
+	int inlined_call_count;
+	int folded_count; // constant expressions and branches
+	int reused_call_count;
+	int removed_function_count;
+};
+
+// returns the new[]'d optimized source
+char *optimizeGlsl(const char *src, GlslOptimizerStats *out_stats);
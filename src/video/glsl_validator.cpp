@@ -0,0 +1,240 @@
+struct GlslErrorLog {
+	const char *src;
+	char *text = nullptr;
+	size_t length = 0, capacity = 0;
+	int error_count = 0;
+
+	void add(int line, const char *format, ...);
+};
+
+enum {MAX_VALIDATION_ERRORS = 32, MAX_BRACKET_DEPTH = 256, MAX_CONDITIONAL_DEPTH = 16};
+
+void GlslErrorLog::add(int line, const char *format, ...) {
+	if (++error_count > MAX_VALIDATION_ERRORS) return;
+	// the offending line without its indentation
+	const char *line_begin = src;
+	for (int l = 1; l < line && *line_begin; line_begin++) l += *line_begin == '\n';
+	while (*line_begin == ' ' || *line_begin == '\t') line_begin++;
+	int line_length = 0;
+	while (line_begin[line_length] && line_begin[line_length] != '\n' && line_begin[line_length] != '\r') line_length++;
+	if (line_length > 80) line_length = 80;
+
+	char message[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	char entry[512];
+	int entry_length = snprintf(entry, sizeof(entry), "0:%d: error: %s\n    %.*s\n", line, message, line_length, line_begin);
+	if (entry_length >= (int)sizeof(entry)) entry_length = (int)sizeof(entry)-1;
+
+	if (length + entry_length + 1 > capacity) {
+		capacity = 2*(length + entry_length + 1);
+		char *new_text = new char[capacity];
+		if (text) {
+			memcpy(new_text, text, length);
+			delete [] text;
+		}
+		text = new_text;
+	}
+	memcpy(text + length, entry, entry_length + 1);
+	length += entry_length;
+}
+
+struct GlslBracket {
+	char c;
+	int line;
+};
+
+static bool isGlslDirective(const GlslToken *token, const char *name) {
+	const char *c = token->text + 1;
+	while (*c == ' ' || *c == '\t') c++;
+	size_t length = strlen(name);
+	return !strncmp(c, name, length) && !isGlslIdentifierStart(c[length]) && !isGlslDigit(c[length]);
+}
+
+// keywords that start a statement, for missing semicolons at the end of the line before
+static bool startsGlslStatement(const GlslToken *token) {
+	static const char *keywords[] = {"return", "if", "for", "while", "do", "break", "continue", "discard", "const"};
+	for (int i = 0; i < (int)ARRAY_COUNT(keywords); i++) {
+		if (token->is(keywords[i])) return true;
+	}
+	return isGlslBuiltinTypeName(token);
+}
+
+// tokens that can end an expression statement
+static bool endsGlslExpression(const GlslToken *token) {
+	static const char *keywords[] = {
+		"else", "do", "return", "const", "in", "out", "inout", "uniform", "varying", "attribute",
+		"highp", "mediump", "lowp", "precision", "flat", "smooth", "invariant", "centroid", "struct"
+	};
+	if (token->type == GTT_NUMBER || token->is("]") || token->is(")") || token->is("++") || token->is("--")) return true;
+	if (token->type != GTT_IDENTIFIER || isGlslBuiltinTypeName(token)) return false;
+	for (int i = 0; i < (int)ARRAY_COUNT(keywords); i++) {
+		if (token->is(keywords[i])) return false;
+	}
+	return true;
+}
+
+int validateGlsl(const char *src, char **out_error_log) {
+	*out_error_log = nullptr;
+	GlslErrorLog log;
+	log.src = src;
+	GlslToken *tokens;
+	int token_count = tokenizeGlsl(src, &tokens);
+
+	// macro names, a macro can expand to a whole statement
+	int macro_count = 0;
+	GlslToken *macros = new GlslToken[token_count+1];
+	for (int i = 0; i < token_count; i++) {
+		if (tokens[i].type != GTT_PREPROCESSOR || !isGlslDirective(tokens + i, "define")) continue;
+		const char *c = strstr(tokens[i].text, "define") + 6;
+		while (*c == ' ' || *c == '\t') c++;
+		GlslToken *name = macros + macro_count++;
+		name->type = GTT_IDENTIFIER;
+		name->text = c;
+		name->length = 0;
+		while (isGlslIdentifierStart(c[name->length]) || isGlslDigit(c[name->length])) name->length++;
+	}
+
+	GlslBracket brackets[MAX_BRACKET_DEPTH];
+	int bracket_depth = 0;
+	// bracket state at each open #if, branches start from it again
+	GlslBracket *conditional_brackets = new GlslBracket[MAX_CONDITIONAL_DEPTH*MAX_BRACKET_DEPTH];
+	int conditional_bracket_depths[MAX_CONDITIONAL_DEPTH];
+	int conditional_lines[MAX_CONDITIONAL_DEPTH];
+	int conditional_depth = 0;
+	bool has_main = false;
+	int previous = -1; // last significant token that isn't a directive
+	int paren_depth = 0;
+
+	for (int i = 0; i < token_count; i++) {
+		const GlslToken *token = tokens + i;
+		if (token->type == GTT_COMMENT) {
+			if (token->text[1] == '*' && (token->length < 4 || strncmp(token->text + token->length - 2, "*/", 2))) {
+				log.add(token->line, "comment is never closed");
+			}
+			continue;
+		}
+		if (!token->isSignificant()) continue;
+
+		if (token->type == GTT_PREPROCESSOR) {
+			if (isGlslDirective(token, "version") && previous >= 0) {
+				log.add(token->line, "#version must come before anything else");
+			} else if (isGlslDirective(token, "if") || isGlslDirective(token, "ifdef") || isGlslDirective(token, "ifndef")) {
+				if (conditional_depth < MAX_CONDITIONAL_DEPTH) {
+					memcpy(conditional_brackets + conditional_depth*MAX_BRACKET_DEPTH, brackets, bracket_depth*sizeof(GlslBracket));
+					conditional_bracket_depths[conditional_depth] = bracket_depth;
+					conditional_lines[conditional_depth] = token->line;
+				}
+				conditional_depth++;
+			} else if (isGlslDirective(token, "elif") || isGlslDirective(token, "else")) {
+				if (!conditional_depth) log.add(token->line, "#elif or #else without #if");
+				else if (conditional_depth <= MAX_CONDITIONAL_DEPTH) {
+					bracket_depth = conditional_bracket_depths[conditional_depth-1];
+					memcpy(brackets, conditional_brackets + (conditional_depth-1)*MAX_BRACKET_DEPTH, bracket_depth*sizeof(GlslBracket));
+				}
+			} else if (isGlslDirective(token, "endif")) {
+				if (!conditional_depth) log.add(token->line, "#endif without #if");
+				else conditional_depth--;
+			}
+			continue;
+		}
+
+		if (token->type == GTT_UNKNOWN) {
+			log.add(token->line, "unexpected character '%.*s'", token->length, token->text);
+		} else if (token->is("(") || token->is("[") || token->is("{")) {
+			if (bracket_depth < MAX_BRACKET_DEPTH) {
+				brackets[bracket_depth].c = token->text[0];
+				brackets[bracket_depth].line = token->line;
+			}
+			bracket_depth++;
+			if (token->is("(")) paren_depth++;
+		} else if (token->is(")") || token->is("]") || token->is("}")) {
+			char open = token->is(")") ? '(' : token->is("]") ? '[' : '{';
+			if (!bracket_depth) {
+				log.add(token->line, "unexpected '%c'", token->text[0]);
+			} else {
+				bracket_depth--;
+				GlslBracket *bracket = bracket_depth < MAX_BRACKET_DEPTH ? brackets + bracket_depth : nullptr;
+				if (bracket && bracket->c != open) {
+					log.add(token->line, "'%c' doesn't match the '%c' of line %d", token->text[0], bracket->c, bracket->line);
+				}
+				if (token->is(")") && paren_depth) paren_depth--;
+			}
+		} else if (token->is("main") && skipGlslSpace(tokens, token_count, i+1) < token_count
+			&& tokens[skipGlslSpace(tokens, token_count, i+1)].is("(")) {
+			has_main = true;
+		}
+
+		// a statement starting on a new line after a complete expression
+		if (previous >= 0 && bracket_depth > 0 && paren_depth == 0 && token->line > tokens[previous].line
+			&& startsGlslStatement(token) && endsGlslExpression(tokens + previous)) {
+			// if (...), for (...) and while (...) are followed by their statement, macros may end in one
+			int last = previous;
+			if (tokens[previous].is(")")) {
+				int depth = 0, open = previous;
+				for (; open >= 0; open--) {
+					if (tokens[open].is(")")) depth++;
+					else if (tokens[open].is("(") && --depth == 0) break;
+				}
+				last = skipGlslSpaceBackwards(tokens, open-1);
+			}
+			bool is_missing = last < 0 || !(tokens[last].is("if") || tokens[last].is("for") || tokens[last].is("while"));
+			for (int mi = 0; mi < macro_count && is_missing && last >= 0; mi++) {
+				if (tokens[last].length == macros[mi].length
+					&& !strncmp(tokens[last].text, macros[mi].text, macros[mi].length)) is_missing = false;
+			}
+			if (is_missing) log.add(tokens[previous].line, "missing ';' at the end of the line");
+		}
+		previous = i;
+	}
+
+	for (int d = bracket_depth < MAX_BRACKET_DEPTH ? bracket_depth : MAX_BRACKET_DEPTH; d > 0; d--) {
+		log.add(brackets[d-1].line, "'%c' is never closed", brackets[d-1].c);
+	}
+	for (int d = conditional_depth < MAX_CONDITIONAL_DEPTH ? conditional_depth : MAX_CONDITIONAL_DEPTH; d > 0; d--) {
+		log.add(conditional_lines[d-1], "#if without #endif");
+	}
+	if (!has_main && token_count) {
+		log.add(tokens[token_count-1].line, "no main() function");
+	}
+	if (log.error_count > MAX_VALIDATION_ERRORS) {
+		char more[64];
+		snprintf(more, sizeof(more), "... %d more errors\n", log.error_count - MAX_VALIDATION_ERRORS);
+		char *text = new char[log.length + strlen(more) + 1];
+		memcpy(text, log.text, log.length);
+		strcpy(text + log.length, more);
+		delete [] log.text;
+		log.text = text;
+	}
+
+	delete [] conditional_brackets;
+	delete [] macros;
+	delete [] tokens;
+	*out_error_log = log.text;
+	return log.error_count;
+}
+
+void GlslValidation::start(const char *shader_src) {
+	size_t length = strlen(shader_src);
+	src = new char[length+1];
+	memcpy(src, shader_src, length+1);
+	src_hash = hashBytes(src, length);
+	SDL_AtomicSet(&state, GVS_VALIDATING);
+	job_queue.push(validateJob, this);
+}
+
+void GlslValidation::validateJob(void *data) {
+	GlslValidation *validation = (GlslValidation*)data;
+	validation->error_count = validateGlsl(validation->src, &validation->error_log);
+	if (!SDL_AtomicCAS(&validation->state, GVS_VALIDATING, GVS_DONE)) {
+		delete validation; // abandoned while validating
+	}
+}
+
+void GlslValidation::release() {
+	// if the job is still running it has to delete the validation when it's done
+	if (SDL_AtomicCAS(&state, GVS_VALIDATING, GVS_ABANDONED)) return;
+	delete this;
+}
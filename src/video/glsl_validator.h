@@ -0,0 +1,29 @@
+// Checks a fragment shader for errors before the driver sees it: stray
+// characters, unterminated comments, unbalanced brackets and #if blocks, a
+// misplaced #version, missing semicolons at line ends and a missing main().
+// Only definite errors are reported, everything else is left to the driver.
+// Messages use the "0:line: error: ..." form of driver logs and quote the line.
+int validateGlsl(const char *src, char **out_error_log); // returns the error count, the log is new[]'d or nullptr
+
+enum GlslValidationState {
+	GVS_VALIDATING,
+	GVS_DONE,
+	GVS_ABANDONED // owner lost interest, the job cleans up
+};
+
+// heap allocated since the owner may let go of it while the job runs
+struct GlslValidation {
+	SDL_atomic_t state = {GVS_VALIDATING}; // GlslValidationState
+	char *src = nullptr;
+	u64 src_hash = 0;
+	int error_count = 0;
+	char *error_log = nullptr; // once GVS_DONE
+
+	void start(const char *shader_src); // validates a copy on the job queue
+	bool isDone() {return SDL_AtomicGet(&state) == GVS_DONE;}
+	void release(); // instead of delete
+
+private:
+	~GlslValidation() {delete [] src; delete [] error_log;}
+	static void validateJob(void *data);
+};
@@ -0,0 +1,228 @@
+GpuMemory gpu_memory;
+
+const char *gpu_memory_kind_names[GMK_COUNT] = {"Textures", "Buffers", "Framebuffers"};
+
+static GLenum getTextureBinding(GLenum target) {
+	switch (target) {
+		case GL_TEXTURE_1D: return GL_TEXTURE_BINDING_1D;
+		case GL_TEXTURE_3D: return GL_TEXTURE_BINDING_3D;
+		case GL_TEXTURE_CUBE_MAP: return GL_TEXTURE_BINDING_CUBE_MAP;
+		default: return GL_TEXTURE_BINDING_2D;
+	}
+}
+
+#ifndef EMSCRIPTEN // no level queries in GLES 2
+static size_t getTexelBytes(GLenum level_target, GLint level) {
+	static const GLenum component_sizes[] = {
+		GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE,
+		GL_TEXTURE_LUMINANCE_SIZE, GL_TEXTURE_INTENSITY_SIZE, GL_TEXTURE_DEPTH_SIZE
+	};
+	int bits = 0;
+	for (int i = 0; i < (int)ARRAY_COUNT(component_sizes); i++) {
+		GLint size = 0;
+		glGetTexLevelParameteriv(level_target, level, component_sizes[i], &size);
+		bits += size;
+	}
+	if (bits == 24 || bits == 48) bits += bits/3; // drivers pad rgb8 and rgb16f to four channels
+	return (size_t)(bits + 7) / 8;
+}
+#endif
+
+size_t measureTextureBytes(GLuint texture, GLenum target) {
+#ifdef EMSCRIPTEN
+	return 0;
+#else
+	if (!texture) return 0;
+	GLint previous_texture;
+	glGetIntegerv(getTextureBinding(target), &previous_texture);
+	glBindTexture(target, texture);
+
+	size_t total = 0;
+	int face_count = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	for (int face = 0; face < face_count; face++) {
+		GLenum level_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X+face : target;
+		for (GLint level = 0; level < 32; level++) {
+			GLint width = 0, height = 0, depth = 0, compressed = 0;
+			glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_WIDTH, &width);
+			if (width == 0) break; // no more levels
+			glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_HEIGHT, &height);
+			glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_DEPTH, &depth);
+			glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_COMPRESSED, &compressed);
+			if (compressed) {
+				GLint compressed_size = 0;
+				glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+				total += (size_t)compressed_size;
+			} else {
+				total += (size_t)width*height*(depth > 0 ? depth : 1)*getTexelBytes(level_target, level);
+			}
+			if (width <= 1 && height <= 1 && depth <= 1) break; // last level of the chain
+		}
+	}
+
+	glBindTexture(target, previous_texture);
+	return total;
+#endif
+}
+
+bool dropTopMipLevel(GLuint *io_texture, GLenum target) {
+#ifdef EMSCRIPTEN // no glGetTexImage in GLES
+	return false;
+#else
+	if (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP) return false;
+	while (glGetError() != GL_NO_ERROR) {} // earlier errors aren't the copy's
+	GLint previous_texture;
+	glGetIntegerv(getTextureBinding(target), &previous_texture);
+	GLuint old_texture = *io_texture;
+	glBindTexture(target, old_texture);
+	GLenum face0_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+
+	int level_count = 0;
+	for (;;) {
+		GLint width, height;
+		glGetTexLevelParameteriv(face0_target, level_count, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(face0_target, level_count, GL_TEXTURE_HEIGHT, &height);
+		if (width == 0) break;
+		level_count++;
+		if (width <= 1 && height <= 1) break;
+	}
+	GLint max_level;
+	glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &max_level);
+	if (level_count > max_level+1) level_count = max_level+1;
+	if (level_count < 2) {
+		glBindTexture(target, previous_texture);
+		return false; // not mipmapped
+	}
+
+	GLint internal_format, compressed, red_type, red_size, width, height;
+	glGetTexLevelParameteriv(face0_target, 1, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+	glGetTexLevelParameteriv(face0_target, 1, GL_TEXTURE_COMPRESSED, &compressed);
+	glGetTexLevelParameteriv(face0_target, 1, GL_TEXTURE_RED_TYPE, &red_type);
+	glGetTexLevelParameteriv(face0_target, 1, GL_TEXTURE_RED_SIZE, &red_size);
+	glGetTexLevelParameteriv(face0_target, 1, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(face0_target, 1, GL_TEXTURE_HEIGHT, &height);
+	// the level's own type, a narrower one would truncate 16 bit and signed formats
+	GLenum type = GL_UNSIGNED_BYTE;
+	if (red_type == GL_FLOAT) type = red_size == 16 ? GL_HALF_FLOAT : GL_FLOAT;
+	else if (red_type == GL_UNSIGNED_NORMALIZED && red_size == 16) type = GL_UNSIGNED_SHORT;
+	else if (red_type == GL_SIGNED_NORMALIZED) type = red_size == 16 ? GL_SHORT : GL_BYTE;
+	GLint params[5];
+	glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, params+0);
+	glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, params+1);
+	glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, params+2);
+	glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, params+3);
+	glGetTexParameteriv(target, GL_TEXTURE_WRAP_R, params+4);
+
+	// level 1 is the largest one that is copied, rgba float is the widest readback
+	u8 *level_data = new u8[(size_t)width*height*4*sizeof(float)];
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	int face_count = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	for (int face = 0; face < face_count; face++) {
+		GLenum face_target = face0_target + face;
+		for (int level = 1; level < level_count; level++) {
+			GLint level_width, level_height, level_size = 0;
+			glBindTexture(target, old_texture);
+			glGetTexLevelParameteriv(face_target, level, GL_TEXTURE_WIDTH, &level_width);
+			glGetTexLevelParameteriv(face_target, level, GL_TEXTURE_HEIGHT, &level_height);
+			if (compressed) {
+				glGetTexLevelParameteriv(face_target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &level_size);
+				glGetCompressedTexImage(face_target, level, level_data);
+			} else {
+				glGetTexImage(face_target, level, GL_RGBA, type, level_data);
+			}
+			glBindTexture(target, texture);
+			if (compressed) {
+				glCompressedTexImage2D(face_target, level-1, internal_format,
+					level_width, level_height, 0, level_size, level_data);
+			} else {
+				glTexImage2D(face_target, level-1, internal_format,
+					level_width, level_height, 0, GL_RGBA, type, level_data);
+			}
+		}
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	delete [] level_data;
+
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, level_count-2);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, params[0]);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, params[1]);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, params[2]);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, params[3]);
+	glTexParameteri(target, GL_TEXTURE_WRAP_R, params[4]);
+
+	if (glGetError() != GL_NO_ERROR) {
+		glDeleteTextures(1, &texture);
+		glBindTexture(target, previous_texture);
+		return false;
+	}
+	glDeleteTextures(1, &old_texture);
+	*io_texture = texture;
+	glBindTexture(target, (GLuint)previous_texture == old_texture ? 0 : previous_texture);
+	return true;
+#endif
+}
+
+int queryGpuFreeMemoryKiB() {
+	static int vendor_extension = -1; // 0: none, 1: nvidia, 2: amd
+	if (vendor_extension == -1) {
+		vendor_extension = SDL_GL_ExtensionSupported("GL_NVX_gpu_memory_info") ? 1
+			: SDL_GL_ExtensionSupported("GL_ATI_meminfo") ? 2 : 0;
+	}
+	GLint kib[4] = {-1, -1, -1, -1};
+	if (vendor_extension == 1) glGetIntegerv(0x9049, kib); // GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
+	if (vendor_extension == 2) glGetIntegerv(0x87FC, kib); // TEXTURE_FREE_MEMORY_ATI, total free pool first
+	return kib[0];
+}
+
+GpuMemory::Entry *GpuMemory::find(GpuMemoryKind kind, GLuint name) {
+	for (int i = 0; i < entry_count; i++) {
+		if (entries[i].kind == kind && entries[i].name == name) return entries + i;
+	}
+	return nullptr;
+}
+
+void GpuMemory::track(GpuMemoryKind kind, GLuint name, size_t size) {
+	Entry *entry = find(kind, name);
+	if (!entry) {
+		if (entry_count == entry_capacity) {
+			entry_capacity = entry_capacity ? 2*entry_capacity : 32;
+			Entry *new_entries = new Entry[entry_capacity];
+			if (entries) {
+				memcpy(new_entries, entries, entry_count*sizeof(Entry));
+				delete [] entries;
+			}
+			entries = new_entries;
+		}
+		entry = entries + entry_count++;
+		entry->name = name;
+		entry->kind = kind;
+		entry->size = 0;
+		counts[kind]++;
+	}
+	bytes[kind] += size - entry->size;
+	entry->size = size;
+	size_t total = getTotalBytes();
+	if (total > peak_bytes) peak_bytes = total;
+}
+
+void GpuMemory::untrack(GpuMemoryKind kind, GLuint name) {
+	Entry *entry = find(kind, name);
+	if (!entry) return;
+	bytes[kind] -= entry->size;
+	counts[kind]--;
+	*entry = entries[--entry_count]; // order doesn't matter
+}
+
+size_t GpuMemory::getBytes(GpuMemoryKind kind, GLuint name) {
+	Entry *entry = find(kind, name);
+	return entry ? entry->size : 0;
+}
+
+size_t GpuMemory::getTotalBytes() {
+	size_t total = 0;
+	for (int kind = 0; kind < GMK_COUNT; kind++) total += bytes[kind];
+	return total;
+}
@@ -0,0 +1,47 @@
+// Bookkeeping of the GPU memory the app allocates. Texture sizes are
+// measured from the driver (every face and mip level), buffers and
+// framebuffers are registered with their byte counts. Padding and driver
+// overhead aren't visible through GL, so the totals are a lower bound.
+enum GpuMemoryKind {
+	GMK_TEXTURE,
+	GMK_BUFFER,
+	GMK_FRAMEBUFFER, // window back buffers and render targets without texture attachments
+	GMK_COUNT
+};
+extern const char *gpu_memory_kind_names[GMK_COUNT];
+
+size_t measureTextureBytes(GLuint texture, GLenum target);
+
+// replaces *io_texture by a copy without its largest mip level (2D and cube maps)
+// returns false if there is no smaller level to drop to
+bool dropTopMipLevel(GLuint *io_texture, GLenum target);
+
+// free memory reported by NVX_gpu_memory_info or ATI_meminfo, -1 if unknown
+int queryGpuFreeMemoryKiB();
+
+struct GpuMemory {
+	size_t bytes[GMK_COUNT] = {};
+	int counts[GMK_COUNT] = {};
+	size_t peak_bytes = 0;
+
+	// an entry is identified by kind and gl name, tracking it again updates its size
+	void track(GpuMemoryKind kind, GLuint name, size_t size);
+	void trackTexture(GLuint texture, GLenum target) {track(GMK_TEXTURE, texture, measureTextureBytes(texture, target));}
+	void untrack(GpuMemoryKind kind, GLuint name);
+	size_t getBytes(GpuMemoryKind kind, GLuint name);
+	size_t getTotalBytes();
+
+private:
+	struct Entry {
+		GLuint name;
+		GpuMemoryKind kind;
+		size_t size;
+	};
+	Entry *entries = nullptr;
+	int entry_count = 0;
+	int entry_capacity = 0;
+
+	Entry *find(GpuMemoryKind kind, GLuint name);
+};
+
+extern GpuMemory gpu_memory;
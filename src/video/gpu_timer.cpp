@@ -0,0 +1,66 @@
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+bool GpuTimer::isSupported() {
+	if (support < 0) {
+#ifdef EMSCRIPTEN // EXT_disjoint_timer_query isn't exposed through the GLES 2 headers
+		support = 0;
+#else
+		const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+		support = extensions && (strstr(extensions, "GL_ARB_timer_query") || strstr(extensions, "GL_EXT_timer_query"));
+		if (!support) LOGI("No timer queries, GPU times aren't available.");
+#endif
+	}
+	return support > 0;
+}
+
+void GpuTimer::begin() {
+	if (!isSupported()) return;
+	if (!queries[0]) glGenQueries(QUERY_COUNT, queries);
+	collect();
+	if (pending[current]) return; // all queries still in flight, skip this frame
+	glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+}
+
+void GpuTimer::end() {
+	if (!isSupported() || pending[current]) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[current] = true;
+	current = (current+1) % QUERY_COUNT;
+}
+
+void GpuTimer::collect() {
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		if (!pending[i]) continue;
+		GLint available = 0;
+		glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) continue;
+		GLuint nanoseconds = 0; // 32 bits are enough for up to 4 seconds
+		glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &nanoseconds);
+		pending[i] = false;
+		last_milliseconds = nanoseconds*1e-6f;
+		float weight = sample_count < 16 ? 1.0f/(sample_count+1) : 1.0f/16.0f; // mean at first, then exponential
+		milliseconds += weight*(last_milliseconds - milliseconds);
+		sample_count++;
+	}
+}
+
+void GpuTimer::reset() {
+	milliseconds = last_milliseconds = 0.0f;
+	sample_count = 0;
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		if (!pending[i]) continue;
+		// orphan results of the old work, reading them would wait for the GPU
+		glDeleteQueries(1, queries + i);
+		glGenQueries(1, queries + i);
+		pending[i] = false;
+	}
+}
+
+void GpuTimer::release() {
+	if (queries[0]) glDeleteQueries(QUERY_COUNT, queries);
+	memset(queries, 0, sizeof(queries));
+	memset(pending, 0, sizeof(pending));
+	current = sample_count = 0;
+}
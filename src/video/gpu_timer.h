@@ -0,0 +1,22 @@
+// GPU time of a range of draw calls from ARB/EXT_timer_query. A few queries
+// are kept in flight and read back once available, so measuring doesn't stall
+// the pipeline. Results lag behind by a few frames.
+struct GpuTimer {
+	float milliseconds = 0.0f; // smoothed over recent frames, 0 until the first result
+	float last_milliseconds = 0.0f;
+
+	bool isSupported();
+	void begin();
+	void end();
+	void collect(); // reads the finished results, begin() does too
+	void reset(); // forget the smoothed value, e.g. after the measured work changed
+	void release();
+
+private:
+	enum {QUERY_COUNT = 4};
+	int support = -1; // -1: not checked yet
+	GLuint queries[QUERY_COUNT] = {};
+	bool pending[QUERY_COUNT] = {};
+	int current = 0;
+	int sample_count = 0;
+};
@@ -0,0 +1,83 @@
+// squared YIQ distance with the weights of pixelmatch, 35215 at most
+static float yiqDistanceSquared(const u8 *pa, const u8 *pb) {
+	float dr = (float)pa[0] - (float)pb[0];
+	float dg = (float)pa[1] - (float)pb[1];
+	float db = (float)pa[2] - (float)pb[2];
+	float y = dr*0.29889531f + dg*0.58662247f + db*0.11448223f;
+	float i = dr*0.59597799f - dg*0.27417610f - db*0.32180189f;
+	float q = dr*0.21147017f - dg*0.52261711f + db*0.31114694f;
+	return 0.5053f*y*y + 0.299f*i*i + 0.1957f*q*q;
+}
+
+void diffImages(const u8 *a, const u8 *b, int width, int height, ImageDiffStats *stats,
+	u8 *out_diff_rgba, float perceptual_threshold) {
+	memset(stats, 0, sizeof(*stats));
+	float max_distance_squared = 35215.0f*perceptual_threshold*perceptual_threshold;
+	stats->pixel_count = width*height;
+	u64 difference_sum = 0;
+	u64 squared_error_sum = 0; // of all rgb channels
+	for (int i = 0; i < stats->pixel_count; i++) {
+		const u8 *pa = a + 4*i, *pb = b + 4*i;
+		int difference = 0;
+		for (int c = 0; c < 3; c++) {
+			int d = pa[c] > pb[c] ? pa[c] - pb[c] : pb[c] - pa[c];
+			if (d > difference) difference = d;
+			squared_error_sum += (u64)(d*d);
+		}
+		bool is_perceptual = difference && yiqDistanceSquared(pa, pb) > max_distance_squared;
+		if (difference) stats->differing_pixel_count++;
+		if (is_perceptual) stats->perceptual_pixel_count++;
+		if (difference > stats->max_difference) stats->max_difference = difference;
+		difference_sum += difference;
+
+		if (out_diff_rgba) {
+			u8 *pd = out_diff_rgba + 4*i;
+			if (difference) { // at least 64 so single steps are visible
+				pd[0] = (u8)(64 + difference*191/255);
+				pd[1] = is_perceptual ? 0 : pd[0];
+				pd[2] = 0;
+			} else {
+				pd[0] = pd[1] = pd[2] = (u8)((pa[0]*54 + pa[1]*183 + pa[2]*19) >> 10); // quarter luminance
+			}
+			pd[3] = 255;
+		}
+	}
+	if (!stats->pixel_count) return;
+	stats->mean_difference = (float)((double)difference_sum / stats->pixel_count);
+	double mse = (double)squared_error_sum / (3.0*stats->pixel_count);
+	stats->psnr = mse > 0.0 ? (float)(10.0*log10(255.0*255.0 / mse)) : INFINITY;
+}
+
+bool writeTga(const char *filepath, const u8 *rgba, int width, int height) {
+	FILE *file = fopen(filepath, "wb");
+	if (!file) {
+		LOGE("Could not open %s for writing", filepath);
+		return false;
+	}
+	u8 header[18] = {};
+	header[2] = 2; // uncompressed true color
+	header[12] = (u8)(width & 0xFF);
+	header[13] = (u8)(width >> 8);
+	header[14] = (u8)(height & 0xFF);
+	header[15] = (u8)(height >> 8);
+	header[16] = 32; // bits per pixel
+	header[17] = 8; // alpha bits, origin at the bottom left
+	fwrite(header, sizeof(header), 1, file);
+
+	u8 *row = new u8[4*width]; // bgra
+	for (int y = 0; y < height; y++) {
+		const u8 *src = rgba + (size_t)4*width*y;
+		for (int x = 0; x < width; x++) {
+			row[4*x+0] = src[4*x+2];
+			row[4*x+1] = src[4*x+1];
+			row[4*x+2] = src[4*x+0];
+			row[4*x+3] = src[4*x+3];
+		}
+		fwrite(row, 4, width, file);
+	}
+	delete [] row;
+	bool is_written = !ferror(file);
+	fclose(file);
+	if (!is_written) LOGE("Could not write %s", filepath);
+	return is_written;
+}
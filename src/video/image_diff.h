@@ -0,0 +1,22 @@
+// Per pixel comparison of two rgba8 images of the same size, e.g. the frames
+// of two shader variants. Differences are measured on the largest rgb channel
+// difference of a pixel in 0..255, alpha is ignored. A pixel differs
+// perceptually if its distance in YIQ space, weighted like pixelmatch does it
+// and normalized to 0..1, is above the threshold.
+struct ImageDiffStats {
+	int pixel_count;
+	int differing_pixel_count; // any channel differs
+	int perceptual_pixel_count; // above the perceptual threshold
+	int max_difference;
+	float mean_difference; // over all pixels
+	float psnr; // in dB, infinite if the images are identical
+};
+
+// out_diff_rgba (optional, width*height*4) shows perceptually differing pixels
+// in red and the others that differ in yellow, brighter for larger differences,
+// over a dimmed gray version of a
+void diffImages(const u8 *a, const u8 *b, int width, int height, ImageDiffStats *stats,
+	u8 *out_diff_rgba = nullptr, float perceptual_threshold = 0.1f);
+
+// uncompressed 32 bit tga, rows from bottom to top like glReadPixels returns them
+bool writeTga(const char *filepath, const u8 *rgba, int width, int height);
@@ -0,0 +1,646 @@
+static const u32 mesh_sdf_version = 1; // bump to invalidate cached bakes
+
+bool isMeshFile(const char *filepath) {
+	return hasFileExtension(filepath, "obj") || hasFileExtension(filepath, "mdl");
+}
+
+struct SdfMesh {
+	float *positions = nullptr; // xyz
+	int vertex_count = 0;
+	u32 *indices = nullptr; // 3 per triangle
+	int triangle_count = 0;
+
+	void clear() {
+		if (positions) {delete [] positions; positions = nullptr;}
+		if (indices) {delete [] indices; indices = nullptr;}
+		vertex_count = triangle_count = 0;
+	}
+};
+
+// Wavefront OBJ, only "v" and "f" lines are of interest. Polygons are fanned.
+static bool loadMeshOBJ(const char *filepath, SdfMesh *mesh) {
+	char *src = readStringFromFile(filepath);
+	if (!src) return false;
+
+	// 1st pass: count vertices and triangles
+	int vertex_capacity = 0, triangle_capacity = 0;
+	for (char *line = src; *line; ) {
+		if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) vertex_capacity++;
+		if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+			int corner_count = 0;
+			for (char *c = line+1; *c && *c != '\n'; c++) {
+				if ((c[-1] == ' ' || c[-1] == '\t') && c[0] != ' ' && c[0] != '\t' && c[0] != '\r') corner_count++;
+			}
+			if (corner_count >= 3) triangle_capacity += corner_count-2;
+		}
+		while (*line && *line != '\n') line++;
+		if (*line) line++;
+	}
+	mesh->positions = new float[3*(vertex_capacity > 0 ? vertex_capacity : 1)];
+	mesh->indices = new u32[3*(triangle_capacity > 0 ? triangle_capacity : 1)];
+
+	// 2nd pass: parse
+	for (char *line = src; *line; ) {
+		if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) {
+			char *c = line+2;
+			float *position = mesh->positions + 3*mesh->vertex_count++;
+			for (int i = 0; i < 3; i++) position[i] = strtof(c, &c);
+		} else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+			char *c = line+2;
+			u32 first = 0, prev = 0;
+			for (int corner = 0; ; corner++) {
+				while (*c == ' ' || *c == '\t') c++;
+				if (!*c || *c == '\n' || *c == '\r') break;
+				long index = strtol(c, &c, 10);
+				while (*c && *c != ' ' && *c != '\t' && *c != '\n') c++; // skip /vt/vn
+				// 1 based, negative indices are relative to the end
+				u32 vertex = (u32)(index < 0 ? mesh->vertex_count + index : index - 1);
+				if (vertex >= (u32)mesh->vertex_count) {
+					LOGE("Invalid face index %ld in %s", index, filepath);
+					delete [] src;
+					mesh->clear();
+					return false;
+				}
+				if (corner == 0) first = vertex;
+				else if (corner >= 2 && mesh->triangle_count < triangle_capacity) {
+					u32 *triangle = mesh->indices + 3*mesh->triangle_count++;
+					triangle[0] = first; triangle[1] = prev; triangle[2] = vertex;
+				}
+				prev = vertex;
+			}
+		}
+		while (*line && *line != '\n') line++;
+		if (*line) line++;
+	}
+
+	delete [] src;
+	return mesh->triangle_count > 0;
+}
+
+// advances offset by size if that stays within the file
+static bool skipMDLBytes(size_t *offset, u64 size, size_t file_size) {
+	if (size > file_size || *offset > file_size - size) return false;
+	*offset += (size_t)size;
+	return true;
+}
+
+// Quake MDL, vertices of the first frame
+static bool loadMeshMDL(const char *filepath, SdfMesh *mesh) {
+	MappedFile file;
+	if (!file.open(filepath)) return false;
+
+	struct MDLHeader {
+		char ident[4];
+		s32 version;
+		float scale[3], translate[3];
+		float bounding_radius;
+		float eye_position[3];
+		s32 skin_count, skin_width, skin_height;
+		s32 vertex_count, triangle_count, frame_count;
+		s32 sync_type, flags;
+		float size;
+	} header;
+	if (file.size < sizeof(header)) return false;
+	memcpy(&header, file.data, sizeof(header));
+	// the limits are far above what the format's tools produce, they keep the sizes from overflowing
+	if (memcmp(header.ident, "IDPO", 4) || header.version != 6
+		|| header.vertex_count <= 0 || header.vertex_count > (1 << 20)
+		|| header.triangle_count <= 0 || header.triangle_count > (1 << 21)
+		|| header.frame_count <= 0 || header.skin_count < 0 || header.skin_count > 1024
+		|| header.skin_width < 0 || header.skin_width > 4096 || header.skin_height < 0 || header.skin_height > 4096) {
+		LOGE("Not a valid Quake MDL file: %s", filepath);
+		return false;
+	}
+
+	size_t offset = sizeof(header);
+	u64 skin_size = (u64)header.skin_width*header.skin_height;
+	for (int si = 0; si < header.skin_count; si++) { // skip skins
+		s32 group;
+		if (offset + 4 > file.size) return false;
+		memcpy(&group, file.data+offset, 4); offset += 4;
+		if (group == 0) {
+			if (!skipMDLBytes(&offset, skin_size, file.size)) return false;
+		} else {
+			s32 picture_count;
+			if (offset + 4 > file.size) return false;
+			memcpy(&picture_count, file.data+offset, 4); offset += 4;
+			if (picture_count <= 0 || picture_count > 1024) return false;
+			if (!skipMDLBytes(&offset, (u64)picture_count*(4 + skin_size), file.size)) return false; // times, pictures
+		}
+	}
+	if (!skipMDLBytes(&offset, (u64)header.vertex_count*12, file.size)) return false; // texcoords: onseam, s, t
+
+	size_t triangles_offset = offset;
+	if (!skipMDLBytes(&offset, (u64)header.triangle_count*16, file.size)) return false; // facesfront, 3 vertex indices
+	s32 frame_type;
+	if (offset + 4 > file.size) return false;
+	memcpy(&frame_type, file.data+offset, 4); offset += 4;
+	if (frame_type != 0) {
+		// group frame: count, bbox min max, times, then simple frames without type
+		s32 frame_count;
+		if (offset + 4 > file.size) return false;
+		memcpy(&frame_count, file.data+offset, 4);
+		if (frame_count <= 0 || frame_count > 1024) return false;
+		if (!skipMDLBytes(&offset, 4 + 8 + 4*(u64)frame_count, file.size)) return false;
+	}
+	if (!skipMDLBytes(&offset, 8 + 16, file.size)) return false; // bbox min max, name
+	if ((u64)header.vertex_count*4 > file.size - offset) return false;
+
+	mesh->vertex_count = header.vertex_count;
+	mesh->positions = new float[3*header.vertex_count];
+	for (int vi = 0; vi < header.vertex_count; vi++) {
+		const u8 *packed = file.data + offset + 4*vi; // x y z normal_index
+		for (int i = 0; i < 3; i++) {
+			mesh->positions[3*vi+i] = header.scale[i]*packed[i] + header.translate[i];
+		}
+	}
+	mesh->triangle_count = header.triangle_count;
+	mesh->indices = new u32[3*header.triangle_count];
+	for (int ti = 0; ti < header.triangle_count; ti++) {
+		s32 vertices[3];
+		memcpy(vertices, file.data + triangles_offset + 16*ti + 4, sizeof(vertices));
+		for (int i = 0; i < 3; i++) {
+			if (vertices[i] < 0 || vertices[i] >= header.vertex_count) {
+				mesh->clear();
+				return false;
+			}
+			mesh->indices[3*ti+i] = (u32)vertices[i];
+		}
+	}
+	return true;
+}
+
+// 4 triangles in SoA layout so the distance test runs on all of them at once
+struct SdfTrianglePacket {
+	float ax[4], ay[4], az[4];
+	float bx[4], by[4], bz[4];
+	float cx[4], cy[4], cz[4];
+	float abx[4], aby[4], abz[4];
+	float bcx[4], bcy[4], bcz[4];
+	float cax[4], cay[4], caz[4];
+	float nx[4], ny[4], nz[4];
+	float inv_ab2[4], inv_bc2[4], inv_ca2[4], inv_n2[4];
+	u32 plane_mask[4]; // all bits set if the triangle is not degenerate
+	int lane_count; // valid lanes, the rest repeat the last triangle
+};
+
+struct SdfBvhNode {
+	float min[3], max[3];
+	u32 first; // inner: left child (right is first+1), leaf: first packet
+	u32 count; // 0: inner node, else number of packets
+};
+
+struct SdfBvh {
+	SdfBvhNode *nodes = nullptr;
+	int node_count = 0;
+	SdfTrianglePacket *packets = nullptr;
+	int packet_count = 0;
+
+	void build(SdfMesh *mesh);
+	float distanceSquared(const float p[3]);
+	int intersectRowX(float y, float z, float *out_hits, int max_hit_count); // ray along +x
+
+	void clear() {
+		if (nodes) {delete [] nodes; nodes = nullptr;}
+		if (packets) {delete [] packets; packets = nullptr;}
+	}
+
+private:
+	SdfMesh *mesh;
+	u32 *triangle_indices; // reordered during build
+	float *centroids;
+
+	void buildNode(int node_index, int begin, int end, int depth);
+	void fillPacket(SdfTrianglePacket *packet, const u32 *indices, int count);
+};
+
+static const int sdf_leaf_size = 8; // triangles
+// from this depth on nodes split at the triangle median, which halves the count,
+// so the depth stays under this + log2(triangle count) and the
+// traversal stacks of 128 always fit
+static const int sdf_median_split_depth = 64;
+
+void SdfBvh::build(SdfMesh *build_mesh) {
+	mesh = build_mesh;
+	int tri_count = mesh->triangle_count;
+	triangle_indices = new u32[tri_count];
+	centroids = new float[3*tri_count];
+	for (int ti = 0; ti < tri_count; ti++) {
+		triangle_indices[ti] = ti;
+		for (int i = 0; i < 3; i++) {
+			centroids[3*ti+i] = (mesh->positions[3*mesh->indices[3*ti+0]+i]
+				+ mesh->positions[3*mesh->indices[3*ti+1]+i]
+				+ mesh->positions[3*mesh->indices[3*ti+2]+i]) / 3.0f;
+		}
+	}
+	nodes = new SdfBvhNode[2*tri_count];
+	packets = new SdfTrianglePacket[tri_count]; // upper bound, every leaf has at least one triangle
+	node_count = 1;
+	packet_count = 0;
+	buildNode(0, 0, tri_count, 0);
+
+	delete [] triangle_indices;
+	delete [] centroids;
+}
+
+void SdfBvh::buildNode(int node_index, int begin, int end, int depth) {
+	SdfBvhNode *node = nodes + node_index;
+	float centroid_min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+	float centroid_max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for (int i = 0; i < 3; i++) {node->min[i] = FLT_MAX; node->max[i] = -FLT_MAX;}
+	for (int ti = begin; ti < end; ti++) {
+		u32 *triangle = mesh->indices + 3*triangle_indices[ti];
+		for (int i = 0; i < 3; i++) {
+			for (int corner = 0; corner < 3; corner++) {
+				float v = mesh->positions[3*triangle[corner]+i];
+				node->min[i] = fminf(node->min[i], v);
+				node->max[i] = fmaxf(node->max[i], v);
+			}
+			float c = centroids[3*triangle_indices[ti]+i];
+			centroid_min[i] = fminf(centroid_min[i], c);
+			centroid_max[i] = fmaxf(centroid_max[i], c);
+		}
+	}
+
+	if (end - begin <= sdf_leaf_size) {
+		node->first = packet_count;
+		node->count = 0;
+		for (int ti = begin; ti < end; ti += 4) {
+			fillPacket(packets + packet_count++, triangle_indices + ti, end-ti < 4 ? end-ti : 4);
+			node->count++;
+		}
+		return;
+	}
+
+	// split at the spatial median of the centroids along the longest axis
+	int axis = 0;
+	for (int i = 1; i < 3; i++) {
+		if (centroid_max[i]-centroid_min[i] > centroid_max[axis]-centroid_min[axis]) axis = i;
+	}
+	float split = 0.5f*(centroid_min[axis] + centroid_max[axis]);
+	int mid = begin;
+	for (int ti = begin; ti < end; ti++) {
+		if (centroids[3*triangle_indices[ti]+axis] < split) {
+			u32 tmp = triangle_indices[ti];
+			triangle_indices[ti] = triangle_indices[mid];
+			triangle_indices[mid] = tmp;
+			mid++;
+		}
+	}
+	// all centroids coincide, or a skewed distribution gets too deep
+	if (mid == begin || mid == end || depth >= sdf_median_split_depth) mid = (begin + end) / 2;
+
+	int left = node_count;
+	node_count += 2;
+	node->first = left;
+	node->count = 0;
+	buildNode(left, begin, mid, depth+1);
+	buildNode(left+1, mid, end, depth+1);
+}
+
+void SdfBvh::fillPacket(SdfTrianglePacket *packet, const u32 *indices, int count) {
+	packet->lane_count = count;
+	for (int lane = 0; lane < 4; lane++) {
+		u32 *triangle = mesh->indices + 3*indices[lane < count ? lane : count-1];
+		float *a = mesh->positions + 3*triangle[0];
+		float *b = mesh->positions + 3*triangle[1];
+		float *c = mesh->positions + 3*triangle[2];
+		packet->ax[lane] = a[0]; packet->ay[lane] = a[1]; packet->az[lane] = a[2];
+		packet->bx[lane] = b[0]; packet->by[lane] = b[1]; packet->bz[lane] = b[2];
+		packet->cx[lane] = c[0]; packet->cy[lane] = c[1]; packet->cz[lane] = c[2];
+		float ab[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+		float bc[3] = {c[0]-b[0], c[1]-b[1], c[2]-b[2]};
+		float ca[3] = {a[0]-c[0], a[1]-c[1], a[2]-c[2]};
+		float n[3] = { // ab x -ca
+			ab[2]*ca[1] - ab[1]*ca[2],
+			ab[0]*ca[2] - ab[2]*ca[0],
+			ab[1]*ca[0] - ab[0]*ca[1]};
+		packet->abx[lane] = ab[0]; packet->aby[lane] = ab[1]; packet->abz[lane] = ab[2];
+		packet->bcx[lane] = bc[0]; packet->bcy[lane] = bc[1]; packet->bcz[lane] = bc[2];
+		packet->cax[lane] = ca[0]; packet->cay[lane] = ca[1]; packet->caz[lane] = ca[2];
+		packet->nx[lane] = n[0]; packet->ny[lane] = n[1]; packet->nz[lane] = n[2];
+		float ab2 = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+		float bc2 = bc[0]*bc[0] + bc[1]*bc[1] + bc[2]*bc[2];
+		float ca2 = ca[0]*ca[0] + ca[1]*ca[1] + ca[2]*ca[2];
+		float n2 = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+		packet->inv_ab2[lane] = ab2 > 0.0f ? 1.0f/ab2 : 0.0f;
+		packet->inv_bc2[lane] = bc2 > 0.0f ? 1.0f/bc2 : 0.0f;
+		packet->inv_ca2[lane] = ca2 > 0.0f ? 1.0f/ca2 : 0.0f;
+		packet->inv_n2[lane] = n2 > 0.0f ? 1.0f/n2 : 0.0f;
+		packet->plane_mask[lane] = n2 > 0.0f ? 0xFFFFFFFF : 0;
+	}
+}
+
+// squared distance from p to the closest of the 4 triangles in the packet
+// closest point is on the plane if p projects inside the triangle, else on one of the edges
+#ifdef USE_SSE2
+static inline __m128 dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+static inline __m128 segmentDistanceSquared(__m128 px, __m128 py, __m128 pz, // relative to segment start
+	__m128 ex, __m128 ey, __m128 ez, __m128 inv_e2) {
+	__m128 t = _mm_mul_ps(dot3(px, py, pz, ex, ey, ez), inv_e2);
+	t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	__m128 dx = _mm_sub_ps(px, _mm_mul_ps(t, ex));
+	__m128 dy = _mm_sub_ps(py, _mm_mul_ps(t, ey));
+	__m128 dz = _mm_sub_ps(pz, _mm_mul_ps(t, ez));
+	return dot3(dx, dy, dz, dx, dy, dz);
+}
+
+// sign of dot(cross(e, p), n) >= 0
+static inline __m128 edgeSide(__m128 ex, __m128 ey, __m128 ez, __m128 px, __m128 py, __m128 pz,
+	__m128 nx, __m128 ny, __m128 nz) {
+	__m128 cx = _mm_sub_ps(_mm_mul_ps(ey, pz), _mm_mul_ps(ez, py));
+	__m128 cy = _mm_sub_ps(_mm_mul_ps(ez, px), _mm_mul_ps(ex, pz));
+	__m128 cz = _mm_sub_ps(_mm_mul_ps(ex, py), _mm_mul_ps(ey, px));
+	return _mm_cmpge_ps(dot3(cx, cy, cz, nx, ny, nz), _mm_setzero_ps());
+}
+
+static float packetDistanceSquared(const SdfTrianglePacket *tp, const float p[3]) {
+	__m128 px = _mm_set1_ps(p[0]), py = _mm_set1_ps(p[1]), pz = _mm_set1_ps(p[2]);
+	__m128 pax = _mm_sub_ps(px, _mm_loadu_ps(tp->ax));
+	__m128 pay = _mm_sub_ps(py, _mm_loadu_ps(tp->ay));
+	__m128 paz = _mm_sub_ps(pz, _mm_loadu_ps(tp->az));
+	__m128 pbx = _mm_sub_ps(px, _mm_loadu_ps(tp->bx));
+	__m128 pby = _mm_sub_ps(py, _mm_loadu_ps(tp->by));
+	__m128 pbz = _mm_sub_ps(pz, _mm_loadu_ps(tp->bz));
+	__m128 pcx = _mm_sub_ps(px, _mm_loadu_ps(tp->cx));
+	__m128 pcy = _mm_sub_ps(py, _mm_loadu_ps(tp->cy));
+	__m128 pcz = _mm_sub_ps(pz, _mm_loadu_ps(tp->cz));
+	__m128 abx = _mm_loadu_ps(tp->abx), aby = _mm_loadu_ps(tp->aby), abz = _mm_loadu_ps(tp->abz);
+	__m128 bcx = _mm_loadu_ps(tp->bcx), bcy = _mm_loadu_ps(tp->bcy), bcz = _mm_loadu_ps(tp->bcz);
+	__m128 cax = _mm_loadu_ps(tp->cax), cay = _mm_loadu_ps(tp->cay), caz = _mm_loadu_ps(tp->caz);
+	__m128 nx = _mm_loadu_ps(tp->nx), ny = _mm_loadu_ps(tp->ny), nz = _mm_loadu_ps(tp->nz);
+
+	__m128 edge_d2 = _mm_min_ps(
+		segmentDistanceSquared(pax, pay, paz, abx, aby, abz, _mm_loadu_ps(tp->inv_ab2)),
+		_mm_min_ps(
+			segmentDistanceSquared(pbx, pby, pbz, bcx, bcy, bcz, _mm_loadu_ps(tp->inv_bc2)),
+			segmentDistanceSquared(pcx, pcy, pcz, cax, cay, caz, _mm_loadu_ps(tp->inv_ca2))));
+
+	__m128 inside = _mm_and_ps(
+		_mm_and_ps(edgeSide(abx, aby, abz, pax, pay, paz, nx, ny, nz),
+		           edgeSide(bcx, bcy, bcz, pbx, pby, pbz, nx, ny, nz)),
+		_mm_and_ps(edgeSide(cax, cay, caz, pcx, pcy, pcz, nx, ny, nz),
+		           _mm_loadu_ps((const float*)tp->plane_mask)));
+	__m128 pn = dot3(pax, pay, paz, nx, ny, nz);
+	__m128 plane_d2 = _mm_mul_ps(_mm_mul_ps(pn, pn), _mm_loadu_ps(tp->inv_n2));
+
+	__m128 d2 = _mm_or_ps(_mm_and_ps(inside, plane_d2), _mm_andnot_ps(inside, edge_d2));
+	d2 = _mm_min_ps(d2, _mm_shuffle_ps(d2, d2, _MM_SHUFFLE(2, 3, 0, 1)));
+	d2 = _mm_min_ps(d2, _mm_shuffle_ps(d2, d2, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(d2);
+}
+#else
+static inline float segmentDistanceSquared(float px, float py, float pz,
+	float ex, float ey, float ez, float inv_e2) {
+	float t = (px*ex + py*ey + pz*ez)*inv_e2;
+	t = fminf(fmaxf(t, 0.0f), 1.0f);
+	float dx = px - t*ex, dy = py - t*ey, dz = pz - t*ez;
+	return dx*dx + dy*dy + dz*dz;
+}
+
+static inline bool edgeSide(float ex, float ey, float ez, float px, float py, float pz,
+	float nx, float ny, float nz) {
+	return (ey*pz - ez*py)*nx + (ez*px - ex*pz)*ny + (ex*py - ey*px)*nz >= 0.0f;
+}
+
+static float packetDistanceSquared(const SdfTrianglePacket *tp, const float p[3]) {
+	float best = FLT_MAX;
+	for (int l = 0; l < tp->lane_count; l++) {
+		float pax = p[0]-tp->ax[l], pay = p[1]-tp->ay[l], paz = p[2]-tp->az[l];
+		float pbx = p[0]-tp->bx[l], pby = p[1]-tp->by[l], pbz = p[2]-tp->bz[l];
+		float pcx = p[0]-tp->cx[l], pcy = p[1]-tp->cy[l], pcz = p[2]-tp->cz[l];
+		float d2;
+		if (tp->plane_mask[l]
+			&& edgeSide(tp->abx[l], tp->aby[l], tp->abz[l], pax, pay, paz, tp->nx[l], tp->ny[l], tp->nz[l])
+			&& edgeSide(tp->bcx[l], tp->bcy[l], tp->bcz[l], pbx, pby, pbz, tp->nx[l], tp->ny[l], tp->nz[l])
+			&& edgeSide(tp->cax[l], tp->cay[l], tp->caz[l], pcx, pcy, pcz, tp->nx[l], tp->ny[l], tp->nz[l])) {
+			float pn = pax*tp->nx[l] + pay*tp->ny[l] + paz*tp->nz[l];
+			d2 = pn*pn*tp->inv_n2[l];
+		} else {
+			d2 = fminf(segmentDistanceSquared(pax, pay, paz, tp->abx[l], tp->aby[l], tp->abz[l], tp->inv_ab2[l]),
+				fminf(segmentDistanceSquared(pbx, pby, pbz, tp->bcx[l], tp->bcy[l], tp->bcz[l], tp->inv_bc2[l]),
+				      segmentDistanceSquared(pcx, pcy, pcz, tp->cax[l], tp->cay[l], tp->caz[l], tp->inv_ca2[l])));
+		}
+		best = fminf(best, d2);
+	}
+	return best;
+}
+#endif
+
+static inline float boxDistanceSquared(const SdfBvhNode *node, const float p[3]) {
+	float d2 = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		float d = fmaxf(fmaxf(node->min[i] - p[i], p[i] - node->max[i]), 0.0f);
+		d2 += d*d;
+	}
+	return d2;
+}
+
+float SdfBvh::distanceSquared(const float p[3]) {
+	float best = FLT_MAX;
+	u32 stack[128];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size) {
+		SdfBvhNode *node = nodes + stack[--stack_size];
+		if (boxDistanceSquared(node, p) >= best) continue;
+		if (node->count) {
+			for (u32 pi = 0; pi < node->count; pi++) {
+				best = fminf(best, packetDistanceSquared(packets + node->first + pi, p));
+			}
+		} else {
+			assert(stack_size + 2 <= (int)ARRAY_COUNT(stack)); // see sdf_median_split_depth
+			// visit the nearer child first (pushed last)
+			float left_d2 = boxDistanceSquared(nodes + node->first, p);
+			float right_d2 = boxDistanceSquared(nodes + node->first + 1, p);
+			bool left_first = left_d2 < right_d2;
+			stack[stack_size++] = node->first + (left_first ? 1 : 0);
+			stack[stack_size++] = node->first + (left_first ? 0 : 1);
+		}
+	}
+	return best;
+}
+
+// x coordinates where the line (*, y, z) crosses the mesh
+int SdfBvh::intersectRowX(float y, float z, float *out_hits, int max_hit_count) {
+	int hit_count = 0;
+	u32 stack[128];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size) {
+		SdfBvhNode *node = nodes + stack[--stack_size];
+		if (y < node->min[1] || y > node->max[1] || z < node->min[2] || z > node->max[2]) continue;
+		if (!node->count) {
+			assert(stack_size + 2 <= (int)ARRAY_COUNT(stack)); // see sdf_median_split_depth
+			stack[stack_size++] = node->first;
+			stack[stack_size++] = node->first + 1;
+			continue;
+		}
+		for (u32 pi = 0; pi < node->count; pi++) {
+			SdfTrianglePacket *tp = packets + node->first + pi;
+			for (int l = 0; l < tp->lane_count; l++) {
+				// 2D point in triangle test in the yz plane
+				float ay = tp->ay[l]-y, az = tp->az[l]-z;
+				float by = tp->by[l]-y, bz = tp->bz[l]-z;
+				float cy = tp->cy[l]-y, cz = tp->cz[l]-z;
+				float w0 = by*cz - bz*cy;
+				float w1 = cy*az - cz*ay;
+				float w2 = ay*bz - az*by;
+				if (!((w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f) || (w0 <= 0.0f && w1 <= 0.0f && w2 <= 0.0f))) continue;
+				float w = w0 + w1 + w2;
+				if (w == 0.0f) continue; // parallel to the row
+				if (hit_count < max_hit_count) {
+					out_hits[hit_count++] = (w0*tp->ax[l] + w1*tp->bx[l] + w2*tp->cx[l]) / w;
+				}
+			}
+		}
+	}
+	// insertion sort, there are only a few hits per row
+	for (int i = 1; i < hit_count; i++) {
+		float hit = out_hits[i];
+		int j = i;
+		for (; j > 0 && out_hits[j-1] > hit; j--) out_hits[j] = out_hits[j-1];
+		out_hits[j] = hit;
+	}
+	return hit_count;
+}
+
+struct SdfBakeContext {
+	SdfBvh *bvh;
+	int resolution;
+	float center[3];
+	float half_extent; // grid covers center +- half_extent
+	float *distances; // resolution^3, x fastest
+	SDL_atomic_t *slices_done;
+};
+
+static void bakeSdfSlice(void *data, int z) {
+	SdfBakeContext *context = (SdfBakeContext*)data;
+	int n = context->resolution;
+	float voxel_size = 2.0f*context->half_extent / n;
+	float origin[3];
+	for (int i = 0; i < 3; i++) origin[i] = context->center[i] - context->half_extent + 0.5f*voxel_size;
+	float inv_half_extent = 1.0f / context->half_extent;
+
+	float hits[256];
+	for (int y = 0; y < n; y++) {
+		float p[3] = {origin[0], origin[1] + y*voxel_size, origin[2] + z*voxel_size};
+		// inside/outside by crossing parity along the row. The row is nudged off the
+		// voxel centers so it doesn't run exactly through shared edges of a grid-aligned mesh
+		int hit_count = context->bvh->intersectRowX(p[1] + 1.3e-4f*voxel_size, p[2] + 0.7e-4f*voxel_size,
+			hits, (int)ARRAY_COUNT(hits));
+		int hits_passed = 0;
+		float *row = context->distances + ((size_t)z*n + y)*n;
+		for (int x = 0; x < n; x++) {
+			p[0] = origin[0] + x*voxel_size;
+			while (hits_passed < hit_count && hits[hits_passed] < p[0]) hits_passed++;
+			float d = sqrtf(context->bvh->distanceSquared(p)) * inv_half_extent;
+			row[x] = (hits_passed & 1) ? -d : d;
+		}
+	}
+	SDL_AtomicAdd(context->slices_done, 1);
+}
+
+static bool writeVolFile(const char *filepath, const float *data, int resolution) {
+	char tmp_filepath[1024+4];
+	snprintf(tmp_filepath, sizeof(tmp_filepath), "%s.tmp", filepath);
+	FILE *file = fopen(tmp_filepath, "wb");
+	if (!file) return false;
+	u8 header[48] = {'V', 'O', 'L', 3};
+	s32 header_ints[5] = {1, resolution, resolution, resolution, 1}; // float32, xyz, channels
+	float bbox[6] = {-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+	memcpy(header+4, header_ints, sizeof(header_ints));
+	memcpy(header+24, bbox, sizeof(bbox));
+	fwrite(header, 1, sizeof(header), file);
+	size_t count = (size_t)resolution*resolution*resolution;
+	bool written = fwrite(data, sizeof(float), count, file) == count;
+	fclose(file);
+	if (!written) {
+		remove(tmp_filepath);
+		return false;
+	}
+	remove(filepath); // rename doesn't overwrite on windows
+	return !rename(tmp_filepath, filepath);
+}
+
+bool MeshSdfBake::start(const char *filepath, const char *cache_dirpath, int grid_resolution) {
+	if (grid_resolution < 8) grid_resolution = 8;
+	resolution = grid_resolution;
+	SDL_AtomicSet(&slices_done, 0);
+
+	MappedFile mesh_file;
+	if (!mesh_file.open(filepath)) return false;
+	u32 options[2] = {mesh_sdf_version, (u32)resolution};
+	u64 key = hashBytes(options, sizeof(options), hashBytes(mesh_file.data, mesh_file.size));
+	mesh_file.close();
+	snprintf(volume_filepath, sizeof(volume_filepath), "%s%016llx.sdf.vol",
+		cache_dirpath ? cache_dirpath : "", (unsigned long long)key);
+
+	if (MappedFile::getFileSize(volume_filepath)) { // baked before
+		SDL_AtomicSet(&slices_done, resolution);
+		SDL_AtomicSet(&state, MSBS_BAKED);
+		return true;
+	}
+
+	mesh_filepath = new char[strlen(filepath)+1];
+	strcpy(mesh_filepath, filepath);
+	SDL_AtomicSet(&state, MSBS_BAKING);
+	job_queue.push(bakeJob, this);
+	return true;
+}
+
+void MeshSdfBake::bakeJob(void *data) {
+	MeshSdfBake *bake = (MeshSdfBake*)data;
+	u64 begin_ticks = SDL_GetPerformanceCounter();
+
+	SdfMesh mesh;
+	bool loaded = hasFileExtension(bake->mesh_filepath, "mdl")
+		? loadMeshMDL(bake->mesh_filepath, &mesh)
+		: loadMeshOBJ(bake->mesh_filepath, &mesh);
+	if (!loaded) {
+		LOGE("Could not load mesh '%s'", bake->mesh_filepath);
+		if (!SDL_AtomicCAS(&bake->state, MSBS_BAKING, MSBS_FAILED)) delete bake; // abandoned
+		return;
+	}
+
+	SdfBvh bvh;
+	bvh.build(&mesh);
+
+	SdfBakeContext context;
+	context.bvh = &bvh;
+	context.resolution = bake->resolution;
+	float half_extent = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		context.center[i] = 0.5f*(bvh.nodes[0].min[i] + bvh.nodes[0].max[i]);
+		half_extent = fmaxf(half_extent, 0.5f*(bvh.nodes[0].max[i] - bvh.nodes[0].min[i]));
+	}
+	context.half_extent = 1.1f*half_extent; // padding so the surface doesn't touch the border
+	if (context.half_extent <= 0.0f) context.half_extent = 1.0f;
+	size_t voxel_count = (size_t)bake->resolution*bake->resolution*bake->resolution;
+	context.distances = new float[voxel_count];
+	context.slices_done = &bake->slices_done;
+
+	job_queue.parallelFor(bake->resolution, bakeSdfSlice, &context);
+
+	bool written = writeVolFile(bake->volume_filepath, context.distances, bake->resolution);
+	delete [] context.distances;
+	bvh.clear();
+	mesh.clear();
+
+	double ms = 1000.0 * (double)(SDL_GetPerformanceCounter() - begin_ticks)
+		/ (double)SDL_GetPerformanceFrequency();
+	LOGI("Baked %d^3 SDF of '%s' in %.0f ms", bake->resolution, bake->mesh_filepath, ms);
+	if (!written) LOGE("Could not write '%s'", bake->volume_filepath);
+	if (!SDL_AtomicCAS(&bake->state, MSBS_BAKING, written ? MSBS_BAKED : MSBS_FAILED)) {
+		delete bake; // abandoned while baking
+	}
+}
+
+void MeshSdfBake::release() {
+	// if the job is still running it has to delete the bake when it's done
+	if (SDL_AtomicCAS(&state, MSBS_BAKING, MSBS_ABANDONED)) return;
+	delete this;
+}
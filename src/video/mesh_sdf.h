@@ -0,0 +1,34 @@
+// Bakes a signed distance field of a triangle mesh (Wavefront OBJ or
+// Quake MDL, first frame) into a 3D texture.
+// The mesh is fit into [-1, 1]^3 (keeping aspect ratio, with some padding)
+// and distances are stored in those units, so a shader samples it as
+//   float d = texture3D(u_sdf, 0.5*p + 0.5).r;
+// Results are cached as .vol files next to the decoded texture cache.
+bool isMeshFile(const char *filepath); // by extension
+
+enum MeshSdfBakeState {
+	MSBS_BAKING,
+	MSBS_BAKED, // volume_filepath is ready to be streamed
+	MSBS_FAILED,
+	MSBS_ABANDONED // owner lost interest, the job cleans up
+};
+
+// heap allocated since the owner may let go of it while a bake is running
+struct MeshSdfBake {
+	SDL_atomic_t state = {MSBS_BAKING}; // MeshSdfBakeState
+	SDL_atomic_t slices_done = {0}; // progress
+	int resolution = 0;
+	char volume_filepath[1024]; // baked or cached result
+
+	// state is MSBS_BAKED right away if the result is cached, otherwise
+	// bakes on the job queue. false if the mesh file can't be read
+	bool start(const char *mesh_filepath, const char *cache_dirpath, int grid_resolution);
+	float getProgress() {return resolution ? (float)SDL_AtomicGet(&slices_done)/(float)resolution : 0.0f;}
+	void release(); // instead of delete
+
+private:
+	char *mesh_filepath = nullptr;
+
+	~MeshSdfBake() {if (mesh_filepath) delete [] mesh_filepath;}
+	static void bakeJob(void *data);
+};
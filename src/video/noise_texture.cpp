@@ -0,0 +1,456 @@
+static const u32 noise_texture_version = 1; // bump when the output changes
+
+const char *noise_type_names[NT_COUNT] = {"Value", "Perlin", "Worley", "Blue Noise"};
+
+bool isNoiseFile(const char *filepath) {
+	const char *suffix = ".noise.vol";
+	size_t len = strlen(filepath), suffix_len = strlen(suffix);
+	return len >= suffix_len && !strcmp(filepath + len - suffix_len, suffix);
+}
+
+static inline u32 hashU32(u32 x) {
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+// lattice coordinates are wrapped by the caller, which makes the noise tile
+static inline u32 hashLattice(u32 seed, int x, int y, int z) {
+	return hashU32((u32)x + hashU32((u32)y + hashU32((u32)z + seed)));
+}
+
+static inline float hashToUnit(u32 h) {
+	return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline float fade(float t) {
+	return t*t*t*(t*(t*6.0f - 15.0f) + 10.0f);
+}
+
+static inline float lerp(float a, float b, float t) {
+	return a + t*(b - a);
+}
+
+static inline int wrap(int i, int period) {
+	return i >= period ? i - period : i;
+}
+
+static float valueNoise(u32 seed, float x, float y, float z, int period, bool is_3d) {
+	int ix = (int)x, iy = (int)y, iz = (int)z; // positive coordinates only
+	float tx = fade(x - ix), ty = fade(y - iy), tz = fade(z - iz);
+	int x0 = ix % period, y0 = iy % period, z0 = is_3d ? iz % period : 0;
+	int x1 = wrap(x0+1, period), y1 = wrap(y0+1, period), z1 = is_3d ? wrap(z0+1, period) : 0;
+	float v00 = lerp(hashToUnit(hashLattice(seed, x0, y0, z0)), hashToUnit(hashLattice(seed, x1, y0, z0)), tx);
+	float v10 = lerp(hashToUnit(hashLattice(seed, x0, y1, z0)), hashToUnit(hashLattice(seed, x1, y1, z0)), tx);
+	float v0 = lerp(v00, v10, ty);
+	if (!is_3d) return v0;
+	float v01 = lerp(hashToUnit(hashLattice(seed, x0, y0, z1)), hashToUnit(hashLattice(seed, x1, y0, z1)), tx);
+	float v11 = lerp(hashToUnit(hashLattice(seed, x0, y1, z1)), hashToUnit(hashLattice(seed, x1, y1, z1)), tx);
+	return lerp(v0, lerp(v01, v11, ty), tz);
+}
+
+static inline float gradient2D(u32 h, float x, float y) {
+	static const float g[8][2] = {
+		{1.0f, 0.0f}, {-1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, -1.0f},
+		{0.70710678f, 0.70710678f}, {-0.70710678f, 0.70710678f},
+		{0.70710678f, -0.70710678f}, {-0.70710678f, -0.70710678f}
+	};
+	const float *gi = g[h >> 29];
+	return gi[0]*x + gi[1]*y;
+}
+
+static inline float gradient3D(u32 h, float x, float y, float z) {
+	// the 12 cube edge directions of improved perlin noise, 4 repeated
+	switch ((h >> 28) & 15) {
+		case  0: case 12: return  x + y;
+		case  1: case 13: return -x + y;
+		case  2:          return  x - y;
+		case  3:          return -x - y;
+		case  4:          return  x + z;
+		case  5: case 15: return -x + z;
+		case  6:          return  x - z;
+		case  7:          return -x - z;
+		case  8:          return  y + z;
+		case  9: case 14: return -y + z;
+		case 10:          return  y - z;
+		default:          return -y - z;
+	}
+}
+
+// returns [-1, 1]
+static float perlinNoise(u32 seed, float x, float y, float z, int period, bool is_3d) {
+	int ix = (int)x, iy = (int)y, iz = (int)z;
+	float fx = x - ix, fy = y - iy, fz = z - iz;
+	float tx = fade(fx), ty = fade(fy), tz = fade(fz);
+	int x0 = ix % period, y0 = iy % period;
+	int x1 = wrap(x0+1, period), y1 = wrap(y0+1, period);
+	if (!is_3d) {
+		float n00 = gradient2D(hashLattice(seed, x0, y0, 0), fx, fy);
+		float n10 = gradient2D(hashLattice(seed, x1, y0, 0), fx - 1.0f, fy);
+		float n01 = gradient2D(hashLattice(seed, x0, y1, 0), fx, fy - 1.0f);
+		float n11 = gradient2D(hashLattice(seed, x1, y1, 0), fx - 1.0f, fy - 1.0f);
+		return 1.41421356f * lerp(lerp(n00, n10, tx), lerp(n01, n11, tx), ty);
+	}
+	int z0 = iz % period, z1 = wrap(z0+1, period);
+	float n000 = gradient3D(hashLattice(seed, x0, y0, z0), fx, fy, fz);
+	float n100 = gradient3D(hashLattice(seed, x1, y0, z0), fx - 1.0f, fy, fz);
+	float n010 = gradient3D(hashLattice(seed, x0, y1, z0), fx, fy - 1.0f, fz);
+	float n110 = gradient3D(hashLattice(seed, x1, y1, z0), fx - 1.0f, fy - 1.0f, fz);
+	float n001 = gradient3D(hashLattice(seed, x0, y0, z1), fx, fy, fz - 1.0f);
+	float n101 = gradient3D(hashLattice(seed, x1, y0, z1), fx - 1.0f, fy, fz - 1.0f);
+	float n011 = gradient3D(hashLattice(seed, x0, y1, z1), fx, fy - 1.0f, fz - 1.0f);
+	float n111 = gradient3D(hashLattice(seed, x1, y1, z1), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+	float n0 = lerp(lerp(n000, n100, tx), lerp(n010, n110, tx), ty);
+	float n1 = lerp(lerp(n001, n101, tx), lerp(n011, n111, tx), ty);
+	return lerp(n0, n1, tz);
+}
+
+// distance to the closest of one jittered feature point per cell, in cell units
+static float worleyNoise(u32 seed, float x, float y, float z, int period, bool is_3d) {
+	int ix = (int)x, iy = (int)y, iz = (int)z;
+	float fx = x - ix, fy = y - iy, fz = z - iz;
+	int dz_range = is_3d ? 1 : 0;
+	float closest = 8.0f;
+	for (int dz = -dz_range; dz <= dz_range; dz++) {
+		int cz = is_3d ? (iz + dz + period) % period : 0;
+		for (int dy = -1; dy <= 1; dy++) {
+			int cy = (iy + dy + period) % period;
+			for (int dx = -1; dx <= 1; dx++) {
+				int cx = (ix + dx + period) % period;
+				u32 h = hashLattice(seed, cx, cy, cz);
+				float px = dx + hashToUnit(h) - fx;
+				float py = dy + hashToUnit(hashU32(h)) - fy;
+				float pz = is_3d ? dz + hashToUnit(hashU32(h ^ 0x9e3779b9)) - fz : 0.0f;
+				float d = px*px + py*py + pz*pz;
+				if (d < closest) closest = d;
+			}
+		}
+	}
+	return sqrtf(closest);
+}
+
+void NoiseBake::valueRow(void *data, int row) {
+	NoiseBake *bake = (NoiseBake*)data;
+	const NoiseParams &p = bake->params;
+	bool is_3d = p.dimensions == 3;
+	int y = row % p.size, z = row / p.size;
+	u8 *out = bake->texels + (size_t)row*p.size;
+	for (int x = 0; x < p.size; x++) {
+		float sum = 0.0f, amplitude = 1.0f, amplitude_sum = 0.0f;
+		int period = p.period;
+		int octave_count = p.type == NT_WORLEY ? 1 : p.octaves;
+		for (int o = 0; o < octave_count; o++) {
+			float scale = (float)period / (float)p.size;
+			float sx = (x + 0.5f)*scale, sy = (y + 0.5f)*scale, sz = (z + 0.5f)*scale;
+			u32 seed = hashU32(p.seed + o);
+			float n;
+			switch (p.type) {
+				case NT_VALUE:  n = valueNoise(seed, sx, sy, sz, period, is_3d); break;
+				case NT_PERLIN: n = 0.5f + 0.5f*perlinNoise(seed, sx, sy, sz, period, is_3d); break;
+				default:        n = worleyNoise(seed, sx, sy, sz, period, is_3d); break;
+			}
+			sum += amplitude*n;
+			amplitude_sum += amplitude;
+			amplitude *= 0.5f;
+			period *= 2; // doubling the period keeps every octave tileable
+		}
+		float v = sum / amplitude_sum;
+		v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+		out[x] = (u8)(v*255.0f + 0.5f);
+	}
+	if (!is_3d || y == p.size-1) SDL_AtomicAdd(&bake->rows_done, 1); // rows or slices
+}
+
+// void-and-cluster (Ulichney 1993). The energy of a pixel is the gaussian
+// weighted sum of the set pixels around it (on the torus, so the result tiles).
+// The tightest cluster is the set pixel with the highest energy, the largest
+// void the empty pixel with the lowest. Searching for those is O(N) per rank,
+// so it's vectorized and split across the job queue.
+static const float blue_noise_sigma = 1.5f;
+static const int blue_noise_kernel_radius = 6; // exp(-r^2/(2 sigma^2)) < 4e-4 beyond
+
+struct BlueNoiseSearch {
+	const float *energy;
+	const u32 *mask; // ~0 for set pixels
+	u32 want_mask;
+	float sign; // -1 to search for the maximum
+	int pixel_count;
+	int chunk_count;
+	float chunk_values[64];
+	int chunk_indices[64];
+};
+
+// minimum of sign*energy over the pixels whose mask equals want_mask in [begin, end).
+// on ties the lowest index wins, so the result doesn't depend on the chunking
+static void searchBlueNoiseRange(const BlueNoiseSearch *s, int begin, int end, float *out_value, int *out_index) {
+	float best_value = FLT_MAX;
+	int best_index = -1;
+	int i = begin;
+#ifdef USE_SSE2
+	__m128 best4 = _mm_set1_ps(FLT_MAX);
+	__m128i best_index4 = _mm_set1_epi32(-1);
+	__m128i index4 = _mm_setr_epi32(begin, begin+1, begin+2, begin+3);
+	const __m128i four = _mm_set1_epi32(4);
+	const __m128i want4 = _mm_set1_epi32((int)s->want_mask);
+	const __m128 sign4 = _mm_set1_ps(s->sign);
+	const __m128 max4 = _mm_set1_ps(FLT_MAX);
+	for (; i + 4 <= end; i += 4) {
+		__m128 e = _mm_mul_ps(_mm_loadu_ps(s->energy + i), sign4);
+		__m128 selected = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(s->mask + i)), want4));
+		__m128 v = _mm_or_ps(_mm_and_ps(selected, e), _mm_andnot_ps(selected, max4));
+		__m128i less = _mm_castps_si128(_mm_cmplt_ps(v, best4));
+		best4 = _mm_min_ps(v, best4);
+		best_index4 = _mm_or_si128(_mm_and_si128(less, index4), _mm_andnot_si128(less, best_index4));
+		index4 = _mm_add_epi32(index4, four);
+	}
+	float lane_values[4];
+	s32 lane_indices[4];
+	_mm_storeu_ps(lane_values, best4);
+	_mm_storeu_si128((__m128i*)lane_indices, best_index4);
+	for (int lane = 0; lane < 4; lane++) {
+		if (lane_indices[lane] < 0) continue;
+		if (lane_values[lane] < best_value || (lane_values[lane] == best_value && lane_indices[lane] < best_index)) {
+			best_value = lane_values[lane];
+			best_index = lane_indices[lane];
+		}
+	}
+#endif
+	for (; i < end; i++) {
+		if (s->mask[i] != s->want_mask) continue;
+		float v = s->sign * s->energy[i];
+		if (v < best_value || (v == best_value && i < best_index)) {
+			best_value = v;
+			best_index = i;
+		}
+	}
+	*out_value = best_value;
+	*out_index = best_index;
+}
+
+static void searchBlueNoiseChunk(void *data, int chunk) {
+	BlueNoiseSearch *s = (BlueNoiseSearch*)data;
+	int chunk_size = (s->pixel_count / s->chunk_count + 3) & ~3;
+	int begin = chunk*chunk_size;
+	int end = chunk == s->chunk_count-1 ? s->pixel_count : begin + chunk_size;
+	if (end > s->pixel_count) end = s->pixel_count;
+	if (begin > end) begin = end;
+	searchBlueNoiseRange(s, begin, end, s->chunk_values + chunk, s->chunk_indices + chunk);
+}
+
+static int searchBlueNoise(BlueNoiseSearch *s, u32 want_mask, float sign) {
+	s->want_mask = want_mask;
+	s->sign = sign;
+	float best_value;
+	int best_index;
+	if (s->chunk_count == 1) {
+		searchBlueNoiseRange(s, 0, s->pixel_count, &best_value, &best_index);
+		return best_index;
+	}
+	job_queue.parallelFor(s->chunk_count, searchBlueNoiseChunk, s);
+	best_value = FLT_MAX;
+	best_index = -1;
+	for (int c = 0; c < s->chunk_count; c++) {
+		if (s->chunk_indices[c] < 0) continue;
+		// chunks are in index order, so strictly less keeps the lowest index on ties
+		if (s->chunk_values[c] < best_value) {
+			best_value = s->chunk_values[c];
+			best_index = s->chunk_indices[c];
+		}
+	}
+	return best_index;
+}
+
+static void splatBlueNoiseEnergy(float *energy, const float *kernel, int size, int pixel, float weight) {
+	int r = blue_noise_kernel_radius, kernel_size = 2*r + 1;
+	int px = pixel % size, py = pixel / size;
+	for (int ky = 0; ky < kernel_size; ky++) {
+		int y = ((py + ky - r) % size + size) % size;
+		float *row = energy + (size_t)y*size;
+		const float *kernel_row = kernel + ky*kernel_size;
+		for (int kx = 0; kx < kernel_size; kx++) {
+			int x = ((px + kx - r) % size + size) % size;
+			row[x] += weight*kernel_row[kx];
+		}
+	}
+}
+
+void NoiseBake::generateBlueNoise() {
+	int size = params.size;
+	int pixel_count = size*size;
+	int r = blue_noise_kernel_radius, kernel_size = 2*r + 1;
+	float kernel[(2*blue_noise_kernel_radius+1)*(2*blue_noise_kernel_radius+1)];
+	for (int ky = 0; ky < kernel_size; ky++) {
+		for (int kx = 0; kx < kernel_size; kx++) {
+			float dx = (float)(kx - r), dy = (float)(ky - r);
+			kernel[ky*kernel_size + kx] = expf(-(dx*dx + dy*dy) / (2.0f*blue_noise_sigma*blue_noise_sigma));
+		}
+	}
+
+	float *energy = new float[pixel_count];
+	float *prototype_energy = new float[pixel_count];
+	u32 *mask = new u32[pixel_count];
+	u32 *prototype_mask = new u32[pixel_count];
+	u32 *ranks = new u32[pixel_count];
+	memset(energy, 0, pixel_count*sizeof(float));
+	memset(mask, 0, pixel_count*sizeof(u32));
+
+	BlueNoiseSearch search;
+	search.energy = energy;
+	search.mask = mask;
+	search.pixel_count = pixel_count;
+	search.chunk_count = 1;
+	if (pixel_count >= 64*64) { // below that the fork/join costs more than it saves
+		search.chunk_count = job_queue.getThreadCount() + 1;
+		if (search.chunk_count > (int)ARRAY_COUNT(search.chunk_values)) search.chunk_count = ARRAY_COUNT(search.chunk_values);
+	}
+
+	// initial binary pattern: 10% white noise
+	int set_count = pixel_count / 10;
+	if (set_count < 1) set_count = 1;
+	u32 h = hashU32(params.seed);
+	for (int placed = 0; placed < set_count;) {
+		h = hashU32(h + 0x9e3779b9);
+		int i = (int)(h % (u32)pixel_count);
+		if (mask[i]) continue;
+		mask[i] = ~0u;
+		splatBlueNoiseEnergy(energy, kernel, size, i, 1.0f);
+		placed++;
+	}
+
+	// relax it: move the tightest cluster into the largest void until they coincide
+	for (int iteration = 0; iteration < pixel_count; iteration++) {
+		int cluster = searchBlueNoise(&search, ~0u, -1.0f);
+		mask[cluster] = 0;
+		splatBlueNoiseEnergy(energy, kernel, size, cluster, -1.0f);
+		int void_index = searchBlueNoise(&search, 0, 1.0f);
+		mask[void_index] = ~0u;
+		splatBlueNoiseEnergy(energy, kernel, size, void_index, 1.0f);
+		if (void_index == cluster) break;
+	}
+	memcpy(prototype_energy, energy, pixel_count*sizeof(float));
+	memcpy(prototype_mask, mask, pixel_count*sizeof(u32));
+
+	int ranks_done = 0;
+	// phase 1: remove the tightest clusters of the prototype, highest rank first
+	for (int rank = set_count-1; rank >= 0; rank--) {
+		int cluster = searchBlueNoise(&search, ~0u, -1.0f);
+		mask[cluster] = 0;
+		splatBlueNoiseEnergy(energy, kernel, size, cluster, -1.0f);
+		ranks[cluster] = (u32)rank;
+		if ((++ranks_done % size) == 0) SDL_AtomicAdd(&rows_done, 1);
+	}
+	// phase 2 and 3: fill the largest voids. the tightest cluster of empty pixels
+	// is the empty pixel with the lowest energy, so the same search covers both
+	memcpy(energy, prototype_energy, pixel_count*sizeof(float));
+	memcpy(mask, prototype_mask, pixel_count*sizeof(u32));
+	for (int rank = set_count; rank < pixel_count; rank++) {
+		if (SDL_AtomicGet(&state) == NBS_ABANDONED) break; // nobody is waiting for it anymore
+		int void_index = searchBlueNoise(&search, 0, 1.0f);
+		mask[void_index] = ~0u;
+		splatBlueNoiseEnergy(energy, kernel, size, void_index, 1.0f);
+		ranks[void_index] = (u32)rank;
+		if ((++ranks_done % size) == 0) SDL_AtomicAdd(&rows_done, 1);
+	}
+
+	for (int i = 0; i < pixel_count; i++) {
+		texels[i] = (u8)(((u64)ranks[i] * 256) / (u64)pixel_count);
+	}
+
+	delete [] energy;
+	delete [] prototype_energy;
+	delete [] mask;
+	delete [] prototype_mask;
+	delete [] ranks;
+}
+
+static bool writeNoiseVolFile(const char *filepath, const u8 *data, int size, int depth) {
+	char tmp_filepath[1024+4];
+	snprintf(tmp_filepath, sizeof(tmp_filepath), "%s.tmp", filepath);
+	FILE *file = fopen(tmp_filepath, "wb");
+	if (!file) return false;
+	u8 header[48] = {'V', 'O', 'L', 3};
+	s32 header_ints[5] = {3, size, size, depth, 1}; // uint8, xyz, channels
+	float bbox[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+	memcpy(header+4, header_ints, sizeof(header_ints));
+	memcpy(header+24, bbox, sizeof(bbox));
+	fwrite(header, 1, sizeof(header), file);
+	size_t count = (size_t)size*size*depth;
+	bool written = fwrite(data, 1, count, file) == count;
+	fclose(file);
+	if (!written) {
+		remove(tmp_filepath);
+		return false;
+	}
+	remove(filepath); // rename doesn't overwrite on windows
+	return !rename(tmp_filepath, filepath);
+}
+
+void NoiseBake::start(const NoiseParams &noise_params, const char *cache_dirpath) {
+	params = noise_params;
+	// canonical parameters, so equal textures share a cache entry
+	if (params.type < 0 || params.type >= NT_COUNT) params.type = NT_PERLIN;
+	if (params.type == NT_BLUE) params.dimensions = 2;
+	if (params.dimensions != 3) params.dimensions = 2;
+	int max_size = params.type == NT_BLUE ? 256 : (params.dimensions == 3 ? 256 : 4096);
+	params.size = params.size < 4 ? 4 : (params.size > max_size ? max_size : params.size);
+	if (params.type == NT_BLUE) {
+		params.period = 0;
+		params.octaves = 0;
+	} else {
+		params.period = params.period < 1 ? 1 : (params.period > params.size ? params.size : params.period);
+		params.octaves = params.octaves < 1 ? 1 : (params.octaves > 8 ? 8 : params.octaves);
+		if (params.type == NT_WORLEY) params.octaves = 1;
+	}
+
+	row_count = params.size; // rows, slices or size ranks at a time for blue noise
+	SDL_AtomicSet(&rows_done, 0);
+	u64 key = hashBytes(&params, sizeof(params), noise_texture_version);
+	snprintf(volume_filepath, sizeof(volume_filepath), "%s%016llx.noise.vol",
+		cache_dirpath ? cache_dirpath : "", (unsigned long long)key);
+
+	if (MappedFile::getFileSize(volume_filepath)) { // generated before
+		SDL_AtomicSet(&rows_done, row_count);
+		SDL_AtomicSet(&state, NBS_BAKED);
+		return;
+	}
+
+	SDL_AtomicSet(&state, NBS_BAKING);
+	job_queue.push(bakeJob, this);
+}
+
+void NoiseBake::bakeJob(void *data) {
+	NoiseBake *bake = (NoiseBake*)data;
+	const NoiseParams &p = bake->params;
+	u64 begin_ticks = SDL_GetPerformanceCounter();
+
+	int depth = p.dimensions == 3 ? p.size : 1;
+	bake->texels = new u8[(size_t)p.size*p.size*depth];
+	if (p.type == NT_BLUE) {
+		bake->generateBlueNoise();
+	} else {
+		job_queue.parallelFor(p.size*depth, valueRow, bake);
+	}
+
+	bool written = false;
+	if (SDL_AtomicGet(&bake->state) == NBS_BAKING) {
+		written = writeNoiseVolFile(bake->volume_filepath, bake->texels, p.size, depth);
+		double ms = 1000.0 * (double)(SDL_GetPerformanceCounter() - begin_ticks)
+			/ (double)SDL_GetPerformanceFrequency();
+		LOGI("Generated %d^%d %s texture in %.0f ms", p.size, p.dimensions, noise_type_names[p.type], ms);
+		if (!written) LOGE("Could not write '%s'", bake->volume_filepath);
+	}
+	delete [] bake->texels;
+	bake->texels = nullptr;
+	if (!SDL_AtomicCAS(&bake->state, NBS_BAKING, written ? NBS_BAKED : NBS_FAILED)) {
+		delete bake; // abandoned while generating
+	}
+}
+
+void NoiseBake::release() {
+	// if the job is still running it has to delete the bake when it's done
+	if (SDL_AtomicCAS(&state, NBS_BAKING, NBS_ABANDONED)) return;
+	delete this;
+}
@@ -0,0 +1,52 @@
+// Tileable noise lookup textures, so shaders can fetch noise instead of
+// computing hashes and gradients per pixel. Generated on the job queue and
+// cached by parameters as 8 bit .vol files in the texture cache.
+enum NoiseType {
+	NT_VALUE,
+	NT_PERLIN,
+	NT_WORLEY, // F1 cellular
+	NT_BLUE, // void-and-cluster threshold map, 2D only
+	NT_COUNT
+};
+
+struct NoiseParams {
+	s32 type = NT_PERLIN; // NoiseType
+	s32 dimensions = 2; // 2 or 3
+	s32 size = 256; // texels per side
+	s32 period = 8; // lattice cells per side of the tile (first octave)
+	s32 octaves = 4; // fBm octaves for value and perlin noise
+	u32 seed = 1;
+};
+
+extern const char *noise_type_names[NT_COUNT];
+
+enum NoiseBakeState {
+	NBS_BAKING,
+	NBS_BAKED, // volume_filepath is ready
+	NBS_FAILED,
+	NBS_ABANDONED // owner lost interest, the job cleans up
+};
+
+bool isNoiseFile(const char *filepath); // generated noise tiles, should use GL_REPEAT
+
+// heap allocated since the owner may let go of it while it is running
+struct NoiseBake {
+	SDL_atomic_t state = {NBS_BAKING}; // NoiseBakeState
+	SDL_atomic_t rows_done = {0}; // progress
+	int row_count = 1;
+	NoiseParams params;
+	char volume_filepath[1024];
+
+	// state is NBS_BAKED right away if the result is cached, otherwise generates on the job queue
+	void start(const NoiseParams &noise_params, const char *cache_dirpath);
+	float getProgress() {return (float)SDL_AtomicGet(&rows_done)/(float)row_count;}
+	void release(); // instead of delete
+
+private:
+	u8 *texels = nullptr;
+
+	~NoiseBake() {if (texels) delete [] texels;}
+	static void bakeJob(void *data);
+	static void valueRow(void *data, int row);
+	void generateBlueNoise();
+};
@@ -0,0 +1,349 @@
+struct BuiltinCost {
+	const char *name;
+	float alu, transcendental;
+};
+
+// rough weights, in the spirit of what drivers expand these to
+static const BuiltinCost builtin_costs[] = {
+	{"abs", 1, 0}, {"sign", 1, 0}, {"floor", 1, 0}, {"ceil", 1, 0}, {"fract", 1, 0},
+	{"mod", 2, 0}, {"min", 1, 0}, {"max", 1, 0}, {"clamp", 2, 0}, {"mix", 3, 0},
+	{"step", 1, 0}, {"smoothstep", 6, 0}, {"radians", 1, 0}, {"degrees", 1, 0},
+	{"dot", 1, 0}, {"cross", 2, 0}, {"length", 1, 1}, {"distance", 2, 1}, {"normalize", 2, 1},
+	{"reflect", 3, 0}, {"refract", 6, 1}, {"faceforward", 2, 0}, {"matrixCompMult", 1, 0},
+	{"dFdx", 1, 0}, {"dFdy", 1, 0}, {"fwidth", 3, 0},
+	{"sqrt", 0, 1}, {"inversesqrt", 0, 1}, {"exp", 0, 1}, {"exp2", 0, 1}, {"log", 0, 1}, {"log2", 0, 1},
+	{"pow", 1, 2}, {"sin", 0, 1}, {"cos", 0, 1}, {"tan", 1, 2}, {"asin", 2, 2}, {"acos", 2, 2}, {"atan", 2, 2}
+};
+
+static const char *cost_operators[] = {
+	"+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "&&", "||", "^^", "!", "?",
+	"+=", "-=", "*=", "/=", "%=", "++", "--", "<<", ">>", "&", "|", "^", "~"
+};
+
+static void addCost(ShaderCost *io_cost, const ShaderCost &cost, float factor) {
+	io_cost->alu += factor*cost.alu;
+	io_cost->transcendental += factor*cost.transcendental;
+	io_cost->fetches += factor*cost.fetches;
+}
+
+void ShaderCostEstimate::clear() {
+	if (source) {delete [] source; source = nullptr;}
+	if (tokens) {delete [] tokens; tokens = nullptr;}
+	if (functions) {delete [] functions; functions = nullptr;}
+	if (loops) {delete [] loops; loops = nullptr;}
+	token_count = function_count = loop_count = 0;
+	per_pixel = ShaderCost();
+	max_loop_depth = unknown_loop_count = 0;
+	has_main = false;
+}
+
+void ShaderCostEstimate::setSource(const char *src) {
+	clear();
+	source = new char[strlen(src)+1];
+	strcpy(source, src);
+	token_count = tokenizeGlsl(source, &tokens);
+
+	// function definitions: name ( ... ) { at the top level
+	functions = new ShaderCostFunction[token_count > 0 ? token_count : 1];
+	loops = new ShaderCostLoop[token_count > 0 ? token_count : 1];
+	for (int i = 0; i < token_count; i++) {
+		if (tokens[i].is("{")) { // struct or stray block
+			i = findClosingGlslBracket(tokens, token_count, i);
+			continue;
+		}
+		if (tokens[i].type != GTT_IDENTIFIER) continue;
+		int open = skipGlslSpace(tokens, token_count, i+1);
+		if (open == token_count || !tokens[open].is("(")) continue;
+		int close = findClosingGlslBracket(tokens, token_count, open);
+		int body = skipGlslSpace(tokens, token_count, close+1);
+		if (body >= token_count || !tokens[body].is("{")) {
+			i = close < token_count ? close : i; // prototype or initializer
+			continue;
+		}
+		ShaderCostFunction *function = functions + function_count++;
+		memset(function, 0, sizeof(*function));
+		int name_length = tokens[i].length < (int)sizeof(function->name) ? tokens[i].length : (int)sizeof(function->name)-1;
+		memcpy(function->name, tokens[i].text, name_length);
+		function->name[name_length] = '\0';
+		function->body_begin = body;
+		function->body_end = findClosingGlslBracket(tokens, token_count, body);
+		i = function->body_end;
+	}
+	is_dirty = true;
+}
+
+void ShaderCostEstimate::update(ShaderUniform *uniforms, int uniform_count) {
+	if (!tokens) return;
+	u64 hash = hashBytes(&unknown_trip_count, sizeof(unknown_trip_count));
+	for (int i = 0; i < uniform_count; i++) {
+		if (uniforms[i].type == GL_INT || uniforms[i].type == GL_FLOAT) {
+			hash = hashBytes(uniforms[i].data, uniforms[i].getSize(), hash);
+		}
+	}
+	if (!is_dirty && hash == inputs_hash) return;
+	inputs_hash = hash;
+	is_dirty = false;
+	frozen_uniforms = uniforms;
+	frozen_uniform_count = uniform_count;
+	estimate();
+	frozen_uniforms = nullptr;
+	frozen_uniform_count = 0;
+}
+
+void ShaderCostEstimate::estimate() {
+	loop_count = 0;
+	unknown_loop_count = 0;
+	per_pixel = ShaderCost();
+	max_loop_depth = 0;
+	has_main = false;
+	for (int fi = 0; fi < function_count; fi++) functions[fi].state = 0;
+	for (int fi = 0; fi < function_count; fi++) {
+		estimateFunction(fi);
+		if (!strcmp(functions[fi].name, "main")) {
+			has_main = true;
+			per_pixel = functions[fi].cost;
+			max_loop_depth = functions[fi].max_loop_depth;
+		}
+	}
+}
+
+void ShaderCostEstimate::estimateFunction(int function_index) {
+	ShaderCostFunction *function = functions + function_index;
+	if (function->state) return; // done, or a recursive call that won't compile anyway
+	function->state = 1;
+	int max_depth = 0;
+	ShaderCost cost = estimateRange(function->body_begin+1, function->body_end, function_index, 0, &max_depth);
+	function = functions + function_index;
+	function->cost = cost;
+	function->max_loop_depth = max_depth;
+	function->state = 2;
+}
+
+int ShaderCostEstimate::findFunction(const GlslToken *name) {
+	for (int fi = 0; fi < function_count; fi++) {
+		if (name->is(functions[fi].name)) return fi; // overloads share the first definition
+	}
+	return -1;
+}
+
+ShaderCost ShaderCostEstimate::estimateRange(int begin, int end, int function_index, int depth, int *io_max_depth) {
+	ShaderCost cost = {};
+	for (int i = begin; i < end; i++) {
+		const GlslToken *token = tokens + i;
+		if (token->type == GTT_OPERATOR) {
+			for (int oi = 0; oi < (int)ARRAY_COUNT(cost_operators); oi++) {
+				if (token->is(cost_operators[oi])) {
+					cost.alu += 1.0f;
+					break;
+				}
+			}
+			continue;
+		}
+		if (token->type != GTT_IDENTIFIER) continue;
+		if (token->is("for") || token->is("while") || token->is("do")) {
+			i = estimateLoop(i, end, function_index, depth, io_max_depth, &cost);
+			continue;
+		}
+		int next = skipGlslSpace(tokens, token_count, i+1);
+		if (next >= end || !tokens[next].is("(")) continue;
+		if (isGlslTextureFetch(token)) {
+			cost.fetches += 1.0f;
+			continue;
+		}
+		bool is_builtin = false;
+		for (int bi = 0; bi < (int)ARRAY_COUNT(builtin_costs); bi++) {
+			if (token->is(builtin_costs[bi].name)) {
+				cost.alu += builtin_costs[bi].alu;
+				cost.transcendental += builtin_costs[bi].transcendental;
+				is_builtin = true;
+				break;
+			}
+		}
+		if (is_builtin) continue;
+		int callee = findFunction(token);
+		if (callee >= 0 && callee != function_index) {
+			estimateFunction(callee);
+			addCost(&cost, functions[callee].cost, 1.0f);
+			if (depth + functions[callee].max_loop_depth > *io_max_depth) {
+				*io_max_depth = depth + functions[callee].max_loop_depth;
+			}
+		} // else a constructor, free
+	}
+	return cost;
+}
+
+int ShaderCostEstimate::findStatementEnd(int begin) {
+	if (begin < token_count && tokens[begin].is("{")) return findClosingGlslBracket(tokens, token_count, begin);
+	int depth = 0;
+	for (int i = begin; i < token_count; i++) {
+		if (tokens[i].is("(") || tokens[i].is("[") || tokens[i].is("{")) depth++;
+		else if (tokens[i].is(")") || tokens[i].is("]") || tokens[i].is("}")) depth--;
+		else if (depth == 0 && tokens[i].is(";")) return i;
+	}
+	return token_count-1;
+}
+
+int ShaderCostEstimate::estimateLoop(int loop_index, int end, int function_index, int depth,
+	int *io_max_depth, ShaderCost *io_cost) {
+	int header_open, header_close, body, body_end, loop_end;
+	const GlslToken *keyword = tokens + loop_index;
+	if (keyword->is("do")) {
+		body = skipGlslSpace(tokens, token_count, loop_index+1);
+		body_end = findStatementEnd(body);
+		int while_index = skipGlslSpace(tokens, token_count, body_end+1);
+		header_open = skipGlslSpace(tokens, token_count, while_index+1);
+		if (header_open >= end || !tokens[header_open].is("(")) return body_end;
+		header_close = findClosingGlslBracket(tokens, token_count, header_open);
+		loop_end = header_close;
+	} else {
+		header_open = skipGlslSpace(tokens, token_count, loop_index+1);
+		if (header_open >= end || !tokens[header_open].is("(")) return loop_index;
+		header_close = findClosingGlslBracket(tokens, token_count, header_open);
+		body = skipGlslSpace(tokens, token_count, header_close+1);
+		body_end = findStatementEnd(body);
+		loop_end = body_end;
+	}
+	if (header_close >= end || body_end >= end) return end; // unbalanced
+
+	ShaderCostLoop *loop = loops + loop_count++;
+	loop->line = keyword->line;
+	loop->depth = depth+1;
+	loop->function_index = function_index;
+	loop->uses_uniform = false;
+	loop->trip_count = keyword->is("for") ? estimateTripCount(header_open, header_close, &loop->uses_uniform) : -1.0f;
+	loop->has_break = false;
+	for (int i = body; i <= body_end; i++) loop->has_break |= tokens[i].is("break");
+	float trip_count = loop->trip_count;
+	if (trip_count < 0.0f) {
+		trip_count = (float)unknown_trip_count;
+		unknown_loop_count++;
+	}
+
+	if (depth+1 > *io_max_depth) *io_max_depth = depth+1;
+	ShaderCost iteration_cost = estimateRange(header_open+1, header_close, function_index, depth+1, io_max_depth);
+	ShaderCost body_cost = estimateRange(body, body_end+1, function_index, depth+1, io_max_depth);
+	addCost(&iteration_cost, body_cost, 1.0f);
+	addCost(io_cost, iteration_cost, trip_count);
+	return loop_end;
+}
+
+bool ShaderCostEstimate::getConstant(int token_index, float *out_value, bool *out_is_uniform) {
+	if (token_index >= token_count) return false;
+	const GlslToken *token = tokens + token_index;
+	if (token->is("-")) { // negative literal
+		bool is_uniform = false;
+		if (!getConstant(skipGlslSpace(tokens, token_count, token_index+1), out_value, &is_uniform)) return false;
+		*out_value = -*out_value;
+		*out_is_uniform |= is_uniform;
+		return true;
+	}
+	if (token->type == GTT_NUMBER) {
+		*out_value = token->length > 2 && (token->text[1] == 'x' || token->text[1] == 'X')
+			? (float)strtol(token->text, nullptr, 16) : (float)atof(token->text);
+		return true;
+	}
+	if (token->type != GTT_IDENTIFIER) return false;
+
+	for (int i = 0; i < frozen_uniform_count; i++) {
+		ShaderUniform *uniform = frozen_uniforms + i;
+		if (uniform->size != 1 || !token->is(uniform->name)) continue;
+		if (uniform->type == GL_INT) *out_value = (float)*(int*)uniform->data;
+		else if (uniform->type == GL_FLOAT) *out_value = *(float*)uniform->data;
+		else return false;
+		*out_is_uniform = true;
+		return true;
+	}
+	for (int i = 0; i < token_count; i++) {
+		if (tokens[i].type == GTT_PREPROCESSOR) { // #define NAME value
+			char name[64];
+			float value;
+			if (sscanf(tokens[i].text, " # define %63s %f", name, &value) == 2 && token->is(name)) {
+				*out_value = value;
+				return true;
+			}
+		} else if (tokens[i].is("const")) { // const type NAME = literal
+			int type = skipGlslSpace(tokens, token_count, i+1);
+			int name = skipGlslSpace(tokens, token_count, type+1);
+			int assign = skipGlslSpace(tokens, token_count, name+1);
+			int value = skipGlslSpace(tokens, token_count, assign+1);
+			if (value >= token_count || !tokens[assign].is("=")) continue;
+			if (tokens[name].length != token->length || strncmp(tokens[name].text, token->text, token->length)) continue;
+			if (tokens[value].type == GTT_NUMBER || tokens[value].is("-")) {
+				return getConstant(value, out_value, out_is_uniform);
+			}
+		}
+	}
+	return false;
+}
+
+static bool isSameGlslToken(const GlslToken *a, const GlslToken *b) {
+	return a->length == b->length && !strncmp(a->text, b->text, a->length);
+}
+
+// index after a constant of the significant header tokens s, a leading - is part of it
+int ShaderCostEstimate::endOfHeaderConstant(const int *s, int k) {
+	return tokens[s[k]].is("-") ? k+2 : k+1;
+}
+
+float ShaderCostEstimate::estimateTripCount(int open, int close, bool *out_uses_uniform) {
+	// significant tokens of the header: [type] i = A ; i < B ; i++
+	int *s = new int[close-open+1];
+	int n = 0;
+	for (int i = skipGlslSpace(tokens, token_count, open+1); i < close; i = skipGlslSpace(tokens, token_count, i+1)) {
+		s[n++] = i;
+	}
+	float trip_count = -1.0f;
+	float start, bound, step = 0.0f;
+	bool is_uniform = false;
+	int k = 0;
+	if (n > 0 && tokens[s[k]].type == GTT_IDENTIFIER && k+1 < n && tokens[s[k+1]].type == GTT_IDENTIFIER) k++; // type
+	int var = k;
+	int semicolon = var+3;
+	while (semicolon < n && !tokens[s[semicolon]].is(";")) semicolon++; // also skips - of a negative start
+	// constants have to end their clause, i < n * 2 is not a bound of n
+	if (semicolon + 4 < n && tokens[s[var+1]].is("=") && semicolon == endOfHeaderConstant(s, var+2)
+		&& getConstant(s[var+2], &start, &is_uniform)) {
+		const GlslToken *v = tokens + s[var];
+		int cond = semicolon+1;
+		const GlslToken *op = tokens + s[cond+1];
+		int cond_semicolon = cond;
+		while (cond_semicolon < n && !tokens[s[cond_semicolon]].is(";")) cond_semicolon++;
+		bool var_left = isSameGlslToken(tokens + s[cond], v);
+		bool var_right = !var_left && cond+2 < n && isSameGlslToken(tokens + s[cond+2], v);
+		char cmp[3] = {};
+		bool has_bound = false;
+		if (var_left && op->length <= 2 && cond_semicolon == endOfHeaderConstant(s, cond+2)) {
+			memcpy(cmp, op->text, op->length);
+			has_bound = getConstant(s[cond+2], &bound, &is_uniform);
+		} else if (var_right && op->length <= 2 && cond_semicolon == cond+3) { // B > i is i < B
+			memcpy(cmp, op->text, op->length);
+			if (cmp[0] == '<') cmp[0] = '>';
+			else if (cmp[0] == '>') cmp[0] = '<';
+			has_bound = getConstant(s[cond], &bound, &is_uniform);
+		}
+		int incr = cond_semicolon+1;
+		if (incr + 1 < n) {
+			const GlslToken *a = tokens + s[incr], *b = tokens + s[incr+1];
+			if ((isSameGlslToken(a, v) && b->is("++")) || (a->is("++") && isSameGlslToken(b, v))) step = 1.0f;
+			if ((isSameGlslToken(a, v) && b->is("--")) || (a->is("--") && isSameGlslToken(b, v))) step = -1.0f;
+			if (isSameGlslToken(a, v) && (b->is("+=") || b->is("-=")) && incr+2 < n
+				&& getConstant(s[incr+2], &step, &is_uniform)) {
+				if (b->is("-=")) step = -step;
+			}
+		}
+		if (has_bound && step != 0.0f) {
+			float span = (bound - start) / step; // iterations until the bound, if it's in the direction of step
+			bool is_known = true;
+			if (!strcmp(cmp, "<") && step > 0.0f) span = ceilf(span);
+			else if (!strcmp(cmp, "<=") && step > 0.0f) span = floorf(span) + 1.0f;
+			else if (!strcmp(cmp, ">") && step < 0.0f) span = ceilf(span);
+			else if (!strcmp(cmp, ">=") && step < 0.0f) span = floorf(span) + 1.0f;
+			else if (!strcmp(cmp, "!=") && span == floorf(span) && span >= 0.0f) {}
+			else is_known = false; // never ends, or not a bound we understand
+			if (is_known) trip_count = span > 0.0f ? span : 0.0f;
+		}
+	}
+	delete [] s;
+	if (trip_count >= 0.0f) *out_uses_uniform = is_uniform;
+	return trip_count;
+}
@@ -0,0 +1,63 @@
+// Static per pixel cost estimate of a fragment shader, from the tokens alone.
+// Operators count as one ALU op each regardless of vector width, builtin
+// functions have rough weights, user functions are expanded at their call
+// sites and loop bodies are multiplied by their trip count. Trip counts come
+// from for loops with constant bounds: literals, const variables, #defines
+// and int or float uniforms frozen at their current values.
+struct ShaderCost {
+	float alu;
+	float transcendental; // sin, exp, pow, sqrt, ...
+	float fetches;
+};
+
+struct ShaderCostLoop {
+	int line;
+	int depth; // 1 for the outermost loop of a function
+	int function_index;
+	float trip_count; // -1 if unknown
+	bool has_break; // trip_count is an upper bound
+	bool uses_uniform; // a bound is the current value of a uniform
+};
+
+struct ShaderCostFunction {
+	char name[64];
+	ShaderCost cost; // of one call, loops and calls expanded
+	int max_loop_depth; // callees included
+	int body_begin, body_end; // token indices of the braces
+	int state; // 0: not estimated, 1: in progress (recursion isn't allowed in GLSL), 2: done
+};
+
+struct ShaderCostEstimate {
+	ShaderCost per_pixel = {}; // cost of main()
+	int max_loop_depth = 0;
+	int unknown_loop_count = 0;
+	int unknown_trip_count = 16; // assumed for loops without constant bounds
+	bool has_main = false;
+	ShaderCostFunction *functions = nullptr;
+	int function_count = 0;
+	ShaderCostLoop *loops = nullptr;
+	int loop_count = 0;
+
+	void setSource(const char *src); // after every compile
+	void update(ShaderUniform *uniforms, int uniform_count); // estimates again if a uniform changed
+	void clear();
+
+private:
+	char *source = nullptr;
+	GlslToken *tokens = nullptr;
+	int token_count = 0;
+	u64 inputs_hash = 0;
+	bool is_dirty = false;
+	ShaderUniform *frozen_uniforms = nullptr; // of the current update
+	int frozen_uniform_count = 0;
+
+	void estimate();
+	ShaderCost estimateRange(int begin, int end, int function_index, int depth, int *io_max_depth);
+	int estimateLoop(int loop_index, int end, int function_index, int depth, int *io_max_depth, ShaderCost *io_cost);
+	void estimateFunction(int function_index);
+	int endOfHeaderConstant(const int *s, int k);
+	float estimateTripCount(int open, int close, bool *out_uses_uniform);
+	bool getConstant(int token_index, float *out_value, bool *out_is_uniform);
+	int findStatementEnd(int begin);
+	int findFunction(const GlslToken *name);
+};
@@ -0,0 +1,384 @@
+const char *heatmap_counter_names[HC_COUNT] = {"Total", "Loop iterations", "Texture fetches"};
+
+static const char *heatmap_globals =
+	"\nfloat _hm_loops = 0.0;\n"
+	"float _hm_fetches = 0.0;\n"
+	"float _hm_discarded = 0.0;\n";
+static const char *heatmap_main =
+	"\nvoid main() {\n"
+	"\t_hm_main();\n"
+	"\tgl_FragColor = vec4(_hm_loops, _hm_fetches, _hm_discarded, 1.0);\n"
+	"}\n";
+static const char *heatmap_loop_counter = " _hm_loops += 1.0;";
+
+// #version and #extension have to stay in front of the globals
+static bool isLeadingDirective(const GlslToken *token) {
+	const char *c = token->text + 1;
+	while (*c == ' ' || *c == '\t') c++;
+	return !strncmp(c, "version", 7) || !strncmp(c, "extension", 9);
+}
+
+char *instrumentShaderForHeatmap(const char *src, int *out_loop_count, int *out_fetch_count) {
+	*out_loop_count = 0;
+	*out_fetch_count = 0;
+	GlslToken *tokens;
+	int token_count = tokenizeGlsl(src, &tokens);
+	if (!token_count) return nullptr;
+
+	GlslRewriter rewriter;
+	rewriter.begin(tokens, token_count);
+	bool *is_do_while = new bool[token_count](); // while tokens ending a do loop with a braced body
+	bool has_main = false;
+	int main_body_end = -1; // discard in main() returns instead, so the pixel still shows its counts
+
+	int globals_index = -1; // after the last leading #version or #extension
+	for (int i = skipGlslSpace(tokens, token_count, 0); i < token_count;
+		i = skipGlslSpace(tokens, token_count, i+1)) {
+		if (tokens[i].type != GTT_PREPROCESSOR) break;
+		if (isLeadingDirective(tokens + i)) globals_index = i;
+		else if (tokens[i].length > 3 && !strncmp(tokens[i].text, "#if", 3)) break; // globals must not end up in a conditional
+	}
+	if (globals_index >= 0) rewriter.insertAfter(globals_index, heatmap_globals);
+	else rewriter.insertBefore(0, heatmap_globals);
+
+	for (int i = 0; i < token_count; i++) {
+		const GlslToken *token = tokens + i;
+		if (token->type != GTT_IDENTIFIER) continue;
+		int next = skipGlslSpace(tokens, token_count, i+1);
+		bool is_call = next < token_count && tokens[next].is("(");
+
+		if (token->is("main") && is_call) {
+			rewriter.replace(i, "_hm_main");
+			has_main = true;
+			int body = skipGlslSpace(tokens, token_count, findClosingGlslBracket(tokens, token_count, next)+1);
+			if (body < token_count && tokens[body].is("{")) main_body_end = findClosingGlslBracket(tokens, token_count, body);
+		} else if (token->is("discard") && i < main_body_end) {
+			rewriter.replace(i, "{ _hm_discarded = 1.0; return; }");
+		} else if (token->is("do")) {
+			if (next == token_count || !tokens[next].is("{")) continue; // counted at its while
+			int close = findClosingGlslBracket(tokens, token_count, next);
+			int while_index = skipGlslSpace(tokens, token_count, close+1);
+			if (while_index < token_count && tokens[while_index].is("while")) is_do_while[while_index] = true;
+			rewriter.insertAfter(next, heatmap_loop_counter);
+			(*out_loop_count)++;
+		} else if ((token->is("for") || token->is("while")) && is_call && !is_do_while[i]) {
+			int close = findClosingGlslBracket(tokens, token_count, next);
+			if (close == token_count) continue;
+			int body = skipGlslSpace(tokens, token_count, close+1);
+			if (body < token_count && tokens[body].is("{")) {
+				rewriter.insertAfter(body, heatmap_loop_counter);
+			} else if (token->is("for")) { // count increments
+				int semicolon_count = 0, depth = 0, increment = close;
+				for (int j = next+1; j < close; j++) {
+					if (tokens[j].is("(") || tokens[j].is("[") || tokens[j].is("{")) depth++;
+					if (tokens[j].is(")") || tokens[j].is("]") || tokens[j].is("}")) depth--;
+					if (depth == 0 && tokens[j].is(";") && ++semicolon_count == 2) {
+						increment = skipGlslSpace(tokens, token_count, j+1);
+						break;
+					}
+				}
+				rewriter.insertBefore(close, increment == close ? "_hm_loops += 1.0" : ", _hm_loops += 1.0");
+			} else { // count condition checks
+				rewriter.insertAfter(next, "(_hm_loops += 1.0) > 0.0 && (");
+				rewriter.insertBefore(close, ")");
+			}
+			(*out_loop_count)++;
+		} else if (is_call && isGlslTextureFetch(token)) {
+			int prev = skipGlslSpaceBackwards(tokens, i-1);
+			if (prev >= 0 && tokens[prev].is(".")) continue; // member
+			if (prev >= 0 && tokens[prev].type == GTT_IDENTIFIER && !tokens[prev].is("return")) continue; // declaration
+			int close = findClosingGlslBracket(tokens, token_count, next);
+			if (close == token_count) continue;
+			rewriter.insertBefore(i, "(_hm_fetches += 1.0, ");
+			rewriter.insertAfter(close, ")");
+			(*out_fetch_count)++;
+		}
+	}
+
+	char *instrumented = nullptr;
+	if (has_main) {
+		rewriter.insertBefore(token_count, heatmap_main);
+		instrumented = rewriter.write();
+	}
+	rewriter.end();
+	delete [] is_do_while;
+	delete [] tokens;
+	return instrumented;
+}
+
+static const vec3 heatmap_ramp[5] = {
+	{{0.0f, 0.0f, 0.3f}},
+	{{0.0f, 0.3f, 1.0f}},
+	{{0.0f, 0.9f, 0.4f}},
+	{{1.0f, 0.9f, 0.0f}},
+	{{1.0f, 0.1f, 0.0f}}
+};
+
+static float clamp01(float x) {
+	return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+}
+
+vec3 getHeatmapRampColor(float t) { // same as the ramp shader
+	t = 4.0f*clamp01(t);
+	vec3 color = heatmap_ramp[0];
+	for (int i = 1; i < 5; i++) {
+		float f = clamp01(t - (float)(i-1));
+		color = (1.0f - f)*color + f*heatmap_ramp[i];
+	}
+	return color;
+}
+
+static const char *heatmap_vert_src =
+	"attribute vec4 va_position;"
+	"void main() {gl_Position = va_position;}";
+
+static const char *heatmap_ramp_frag_src =
+	"uniform sampler2D u_counts;\n"
+	"uniform vec2 u_resolution;\n"
+	"uniform int u_counter;\n"
+	"uniform float u_range_max;\n"
+	"uniform vec3 u_ramp[5];\n"
+	"void main() {\n"
+	"	vec4 counts = texture2D(u_counts, gl_FragCoord.xy / u_resolution);\n"
+	"	if (counts.a == 0.0) { gl_FragColor = vec4(0.1, 0.1, 0.1, 1.0); return; } // not counted\n"
+	"	float count = u_counter == 1 ? counts.r : (u_counter == 2 ? counts.g : counts.r + counts.g);\n"
+	"	float t = 4.0 * clamp(count / u_range_max, 0.0, 1.0);\n"
+	"	vec3 color = u_ramp[0];\n"
+	"	color = mix(color, u_ramp[1], clamp(t, 0.0, 1.0));\n"
+	"	color = mix(color, u_ramp[2], clamp(t - 1.0, 0.0, 1.0));\n"
+	"	color = mix(color, u_ramp[3], clamp(t - 2.0, 0.0, 1.0));\n"
+	"	color = mix(color, u_ramp[4], clamp(t - 3.0, 0.0, 1.0));\n"
+	"	gl_FragColor = vec4(counts.b > 0.0 ? 0.5*color : color, 1.0); // darker if discarded\n"
+	"}\n";
+
+static char *copyString(const char *str) {
+	char *copy = new char[strlen(str)+1];
+	strcpy(copy, str);
+	return copy;
+}
+
+void ShaderHeatmap::compile(const char *src) {
+	if (compile_error_log) {
+		delete [] compile_error_log;
+		compile_error_log = nullptr;
+	}
+	if (inputs) {
+		delete [] inputs;
+		inputs = nullptr;
+	}
+	input_count = 0;
+	is_compiled = false;
+
+	if (!has_vertex_shaders) {
+		shader.compileAndAttach(GL_VERTEX_SHADER, heatmap_vert_src);
+		shader.bindVertexAttrib("va_position", VAT_POSITION);
+		ramp_shader.compileAndAttach(GL_VERTEX_SHADER, heatmap_vert_src);
+		ramp_shader.compileAndAttach(GL_FRAGMENT_SHADER, heatmap_ramp_frag_src);
+		ramp_shader.bindVertexAttrib("va_position", VAT_POSITION);
+		ramp_shader.link();
+		has_vertex_shaders = true;
+	}
+
+	char *instrumented_src = instrumentShaderForHeatmap(src, &loop_count, &fetch_count);
+	if (!instrumented_src) {
+		compile_error_log = copyString("There is no main() to instrument.");
+		return;
+	}
+	bool is_compiled_and_linked = false;
+	if (!shader.compileAndAttach(GL_FRAGMENT_SHADER, instrumented_src)) {
+		compile_error_log = shader.getShaderCompileErrorLog(GL_FRAGMENT_SHADER);
+	} else if (!shader.link()) {
+		compile_error_log = shader.getLinkErrorLog();
+	} else {
+		is_compiled_and_linked = true;
+	}
+	if (!is_compiled_and_linked) {
+		LOGW("Instrumented shader did not compile:\n%s", compile_error_log);
+		delete [] instrumented_src;
+		return;
+	}
+	delete [] instrumented_src;
+
+	// same uniforms as the main shader but other locations
+	GLint active_count = 0;
+	glGetProgramiv(shader.getProgram(), GL_ACTIVE_UNIFORMS, &active_count);
+	inputs = new ShaderUniform[active_count > 0 ? active_count : 1];
+	for (int i = 0; i < active_count; i++) {
+		ShaderUniform *input = inputs + input_count++;
+		GLsizei name_len;
+		glGetActiveUniform(shader.getProgram(), i, (GLsizei)sizeof(input->name),
+			&name_len, &input->size, &input->type, input->name);
+		input->location = shader.getUniformLocation(input->name);
+		input->data = nullptr;
+		input->flags = 0;
+	}
+	is_compiled = true;
+}
+
+void ShaderHeatmap::release() {
+	if (compile_error_log) {
+		delete [] compile_error_log;
+		compile_error_log = nullptr;
+	}
+	if (inputs) {
+		delete [] inputs;
+		inputs = nullptr;
+	}
+	input_count = 0;
+	is_compiled = false;
+	if (counts_texture) {
+		gpu_memory.untrack(GMK_TEXTURE, counts_texture);
+		glDeleteTextures(1, &counts_texture);
+		counts_texture = 0;
+	}
+	if (framebuffer) {
+		gpu_memory.untrack(GMK_FRAMEBUFFER, framebuffer);
+		glDeleteFramebuffers(1, &framebuffer);
+		framebuffer = 0;
+	}
+	if (pixel_buffer) {
+		gpu_memory.untrack(GMK_BUFFER, pixel_buffer);
+		glDeleteBuffers(1, &pixel_buffer);
+		pixel_buffer = 0;
+	}
+	readback_pending = false;
+	width = height = 0;
+	counted_pixel_count = 0;
+}
+
+Shader *ShaderHeatmap::beginCounting(int counts_width, int counts_height,
+	ShaderUniform *uniforms, int uniform_count) {
+	if (!is_compiled) return nullptr;
+
+	if (!framebuffer) {
+		glGenFramebuffers(1, &framebuffer);
+		gpu_memory.track(GMK_FRAMEBUFFER, framebuffer, 0); // storage is counts_texture
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	if (!counts_texture || counts_width != width || counts_height != height) {
+		if (!counts_texture) glGenTextures(1, &counts_texture);
+		glBindTexture(GL_TEXTURE_2D, counts_texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, counts_width, counts_height, 0, GL_RGBA, GL_FLOAT, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		gpu_memory.trackTexture(counts_texture, GL_TEXTURE_2D);
+		width = counts_width;
+		height = counts_height;
+		readback_pending = false; // has the old size
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, counts_texture, 0);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			LOGE("Heatmap framebuffer incomplete (0x%X), float render targets not supported?", status);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			release();
+			compile_error_log = copyString("Float render targets are not supported.");
+			return nullptr;
+		}
+	}
+
+	glGetIntegerv(GL_VIEWPORT, previous_viewport);
+	glViewport(0, 0, width, height);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // alpha 0: nothing counted
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_BLEND); // counts have to arrive as written
+
+	shader.use();
+	for (int i = 0; i < input_count; i++) {
+		ShaderUniform *input = inputs + i;
+		input->data = nullptr;
+		for (int j = 0; j < uniform_count; j++) {
+			ShaderUniform *uniform = uniforms + j;
+			if (uniform->type != input->type || uniform->size < input->size) continue;
+			if (strcmp(uniform->name, input->name)) continue;
+			input->data = uniform->data;
+			input->apply();
+			break;
+		}
+	}
+	return &shader;
+}
+
+void ShaderHeatmap::endCounting() {
+	glUseProgram(0);
+
+	// a readback from an earlier frame is done by now, otherwise start one every few frames
+	if (readback_pending) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
+		const float *counts = (const float*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+		if (counts) {
+			computeStats(counts, readback_width*readback_height);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		readback_pending = false;
+	} else if (++frames_since_readback >= 10) {
+		size_t size = (size_t)width*height*4*sizeof(float);
+		if (!pixel_buffer) glGenBuffers(1, &pixel_buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, (GLvoid*)0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		gpu_memory.track(GMK_BUFFER, pixel_buffer, size);
+		readback_width = width;
+		readback_height = height;
+		readback_pending = true;
+		frames_since_readback = 0;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+	glEnable(GL_BLEND);
+}
+
+void ShaderHeatmap::computeStats(const float *counts, int pixel_count) {
+	float min[HC_COUNT], max[HC_COUNT];
+	double sum[HC_COUNT] = {};
+	for (int c = 0; c < HC_COUNT; c++) {
+		min[c] = FLT_MAX;
+		max[c] = 0.0f;
+	}
+	int counted = 0;
+	for (int i = 0; i < pixel_count; i++, counts += 4) {
+		if (counts[3] == 0.0f) continue; // discarded outside of main()
+		float values[HC_COUNT] = {counts[0] + counts[1], counts[0], counts[1]};
+		for (int c = 0; c < HC_COUNT; c++) {
+			if (values[c] < min[c]) min[c] = values[c];
+			if (values[c] > max[c]) max[c] = values[c];
+			sum[c] += values[c];
+		}
+		counted++;
+	}
+	counted_pixel_count = counted;
+	for (int c = 0; c < HC_COUNT; c++) {
+		stats[c].min = counted ? min[c] : 0.0f;
+		stats[c].max = max[c];
+		stats[c].mean = counted ? (float)(sum[c] / counted) : 0.0f;
+	}
+}
+
+void ShaderHeatmap::draw(GLuint triangle_vbo) {
+	if (!is_compiled || !counts_texture) return;
+	float max = auto_range ? stats[counter].max : range_max;
+	if (max < 1.0f) max = 1.0f;
+
+	ramp_shader.use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, counts_texture);
+	glUniform1i(ramp_shader.getUniformLocation("u_counts"), 0);
+	glUniform2f(ramp_shader.getUniformLocation("u_resolution"), (float)width, (float)height);
+	glUniform1i(ramp_shader.getUniformLocation("u_counter"), counter);
+	glUniform1f(ramp_shader.getUniformLocation("u_range_max"), max);
+	glUniform3fv(ramp_shader.getUniformLocation("u_ramp"), 5, heatmap_ramp[0].e);
+	glBindBuffer(GL_ARRAY_BUFFER, triangle_vbo); // fullscreen triangle
+	glEnableVertexAttribArray(VAT_POSITION);
+	glVertexAttribPointer(VAT_POSITION, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(VAT_POSITION);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+}
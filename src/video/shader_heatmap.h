@@ -0,0 +1,65 @@
+// Per pixel cost view of a fragment shader. The source is instrumented at the
+// token level before compiling: loop iterations and texture fetches are
+// counted in globals, main() is renamed and a new main() writes the counts
+// into a float render target. A second pass maps the counts to a color ramp.
+// Loops with a braced body count body entries, other loops count increments
+// (for) or condition checks (while). Pixels discarded in main() are drawn
+// darker, pixels discarded in other functions aren't counted.
+enum HeatmapCounter {
+	HC_TOTAL, // loop iterations plus texture fetches
+	HC_LOOPS,
+	HC_FETCHES,
+	HC_COUNT
+};
+extern const char *heatmap_counter_names[HC_COUNT];
+
+struct HeatmapStats {
+	float min, max, mean;
+};
+
+// returns the new[]'d instrumented source, nullptr if there is no main()
+char *instrumentShaderForHeatmap(const char *src, int *out_loop_count, int *out_fetch_count);
+
+// color of the ramp at t in [0, 1], also used to draw the legend
+vec3 getHeatmapRampColor(float t);
+
+struct ShaderHeatmap {
+	bool enabled = false;
+	int counter = HC_TOTAL;
+	bool auto_range = true; // scale the ramp to the max of the last readback
+	float range_max = 64.0f;
+	char *compile_error_log = nullptr;
+	int loop_count = 0, fetch_count = 0; // instrumented sites
+	HeatmapStats stats[HC_COUNT] = {};
+	int counted_pixel_count = 0; // pixels of the last readback that wrote counts
+
+	// instruments and compiles src, the uniforms of the instrumented shader take
+	// the values of main shader uniforms of the same name at draw time
+	void compile(const char *src);
+	void release();
+	bool isCompiled() {return is_compiled;}
+
+	// renders the counts into the stats framebuffer with the instrumented shader
+	// bound, the caller sets the builtin uniforms and draws in between
+	Shader *beginCounting(int width, int height, ShaderUniform *uniforms, int uniform_count);
+	void endCounting();
+	void draw(GLuint triangle_vbo); // ramp over the current framebuffer
+
+private:
+	Shader shader;
+	Shader ramp_shader;
+	bool is_compiled = false;
+	bool has_vertex_shaders = false;
+	ShaderUniform *inputs = nullptr; // data points into the main shader's uniform data
+	int input_count = 0;
+	GLuint framebuffer = 0;
+	GLuint counts_texture = 0;
+	int width = 0, height = 0;
+	GLint previous_viewport[4];
+	GLuint pixel_buffer = 0; // readback is mapped a frame later so it doesn't stall
+	bool readback_pending = false;
+	int frames_since_readback = 0;
+	int readback_width = 0, readback_height = 0;
+
+	void computeStats(const float *counts, int pixel_count);
+};
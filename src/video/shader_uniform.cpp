@@ -8,7 +8,7 @@ size_t ShaderUniform::getTypeSize() {
 		case GL_FLOAT_MAT2: return 16;
 		case GL_FLOAT_MAT3: return 36;
 		case GL_FLOAT_MAT4: return 64;
-		case GL_SAMPLER_2D: case GL_SAMPLER_CUBE: return 4;
+		case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: return 4;
 		default: LOGE("ShaderUniform: unknown type 0x%X", type); return 0;
 	}
 }
@@ -66,7 +66,7 @@ void ShaderUniform::gui() {
 				sprintf(name_buf, "%s[3]", name);
 				ImGui::DragFloat4(name_buf, (float*)(datai+48));
 			} break;
-			case GL_SAMPLER_2D: case GL_SAMPLER_CUBE: ImGui::InputInt(name_buf, (int*)(datai)); break;
+			case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: ImGui::InputInt(name, (int*)(datai)); break;
 			default: assert(!"ShaderUniform: unhandled type");
 		}
 		ImGui::PopID();
@@ -97,7 +97,7 @@ void ShaderUniform::apply() {
 		case GL_FLOAT_MAT2: glUniformMatrix2fv(location, size, GL_FALSE, (float*)data); break;
 		case GL_FLOAT_MAT3: glUniformMatrix3fv(location, size, GL_FALSE, (float*)data); break;
 		case GL_FLOAT_MAT4: glUniformMatrix4fv(location, size, GL_FALSE, (float*)data); break;
-		case GL_SAMPLER_2D: case GL_SAMPLER_CUBE: glUniform1iv(location, size, (int *)data); break;
+		case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: glUniform1iv(location, size, (int *)data); break;
 		default: assert(!"ShaderUniform: unhandled type");
 	}
 }
@@ -0,0 +1,437 @@
+static const char *texture_cache_dirname = "texture_cache";
+static const char *texture_cache_ext = ".texcache";
+static const char *texture_cache_fourcc = "TXCH";
+static const u32 texture_cache_version = 1;
+
+struct TextureCacheHeader {
+	char fourcc[4];
+	u32 version;
+	u32 target; // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+	u32 internal_format;
+	u32 format, type; // unused if compressed
+	u32 compressed;
+	u32 width, height; // of level 0
+	u32 level_count, face_count;
+	u32 min_filter, mag_filter, wrap_s, wrap_t;
+};
+
+struct TextureCacheLevel { // face_count*level_count of these follow the header, face major
+	u64 offset; // from beginning of file
+	u64 size;
+	u32 width, height;
+};
+
+void TextureCache::init(const char *pref_path) {
+	if (dirpath) delete [] dirpath;
+	size_t dirpath_len = strlen(pref_path)+strlen(texture_cache_dirname)+1;
+	dirpath = new char[dirpath_len+1];
+	strcpy(dirpath, pref_path);
+	strcat(dirpath, texture_cache_dirname);
+	makeDirectory(dirpath); // fails harmlessly if it already exists
+	strcat(dirpath, pref_path[strlen(pref_path)-1] == '\\' ? "\\" : "/");
+}
+
+void TextureCache::getEntryFilepath(char *out_filepath, size_t out_filepath_size, u64 key) {
+	snprintf(out_filepath, out_filepath_size, "%s%016llx%s",
+		dirpath, (unsigned long long)key, texture_cache_ext);
+}
+
+static GLuint loadTextureUncached(const char *image_filepath, GLenum target,
+	int *out_width, int *out_height) {
+	if (target == GL_TEXTURE_CUBE_MAP) {
+		GLuint texture = loadTextureCubeCross(image_filepath, /*build_mipmaps*/true, out_width);
+		*out_height = *out_width;
+		return texture;
+	}
+	return loadTexture2D(image_filepath, /*build_mipmaps*/true, out_width, out_height);
+}
+
+// key on file contents so renamed or copied files still hit
+u64 TextureCache::getKey(const MappedFile &image_file, GLenum target) {
+	u32 options[2] = {texture_cache_version, (u32)target};
+	return hashBytes(options, sizeof(options), hashBytes(image_file.data, image_file.size));
+}
+
+GLuint TextureCache::loadTexture(const char *image_filepath, GLenum target,
+	int *out_width, int *out_height) {
+	if (!dirpath) return loadTextureUncached(image_filepath, target, out_width, out_height);
+
+	u64 begin_ticks = SDL_GetPerformanceCounter();
+
+	u64 key;
+	if (!getPrefetchedKey(image_filepath, target, &key)) {
+		MappedFile image_file;
+		if (!image_file.open(image_filepath)) return 0;
+		key = getKey(image_file, target);
+		image_file.close();
+	}
+
+	char entry_filepath[1024];
+	getEntryFilepath(entry_filepath, sizeof(entry_filepath), key);
+	GLuint texture = loadEntry(entry_filepath, target, out_width, out_height);
+	if (texture) {
+		double ms = 1000.0 * (double)(SDL_GetPerformanceCounter() - begin_ticks)
+			/ (double)SDL_GetPerformanceFrequency();
+		LOGI("Loaded '%s' from texture cache in %.2f ms", image_filepath, ms);
+		return texture;
+	}
+
+	texture = loadTextureUncached(image_filepath, target, out_width, out_height);
+	if (texture) queueStore(entry_filepath, texture, target);
+	return texture;
+}
+
+void TextureCache::prefetch(const char *image_filepath, GLenum target) {
+	if (!dirpath) return;
+	for (int i = 0; i < (int)ARRAY_COUNT(prefetches); i++) {
+		Prefetch *p = prefetches + i;
+		if (p->image_filepath) continue;
+		p->image_filepath = new char[strlen(image_filepath)+1];
+		strcpy(p->image_filepath, image_filepath);
+		p->cache = this;
+		p->target = target;
+		p->is_hashed = false;
+		SDL_AtomicSet(&p->is_done, 0);
+		job_queue.push(prefetchJob, p);
+		return;
+	}
+}
+
+void TextureCache::prefetchJob(void *data) {
+	Prefetch *p = (Prefetch*)data;
+	TextureCache *cache = p->cache;
+	PROFILE_ZONE("texture prefetch");
+	MappedFile image_file;
+	if (image_file.open(p->image_filepath)) {
+		p->key = cache->getKey(image_file, p->target);
+		p->is_hashed = true;
+		image_file.close();
+
+		// fault the entry into the page cache, the upload reads it from there
+		char entry_filepath[1024];
+		cache->getEntryFilepath(entry_filepath, sizeof(entry_filepath), p->key);
+		MappedFile entry_file;
+		if (entry_file.open(entry_filepath)) {
+			volatile u8 sum = 0;
+			for (size_t offset = 0; offset < entry_file.size; offset += 4096) sum += entry_file.data[offset];
+			entry_file.close();
+		}
+	}
+	SDL_AtomicSet(&p->is_done, 1);
+}
+
+static void waitForPrefetch(SDL_atomic_t *is_done) {
+	while (!SDL_AtomicGet(is_done)) SDL_Delay(1);
+}
+
+bool TextureCache::getPrefetchedKey(const char *image_filepath, GLenum target, u64 *out_key) {
+	for (int i = 0; i < (int)ARRAY_COUNT(prefetches); i++) {
+		Prefetch *p = prefetches + i;
+		if (!p->image_filepath || p->target != target || strcmp(p->image_filepath, image_filepath)) continue;
+		waitForPrefetch(&p->is_done);
+		bool is_hashed = p->is_hashed;
+		*out_key = p->key;
+		delete [] p->image_filepath;
+		p->image_filepath = nullptr;
+		return is_hashed;
+	}
+	return false;
+}
+
+void TextureCache::finishPrefetches() {
+	for (int i = 0; i < (int)ARRAY_COUNT(prefetches); i++) {
+		Prefetch *p = prefetches + i;
+		if (!p->image_filepath) continue;
+		waitForPrefetch(&p->is_done);
+		delete [] p->image_filepath;
+		p->image_filepath = nullptr;
+	}
+}
+
+GLuint TextureCache::loadEntry(const char *entry_filepath, GLenum target,
+	int *out_width, int *out_height) {
+	MappedFile file;
+	if (!file.open(entry_filepath)) return 0; // cache miss
+
+	TextureCacheHeader *header = (TextureCacheHeader*)file.data;
+	TextureCacheLevel *levels = (TextureCacheLevel*)(header+1);
+	if (file.size < sizeof(TextureCacheHeader)
+		|| memcmp(header->fourcc, texture_cache_fourcc, 4)
+		|| header->version != texture_cache_version
+		|| header->target != target
+		|| header->level_count == 0 || header->level_count > 32
+		|| (header->face_count != 1 && header->face_count != 6)
+		|| file.size < sizeof(TextureCacheHeader)
+			+ header->face_count*header->level_count*sizeof(TextureCacheLevel)) {
+		LOGW("Ignoring invalid texture cache entry '%s'", entry_filepath);
+		file.close();
+		return 0;
+	}
+	u32 entry_count = header->face_count*header->level_count;
+	for (u32 ei = 0; ei < entry_count; ei++) {
+		if (levels[ei].offset + levels[ei].size > file.size) {
+			LOGW("Ignoring truncated texture cache entry '%s'", entry_filepath);
+			file.close();
+			return 0;
+		}
+	}
+
+	while (glGetError() != GL_NO_ERROR) {} // earlier errors aren't the upload's
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(target, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (u32 face = 0; face < header->face_count; face++) {
+		GLenum face_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X+face : target;
+		for (u32 level = 0; level < header->level_count; level++) {
+			TextureCacheLevel *l = levels + face*header->level_count + level;
+			// texel data is handed to the driver directly from the page cache
+			if (header->compressed) {
+				glCompressedTexImage2D(face_target, level, header->internal_format,
+					l->width, l->height, 0, (GLsizei)l->size, file.data + l->offset);
+			} else {
+				glTexImage2D(face_target, level, header->internal_format,
+					l->width, l->height, 0, header->format, header->type, file.data + l->offset);
+			}
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, header->level_count-1);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, header->min_filter);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, header->mag_filter);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, header->wrap_s);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, header->wrap_t);
+
+	if (glGetError() != GL_NO_ERROR) {
+		LOGW("Failed to upload texture cache entry '%s'", entry_filepath);
+		glDeleteTextures(1, &texture);
+		file.close();
+		return 0;
+	}
+
+	*out_width = header->width;
+	*out_height = header->height;
+	file.close();
+	touchFile(entry_filepath); // most recently used
+	return texture;
+}
+
+// reads the texture back from the driver so the entry has exactly the layout
+// and contents the regular loaders produced. The copy into the pixel buffer is
+// queued on the GPU, update() maps it once it's done.
+void TextureCache::queueStore(const char *entry_filepath, GLuint texture, GLenum target) {
+#ifndef EMSCRIPTEN // no glGetTexImage in GLES
+	PendingStore *store = nullptr;
+	for (int i = 0; i < (int)ARRAY_COUNT(pending_stores); i++) {
+		if (!pending_stores[i].entry_filepath) {
+			store = pending_stores + i;
+			break;
+		}
+	}
+	if (!store) return; // stored the next time it's loaded
+
+	while (glGetError() != GL_NO_ERROR) {} // earlier errors aren't the readback's
+	glBindTexture(target, texture);
+	GLenum face0_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+
+	TextureCacheHeader header = {};
+	memcpy(header.fourcc, texture_cache_fourcc, 4);
+	header.version = texture_cache_version;
+	header.target = target;
+	header.face_count = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+
+	GLint value;
+	glGetTexLevelParameteriv(face0_target, 0, GL_TEXTURE_INTERNAL_FORMAT, &value); header.internal_format = value;
+	glGetTexLevelParameteriv(face0_target, 0, GL_TEXTURE_WIDTH, &value); header.width = value;
+	glGetTexLevelParameteriv(face0_target, 0, GL_TEXTURE_HEIGHT, &value); header.height = value;
+	glGetTexLevelParameteriv(face0_target, 0, GL_TEXTURE_COMPRESSED, &value); header.compressed = value;
+	GLint alpha_size, red_type;
+	glGetTexLevelParameteriv(face0_target, 0, GL_TEXTURE_ALPHA_SIZE, &alpha_size);
+	glGetTexLevelParameteriv(face0_target, 0, GL_TEXTURE_RED_TYPE, &red_type);
+	header.format = alpha_size ? GL_RGBA : GL_RGB;
+	header.type = red_type == GL_FLOAT ? GL_FLOAT : GL_UNSIGNED_BYTE;
+	int texel_size = (header.format == GL_RGBA ? 4 : 3) * (header.type == GL_FLOAT ? 4 : 1);
+
+	glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, &value); header.min_filter = value;
+	glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, &value); header.mag_filter = value;
+	glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &value); header.wrap_s = value;
+	glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, &value); header.wrap_t = value;
+
+	// count levels down to 1x1 (or as far as the loader built them)
+	for (header.level_count = 1; header.level_count < 32; header.level_count++) {
+		GLint width, height;
+		glGetTexLevelParameteriv(face0_target, header.level_count-1, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(face0_target, header.level_count-1, GL_TEXTURE_HEIGHT, &height);
+		if (width <= 1 && height <= 1) break;
+		glGetTexLevelParameteriv(face0_target, header.level_count, GL_TEXTURE_WIDTH, &width);
+		if (width == 0) break; // no more levels
+	}
+
+	u32 entry_count = header.face_count*header.level_count;
+	size_t levels_end = sizeof(TextureCacheHeader) + entry_count*sizeof(TextureCacheLevel);
+	size_t data_offset = (levels_end + 15) & ~(size_t)15; // the first level, aligned like the others
+	u8 *header_and_levels = new u8[data_offset];
+	memset(header_and_levels, 0, data_offset);
+	memcpy(header_and_levels, &header, sizeof(header));
+	TextureCacheLevel *levels = (TextureCacheLevel*)(header_and_levels + sizeof(header));
+	u64 offset = levels_end;
+	for (u32 face = 0; face < header.face_count; face++) {
+		GLenum face_target = face0_target + face;
+		for (u32 level = 0; level < header.level_count; level++) {
+			TextureCacheLevel *l = levels + face*header.level_count + level;
+			GLint width, height;
+			glGetTexLevelParameteriv(face_target, level, GL_TEXTURE_WIDTH, &width);
+			glGetTexLevelParameteriv(face_target, level, GL_TEXTURE_HEIGHT, &height);
+			l->width = width;
+			l->height = height;
+			if (header.compressed) {
+				GLint compressed_size;
+				glGetTexLevelParameteriv(face_target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+				l->size = compressed_size;
+			} else {
+				l->size = (u64)width*height*texel_size;
+			}
+			offset = (offset + 15) & ~(u64)15; // keep texel rows nicely aligned in the mapping
+			l->offset = offset;
+			offset += l->size;
+		}
+	}
+
+	size_t data_size = (size_t)offset - data_offset;
+	GLuint pixel_buffer;
+	glGenBuffers(1, &pixel_buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, data_size, nullptr, GL_STREAM_READ);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	for (u32 face = 0; face < header.face_count; face++) {
+		GLenum face_target = face0_target + face;
+		for (u32 level = 0; level < header.level_count; level++) {
+			TextureCacheLevel *l = levels + face*header.level_count + level;
+			GLvoid *buffer_offset = (GLvoid*)(size_t)(l->offset - data_offset);
+			if (header.compressed) {
+				glGetCompressedTexImage(face_target, level, buffer_offset);
+			} else {
+				glGetTexImage(face_target, level, header.format, header.type, buffer_offset);
+			}
+		}
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (glGetError() != GL_NO_ERROR) {
+		LOGW("Could not read back the texture for '%s'.", entry_filepath);
+		glDeleteBuffers(1, &pixel_buffer);
+		delete [] header_and_levels;
+		return;
+	}
+	gpu_memory.track(GMK_BUFFER, pixel_buffer, data_size);
+	store->entry_filepath = new char[strlen(entry_filepath)+1];
+	strcpy(store->entry_filepath, entry_filepath);
+	store->pixel_buffer = pixel_buffer;
+	store->size = (size_t)offset;
+	store->data_offset = data_offset;
+	store->header_and_levels = header_and_levels;
+	store->frame_count = 0;
+#endif
+}
+
+void TextureCache::update() {
+	if (!dirpath) return;
+	if (!is_trim_started) { // the workers run by now, entries written before this run count too
+		is_trim_started = true;
+		job_queue.push(trimJob, this);
+	}
+	for (int i = 0; i < (int)ARRAY_COUNT(pending_stores); i++) {
+		PendingStore *store = pending_stores + i;
+		// the copy is done after a few frames, mapping it earlier would wait for it
+		if (store->entry_filepath && ++store->frame_count >= 3) finishStore(store);
+	}
+}
+
+void TextureCache::finishStore(PendingStore *store) {
+#ifndef EMSCRIPTEN
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, store->pixel_buffer);
+	const u8 *mapped = (const u8*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (mapped) {
+		StoreJobData *job_data = new StoreJobData;
+		job_data->cache = this;
+		job_data->entry_filepath = store->entry_filepath;
+		job_data->size = store->size;
+		job_data->data = new u8[store->size];
+		memcpy(job_data->data, store->header_and_levels, store->data_offset);
+		memcpy(job_data->data + store->data_offset, mapped, store->size - store->data_offset);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		job_queue.push(storeJob, job_data);
+	} else {
+		LOGW("Could not map the readback of '%s'.", store->entry_filepath);
+		delete [] store->entry_filepath;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	gpu_memory.untrack(GMK_BUFFER, store->pixel_buffer);
+	glDeleteBuffers(1, &store->pixel_buffer);
+	delete [] store->header_and_levels;
+	memset(store, 0, sizeof(*store));
+#endif
+}
+
+void TextureCache::storeJob(void *data) {
+	StoreJobData *job_data = (StoreJobData*)data;
+	PROFILE_ZONE("texture cache store");
+	const char *entry_filepath = job_data->entry_filepath;
+
+	// write to a temporary file first so an interrupted write never leaves a broken entry
+	char tmp_filepath[1024+4];
+	snprintf(tmp_filepath, sizeof(tmp_filepath), "%s.tmp", entry_filepath);
+	FILE *file = fopen(tmp_filepath, "wb");
+	if (file) {
+		fwrite(job_data->data, 1, job_data->size, file);
+		bool write_failed = ferror(file) != 0;
+		fclose(file);
+		if (write_failed) {
+			LOGW("Could not write '%s'.", tmp_filepath);
+			remove(tmp_filepath);
+		} else {
+			remove(entry_filepath); // rename doesn't overwrite on windows
+			rename(tmp_filepath, entry_filepath);
+		}
+	} else {
+		LOGW("Could not write '%s'.", tmp_filepath);
+	}
+	job_data->cache->trim();
+
+	delete [] job_data->entry_filepath;
+	delete [] job_data->data;
+	delete job_data;
+}
+
+void TextureCache::trimJob(void *data) {
+	PROFILE_ZONE("texture cache trim");
+	((TextureCache*)data)->trim();
+}
+
+static int compareDirectoryFileMtimes(const void *a, const void *b) {
+	u64 mtime_a = ((const DirectoryFile*)a)->mtime, mtime_b = ((const DirectoryFile*)b)->mtime;
+	return mtime_a < mtime_b ? -1 : mtime_a > mtime_b ? 1 : 0;
+}
+
+// deletes the least recently used files until the directory fits max_mib
+void TextureCache::trim() {
+	if (!SDL_AtomicCAS(&is_trimming, 0, 1)) return; // another worker is at it
+	DirectoryFile *files;
+	int file_count = listDirectoryFiles(dirpath, &files);
+	u64 total_size = 0;
+	for (int i = 0; i < file_count; i++) total_size += files[i].size;
+	u64 max_size = (u64)max_mib << 20;
+	if (total_size > max_size) {
+		qsort(files, file_count, sizeof(DirectoryFile), compareDirectoryFileMtimes);
+		for (int i = 0; i < file_count && total_size > max_size; i++) {
+			if (hasFileExtension(files[i].filename, "tmp")) continue; // still being written
+			char filepath[1024];
+			snprintf(filepath, sizeof(filepath), "%s%s", dirpath, files[i].filename);
+			if (!remove(filepath)) total_size -= files[i].size;
+		}
+		LOGI("Trimmed the texture cache to %.1f MiB", (double)total_size/(1 << 20));
+	}
+	freeDirectoryFiles(files, file_count);
+	SDL_AtomicSet(&is_trimming, 0);
+}
@@ -0,0 +1,66 @@
+// On-disk cache of decoded textures in the pref path.
+// Entries are keyed by a hash of the image file contents and the load options
+// and hold every mip level in the layout glTexImage2D expects, so a cache hit
+// is a memory mapping and one upload per level instead of a full decode.
+// A miss reads the texture back into a pixel buffer without waiting, the
+// entry is written on a worker a few frames later. Beyond max_mib the least
+// recently used files of the directory are deleted, a hit touches its entry.
+struct TextureCache {
+	char *dirpath = nullptr; // with trailing path separator, nullptr disables the cache
+	int max_mib = 1024; // of the whole directory, baked volumes included
+
+	void init(const char *pref_path);
+	void update(); // once per frame on the main thread, finishes the readbacks of earlier frames
+
+	// drop-in for loadTexture2D and loadTextureCubeCross (target decides which)
+	// out_height equals out_width for cube maps
+	GLuint loadTexture(const char *image_filepath, GLenum target,
+		int *out_width, int *out_height);
+
+	// hashes the image file and reads its cache entry on a worker, so a
+	// loadTexture of the same file and target later only uploads. Used to
+	// overlap the restored textures with window creation.
+	void prefetch(const char *image_filepath, GLenum target);
+	void finishPrefetches(); // waits for and drops the unused ones
+
+private:
+	struct Prefetch {
+		TextureCache *cache;
+		char *image_filepath; // nullptr: unused
+		GLenum target;
+		u64 key;
+		bool is_hashed; // false if the image file couldn't be read
+		SDL_atomic_t is_done;
+	};
+	Prefetch prefetches[16] = {};
+
+	struct PendingStore {
+		char *entry_filepath; // nullptr: unused
+		GLuint pixel_buffer; // the whole entry, header and levels are filled in when it's written
+		size_t size;
+		size_t data_offset; // of the first level
+		u8 *header_and_levels; // data_offset bytes
+		int frame_count; // since the readback
+	};
+	PendingStore pending_stores[8] = {};
+	bool is_trim_started = false;
+	SDL_atomic_t is_trimming = {0};
+
+	struct StoreJobData {
+		TextureCache *cache;
+		char *entry_filepath;
+		u8 *data;
+		size_t size;
+	};
+	static void storeJob(void *data);
+	static void trimJob(void *data);
+	void trim();
+
+	static void prefetchJob(void *data);
+	bool getPrefetchedKey(const char *image_filepath, GLenum target, u64 *out_key);
+	u64 getKey(const MappedFile &image_file, GLenum target);
+	void getEntryFilepath(char *out_filepath, size_t out_filepath_size, u64 key);
+	GLuint loadEntry(const char *entry_filepath, GLenum target, int *out_width, int *out_height);
+	void queueStore(const char *entry_filepath, GLuint texture, GLenum target);
+	void finishStore(PendingStore *store);
+};
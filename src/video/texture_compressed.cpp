@@ -0,0 +1,268 @@
+bool isCompressedTextureFile(const char *filepath) {
+	return hasFileExtension(filepath, "dds") || hasFileExtension(filepath, "ktx");
+}
+
+// where the texel data of a container lives in the mapped file
+struct CompressedTextureLayout {
+	GLenum internal_format;
+	GLenum target;
+	u32 width, height;
+	u32 level_count;
+	u32 face_count;
+	size_t data_offset; // first byte of face 0 level 0
+	bool ktx; // ktx stores level major with size prefixes, dds face major
+};
+
+static u32 getBlockSize(GLenum internal_format) {
+	switch (internal_format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+		case GL_COMPRESSED_SIGNED_RED_RGTC1:
+			return 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_SIGNED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+		case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+			return 16;
+		default: return 0; // not a 4x4 block format we know
+	}
+}
+
+static size_t getLevelSize(GLenum internal_format, u32 width, u32 height) {
+	u32 blocks_x = width > 4 ? (width+3)/4 : 1;
+	u32 blocks_y = height > 4 ? (height+3)/4 : 1;
+	return (size_t)blocks_x*blocks_y*getBlockSize(internal_format);
+}
+
+// DDS
+
+#define DDS_FOURCC(a, b, c, d) ((u32)(a) | ((u32)(b)<<8) | ((u32)(c)<<16) | ((u32)(d)<<24))
+
+struct DDSPixelFormat {
+	u32 size, flags, fourcc, rgb_bit_count;
+	u32 r_mask, g_mask, b_mask, a_mask;
+};
+
+struct DDSHeader {
+	u32 size, flags, height, width, pitch_or_linear_size, depth, mip_map_count;
+	u32 reserved1[11];
+	DDSPixelFormat pixel_format;
+	u32 caps, caps2, caps3, caps4, reserved2;
+};
+
+struct DDSHeaderDX10 {
+	u32 dxgi_format, resource_dimension, misc_flag, array_size, misc_flags2;
+};
+
+static const u32 DDPF_FOURCC = 0x4;
+static const u32 DDSCAPS2_CUBEMAP = 0x200;
+static const u32 DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+static GLenum getInternalFormatFromFourCC(u32 fourcc) {
+	switch (fourcc) {
+		case DDS_FOURCC('D','X','T','1'): return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		case DDS_FOURCC('D','X','T','3'): return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		case DDS_FOURCC('D','X','T','5'): return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case DDS_FOURCC('A','T','I','1'): case DDS_FOURCC('B','C','4','U'): return GL_COMPRESSED_RED_RGTC1;
+		case DDS_FOURCC('B','C','4','S'): return GL_COMPRESSED_SIGNED_RED_RGTC1;
+		case DDS_FOURCC('A','T','I','2'): case DDS_FOURCC('B','C','5','U'): return GL_COMPRESSED_RG_RGTC2;
+		case DDS_FOURCC('B','C','5','S'): return GL_COMPRESSED_SIGNED_RG_RGTC2;
+		default: return 0;
+	}
+}
+
+static GLenum getInternalFormatFromDXGI(u32 dxgi_format) {
+	switch (dxgi_format) {
+		case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; // DXGI_FORMAT_BC1_UNORM
+		case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; // DXGI_FORMAT_BC1_UNORM_SRGB
+		case 74: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; // DXGI_FORMAT_BC2_UNORM
+		case 75: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT; // DXGI_FORMAT_BC2_UNORM_SRGB
+		case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; // DXGI_FORMAT_BC3_UNORM
+		case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; // DXGI_FORMAT_BC3_UNORM_SRGB
+		case 80: return GL_COMPRESSED_RED_RGTC1; // DXGI_FORMAT_BC4_UNORM
+		case 81: return GL_COMPRESSED_SIGNED_RED_RGTC1; // DXGI_FORMAT_BC4_SNORM
+		case 83: return GL_COMPRESSED_RG_RGTC2; // DXGI_FORMAT_BC5_UNORM
+		case 84: return GL_COMPRESSED_SIGNED_RG_RGTC2; // DXGI_FORMAT_BC5_SNORM
+		case 95: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT; // DXGI_FORMAT_BC6H_UF16
+		case 96: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT; // DXGI_FORMAT_BC6H_SF16
+		case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM; // DXGI_FORMAT_BC7_UNORM
+		case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM; // DXGI_FORMAT_BC7_UNORM_SRGB
+		default: return 0;
+	}
+}
+
+static bool parseDDS(const char *filepath, MappedFile *file, CompressedTextureLayout *layout) {
+	size_t offset = 4 + sizeof(DDSHeader);
+	if (file->size < offset || memcmp(file->data, "DDS ", 4)) {
+		LOGE("Not a valid DDS file: %s", filepath);
+		return false;
+	}
+	DDSHeader header;
+	memcpy(&header, file->data+4, sizeof(header));
+	if (!(header.pixel_format.flags & DDPF_FOURCC)) {
+		LOGE("Uncompressed DDS files are not supported: %s", filepath);
+		return false;
+	}
+
+	bool is_cube = (header.caps2 & DDSCAPS2_CUBEMAP) != 0;
+	if (header.pixel_format.fourcc == DDS_FOURCC('D','X','1','0')) {
+		DDSHeaderDX10 header_dx10;
+		if (file->size < offset + sizeof(header_dx10)) return false;
+		memcpy(&header_dx10, file->data+offset, sizeof(header_dx10));
+		offset += sizeof(header_dx10);
+		layout->internal_format = getInternalFormatFromDXGI(header_dx10.dxgi_format);
+		is_cube = is_cube || (header_dx10.misc_flag & DDS_RESOURCE_MISC_TEXTURECUBE);
+		if (!layout->internal_format) {
+			LOGE("Unsupported DXGI format %u in %s", header_dx10.dxgi_format, filepath);
+			return false;
+		}
+	} else {
+		layout->internal_format = getInternalFormatFromFourCC(header.pixel_format.fourcc);
+		if (!layout->internal_format) {
+			LOGE("Unsupported DDS FourCC 0x%08X in %s", header.pixel_format.fourcc, filepath);
+			return false;
+		}
+	}
+
+	layout->target = is_cube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	layout->width = header.width;
+	layout->height = header.height;
+	layout->level_count = header.mip_map_count ? header.mip_map_count : 1;
+	layout->face_count = is_cube ? 6 : 1;
+	layout->data_offset = offset;
+	layout->ktx = false;
+	return true;
+}
+
+// KTX
+
+static const u8 ktx_identifier[12] = {
+	0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+struct KTXHeader {
+	u32 endianness;
+	u32 gl_type, gl_type_size, gl_format;
+	u32 gl_internal_format, gl_base_internal_format;
+	u32 pixel_width, pixel_height, pixel_depth;
+	u32 number_of_array_elements, number_of_faces, number_of_mipmap_levels;
+	u32 bytes_of_key_value_data;
+};
+
+static bool parseKTX(const char *filepath, MappedFile *file, CompressedTextureLayout *layout) {
+	size_t offset = sizeof(ktx_identifier) + sizeof(KTXHeader);
+	if (file->size < offset || memcmp(file->data, ktx_identifier, sizeof(ktx_identifier))) {
+		LOGE("Not a valid KTX file: %s", filepath);
+		return false;
+	}
+	KTXHeader header;
+	memcpy(&header, file->data+sizeof(ktx_identifier), sizeof(header));
+	if (header.endianness != 0x04030201) {
+		LOGE("Byte swapped KTX files are not supported: %s", filepath);
+		return false;
+	}
+	if (header.gl_type != 0 || !getBlockSize(header.gl_internal_format)) {
+		LOGE("Only block compressed KTX files are supported: %s", filepath);
+		return false;
+	}
+	if (header.pixel_depth > 1 || header.number_of_array_elements > 1) {
+		LOGE("3D and array KTX textures are not supported: %s", filepath);
+		return false;
+	}
+	if (header.number_of_faces != 1 && header.number_of_faces != 6) return false;
+
+	layout->internal_format = header.gl_internal_format;
+	layout->target = header.number_of_faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	layout->width = header.pixel_width;
+	layout->height = header.pixel_height;
+	// 0 means the loader should generate mipmaps, which isn't possible for compressed data
+	layout->level_count = header.number_of_mipmap_levels ? header.number_of_mipmap_levels : 1;
+	layout->face_count = header.number_of_faces;
+	layout->data_offset = offset + header.bytes_of_key_value_data;
+	layout->ktx = true;
+	return true;
+}
+
+GLuint loadTextureCompressed(const char *filepath, GLenum *out_target,
+	int *out_width, int *out_height) {
+	MappedFile file;
+	if (!file.open(filepath)) {
+		LOGE("Could not open '%s'", filepath);
+		return 0;
+	}
+
+	CompressedTextureLayout layout;
+	bool parsed = hasFileExtension(filepath, "ktx")
+		? parseKTX(filepath, &file, &layout)
+		: parseDDS(filepath, &file, &layout);
+	if (!parsed || layout.width == 0 || layout.height == 0 || layout.level_count > 32) {
+		file.close();
+		return 0;
+	}
+
+	while (glGetError() != GL_NO_ERROR) {} // earlier errors aren't the upload's
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(layout.target, texture);
+
+	size_t offset = layout.data_offset;
+	for (u32 face = 0; face < layout.face_count; face++) {
+		GLenum face_target = layout.target == GL_TEXTURE_CUBE_MAP
+			? GL_TEXTURE_CUBE_MAP_POSITIVE_X+face : layout.target;
+		if (layout.ktx) offset = layout.data_offset; // faces are interleaved per level
+		for (u32 level = 0; level < layout.level_count; level++) {
+			u32 width = layout.width >> level; if (width == 0) width = 1;
+			u32 height = layout.height >> level; if (height == 0) height = 1;
+			size_t level_size = getLevelSize(layout.internal_format, width, height);
+			size_t face_offset = offset;
+			if (layout.ktx) {
+				// u32 imageSize, then each face padded to 4 bytes
+				size_t face_stride = (level_size + 3) & ~(size_t)3;
+				face_offset = offset + 4 + face*face_stride;
+				offset += 4 + layout.face_count*face_stride;
+			} else {
+				offset += level_size;
+			}
+			if (face_offset + level_size > file.size) {
+				LOGE("Truncated compressed texture: %s", filepath);
+				glDeleteTextures(1, &texture);
+				file.close();
+				return 0;
+			}
+			glCompressedTexImage2D(face_target, level, layout.internal_format,
+				width, height, 0, (GLsizei)level_size, file.data + face_offset);
+		}
+	}
+
+	glTexParameteri(layout.target, GL_TEXTURE_MAX_LEVEL, layout.level_count-1);
+	glTexParameteri(layout.target, GL_TEXTURE_MIN_FILTER,
+		layout.level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(layout.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (layout.target == GL_TEXTURE_CUBE_MAP) {
+		glTexParameteri(layout.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(layout.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	file.close(); // the driver has its copy
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR) {
+		LOGE("Failed to upload '%s' (0x%X), compressed format 0x%X not supported by driver?",
+			filepath, error, layout.internal_format);
+		glDeleteTextures(1, &texture);
+		return 0;
+	}
+
+	*out_target = layout.target;
+	*out_width = layout.width;
+	*out_height = layout.height;
+	return texture;
+}
@@ -0,0 +1,9 @@
+// Block compressed texture containers (DDS and KTX 1.1 with BC1-BC7).
+// The file is memory mapped and every mip level is handed to
+// glCompressedTexImage2D straight from the mapping, there is no decode step.
+
+bool isCompressedTextureFile(const char *filepath); // by extension
+
+// out_target is GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP depending on the file
+GLuint loadTextureCompressed(const char *filepath, GLenum *out_target,
+	int *out_width, int *out_height);
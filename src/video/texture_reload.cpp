@@ -0,0 +1,60 @@
+void TextureReload::start(const char *image_filepath) {
+	filepath = new char[strlen(image_filepath)+1];
+	strcpy(filepath, image_filepath);
+	SDL_AtomicSet(&state, TRS_DECODING);
+	job_queue.push(decodeJob, this);
+}
+
+void TextureReload::decodeJob(void *data) {
+	TextureReload *reload = (TextureReload*)data;
+	ProfileScope decode_zone("texture decode");
+	int channel_count;
+	reload->is_hdr = !!stbi_is_hdr(reload->filepath);
+	if (reload->is_hdr) {
+		reload->pixels = stbi_loadf(reload->filepath, &reload->width, &reload->height, &channel_count, 3);
+	} else {
+		reload->pixels = stbi_load(reload->filepath, &reload->width, &reload->height, &channel_count, 4);
+	}
+	decode_zone.end(); // the owner may release reload once the state is set
+	if (!SDL_AtomicCAS(&reload->state, TRS_DECODING, reload->pixels ? TRS_DECODED : TRS_FAILED)) {
+		delete reload; // abandoned while decoding
+	}
+}
+
+bool TextureReload::upload(GLuint texture, int *out_width, int *out_height) {
+	if (SDL_AtomicGet(&state) != TRS_DECODED) return false;
+	PROFILE_ZONE("texture upload");
+
+	GLenum format = is_hdr ? GL_RGB : GL_RGBA;
+	GLenum type = is_hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	GLint texture_width, texture_height, internal_format;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &texture_width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &texture_height);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (texture_width == width && texture_height == height) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, pixels);
+	} else { // same texture object, new storage
+		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, pixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glGenerateMipmap(GL_TEXTURE_2D); // the whole chain again from the new level 0
+
+	*out_width = width;
+	*out_height = height;
+	return true;
+}
+
+void TextureReload::release() {
+	// if the job is still running it has to delete the reload when it's done
+	if (SDL_AtomicCAS(&state, TRS_DECODING, TRS_ABANDONED)) return;
+	delete this;
+}
+
+TextureReload::~TextureReload() {
+	if (pixels) stbi_image_free(pixels);
+	delete [] filepath;
+}
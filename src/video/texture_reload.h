@@ -0,0 +1,29 @@
+// Decodes an image on a worker thread and updates an existing 2D texture
+// in place, so editing a texture on disk doesn't stall the render loop.
+enum TextureReloadState {
+	TRS_DECODING,
+	TRS_DECODED,
+	TRS_FAILED,
+	TRS_ABANDONED // owner lost interest, the job cleans up
+};
+
+// heap allocated since the owner may let go of it while the job runs
+struct TextureReload {
+	SDL_atomic_t state = {TRS_DECODING}; // TextureReloadState
+
+	void start(const char *image_filepath); // decodes on the job queue
+
+	// call on the main thread once decoded, replaces the texels of texture
+	// and rebuilds its mip chain. out_width/out_height are the new dimensions
+	bool upload(GLuint texture, int *out_width, int *out_height);
+	void release(); // instead of delete, also frees the decoded pixels
+
+private:
+	char *filepath = nullptr;
+	void *pixels = nullptr; // owned by stb_image
+	int width, height;
+	bool is_hdr;
+
+	~TextureReload();
+	static void decodeJob(void *data);
+};
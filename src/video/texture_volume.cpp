@@ -0,0 +1,228 @@
+static const char vol_magic[3] = {'V', 'O', 'L'};
+
+// pixel format is always GL_RED
+static void getVolumeFormatGL(VolumeFormat format, GLenum *out_internal_format, GLenum *out_type) {
+	switch (format) {
+		case VF_R8:   *out_internal_format = GL_R8;   *out_type = GL_UNSIGNED_BYTE;  break;
+		case VF_R16:  *out_internal_format = GL_R16;  *out_type = GL_UNSIGNED_SHORT; break;
+		case VF_R16F: *out_internal_format = GL_R16F; *out_type = GL_HALF_FLOAT;     break;
+		case VF_R32F: *out_internal_format = GL_R32F; *out_type = GL_FLOAT;          break;
+		default: assert(!"invalid volume format");
+	}
+}
+
+size_t VolumeFileInfo::getTexelSize() {
+	switch (format) {
+		case VF_R8: return 1;
+		case VF_R16: case VF_R16F: return 2;
+		case VF_R32F: return 4;
+		default: assert(!"invalid volume format"); return 0;
+	}
+}
+
+bool isVolumeFile(const char *filepath) {
+	return hasFileExtension(filepath, "raw") || hasFileExtension(filepath, "vol");
+}
+
+// Mitsuba grid volume: "VOL" 3, i32 encoding, i32 x y z resolution, i32 channels, 6 floats bbox
+static bool readVolInfo(const char *filepath, VolumeFileInfo *out_info) {
+	FILE *file = fopen(filepath, "rb");
+	if (!file) return false;
+	u8 header[48];
+	bool header_read = fread(header, 1, sizeof(header), file) == sizeof(header);
+	fclose(file);
+	if (!header_read || memcmp(header, vol_magic, 3) || header[3] != 3) {
+		LOGE("Not a valid vol file: %s", filepath);
+		return false;
+	}
+	s32 encoding, resolution[3], channel_count;
+	memcpy(&encoding, header+4, 4);
+	memcpy(resolution, header+8, 12);
+	memcpy(&channel_count, header+20, 4);
+	if (channel_count != 1) {
+		LOGE("Only single channel volumes are supported: %s has %d", filepath, channel_count);
+		return false;
+	}
+	switch (encoding) {
+		case 1: out_info->format = VF_R32F; break;
+		case 2: out_info->format = VF_R16F; break;
+		case 3: out_info->format = VF_R8; break;
+		default: LOGE("Unknown vol encoding %d in %s", encoding, filepath); return false;
+	}
+	out_info->width = resolution[0];
+	out_info->height = resolution[1];
+	out_info->depth = resolution[2];
+	out_info->data_offset = sizeof(header);
+	return true;
+}
+
+// headerless, name contains "<width>x<height>x<depth>" and one of the format tokens
+static bool readRawInfo(const char *filepath, VolumeFileInfo *out_info) {
+	const char *basename = strrchr(filepath, '/');
+	const char *basename_win = strrchr(filepath, '\\');
+	if (basename_win > basename) basename = basename_win;
+	basename = basename ? basename+1 : filepath;
+
+	// size and format are whole tokens between _ - and ., bonsai_256x256x256_uint8.raw
+	struct {const char *token; VolumeFormat format;} format_tokens[] = {
+		{"uint8", VF_R8}, {"uint16", VF_R16}, {"float16", VF_R16F}, {"float32", VF_R32F},
+		{"r8", VF_R8}, {"r16", VF_R16}, {"r16f", VF_R16F}, {"r32f", VF_R32F}
+	};
+	bool has_size = false;
+	int format_count = 0;
+	const char *extension = strrchr(basename, '.');
+	if (!extension) extension = basename + strlen(basename);
+	for (const char *token = basename; token < extension;) {
+		int token_len = (int)strcspn(token, "_-.");
+		if (token + token_len > extension) token_len = (int)(extension - token);
+		char text[32];
+		if (token_len < (int)sizeof(text)) {
+			memcpy(text, token, token_len);
+			text[token_len] = '\0';
+			int width, height, depth, len;
+			if (sscanf(text, "%dx%dx%d%n", &width, &height, &depth, &len) == 3 && len == token_len) {
+				out_info->width = width;
+				out_info->height = height;
+				out_info->depth = depth;
+				has_size = true;
+			}
+			for (int fi = 0; fi < (int)ARRAY_COUNT(format_tokens); fi++) {
+				if (SDL_strcasecmp(text, format_tokens[fi].token)) continue;
+				if (!format_count || out_info->format != format_tokens[fi].format) format_count++; // >1: conflicting
+				out_info->format = format_tokens[fi].format;
+			}
+		}
+		token += token_len;
+		if (token < extension) token++; // separator
+	}
+	if (!has_size) {
+		LOGE("Raw volume name needs the size like name_256x256x128_uint8.raw: %s", basename);
+		return false;
+	}
+	if (format_count != 1) {
+		LOGE("Raw volume name needs one format of uint8, uint16, float16 or float32 like name_256x256x128_uint8.raw: %s", basename);
+		return false;
+	}
+	out_info->data_offset = 0;
+	return true;
+}
+
+bool readVolumeFileInfo(const char *filepath, VolumeFileInfo *out_info) {
+	bool valid = hasFileExtension(filepath, "vol")
+		? readVolInfo(filepath, out_info)
+		: readRawInfo(filepath, out_info);
+	if (!valid) return false;
+	if (out_info->width <= 0 || out_info->height <= 0 || out_info->depth <= 0) return false;
+
+	u64 data_size = (u64)out_info->getSliceSize()*out_info->depth;
+	if (MappedFile::getFileSize(filepath) < out_info->data_offset + data_size) {
+		LOGE("Volume file is smaller than %dx%dx%d: %s",
+			out_info->width, out_info->height, out_info->depth, filepath);
+		return false;
+	}
+	return true;
+}
+
+GLuint loadVolumeTexture2D(const char *filepath, int *out_width, int *out_height) {
+	VolumeFileInfo info;
+	if (!readVolumeFileInfo(filepath, &info)) return 0;
+	if (info.depth != 1) {
+		LOGE("Volume with %d slices can't be loaded as a 2D texture: %s", info.depth, filepath);
+		return 0;
+	}
+	MappedFile file;
+	if (!file.openRange(filepath, info.data_offset, info.getSliceSize())) return 0;
+
+	GLenum internal_format, type;
+	getVolumeFormatGL(info.format, &internal_format, &type);
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// data, not an image: no mipmaps averaging texels together
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, info.width, info.height, 0, GL_RED, type, file.data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	file.close();
+
+	*out_width = info.width;
+	*out_height = info.height;
+	return texture;
+}
+
+bool VolumeStream::begin(const char *volume_filepath, GLuint *out_texture) {
+	end();
+	if (!readVolumeFileInfo(volume_filepath, &info)) return false;
+
+	GLint max_size;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &max_size);
+	if (info.width > max_size || info.height > max_size || info.depth > max_size) {
+		LOGE("Volume %dx%dx%d exceeds GL_MAX_3D_TEXTURE_SIZE %d",
+			info.width, info.height, info.depth, max_size);
+		return false;
+	}
+
+	GLenum internal_format, type;
+	getVolumeFormatGL(info.format, &internal_format, &type);
+	while (glGetError() != GL_NO_ERROR) {} // earlier errors aren't the allocation's
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	// allocate only, slices are filled in by update()
+	glTexImage3D(GL_TEXTURE_3D, 0, internal_format, info.width, info.height, info.depth, 0, GL_RED, type, nullptr);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	if (glGetError() != GL_NO_ERROR) {
+		LOGE("Could not allocate %dx%dx%d volume texture", info.width, info.height, info.depth);
+		glDeleteTextures(1, &texture);
+		texture = 0;
+		return false;
+	}
+
+	filepath = new char[strlen(volume_filepath)+1];
+	strcpy(filepath, volume_filepath);
+	next_slice = 0;
+	*out_texture = texture;
+	return true;
+}
+
+void VolumeStream::update(size_t byte_budget) {
+	if (!filepath) return;
+
+	size_t slice_size = info.getSliceSize();
+	int batch_slice_count = (int)(byte_budget / slice_size);
+	if (batch_slice_count < 1) batch_slice_count = 1; // at least one slice per frame
+	if (batch_slice_count > info.depth - next_slice) batch_slice_count = info.depth - next_slice;
+
+	MappedFile batch;
+	if (!batch.openRange(filepath, info.data_offset + (u64)next_slice*slice_size,
+		(size_t)batch_slice_count*slice_size)) {
+		LOGE("Could not map slices %d-%d of '%s'", next_slice, next_slice+batch_slice_count-1, filepath);
+		end();
+		return;
+	}
+
+	GLenum internal_format, type;
+	getVolumeFormatGL(info.format, &internal_format, &type);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, next_slice,
+		info.width, info.height, batch_slice_count, GL_RED, type, batch.data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	batch.close(); // the driver has its copy, release the pages
+
+	next_slice += batch_slice_count;
+	if (next_slice == info.depth) end();
+}
+
+void VolumeStream::end() {
+	if (filepath) {
+		delete [] filepath;
+		filepath = nullptr;
+	}
+}
@@ -0,0 +1,42 @@
+// 3D textures from raw volume data (CT scans, simulation output).
+// Supported are Mitsuba style .vol files and headerless .raw files whose
+// name carries size and format, e.g. "bonsai_256x256x256_uint8.raw".
+enum VolumeFormat {
+	VF_R8,   // uint8
+	VF_R16,  // uint16
+	VF_R16F, // float16
+	VF_R32F  // float32
+};
+
+struct VolumeFileInfo {
+	int width, height, depth;
+	VolumeFormat format;
+	u64 data_offset; // first byte of slice 0
+
+	size_t getTexelSize();
+	size_t getSliceSize() {return (size_t)width*height*getTexelSize();}
+};
+
+bool isVolumeFile(const char *filepath); // by extension
+bool readVolumeFileInfo(const char *filepath, VolumeFileInfo *out_info);
+
+// single slice volumes (depth 1) as GL_TEXTURE_2D, uploaded in one go
+GLuint loadVolumeTexture2D(const char *filepath, int *out_width, int *out_height);
+
+// Uploads a volume into a GL_TEXTURE_3D a batch of slices at a time. Only the
+// current batch is memory mapped, so resident memory stays bounded by the
+// per frame budget no matter how large the file is.
+struct VolumeStream {
+	GLuint texture = 0; // owned by the texture slot
+	VolumeFileInfo info;
+	int next_slice = 0;
+
+	bool begin(const char *volume_filepath, GLuint *out_texture);
+	void update(size_t byte_budget); // call once per frame until done
+	bool isStreaming() {return filepath != nullptr;}
+	float getProgress() {return info.depth ? (float)next_slice/(float)info.depth : 0.0f;}
+	void end();
+
+private:
+	char *filepath = nullptr;
+};
@@ -0,0 +1,328 @@
+bool isVideoFile(const char *filepath) {
+	return hasFileExtension(filepath, "y4m");
+}
+
+bool VideoStream::openY4M(const char *video_filepath) {
+	u64 file_size = MappedFile::getFileSize(video_filepath);
+	MappedFile header_file;
+	size_t header_map_size = file_size < 4096 ? (size_t)file_size : 4096; // stream and first frame header
+	if (!header_map_size || !header_file.openRange(video_filepath, 0, header_map_size)) return false;
+	char header[4096+1];
+	memcpy(header, header_file.data, header_map_size);
+	header[header_map_size] = '\0';
+	header_file.close();
+
+	if (strncmp(header, "YUV4MPEG2 ", 10)) {
+		LOGE("Not a YUV4MPEG2 file: %s", video_filepath);
+		return false;
+	}
+	char *header_end = strchr(header, '\n');
+	if (!header_end) return false;
+	*header_end = '\0';
+	int fps_num = 30, fps_den = 1;
+	y4m_chroma_shift_x = y4m_chroma_shift_y = 1; // 420 unless told otherwise
+	y4m_mono = false;
+	for (char *token = strtok(header + 10, " "); token; token = strtok(nullptr, " ")) {
+		switch (token[0]) {
+			case 'W': width = atoi(token+1); break;
+			case 'H': height = atoi(token+1); break;
+			case 'F': sscanf(token+1, "%d:%d", &fps_num, &fps_den); break;
+			case 'C':
+				if (!strncmp(token+1, "420", 3) && !strstr(token, "p1")) { // not 420p10, 420p12
+					y4m_chroma_shift_x = y4m_chroma_shift_y = 1;
+				} else if (!strcmp(token+1, "422")) {
+					y4m_chroma_shift_x = 1; y4m_chroma_shift_y = 0;
+				} else if (!strcmp(token+1, "444")) {
+					y4m_chroma_shift_x = y4m_chroma_shift_y = 0;
+				} else if (!strcmp(token+1, "mono")) {
+					y4m_mono = true;
+				} else {
+					LOGE("Unsupported y4m colorspace %s (8 bit 420, 422, 444 and mono are)", token+1);
+					return false;
+				}
+				break;
+			default: break; // interlacing, aspect ratio and extensions don't matter here
+		}
+	}
+	if (width <= 0 || height <= 0 || fps_num <= 0 || fps_den <= 0) return false;
+	fps = (float)fps_num / (float)fps_den;
+
+	y4m_data_offset = (u64)(header_end - header) + 1;
+	const char *frame_header = header + y4m_data_offset;
+	const char *frame_header_end = strchr(frame_header, '\n');
+	if (strncmp(frame_header, "FRAME", 5) || !frame_header_end) {
+		LOGE("No frames in '%s'", video_filepath);
+		return false;
+	}
+	// assumes every frame header looks like the first, usually just "FRAME\n"
+	y4m_frame_header_size = (size_t)(frame_header_end - frame_header) + 1;
+	size_t chroma_size = y4m_mono ? 0 : (size_t)((width + (1 << y4m_chroma_shift_x) - 1) >> y4m_chroma_shift_x)
+		* ((height + (1 << y4m_chroma_shift_y) - 1) >> y4m_chroma_shift_y);
+	y4m_frame_stride = y4m_frame_header_size + (size_t)width*height + 2*chroma_size;
+	frame_count = (int)((file_size - y4m_data_offset) / y4m_frame_stride);
+	is_y4m = true;
+	return frame_count > 0;
+}
+
+bool VideoStream::openImageSequence(const char *image_filepath) {
+	// the number is the run of digits right before the extension
+	const char *ext = strrchr(image_filepath, '.');
+	if (!ext) ext = image_filepath + strlen(image_filepath);
+	const char *digits = ext;
+	while (digits > image_filepath && digits[-1] >= '0' && digits[-1] <= '9') digits--;
+	sequence_digit_count = (int)(ext - digits);
+	if (!sequence_digit_count) {
+		LOGE("Image sequence files need a frame number like frame_0001.png: %s", image_filepath);
+		return false;
+	}
+	sequence_first = atoi(digits);
+	size_t prefix_len = digits - image_filepath;
+	sequence_prefix = new char[prefix_len+1];
+	memcpy(sequence_prefix, image_filepath, prefix_len);
+	sequence_prefix[prefix_len] = '\0';
+	sequence_suffix = new char[strlen(ext)+1];
+	strcpy(sequence_suffix, ext);
+
+	char frame_filepath[1024];
+	frame_count = 0;
+	for (;;) {
+		snprintf(frame_filepath, sizeof(frame_filepath), "%s%0*d%s",
+			sequence_prefix, sequence_digit_count, sequence_first + frame_count, sequence_suffix);
+		struct stat attr;
+		if (stat(frame_filepath, &attr)) break;
+		frame_count++;
+	}
+	int channel_count;
+	if (frame_count < 2 || !stbi_info(image_filepath, &width, &height, &channel_count)) {
+		LOGE("'%s' is not part of an image sequence", image_filepath);
+		return false;
+	}
+	fps = 30.0f;
+	is_y4m = false;
+	return true;
+}
+
+static inline u8 clampToByte(int v) {
+	return v < 0 ? 0 : (v > 255 ? 255 : (u8)v);
+}
+
+bool VideoStream::decodeFrame(int frame, u8 *out_pixels) {
+	if (!is_y4m) {
+		char frame_filepath[1024];
+		snprintf(frame_filepath, sizeof(frame_filepath), "%s%0*d%s",
+			sequence_prefix, sequence_digit_count, sequence_first + frame, sequence_suffix);
+		int w, h, channel_count;
+		u8 *pixels = stbi_load(frame_filepath, &w, &h, &channel_count, 4);
+		if (!pixels) return false;
+		bool matches = w == width && h == height;
+		if (matches) memcpy(out_pixels, pixels, (size_t)width*height*4);
+		stbi_image_free(pixels);
+		return matches;
+	}
+
+	MappedFile file;
+	if (!file.openRange(filepath, y4m_data_offset + (u64)frame*y4m_frame_stride, y4m_frame_stride)) return false;
+	if (memcmp(file.data, "FRAME", 5)) return false;
+	const u8 *y_plane = file.data + y4m_frame_header_size;
+	int chroma_width = (width + (1 << y4m_chroma_shift_x) - 1) >> y4m_chroma_shift_x;
+	int chroma_height = (height + (1 << y4m_chroma_shift_y) - 1) >> y4m_chroma_shift_y;
+	const u8 *u_plane = y_plane + (size_t)width*height;
+	const u8 *v_plane = u_plane + (size_t)chroma_width*chroma_height;
+	// bt.601 limited range, fixed point
+	for (int y = 0; y < height; y++) {
+		const u8 *y_row = y_plane + (size_t)y*width;
+		const u8 *u_row = u_plane + (size_t)(y >> y4m_chroma_shift_y)*chroma_width;
+		const u8 *v_row = v_plane + (size_t)(y >> y4m_chroma_shift_y)*chroma_width;
+		u8 *out = out_pixels + (size_t)y*width*4;
+		for (int x = 0; x < width; x++) {
+			int c = 298*(y_row[x] - 16);
+			int d = y4m_mono ? 0 : u_row[x >> y4m_chroma_shift_x] - 128;
+			int e = y4m_mono ? 0 : v_row[x >> y4m_chroma_shift_x] - 128;
+			out[4*x+0] = clampToByte((c + 409*e + 128) >> 8);
+			out[4*x+1] = clampToByte((c - 100*d - 208*e + 128) >> 8);
+			out[4*x+2] = clampToByte((c + 516*d + 128) >> 8);
+			out[4*x+3] = 255;
+		}
+	}
+	return true;
+}
+
+int VideoStream::decoderThread(void *data) {
+	VideoStream *video = (VideoStream*)data;
+	int sequence = 0;
+	int frame_generation = SDL_AtomicGet(&video->generation);
+	bool logged_error = false;
+	while (!SDL_AtomicGet(&video->quit)) {
+		int seek = SDL_AtomicGet(&video->seek_sequence);
+		if (seek >= 0 && SDL_AtomicCAS(&video->seek_sequence, seek, -1)) {
+			sequence = seek;
+			frame_generation = SDL_AtomicGet(&video->generation);
+		}
+		// wait for a free slot, but wake up now and then to see seeks and quit
+		if (SDL_SemWaitTimeout(video->free_frames, 10) != 0) continue;
+
+		int write = SDL_AtomicGet(&video->write_index);
+		VideoFrame *frame = video->frames + (write & (frame_ring_size-1));
+		if (!video->decodeFrame(sequence % video->frame_count, frame->pixels)) {
+			if (!logged_error) LOGE("Could not decode frame %d of '%s'", sequence % video->frame_count, video->filepath);
+			logged_error = true;
+			memset(frame->pixels, 0, (size_t)video->width*video->height*4);
+		}
+		frame->sequence = sequence++;
+		frame->generation = frame_generation;
+		SDL_AtomicSet(&video->write_index, write + 1); // publishes the frame
+		SDL_SemPost(video->ready_frames);
+	}
+	return 0;
+}
+
+bool VideoStream::open(const char *video_filepath, GLuint *out_texture) {
+	close();
+	filepath = new char[strlen(video_filepath)+1];
+	strcpy(filepath, video_filepath);
+	bool opened = isVideoFile(video_filepath) ? openY4M(video_filepath) : openImageSequence(video_filepath);
+	if (!opened) {
+		close();
+		return false;
+	}
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenBuffers(2, pixel_buffers);
+	pixel_buffer_index = 0;
+	gpu_memory.track(GMK_BUFFER, pixel_buffers[0], (size_t)width*height*4); // allocated on first upload
+	gpu_memory.track(GMK_BUFFER, pixel_buffers[1], (size_t)width*height*4);
+
+	for (int i = 0; i < frame_ring_size; i++) {
+		frames[i].pixels = new u8[(size_t)width*height*4];
+		frames[i].sequence = -1;
+		frames[i].generation = -1;
+	}
+	SDL_AtomicSet(&write_index, 0);
+	SDL_AtomicSet(&read_index, 0);
+	SDL_AtomicSet(&seek_sequence, -1);
+	SDL_AtomicSet(&generation, 0);
+	SDL_AtomicSet(&quit, 0);
+	shown_sequence = -1;
+	dropped_frame_count = 0;
+	late_frame_count = 0;
+	free_frames = SDL_CreateSemaphore(frame_ring_size);
+	ready_frames = SDL_CreateSemaphore(0);
+	thread = SDL_CreateThread(decoderThread, "video decoder", this);
+	if (!thread) {
+		LOGE("Could not start the decoder of '%s': %s", filepath, SDL_GetError());
+		glDeleteTextures(1, &texture);
+		close();
+		return false;
+	}
+
+	LOGI("Opened %dx%d video '%s', %d frames at %.2f fps", width, height, filepath, frame_count, fps);
+	*out_texture = texture;
+	return true;
+}
+
+void VideoStream::close() {
+	if (thread) {
+		SDL_AtomicSet(&quit, 1);
+		SDL_WaitThread(thread, nullptr);
+		thread = nullptr;
+	}
+	for (int i = 0; i < frame_ring_size; i++) {
+		delete [] frames[i].pixels;
+		frames[i].pixels = nullptr;
+	}
+	if (free_frames) {
+		SDL_DestroySemaphore(free_frames);
+		free_frames = nullptr;
+	}
+	if (ready_frames) {
+		SDL_DestroySemaphore(ready_frames);
+		ready_frames = nullptr;
+	}
+	if (pixel_buffers[0]) {
+		gpu_memory.untrack(GMK_BUFFER, pixel_buffers[0]);
+		gpu_memory.untrack(GMK_BUFFER, pixel_buffers[1]);
+		glDeleteBuffers(2, pixel_buffers);
+		pixel_buffers[0] = pixel_buffers[1] = 0;
+	}
+	if (filepath) {delete [] filepath; filepath = nullptr;}
+	if (sequence_prefix) {delete [] sequence_prefix; sequence_prefix = nullptr;}
+	if (sequence_suffix) {delete [] sequence_suffix; sequence_suffix = nullptr;}
+	frame_count = 0;
+}
+
+void VideoStream::requestSeek(int sequence) {
+	SDL_AtomicAdd(&generation, 1); // everything in the ring is stale now
+	SDL_AtomicSet(&seek_sequence, sequence);
+}
+
+void VideoStream::popFrame() {
+	SDL_AtomicAdd(&read_index, 1);
+	SDL_SemPost(free_frames);
+}
+
+void VideoStream::update(GLuint texture, float time) {
+	if (!thread) return;
+	int wanted = time > 0.0f ? (int)(time * fps) : 0;
+	if (wanted == shown_sequence) return;
+
+	u64 deadline = SDL_GetPerformanceCounter() + 2*SDL_GetPerformanceFrequency(); // for wait_for_frames
+	for (;;) {
+		int read = SDL_AtomicGet(&read_index);
+		if (read == SDL_AtomicGet(&write_index)) { // decoder is behind
+			u64 now = SDL_GetPerformanceCounter();
+			if (wait_for_frames && now < deadline) {
+				// a post can be of a frame that was already taken, the ring is checked again either way
+				Uint32 wait_ms = (Uint32)((deadline - now)*1000/SDL_GetPerformanceFrequency()) + 1;
+				SDL_SemWaitTimeout(ready_frames, wait_ms);
+				continue;
+			}
+			late_frame_count++;
+			return;
+		}
+		VideoFrame *frame = frames + (read & (frame_ring_size-1));
+		if (frame->generation != SDL_AtomicGet(&generation)) { // decoded before a seek
+			popFrame();
+			continue;
+		}
+		if (frame->sequence < wanted) {
+			if (wanted - frame->sequence > frame_ring_size) {
+				requestSeek(wanted); // too far behind, skip ahead instead of decoding everything in between
+			} else {
+				dropped_frame_count++;
+				popFrame();
+			}
+			continue;
+		}
+		if (frame->sequence > wanted) { // time went backwards
+			requestSeek(wanted);
+			continue;
+		}
+
+		// orphan the buffer so mapping it doesn't wait for the previous upload
+		size_t size = (size_t)width*height*4;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffers[pixel_buffer_index]);
+		pixel_buffer_index ^= 1;
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		void *mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+		if (mapped) {
+			memcpy(mapped, frame->pixels, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		popFrame();
+		shown_sequence = wanted;
+		return;
+	}
+}
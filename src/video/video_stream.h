@@ -0,0 +1,63 @@
+// Video texture from a YUV4MPEG2 (.y4m) file or an image sequence
+// (frame_0001.png, frame_0002.png, ...). A decoder thread runs ahead into
+// a bounded ring of RGBA frames and the render thread uploads the frame for
+// the current u_time through an orphaned pixel buffer object. It loops.
+bool isVideoFile(const char *filepath); // y4m, by extension
+
+struct VideoFrame {
+	u8 *pixels = nullptr; // width*height*4
+	int sequence; // unbounded frame number, the file frame is sequence % frame_count
+	int generation; // frames from before a seek are stale
+};
+
+struct VideoStream {
+	char *filepath = nullptr; // the .y4m or the first image of the sequence
+	int width = 0, height = 0;
+	int frame_count = 0;
+	float fps = 30.0f; // from the y4m header, image sequences default to 30
+	bool wait_for_frames = false; // block until the frame for u_time is decoded (export, benchmarks, replays)
+	int shown_sequence = -1;
+	int dropped_frame_count = 0; // decoded but skipped because they were too late
+	int late_frame_count = 0; // frames shown without the right video frame ready
+
+	bool open(const char *video_filepath, GLuint *out_texture);
+	void close();
+	void update(GLuint texture, float time); // render thread, once per frame
+
+private:
+	// y4m
+	bool is_y4m = false;
+	u64 y4m_data_offset = 0; // first frame header
+	size_t y4m_frame_stride = 0; // "FRAME\n" + planes
+	size_t y4m_frame_header_size = 0;
+	int y4m_chroma_shift_x = 1, y4m_chroma_shift_y = 1; // 420: 1 1, 422: 1 0, 444: 0 0
+	bool y4m_mono = false;
+
+	// image sequence: prefix + number with digit_count digits + suffix
+	char *sequence_prefix = nullptr;
+	char *sequence_suffix = nullptr;
+	int sequence_first = 0;
+	int sequence_digit_count = 0;
+
+	// decoder thread fills the ring, render thread drains it
+	enum {frame_ring_size = 8}; // power of two
+	VideoFrame frames[frame_ring_size];
+	SDL_atomic_t write_index = {0};
+	SDL_atomic_t read_index = {0};
+	SDL_sem *free_frames = nullptr; // ring slots the decoder may write
+	SDL_sem *ready_frames = nullptr; // posted for each published frame, wait_for_frames sleeps on it
+	SDL_atomic_t seek_sequence = {-1}; // requested by the render thread
+	SDL_atomic_t generation = {0};
+	SDL_atomic_t quit = {0};
+	SDL_Thread *thread = nullptr;
+
+	GLuint pixel_buffers[2] = {};
+	int pixel_buffer_index = 0;
+
+	bool openY4M(const char *video_filepath);
+	bool openImageSequence(const char *image_filepath);
+	bool decodeFrame(int frame, u8 *out_pixels); // decoder thread
+	void requestSeek(int sequence);
+	void popFrame();
+	static int decoderThread(void *data);
+};